@@ -20,6 +20,7 @@
 #include "hss_types.h"
 
 #include "ssmb_ipi.h"
+#include "hss_memcpy_via_pdma.h"
 
 #if IS_ENABLED(CONFIG_SERVICE_IPI_POLL)
 #  include "ipi_poll_service.h"
@@ -37,6 +38,10 @@
 # include "spi_service.h"
 #endif
 
+#if IS_ENABLED(CONFIG_SERVICE_QSPI)
+# include "qspi_service.h"
+#endif
+
 #if IS_ENABLED(CONFIG_SERVICE_SCRUB)
 # include "scrub_service.h"
 #endif
@@ -208,9 +213,13 @@ struct StateMachine /*@null@*/ * const pGlobalStateMachines[] = {
     &boot_service3,
     &boot_service4,
 #endif
+    &memcpy_via_pdma_service,
 #if IS_ENABLED(CONFIG_SERVICE_SPI)
     &spi_service,
 #endif
+#if IS_ENABLED(CONFIG_SERVICE_QSPI)
+    &qspi_service,
+#endif
 #if IS_ENABLED(CONFIG_SERVICE_UART)
     &uart_service,
 #endif
@@ -332,6 +332,28 @@ Flash_read
     QSPI_TRANSFER_BLOCK(4, command_buf, 0, buf, len, dummy_cycles);
 }
 
+/***************************************************************************//**
+ * See micron_mt25q.h for details of how to use this function.
+ */
+void
+Flash_read_sfdp
+(
+    uint8_t* buf,
+    uint32_t addr,
+    uint32_t len
+)
+{
+    uint8_t command_buf[4] __attribute__ ((aligned (4))) = {0u};
+
+    /* SFDP reads always use 3 address bytes and 8 dummy cycles */
+    command_buf[0] = MICRON_READ_DISCOVERY;
+    command_buf[1] = (addr >> 16u) & 0xFFu;
+    command_buf[2] = (addr >> 8u) & 0xFFu;
+    command_buf[3] = addr & 0xFFu;
+
+    QSPI_TRANSFER_BLOCK(3, command_buf, 0, buf, len, 8u);
+}
+
 /***************************************************************************//**
  * See micron_mt25q.h for details of how to use this function.
  */
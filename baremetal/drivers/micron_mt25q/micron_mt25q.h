@@ -248,6 +248,31 @@ Flash_read_status_regs
     uint8_t * buf
 );
 
+/*-------------------------------------------------------------------------*//**
+  The Flash_read_sfdp() function reads from the JESD216 Serial Flash Discoverable
+  Parameters (SFDP) of the flash memory.
+
+  @param buf
+  The buf parameter is a pointer to the buffer in which the driver will copy
+  the parameter data.
+
+  @param addr
+  The addr parameter is the address within the SFDP area from which to read.
+
+  @param len
+  The len parameter is the number of bytes to read.
+
+  @return
+    This function does not return any value.
+*/
+void
+Flash_read_sfdp
+(
+    uint8_t* buf,
+    uint32_t addr,
+    uint32_t len
+);
+
 /*-------------------------------------------------------------------------*//**
   The Flash_enter_xip() function puts the flash memory into the XIP mode. To exit
   XIP, use Flash_exit_xip() function or reset the device.
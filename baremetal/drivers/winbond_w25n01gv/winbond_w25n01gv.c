@@ -26,6 +26,7 @@ extern "C" {
 #define NUM_PAGES_PER_BLOCK                     64u
 #define NUM_BLOCKS_PER_DIE                      1024u
 #define PAGE_LENGTH                             2048u
+#define PARAMETER_PAGE                          0x01u /* in the OTP area */
 #define BLOCK_LENGTH                            (PAGE_LENGTH * NUM_PAGES_PER_BLOCK)
 #define DIE_SIZE                                (BLOCK_LENGTH * NUM_BLOCKS_PER_DIE)
 #define NUM_LUTS                                20u
@@ -106,7 +107,9 @@ static void send_write_enable_command(void);
 static void disable_write_protect(void);
 static bool is_bad_block(uint16_t block_index);
 static uint8_t erase_block(uint16_t addr);
+static uint8_t erase_block_start(uint16_t block_index);
 static uint8_t program_page(uint8_t const * const p_tx_buf, uint32_t page, const uint32_t wr_len);
+static void program_page_start(uint8_t const * const p_tx_buf, uint32_t page, const uint32_t wr_len);
 static uint8_t mark_block_as_bad(uint32_t block_index);
 static void read_statusreg(uint8_t status_reg_address, uint8_t* rd_buf);
 static void write_statusreg(uint8_t address, uint8_t value);
@@ -268,6 +271,40 @@ uint8_t Flash_erase_block(uint16_t block_index)
     return(status);
 }
 
+uint8_t Flash_erase_block_start(uint16_t block_index)
+{
+    disable_write_protect();
+
+    return erase_block_start(block_index);
+}
+
+void Flash_program_page_start(uint8_t const * const buf, uint32_t page, uint32_t len)
+{
+    disable_write_protect();
+
+    program_page_start(buf, page, len);
+}
+
+bool Flash_poll_erase_complete(uint8_t *pStatus)
+{
+    uint8_t status_reg = 0u;
+
+    read_statusreg(STATUS_REG_3, &status_reg);
+    *pStatus = (STATUS_REG_3_EFAIL & status_reg);
+
+    return !((STATUS_REG_3_BUSY | STATUS_REG_3_WEL) & status_reg);
+}
+
+bool Flash_poll_program_complete(uint8_t *pStatus)
+{
+    uint8_t status_reg = 0u;
+
+    read_statusreg(STATUS_REG_3, &status_reg);
+    *pStatus = ((STATUS_REG_3_ECC1 | STATUS_REG_3_PFAIL) & status_reg);
+
+    return !((STATUS_REG_3_BUSY | STATUS_REG_3_WEL) & status_reg);
+}
+
 uint8_t Flash_program(uint8_t* buf, uint32_t addr, uint32_t len)
 {
     int32_t remaining_length = (int32_t)len;
@@ -300,6 +337,22 @@ uint8_t Flash_program(uint8_t* buf, uint32_t addr, uint32_t len)
     return status;
 }
 
+uint8_t Flash_read_parameter_page(uint8_t* buf, uint16_t offset, uint32_t len)
+{
+    uint8_t result;
+    uint8_t status_reg2_value;
+
+    // the parameter page is read from the OTP area, selected by OTP-E
+    read_statusreg(STATUS_REG_2, (uint8_t *)&status_reg2_value);
+    write_statusreg(STATUS_REG_2, status_reg2_value | STATUS_REG_2_OTP_E);
+
+    result = read_page(buf, PARAMETER_PAGE, offset, len);
+
+    write_statusreg(STATUS_REG_2, status_reg2_value);
+
+    return result;
+}
+
 uint8_t Flash_add_entry_to_bb_lut(uint16_t lba, uint16_t pba)
 {
     uint8_t result = 0u;
@@ -409,6 +462,18 @@ static bool is_bad_block(uint16_t block_index)
 }
 
 static uint8_t erase_block(uint16_t block_index)
+{
+    uint8_t status = erase_block_start(block_index);
+
+    if (!status) {
+        status = wait_if_busy_or_wel();
+        status = (STATUS_REG_3_EFAIL & status);
+    }
+
+    return status;
+}
+
+static uint8_t erase_block_start(uint16_t block_index)
 {
     uint8_t status;
 
@@ -435,19 +500,28 @@ static uint8_t erase_block(uint16_t block_index)
         MSS_QSPI_polled_transfer_block(0u, (const void * const)command_buf, 3u,
             (const void * const)0, 0u, 0u);
 
-        status = wait_if_busy_or_wel();
-
-        status = (STATUS_REG_3_EFAIL & status);
+        status = 0u;
     }
 
     return status;
 }
 
 static uint8_t program_page(uint8_t const * const p_tx_buf, uint32_t page, const uint32_t wr_len)
+{
+    uint8_t status = 0xFFu;
+
+    program_page_start(p_tx_buf, page, wr_len);
+
+    status = wait_if_busy_or_wel();
+
+    // ECC-1 indicates 2-bit error that cannot be corrected...
+    return ((STATUS_REG_3_ECC1 | STATUS_REG_3_PFAIL) & status);
+}
+
+static void program_page_start(uint8_t const * const p_tx_buf, uint32_t page, const uint32_t wr_len)
 {
     uint8_t command_buf[PAGE_LENGTH + 3] __attribute__ ((aligned (4))) = { 0u };
     uint16_t column = 0u;
-    uint8_t status = 0xFFu;
 
     ASSERT(wr_len <= PAGE_LENGTH);
 
@@ -494,11 +568,6 @@ static uint8_t program_page(uint8_t const * const p_tx_buf, uint32_t page, const
     send_write_enable_command();
     MSS_QSPI_polled_transfer_block(0u, (const void * const)command_buf, 3u,
         (const void * const)0, 0u, 0u);
-
-    status = wait_if_busy_or_wel();
-
-    // ECC-1 indicates 2-bit error that cannot be corrected...
-    return ((STATUS_REG_3_ECC1 | STATUS_REG_3_PFAIL) & status);
 }
 
 static uint8_t mark_block_as_bad(uint32_t block_index)
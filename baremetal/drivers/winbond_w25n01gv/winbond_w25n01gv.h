@@ -29,6 +29,7 @@
 #define MSS_WINBOND_MT25Q_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "drivers/mss/mss_qspi/mss_qspi.h"
 
 #ifdef __cplusplus
@@ -211,6 +212,74 @@ uint8_t Flash_erase_block(uint16_t block_nb);
 */
 uint8_t Flash_program(uint8_t* buf, uint32_t addr, uint32_t len);
 
+/*-------------------------------------------------------------------------*//**
+  The Flash_erase_block_start() function starts erasing a block, and returns
+  without waiting for the erase to complete. Completion is detected using
+  Flash_poll_erase_complete().
+
+  @param block_nb
+  The block_nb parameter is the block to be erased.
+
+  @return
+    This function returns a non-zero value if the erase could not be started,
+    for example because the block is marked as bad. A zero return value
+    indicates that the erase is in progress.
+*/
+uint8_t Flash_erase_block_start(uint16_t block_nb);
+
+/*-------------------------------------------------------------------------*//**
+  The Flash_program_page_start() function loads a page of data into the flash
+  memory data buffer and starts programming it, and returns without waiting for
+  the program operation to complete. Completion is detected using
+  Flash_poll_program_complete().
+
+  @param buf
+  The buf parameter points to the data to be programmed.
+
+  @param page
+  The page parameter is the page address to be programmed.
+
+  @param len
+  The len parameter is the number of bytes to program, at most one page.
+*/
+void Flash_program_page_start(uint8_t const * const buf, uint32_t page, uint32_t len);
+
+/*-------------------------------------------------------------------------*//**
+  The Flash_poll_erase_complete() and Flash_poll_program_complete() functions
+  read the flash status register once, to check whether an erase or program
+  operation started by Flash_erase_block_start() or Flash_program_page_start()
+  has completed.
+
+  @param pStatus
+  The pStatus parameter receives a non-zero value if the operation failed.
+
+  @return
+    These functions return true once the operation has completed.
+*/
+bool Flash_poll_erase_complete(uint8_t *pStatus);
+bool Flash_poll_program_complete(uint8_t *pStatus);
+
+/*-------------------------------------------------------------------------*//**
+  The Flash_read_parameter_page() function reads from the ONFI-format parameter
+  page, which holds three redundant copies of the device parameters, each of
+  256 bytes.
+
+  @param buf
+  The buf parameter is a pointer to the buffer in which the driver will copy
+  the data read from the parameter page.
+
+  @param offset
+  The offset parameter is the byte offset within the parameter page.
+
+  @param len
+  The len parameter is the number of bytes to read.
+
+  @return
+    This function returns a non-zero value if there was an error during the read
+    operation. A zero return value indicates success.
+*/
+uint8_t Flash_read_parameter_page(uint8_t* buf, uint16_t offset, uint32_t len);
+
 /*-------------------------------------------------------------------------*//**
   The Flash_scan_for_bad_blocks() function scans for bad blocks within the flash
   memory. The NAND flash devices are allowed to be shipped with certain number of
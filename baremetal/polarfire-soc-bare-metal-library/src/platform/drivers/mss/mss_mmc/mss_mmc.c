@@ -43,6 +43,7 @@ extern "C" {
 #define MMC_HS400_MODE                  0x03B90300u
 #define MMC_HS_MODE_DEFAULT             0x03B90000u
 #define MMC_HPI_ENABLE                  0x03A10100u
+#define MMC_PARTITION_CONFIG_CSD        0x03B30000u
 
 #define MMC_CQ_ENABLE                   0x030F0100u
 #define CQ_IDLE_TIME                    0x1000u
@@ -67,15 +68,19 @@ extern "C" {
 #define SIZE_64KB                       0x00010000u
 #define SIZE_1GB                        0x40000000u
 
+#define EXT_CSD_BOOT_SIZE_MULT_OFFSET   226u
 #define EXT_CSD_SECTOR_COUNT_OFFSET     212u
 #define EXT_CSD_CARD_TYPE_OFFSET        196u
 #define EXT_CSD_REVISION_OFFSET         192u
 #define EXT_CSD_HS_TIMING_OFFSET        185u
+#define EXT_CSD_PARTITION_CONFIG_OFFSET 179u
 #define EXT_CSD_ES_SUPPORT_OFFSET       184u
 #define EXT_CSD_CQ_SUPPORT_OFFSET       308u
 /* CMD Queuing Depth */
 #define EXT_CSD_CQ_DEPTH_OFFSET         307u
 #define EXT_CSD_CQ_MODE_EN_OFFSET       15u
+/* Boot partition size unit, 128KB */
+#define BOOT_SIZE_MULT_UNIT             0x00020000u
 
 #define READ_SEND_SCR                   0xFFFFFFFEu
 #define SCR_REG_DATA_SIZE               8u
@@ -677,6 +682,63 @@ MSS_MMC_get_info
     *sector_size = g_sector_size;
     *sector_count = g_hw_sec_count;
 }
+/*-------------------------------------------------------------------------*//**
+ * See "mss_mmc.h" for details of how to use this function.
+ */
+mss_mmc_status_t
+MSS_MMC_get_partition_config
+(
+    uint8_t *partition_config,
+    uint32_t *boot_partition_size
+)
+{
+    uint32_t csd_reg[BLK_SIZE/WORD_SIZE];
+    uint8_t *pcsd_reg;
+    mss_mmc_status_t ret_status;
+
+    /* Read EXT_CSD */
+    ret_status = MSS_MMC_single_block_read(READ_SEND_EXT_CSD, csd_reg);
+    if (MSS_MMC_TRANSFER_SUCCESS == ret_status)
+    {
+        pcsd_reg = ((uint8_t *)csd_reg);
+        *partition_config = pcsd_reg[EXT_CSD_PARTITION_CONFIG_OFFSET];
+        *boot_partition_size = pcsd_reg[EXT_CSD_BOOT_SIZE_MULT_OFFSET] * BOOT_SIZE_MULT_UNIT;
+    }
+    return (ret_status);
+}
+/*-------------------------------------------------------------------------*//**
+ * See "mss_mmc.h" for details of how to use this function.
+ */
+mss_mmc_status_t
+MSS_MMC_set_partition_config
+(
+    uint8_t partition_config
+)
+{
+    cif_response_t response_status;
+    mss_mmc_status_t ret_status = MSS_MMC_TRANSFER_FAIL;
+
+    if (g_mmc_init_complete != MMC_SET)
+    {
+        ret_status = MSS_MMC_NOT_INITIALISED;
+    }
+    else
+    {
+        response_status = cif_send_cmd(MMC_PARTITION_CONFIG_CSD
+                                        | ((uint32_t)partition_config << SHIFT_8BIT),
+                                        MMC_CMD_6_SWITCH, MSS_MMC_RESPONSE_R1B);
+        if (TRANSFER_IF_FAIL != response_status)
+        {
+            response_status = check_device_status(response_status);
+        }
+
+        if (TRANSFER_IF_SUCCESS == response_status)
+        {
+            ret_status = MSS_MMC_TRANSFER_SUCCESS;
+        }
+    }
+    return (ret_status);
+}
 
 mss_mmc_status_t MSS_MMC_single_block_read(uint32_t src_addr, uint32_t * dst_addr)
 {
@@ -955,6 +1017,135 @@ mss_mmc_status_t MSS_MMC_sdma_read(uint32_t src, uint8_t *dest, uint32_t size)
     }
     return (ret_status);
 }
+/*-------------------------------------------------------------------------*//**
+ * See "mss_mmc.h" for details of how to use this function.
+ */
+mss_mmc_status_t MSS_MMC_adma2_desc_read(uint32_t src, const void *desc_table, uint32_t size)
+{
+    uint32_t blockcount;
+    uint32_t argument;
+    uint32_t blocklen;
+    uint32_t tmp, srs03_data, srs9;
+    cif_response_t response_status;
+    mss_mmc_status_t ret_status = MSS_MMC_NO_ERROR;
+    mMMC_DECLARE_TIMEOUT(mmc_spin_timeout);
+
+    blocklen = BLK_SIZE;
+    argument = src;
+
+    if (g_mmc_init_complete == MMC_SET)
+    {
+        if (MSS_MMC_TRANSFER_IN_PROGRESS == g_mmc_trs_status.state)
+        {
+            ret_status = MSS_MMC_TRANSFER_IN_PROGRESS;
+        }
+        else
+        {
+            /* Size should be divided by 512, not greater than (32MB - 512) */
+            if (((size % blocklen) != MMC_CLEAR) || (size > (SIZE_32MB - BLK_SIZE))
+                    || (size == MMC_CLEAR) || (desc_table == NULL_POINTER))
+            {
+                ret_status = MSS_MMC_INVALID_PARAMETER;
+                g_mmc_trs_status.state = MSS_MMC_INVALID_PARAMETER;
+            }
+            else
+            {
+                /* Disable PLIC interrupt for MMC */
+                PLIC_DisableIRQ(MMC_main_PLIC);
+                /* Disable error/interrupt */
+                MMC->SRS14 = MMC_CLEAR;
+                /* check eMMC/SD device is busy */
+                mMMC_ARM_TIMEOUT(mmc_spin_timeout);
+                do
+                {
+                    response_status = cif_send_cmd(sdcard_RCA << SHIFT_16BIT,
+                                                    MMC_CMD_13_SEND_STATUS,
+                                                    MSS_MMC_RESPONSE_R1);
+                    mMMC_CHECK_TIMEOUT(mmc_spin_timeout, MSS_MMC_NOT_INITIALISED);
+                } while (DEVICE_BUSY == response_status);
+
+                if (TRANSFER_IF_SUCCESS == response_status)
+                {
+                    /* Reset Data and cmd line */
+                    MMC->SRS11 |= MMC_RESET_DATA_CMD_LINE;
+                    mmc_delay(MASK_8BIT);
+                    /* Calculate block count */
+                    blockcount = ((size - MMC_SET) / blocklen) + MMC_SET;
+                    /* select ADMA2 */
+                    tmp = MMC->SRS10;
+                    tmp = (tmp & (~SRS10_DMA_SELECT_MASK));
+                    MMC->SRS10 = (tmp | SRS10_DMA_SELECT_ADMA2);
+                    /* ADMA2 descriptor table address */
+                    MMC->SRS22 = ((uint32_t)((uintptr_t)desc_table));
+                    MMC->SRS23 = ((uint32_t)(((uint64_t)((uintptr_t)desc_table)) >> MMC_64BIT_UPPER_ADDR_SHIFT));
+                    /* Block length and count */
+                    MMC->SRS01 = (blocklen | (blockcount << BLOCK_COUNT_ENABLE_SHIFT));
+
+                    /* Enable interrupts */
+                    MMC->SRS14 = (SRS14_COMMAND_COMPLETE_SIG_EN |
+                                SRS14_TRANSFER_COMPLETE_SIG_EN |
+                                SRS14_ADMA_ERROR_SIG_EN |
+                                SRS14_DATA_TIMEOUT_ERR_SIG_EN);
+
+                    PLIC_EnableIRQ(MMC_main_PLIC);
+
+                    /* Check cmd and data line busy */
+                    mMMC_ARM_TIMEOUT(mmc_spin_timeout);
+                    do
+                    {
+                        srs9 = MMC->SRS09;
+                        mMMC_CHECK_TIMEOUT(mmc_spin_timeout, MSS_MMC_NOT_INITIALISED);
+                    } while ((srs9 & (SRS9_CMD_INHIBIT_CMD | SRS9_CMD_INHIBIT_DAT)) != MMC_CLEAR);
+
+                    if (blockcount > MMC_SET) /* Multi Block read */
+                    {
+                        /* DPS, Data transfer direction - read */
+                        srs03_data = ((uint32_t)(SRS3_DATA_PRESENT | SRS3_TRANS_DIRECT_READ
+                                            | SRS3_MULTI_BLOCK_SEL | SRS3_BLOCK_COUNT_ENABLE
+                                            | SRS3_RESPONSE_CHECK_TYPE_R1 | SRS3_RESP_LENGTH_48
+                                            | SRS3_CRC_CHECK_EN | SRS3_INDEX_CHECK_EN
+                                            | SRS3_DMA_ENABLE));
+
+                        /* multi block transfer */
+                        g_mmc_is_multi_blk = MMC_SET;
+                        /* Command argument */
+                        MMC->SRS02 = argument;
+                        /* execute command */
+                        MMC->SRS03 = ((uint32_t)((MMC_CMD_18_READ_MULTIPLE_BLOCK << MMC_SRS03_COMMAND_SHIFT) | srs03_data));
+                    }
+                    else /* single block read */
+                    {
+                        /* DPS, Data transfer direction - read */
+                        srs03_data = ((uint32_t)(SRS3_DATA_PRESENT | SRS3_TRANS_DIRECT_READ
+                                                | SRS3_BLOCK_COUNT_ENABLE
+                                                | SRS3_RESPONSE_CHECK_TYPE_R1
+                                                | SRS3_RESP_LENGTH_48
+                                                | SRS3_CRC_CHECK_EN | SRS3_INDEX_CHECK_EN
+                                                | SRS3_DMA_ENABLE));
+                        /* single block transfer */
+                        g_mmc_is_multi_blk = MMC_CLEAR;
+                        /* Command argument */
+                        MMC->SRS02 = argument;
+                        /* execute command */
+                        MMC->SRS03 = ((uint32_t)((MMC_CMD_17_READ_SINGLE_BLOCK << MMC_SRS03_COMMAND_SHIFT) | srs03_data));
+                    }
+                    g_mmc_trs_status.state = MSS_MMC_TRANSFER_IN_PROGRESS;
+                    ret_status = MSS_MMC_TRANSFER_IN_PROGRESS;
+                }
+                else
+                {
+                    g_mmc_trs_status.state = MSS_MMC_DEVICE_ERROR;
+                    ret_status = MSS_MMC_DEVICE_ERROR;
+                }
+            }
+        }
+    }
+    else
+    {
+        ret_status = MSS_MMC_NOT_INITIALISED;
+    }
+    return (ret_status);
+}
 /*******************************************************************************
 *************************** WRITE APIs *****************************************
 *******************************************************************************/
@@ -1085,6 +1276,164 @@ mss_mmc_status_t MSS_MMC_single_block_write(const uint32_t * src_addr, uint32_t
     }
     return (ret_status);
 }
+/*-------------------------------------------------------------------------*//**
+ * See "mss_mmc.h" for details of how to use this function.
+ */
+mss_mmc_status_t MSS_MMC_adma2_desc_write(const void *desc_table, uint32_t dest, uint32_t size, uint32_t flags)
+{
+    uint32_t blockcount;
+    uint32_t argument;
+    uint32_t blocklen;
+    uint32_t tmp, srs03_data, srs9;
+    cif_response_t response_status;
+    mss_mmc_status_t ret_status = MSS_MMC_NO_ERROR;
+    mMMC_DECLARE_TIMEOUT(mmc_spin_timeout);
+
+    blocklen = BLK_SIZE;
+    argument = dest;
+
+    if (g_mmc_init_complete == MMC_SET)
+    {
+        if (MSS_MMC_TRANSFER_IN_PROGRESS == g_mmc_trs_status.state)
+        {
+            ret_status = MSS_MMC_TRANSFER_IN_PROGRESS;
+        }
+        else
+        {
+            /* Size should be divided by 512, not greater than (32MB - 512) */
+            if (((size % blocklen) != MMC_CLEAR) || (size > (SIZE_32MB - BLK_SIZE))
+                    || (size == MMC_CLEAR) || (desc_table == NULL_POINTER))
+            {
+                ret_status = MSS_MMC_INVALID_PARAMETER;
+            }
+            else
+            {
+                /* Disable PLIC interrupt for MMC */
+                PLIC_DisableIRQ(MMC_main_PLIC);
+                /* Disable error/interrupt */
+                MMC->SRS14 = MMC_CLEAR;
+                /* check eMMC/SD device is busy */
+                mMMC_ARM_TIMEOUT(mmc_spin_timeout);
+                do
+                {
+                    response_status = cif_send_cmd(sdcard_RCA << SHIFT_16BIT,
+                                                        MMC_CMD_13_SEND_STATUS,
+                                                        MSS_MMC_RESPONSE_R1);
+                    mMMC_CHECK_TIMEOUT(mmc_spin_timeout, MSS_MMC_NOT_INITIALISED);
+                } while (DEVICE_BUSY == response_status);
+
+                /* Calculate block count */
+                blockcount = ((size - MMC_SET) / blocklen) + MMC_SET;
+
+                if (TRANSFER_IF_SUCCESS == response_status)
+                {
+                    /* Reset Data and cmd line */
+                    MMC->SRS11 |= MMC_RESET_DATA_CMD_LINE;
+                    mmc_delay(MASK_8BIT);
+
+                    /* SD pre-erase hint, ACMD23 */
+                    if ((blockcount > MMC_SET) && ((flags & MSS_MMC_WRITE_SD_PRE_ERASE) != MMC_CLEAR))
+                    {
+                        response_status = cif_send_cmd(sdcard_RCA << SHIFT_16BIT, SD_CMD_55,
+                                                        MSS_MMC_RESPONSE_R1);
+                        if (TRANSFER_IF_SUCCESS == response_status)
+                        {
+                            response_status = cif_send_cmd(blockcount, SD_ACMD_23_SET_WR_BLK_ERASE_COUNT,
+                                                            MSS_MMC_RESPONSE_R1);
+                        }
+                    }
+                }
+
+                /* pre-declared block count, CMD23, which must immediately precede CMD25 */
+                if ((TRANSFER_IF_SUCCESS == response_status) && (blockcount > MMC_SET)
+                        && ((flags & MSS_MMC_WRITE_SET_BLOCK_COUNT) != MMC_CLEAR))
+                {
+                    response_status = cif_send_cmd(blockcount, MMC_CMD_23_SET_BLOCK_COUNT,
+                                                    MSS_MMC_RESPONSE_R1);
+                }
+
+                if (TRANSFER_IF_SUCCESS == response_status)
+                {
+                    /* select ADMA2 */
+                    tmp = MMC->SRS10;
+                    tmp = (tmp & (~SRS10_DMA_SELECT_MASK));
+                    MMC->SRS10 = (tmp | SRS10_DMA_SELECT_ADMA2);
+                    /* ADMA2 descriptor table address */
+                    MMC->SRS22 = (uint32_t)(uintptr_t)desc_table;
+                    MMC->SRS23 = (uint32_t)(((uint64_t)(uintptr_t)desc_table) >> MMC_64BIT_UPPER_ADDR_SHIFT);
+                    /* Block length and count */
+                    MMC->SRS01 = (blocklen | (blockcount << BLOCK_COUNT_ENABLE_SHIFT));
+                    /* enable interrupts */
+                    MMC->SRS14 = (SRS14_COMMAND_COMPLETE_SIG_EN |
+                                    SRS14_TRANSFER_COMPLETE_SIG_EN |
+                                    SRS14_ADMA_ERROR_SIG_EN |
+                                    SRS14_DATA_TIMEOUT_ERR_SIG_EN);
+                    /* Enable PLIC MMC interrupt */
+                    PLIC_EnableIRQ(MMC_main_PLIC);
+
+                    /* check data line busy */
+                    mMMC_ARM_TIMEOUT(mmc_spin_timeout);
+                    do
+                    {
+                        srs9 = MMC->SRS09;
+                        mMMC_CHECK_TIMEOUT(mmc_spin_timeout, MSS_MMC_NOT_INITIALISED);
+                    } while ((srs9 & (SRS9_CMD_INHIBIT_CMD | SRS9_CMD_INHIBIT_DAT)) != MMC_CLEAR);
+
+                    if (blockcount > MMC_SET) /* Multi Block write */
+                    {
+                        /* DPS, Data transfer direction - write */
+                        srs03_data = (uint32_t)(SRS3_DATA_PRESENT | SRS3_TRANS_DIRECT_WRITE
+                                                | SRS3_MULTI_BLOCK_SEL | SRS3_BLOCK_COUNT_ENABLE
+                                                | SRS3_RESPONSE_CHECK_TYPE_R1 | SRS3_RESP_LENGTH_48
+                                                | SRS3_CRC_CHECK_EN | SRS3_INDEX_CHECK_EN
+                                                | SRS3_DMA_ENABLE);
+                        /* a pre-declared block count ends the write without CMD12 */
+                        if ((flags & MSS_MMC_WRITE_SET_BLOCK_COUNT) != MMC_CLEAR)
+                        {
+                            g_mmc_is_multi_blk = MMC_CLEAR;
+                        }
+                        else
+                        {
+                            g_mmc_is_multi_blk = MMC_SET;
+                        }
+
+                        MMC->SRS02 = argument;
+                        /* execute command */
+                        MMC->SRS03 = (uint32_t)((MMC_CMD_25_WRITE_MULTI_BLOCK << MMC_SRS03_COMMAND_SHIFT) | srs03_data);
+                    }
+                    else /* single block write */
+                    {
+                        /* DPS, Data transfer direction - write */
+                        srs03_data = (uint32_t)(SRS3_DATA_PRESENT | SRS3_TRANS_DIRECT_WRITE
+                                                | SRS3_BLOCK_COUNT_ENABLE
+                                                | SRS3_RESPONSE_CHECK_TYPE_R1
+                                                | SRS3_RESP_LENGTH_48
+                                                | SRS3_CRC_CHECK_EN
+                                                | SRS3_INDEX_CHECK_EN
+                                                | SRS3_DMA_ENABLE);
+                        /* single block transfer */
+                        g_mmc_is_multi_blk = MMC_CLEAR;
+                        /* execute command */
+                        MMC->SRS02 = argument;
+                        MMC->SRS03 = (uint32_t)((MMC_CMD_24_WRITE_SINGLE_BLOCK << MMC_SRS03_COMMAND_SHIFT) | srs03_data);
+                    }
+                    g_mmc_trs_status.state = MSS_MMC_TRANSFER_IN_PROGRESS;
+                    ret_status = MSS_MMC_TRANSFER_IN_PROGRESS;
+                }
+                else
+                {
+                    g_mmc_trs_status.state = MSS_MMC_DEVICE_ERROR;
+                    ret_status = MSS_MMC_DEVICE_ERROR;
+                }
+            }
+        }
+    }
+    else
+    {
+        ret_status = MSS_MMC_NOT_INITIALISED;
+    }
+    return (ret_status);
+}
 /*-------------------------------------------------------------------------*//**
  * See "mss_mmc.h" for details of how to use this function.
  */
@@ -262,6 +262,10 @@ extern "C"
  */
 #define MSS_SDCARD_MODE_DDR50           0xEu
 
+/* Flags for MSS_MMC_adma2_desc_write() */
+#define MSS_MMC_WRITE_SET_BLOCK_COUNT   0x01u   /* pre-declare the block count, CMD23 */
+#define MSS_MMC_WRITE_SD_PRE_ERASE      0x02u   /* SD pre-erase hint, ACMD23 */
+
 /* Host controller data width */
 #define MSS_MMC_DATA_WIDTH_1BIT         0x00u
 #define MSS_MMC_DATA_WIDTH_4BIT         0x01u
@@ -445,6 +449,50 @@ MSS_MMC_get_info
     uint32_t *sector_count
 );
 
+/*-------------------------------------------------------------------------*//**
+  The function MSS_MMC_get_partition_config() reads the PARTITION_CONFIG and
+  BOOT_SIZE_MULT fields of the EXT_CSD register of an eMMC device.
+
+  @param partition_config
+  This parameter is a pointer to the data containing the PARTITION_CONFIG
+  field. Bits [5:3] (BOOT_PARTITION_ENABLE) select the partition the device
+  boots from, and bits [2:0] (PARTITION_ACCESS) the partition being accessed:
+  0 for the user data area, 1 for BOOT1 and 2 for BOOT2.
+
+  @param boot_partition_size
+  This parameter is a pointer to the data containing the size in bytes of
+  each of the BOOT1 and BOOT2 partitions.
+
+  @return
+  This function returns a value of type mss_mmc_status_t which specifies the
+  transfer status of the operation.
+ */
+mss_mmc_status_t
+MSS_MMC_get_partition_config
+(
+    uint8_t *partition_config,
+    uint32_t *boot_partition_size
+);
+
+/*-------------------------------------------------------------------------*//**
+  The function MSS_MMC_set_partition_config() writes the PARTITION_CONFIG
+  field of the EXT_CSD register of an eMMC device, using CMD6 (SWITCH).
+  Subsequent transfers access the partition selected by PARTITION_ACCESS.
+
+  Note: The caller must ensure that no transfer is in progress.
+
+  @param partition_config
+  Specifies the new value of the PARTITION_CONFIG field.
+
+  @return
+  This function returns MSS_MMC_TRANSFER_SUCCESS if the field was written.
+ */
+mss_mmc_status_t
+MSS_MMC_set_partition_config
+(
+    uint8_t partition_config
+);
+
 /*-------------------------------------------------------------------------*//**
   The MSS_MMC_single_block_write() function is used to transmit a single block
   of data from the host controller to the eMMC/SD device. The size of the block
@@ -736,6 +784,104 @@ MSS_MMC_sdma_read
     uint32_t size
 );
 
+/*-------------------------------------------------------------------------*//**
+  The MSS_MMC_adma2_desc_read() function is used to read a single block or
+  multiple blocks of data from the eMMC/SD device using ADMA2, with a caller
+  supplied ADMA2 descriptor table. The descriptor table allows the data read by
+  a single command to be scattered across several destination buffers, and is
+  not subject to the SDMA buffer boundary.
+
+  The controller operates in Host Version 4 mode with 64-bit addressing, so
+  each descriptor is 128 bits: attribute and length in the first word, the
+  64-bit buffer address in the next two words, and a reserved fourth word. The
+  table must be 8-byte aligned, and the last descriptor must have the End
+  attribute set. The total length described by the table must equal size.
+
+  Note: A call to MSS_MMC_adma2_desc_read() while a transfer is in progress
+  will not initiate a new transfer. Use the MSS_MMC_get_transfer_status()
+  function or a completion handler registered by the MSS_MMC_set_handler()
+  function to check the status of the current transfer before calling the
+  MSS_MMC_adma2_desc_read() function again.
+
+  Note: This function is a non-blocking function and will return immediately
+  after initiating the read transfer.
+
+  @param src
+  Specifies the sector address in the eMMC/SD device from where the data is
+  to be read.
+
+  @param desc_table
+  This parameter is a pointer to the ADMA2 descriptor table describing the
+  destination buffers.
+
+  @param size
+  Specifies the size in bytes of the requested transfer. The value of size
+  must be a multiple of 512 but not greater than (32MB - 512).
+
+  @return
+  This function returns a value of type mss_mmc_status_t which specifies the
+  transfer status of the operation.
+ */
+mss_mmc_status_t
+MSS_MMC_adma2_desc_read
+(
+    uint32_t src,
+    const void *desc_table,
+    uint32_t size
+);
+
+/*-------------------------------------------------------------------------*//**
+  The MSS_MMC_adma2_desc_write() function is used to write a single block or
+  multiple blocks of data to the eMMC/SD device using ADMA2, with a caller
+  supplied ADMA2 descriptor table, as described for MSS_MMC_adma2_desc_read().
+
+  For multiple block writes, the flags parameter selects how the write is
+  bounded:
+    - MSS_MMC_WRITE_SET_BLOCK_COUNT pre-declares the number of blocks with
+      CMD23 (SET_BLOCK_COUNT) immediately before CMD25, so that the card knows
+      the extent of the write in advance and no CMD12 is needed to stop it.
+      CMD23 is mandatory for eMMC devices, but optional for SD cards.
+    - otherwise, the write is open-ended and stopped with CMD12 once the data
+      has been transferred.
+  MSS_MMC_WRITE_SD_PRE_ERASE additionally sends ACMD23 (SET_WR_BLK_ERASE_COUNT)
+  to an SD card before CMD25, so that it can pre-erase the blocks to be
+  written.
+
+  Note: A call to MSS_MMC_adma2_desc_write() while a transfer is in progress
+  will not initiate a new transfer.
+
+  Note: This function is a non-blocking function and will return immediately
+  after initiating the write transfer.
+
+  @param desc_table
+  This parameter is a pointer to the ADMA2 descriptor table describing the
+  source buffers.
+
+  @param dest
+  Specifies the sector address in the eMMC/SD device where the data is
+  to be stored.
+
+  @param size
+  Specifies the size in bytes of the requested transfer. The value of size
+  must be a multiple of 512 but not greater than (32MB - 512).
+
+  @param flags
+  A bitwise OR of MSS_MMC_WRITE_SET_BLOCK_COUNT and MSS_MMC_WRITE_SD_PRE_ERASE,
+  or zero.
+
+  @return
+  This function returns a value of type mss_mmc_status_t which specifies the
+  transfer status of the operation.
+ */
+mss_mmc_status_t
+MSS_MMC_adma2_desc_write
+(
+    const void *desc_table,
+    uint32_t dest,
+    uint32_t size,
+    uint32_t flags
+);
+
 /*-------------------------------------------------------------------------*//**
   The MSS_MMC_adma2_write() function is used to transfer a single block or
   multiple blocks of data from the host controller to the eMMC/SD device using
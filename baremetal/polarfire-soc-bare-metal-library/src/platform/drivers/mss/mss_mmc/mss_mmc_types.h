@@ -101,6 +101,7 @@ extern "C"
 #define SD_CMD_5                            5u    /* R4 Rsp        */
 #define SD_ACMD_6                           6u    /* R1 Rsp        */
 #define SD_ACMD_51                          51u    /* R1 Rsp        */
+#define SD_ACMD_23_SET_WR_BLK_ERASE_COUNT   23u    /* R1 Rsp        */
 #define SD_CMD_6                            6u    /* R1 Rsp        */
 #define SD_CMD_16                           16u    /* R1 Rsp        */
 
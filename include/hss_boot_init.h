@@ -44,6 +44,16 @@ void HSS_BootSelectPayload(void);
 void HSS_BootSelectSPI(void);
 
 void HSS_BootListStorageProviders(void);
+
+bool HSS_Storage_Init(void);
+bool HSS_Storage_ReadBlock(void *pDest, size_t srcOffset, size_t byteCount);
+bool HSS_Storage_WriteBlock(size_t dstOffset, void *pSrc, size_t byteCount);
+bool HSS_Storage_ReadBlockStart(void *pDest, size_t srcOffset, size_t byteCount);
+bool HSS_Storage_WriteBlockStart(size_t dstOffset, void *pSrc, size_t byteCount);
+bool HSS_Storage_IsTransferComplete(bool *pResult);
+void HSS_Storage_GetInfo(uint32_t *pBlockSize, uint32_t *pEraseSize, uint32_t *pBlockCount);
+void HSS_Storage_FlushWriteBuffer(void);
+
 #ifdef __cplusplus
 }
 #endif
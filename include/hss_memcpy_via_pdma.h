@@ -33,6 +33,8 @@
 extern "C" {
 #endif
 
+#include "hss_state_machine.h"
+
 /**
  * \file memcpy via PDMA
  * \brief memcpy via PDMA
@@ -40,6 +42,37 @@ extern "C" {
 
 void *memcpy_via_pdma(void *dest, void const *src, size_t num_bytes);
 
+/**
+ * \brief Asynchronous memcpy via PDMA
+ *
+ * Copies are queued in submission order and spread across all free PDMA channels.
+ * Unaligned heads and tails are copied by the CPU at submission time. Completion
+ * is detected by memcpy_via_pdma_async_service(), which memcpy_via_pdma_service runs
+ * from the E51 superloop, and can be polled for, or signalled via an optional callback.
+ *
+ * The request structure is owned by the caller, and must remain valid until the
+ * copy has completed. Its contents are private to the PDMA copy engine.
+ */
+typedef void (*memcpy_via_pdma_callback_t)(void *pContext);
+
+struct MemcpyViaPdmaRequest {
+    char *pDest;
+    char const *pSrc;
+    size_t bytesToSubmit;
+    unsigned int channelMask;
+    bool pending;
+    memcpy_via_pdma_callback_t callback;
+    void *pContext;
+    struct MemcpyViaPdmaRequest *pNext;
+};
+
+bool memcpy_via_pdma_async(struct MemcpyViaPdmaRequest *pRequest, void *dest, void const *src,
+    size_t num_bytes, memcpy_via_pdma_callback_t callback, void *pContext);
+bool memcpy_via_pdma_async_poll(struct MemcpyViaPdmaRequest *pRequest);
+void memcpy_via_pdma_async_service(void);
+
+extern struct StateMachine memcpy_via_pdma_service;
+
 #ifdef __cplusplus
 }
 #endif
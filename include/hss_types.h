@@ -69,6 +69,9 @@ extern "C" {
 #  ifndef MIN
 #    define MIN(A,B)		((A) < (B) ? A : B)
 #  endif
+#  ifndef MAX
+#    define MAX(a, b)		((a) > (b) ? (a) : (b))
+#  endif
 #  define likely(x)		__builtin_expect((x), 1)
 #  define unlikely(x)		__builtin_expect((x), 0)
 #  ifndef __ssize_t_defined
@@ -236,6 +239,9 @@ struct HSS_Storage {
     bool (* const writeBlock)(size_t dstOffset, void *pSrc, size_t byteCount);
     void (* const getInfo)(uint32_t *pBlockSize, uint32_t *pEraseSize, uint32_t *pBlockCount);
     void (* const flushWriteBuffer)(void);
+    bool (* const readBlockStart)(void *pDest, size_t srcOffset, size_t byteCount);
+    bool (* const writeBlockStart)(size_t dstOffset, void *pSrc, size_t byteCount);
+    bool (* const isTransferComplete)(bool *pResult);
 };
 
 
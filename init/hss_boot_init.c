@@ -24,7 +24,7 @@
 #include "u54_state.h"
 
 #if IS_ENABLED(CONFIG_SERVICE_SPI)
-#  include <mss_sys_services.h>
+#  include "spi_service.h"
 #  define SPI_FLASH_BOOT_ENABLED (CONFIG_SERVICE_BOOT_SPI_FLASH_OFFSET != 0xFFFFFFFF)
 #else
 #  define SPI_FLASH_BOOT_ENABLED 0
@@ -40,13 +40,10 @@
 
 #if IS_ENABLED(CONFIG_SERVICE_MMC)
 #  include "mmc_service.h"
+#  include "mmc_boot_partition.h"
 #  include "gpt.h"
 #endif
 
-#if (SPI_FLASH_BOOT_ENABLED)
-#  include "mss_sys_services.h"
-#endif
-
 #include "hss_state_machine.h"
 #include "hss_debug.h"
 #include "hss_perfctr.h"
@@ -71,9 +68,19 @@
 // local module functions
 
 #if IS_ENABLED(CONFIG_SERVICE_BOOT)
+#  if IS_ENABLED(CONFIG_CRYPTO_SIGNING)
+#    define BOOT_COPY_PIECE_SIZE (64u * 1024u)
+#  endif
 typedef bool (*HSS_BootImageCopyFnPtr_t)(void *pDest, size_t srcOffset, size_t byteCount);
 static bool copyBootImageToDDR_(struct HSS_BootImage *pBootImage, char *pDest,
     size_t srcOffset, HSS_BootImageCopyFnPtr_t pCopyFunction);
+#  if IS_ENABLED(CONFIG_SERVICE_BOOT_STREAMING)
+static bool copyBootImageHeaderToDDR_(struct HSS_BootImage *pBootImage, char *pDest,
+    size_t srcOffset, HSS_BootImageCopyFnPtr_t pCopyFunction);
+#  endif
+#  if IS_ENABLED(CONFIG_COMPRESSION)
+static bool decompressBootImageToDDR_(struct HSS_Storage *pStorage, char *pDest, size_t srcOffset);
+#  endif
 
 static void printBootImageDetails_(struct HSS_BootImage const * const pBootImage);
 static bool tryBootFunction_(struct HSS_Storage *pStorage, HSS_GetBootImageFnPtr_t getBootImageFunction);
@@ -96,7 +103,10 @@ static struct HSS_Storage qspiStorage_ = {
     .readBlock = HSS_CachedQSPI_ReadBlock,
     .writeBlock = HSS_CachedQSPI_WriteBlock,
     .getInfo = HSS_CachedQSPI_GetInfo,
-    .flushWriteBuffer = HSS_CachedQSPI_FlushWriteBuffer
+    .flushWriteBuffer = HSS_CachedQSPI_FlushWriteBuffer,
+    .readBlockStart = NULL,
+    .writeBlockStart = NULL,
+    .isTransferComplete = NULL
 };
 #endif
 #if IS_ENABLED(CONFIG_SERVICE_MMC)
@@ -107,18 +117,30 @@ static struct HSS_Storage mmcStorage_ = {
     .readBlock = HSS_MMC_ReadBlock,
     .writeBlock = HSS_MMC_WriteBlockSDMA,
     .getInfo = HSS_MMC_GetInfo,
-    .flushWriteBuffer = NULL
+    .flushWriteBuffer = NULL,
+#if IS_ENABLED(CONFIG_SERVICE_MMC_ADMA2)
+    .readBlockStart = HSS_MMC_ReadBlockStart,
+    .writeBlockStart = HSS_MMC_WriteBlockStart,
+    .isTransferComplete = HSS_MMC_IsTransferComplete
+#else
+    .readBlockStart = NULL,
+    .writeBlockStart = NULL,
+    .isTransferComplete = NULL
+#endif
 };
 #endif
 #if IS_ENABLED(CONFIG_SERVICE_SPI)
 static struct HSS_Storage spiStorage_ = {
     .name = "SPI",
     .getBootImage = getBootImageFromSpiFlash_,
-    .init = NULL,
-    .readBlock = NULL,
+    .init = HSS_SPI_Init,
+    .readBlock = HSS_SPI_ReadBlock,
     .writeBlock = NULL,
-    .getInfo = NULL,
-    .flushWriteBuffer = NULL
+    .getInfo = HSS_SPI_GetInfo,
+    .flushWriteBuffer = NULL,
+    .readBlockStart = HSS_SPI_ReadBlockStart,
+    .writeBlockStart = NULL,
+    .isTransferComplete = HSS_SPI_IsTransferComplete
 };
 #endif
 #if IS_ENABLED(CONFIG_SERVICE_BOOT_USE_PAYLOAD)
@@ -129,7 +151,10 @@ static struct HSS_Storage payloadStorage_ = {
     .readBlock = NULL,
     .writeBlock = NULL,
     .getInfo = NULL,
-    .flushWriteBuffer = NULL
+    .flushWriteBuffer = NULL,
+    .readBlockStart = NULL,
+    .writeBlockStart = NULL,
+    .isTransferComplete = NULL
 };
 #endif
 
@@ -246,13 +271,22 @@ bool tryBootFunction_(struct HSS_Storage *pStorage, HSS_GetBootImageFnPtr_t cons
 
     (void)decompressedFlag;
 
+    // boot image functions that stream chunks from storage will re-register their source
+    HSS_Register_Boot_Image_Source(NULL, 0u);
+
+#  if IS_ENABLED(CONFIG_CRYPTO_SIGNING)
+    // a streamed signature check of an earlier image, perhaps loaded to the same address,
+    // must not be taken for this one
+    HSS_Boot_Secure_StreamReset();
+#  endif
 
     result = bootImageFunction(pStorage, &pBootImage);
     //
     // check if this image is compressed...
     // if so, decompress it
     //
-    // for now, compression only works with a source already in DDR
+    // boot image functions that read from block storage decompress as they read, so
+    // this only handles compressed images whose source is already in memory
 #  if IS_ENABLED(CONFIG_COMPRESSION)
     if (result && pBootImage && (pBootImage->magic == mHSS_COMPRESSED_MAGIC)) {
         decompressedFlag = true;
@@ -310,10 +344,176 @@ static bool copyBootImageToDDR_(struct HSS_BootImage *pBootImage, char *pDest,
 
     mHSS_DEBUG_PRINTF(LOG_NORMAL, "Copying %lu bytes to 0x%lx\n",
         pBootImage->bootImageLength, pDest);
-    result = pCopyFunction(pDest, srcOffset, pBootImage->bootImageLength);
+
+#  if IS_ENABLED(CONFIG_CRYPTO_SIGNING)
+    //
+    // copy the image in pieces, and hash each piece while it is still cache-hot, rather
+    // than making a second pass over the entire image in DDR to check its signature
+    // later...
+    if (HSS_Boot_Secure_StreamBegin(pBootImage)) {
+        size_t const bootImageLength = pBootImage->bootImageLength;
+        size_t offset = 0u;
+
+        while (result && (offset < bootImageLength)) {
+            size_t const pieceSize = MIN(bootImageLength - offset, (size_t)BOOT_COPY_PIECE_SIZE);
+
+            result = pCopyFunction(pDest + offset, srcOffset + offset, pieceSize);
+            if (result) {
+                (void)HSS_Boot_Secure_StreamUpdate(pDest + offset, offset, pieceSize);
+            }
+
+            offset += pieceSize;
+        }
+
+        // a failed streamed check is not fatal here: the signature is checked again
+        // from DDR when the image is validated
+        (void)HSS_Boot_Secure_StreamEnd((struct HSS_BootImage *)pDest);
+    } else
+#  endif
+    {
+        result = pCopyFunction(pDest, srcOffset, pBootImage->bootImageLength);
+    }
+
+    return result;
+}
+
+#  if IS_ENABLED(CONFIG_COMPRESSION)
+static bool decompressBootImageToDDR_(struct HSS_Storage *pStorage, char *pDest, size_t srcOffset)
+{
+    bool result = false;
+
+    //
+    // rather than staging the compressed image in DDR and then decompressing it,
+    // decompress it directly from storage as it is read
+    mHSS_DEBUG_PRINTF(LOG_NORMAL, "Decompressing from %s to 0x%lx\n", pStorage->name, pDest);
+    int outputSize = HSS_Decompress_FromStorage(pStorage, srcOffset, pDest);
+    mHSS_DEBUG_PRINTF(LOG_NORMAL, "decompressed %d bytes ...\n", outputSize);
+
+    if (outputSize > 0) {
+        result = true;
+    }
+
+    return result;
+}
+#  endif
+
+#  if IS_ENABLED(CONFIG_SERVICE_BOOT_STREAMING)
+static bool copyBootImageHeaderToDDR_(struct HSS_BootImage *pBootImage, char *pDest,
+    size_t srcOffset, HSS_BootImageCopyFnPtr_t pCopyFunction)
+{
+    bool result = false;
+
+    printBootImageDetails_(pBootImage);
+
+    //
+    // headerLength covers the header and the chunk and ZI chunk tables, which is all
+    // that the boot service needs in DDR if chunks are streamed from storage
+    if ((pBootImage->headerLength < sizeof(struct HSS_BootImage))
+        || (pBootImage->headerLength > pBootImage->bootImageLength)
+        || (pBootImage->chunkTableOffset >= pBootImage->headerLength)
+        || (pBootImage->ziChunkTableOffset >= pBootImage->headerLength)) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "Invalid header length %lu\n", pBootImage->headerLength);
+    } else {
+        mHSS_DEBUG_PRINTF(LOG_NORMAL, "Copying %lu header bytes to 0x%lx\n",
+            pBootImage->headerLength, pDest);
+        result = pCopyFunction(pDest, srcOffset, pBootImage->headerLength);
+    }
 
     return result;
 }
+#  endif
+#endif
+
+#if IS_ENABLED(CONFIG_SERVICE_BOOT) && IS_ENABLED(CONFIG_SERVICE_MMC)
+static bool loadBootImageFromMMC_(struct HSS_Storage *pStorage, size_t srcOffset,
+    size_t maxByteCount, bool streamingAllowed, struct HSS_BootImage **ppBootImage)
+{
+    bool result = false;
+
+    mHSS_DEBUG_PRINTF(LOG_NORMAL, "Attempting to read image header (%d bytes) ...\n",
+        sizeof(struct HSS_BootImage));
+    result = HSS_MMC_ReadBlock(&bootImage, srcOffset,
+        sizeof(struct HSS_BootImage));
+
+    if (!result) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "HSS_MMC_ReadBlock() failed\n");
+    } else {
+        result = HSS_Boot_VerifyMagic(&bootImage);
+
+        if (!result) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "HSS_Boot_VerifyMagic() failed\n");
+        } else if (bootImage.bootImageLength > maxByteCount) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "bootImageLength 0x%lx exceeds partition size 0x%lx\n",
+                bootImage.bootImageLength, maxByteCount);
+            result = false;
+        } else {
+            int perf_ctr_index = PERF_CTR_UNINITIALIZED;
+            HSS_PerfCtr_Allocate(&perf_ctr_index, "Boot Image MMC Copy");
+
+#  if IS_ENABLED(CONFIG_COMPRESSION)
+            if (bootImage.magic == mHSS_COMPRESSED_MAGIC) {
+                result = decompressBootImageToDDR_(pStorage,
+                    (char *)(CONFIG_SERVICE_BOOT_DDR_TARGET_ADDR), srcOffset);
+            } else
+#  endif
+#  if IS_ENABLED(CONFIG_SERVICE_BOOT_MMC_STREAMING)
+            if (streamingAllowed && (bootImage.magic == mHSS_BOOT_MAGIC)) {
+                result = copyBootImageHeaderToDDR_(&bootImage,
+                    (char *)(CONFIG_SERVICE_BOOT_DDR_TARGET_ADDR), srcOffset,
+                    HSS_MMC_ReadBlock);
+
+                if (result) {
+                    HSS_Register_Boot_Image_Source(pStorage, srcOffset);
+                }
+            } else
+#  endif
+            {
+                result = copyBootImageToDDR_(&bootImage,
+                    (char *)(CONFIG_SERVICE_BOOT_DDR_TARGET_ADDR), srcOffset,
+                    HSS_MMC_ReadBlock);
+            }
+            *ppBootImage = (struct HSS_BootImage *)(CONFIG_SERVICE_BOOT_DDR_TARGET_ADDR);
+
+            HSS_PerfCtr_Lap(perf_ctr_index);
+
+            if (!result) {
+                 mHSS_DEBUG_PRINTF(LOG_ERROR, "copyBootImageToDDR_() failed\n");
+            }
+        }
+    }
+
+    return result;
+}
+
+#  if IS_ENABLED(CONFIG_SERVICE_BOOT_MMC_BOOT_PARTITION)
+//
+// boot images in eMMC hardware boot partitions are copied in full, rather than streamed,
+// so that the user data area can be selected again once done
+//
+struct MMCBootPartitionContext {
+    struct HSS_Storage *pStorage;
+    struct HSS_BootImage **ppBootImage;
+};
+
+static bool loadBootImageFromMMCBootPartition_(void *pContext,
+    enum HSS_MMC_HWPartition partition, size_t partitionSize)
+{
+    struct MMCBootPartitionContext * const pCtx = (struct MMCBootPartitionContext *)pContext;
+
+    (void)partition;
+
+    return loadBootImageFromMMC_(pCtx->pStorage, 0u, partitionSize, false, pCtx->ppBootImage)
+        && HSS_Boot_VerifyHeaderCrc(*pCtx->ppBootImage);
+}
+
+static bool getBootImageFromMMCBootPartition_(struct HSS_Storage *pStorage,
+    struct HSS_BootImage **ppBootImage)
+{
+    struct MMCBootPartitionContext ctx = { .pStorage = pStorage, .ppBootImage = ppBootImage };
+
+    return HSS_MMC_BootFromBootPartition(&bootImage, loadBootImageFromMMCBootPartition_, &ctx);
+}
+#  endif
 #endif
 
 static bool getBootImageFromMMC_(struct HSS_Storage *pStorage, struct HSS_BootImage **ppBootImage)
@@ -333,6 +533,12 @@ static bool getBootImageFromMMC_(struct HSS_Storage *pStorage, struct HSS_BootIm
     uint32_t blockSize, eraseSize, blockCount;
     pStorage->getInfo(&blockSize, &eraseSize, &blockCount);
 
+# if IS_ENABLED(CONFIG_SERVICE_BOOT_MMC_BOOT_PARTITION)
+    if (getBootImageFromMMCBootPartition_(pStorage, ppBootImage)) {
+        return true;
+    }
+# endif
+
 # if (IS_ENABLED(CONFIG_SERVICE_BOOT_MMC_USE_GPT))
     {
         HSS_GPT_t gpt;
@@ -373,36 +579,8 @@ static bool getBootImageFromMMC_(struct HSS_Storage *pStorage, struct HSS_BootIm
     //
     // Even if we have GPT enabled and it fails to find a GPT parttion, we'll still
     // try to boot
-    {
-        mHSS_DEBUG_PRINTF(LOG_NORMAL, "Attempting to read image header (%d bytes) ...\n",
-            sizeof(struct HSS_BootImage));
-        result = HSS_MMC_ReadBlock(&bootImage, srcLBAOffset * blockSize,
-            sizeof(struct HSS_BootImage));
-
-        if (!result) {
-            mHSS_DEBUG_PRINTF(LOG_ERROR, "HSS_MMC_ReadBlock() failed\n");
-        } else {
-            result = HSS_Boot_VerifyMagic(&bootImage);
-
-            if (!result) {
-                mHSS_DEBUG_PRINTF(LOG_ERROR, "HSS_Boot_VerifyMagic() failed\n");
-            } else {
-                int perf_ctr_index = PERF_CTR_UNINITIALIZED;
-                HSS_PerfCtr_Allocate(&perf_ctr_index, "Boot Image MMC Copy");
-
-                result = copyBootImageToDDR_(&bootImage,
-                    (char *)(CONFIG_SERVICE_BOOT_DDR_TARGET_ADDR), srcLBAOffset * blockSize,
-                    HSS_MMC_ReadBlock);
-                *ppBootImage = (struct HSS_BootImage *)(CONFIG_SERVICE_BOOT_DDR_TARGET_ADDR);
-
-                HSS_PerfCtr_Lap(perf_ctr_index);
-
-                if (!result) {
-                     mHSS_DEBUG_PRINTF(LOG_ERROR, "copyBootImageToDDR_() failed\n");
-                }
-            }
-        }
-    }
+    result = loadBootImageFromMMC_(pStorage, srcLBAOffset * blockSize, SIZE_MAX, true,
+        ppBootImage);
 #endif
 
     return result;
@@ -481,9 +659,17 @@ static bool getBootImageFromQSPI_(struct HSS_Storage *pStorage, struct HSS_BootI
             int perf_ctr_index = PERF_CTR_UNINITIALIZED;
             HSS_PerfCtr_Allocate(&perf_ctr_index, "Boot Image QSPI Copy");
 
-            result = copyBootImageToDDR_(&bootImage,
-                (char *)(CONFIG_SERVICE_BOOT_DDR_TARGET_ADDR), srcLBAOffset * blockSize,
-                HSS_QSPI_ReadBlock);
+#  if IS_ENABLED(CONFIG_COMPRESSION)
+            if (bootImage.magic == mHSS_COMPRESSED_MAGIC) {
+                result = decompressBootImageToDDR_(pStorage,
+                    (char *)(CONFIG_SERVICE_BOOT_DDR_TARGET_ADDR), srcLBAOffset * blockSize);
+            } else
+#  endif
+            {
+                result = copyBootImageToDDR_(&bootImage,
+                    (char *)(CONFIG_SERVICE_BOOT_DDR_TARGET_ADDR), srcLBAOffset * blockSize,
+                    HSS_QSPI_ReadBlock);
+            }
             *ppBootImage = (struct HSS_BootImage *)(CONFIG_SERVICE_BOOT_DDR_TARGET_ADDR);
 
             HSS_PerfCtr_Lap(perf_ctr_index);
@@ -493,6 +679,9 @@ static bool getBootImageFromQSPI_(struct HSS_Storage *pStorage, struct HSS_BootI
             }
         }
     }
+
+    // the boot image has been read, so hand the flash on in its default IO mode
+    HSS_QSPI_RestoreDefaultIOFormat();
 #endif
 
     return result;
@@ -546,18 +735,6 @@ void HSS_BootSelectPayload(void)
 #endif
 }
 
-#if IS_ENABLED(CONFIG_SERVICE_BOOT) && IS_ENABLED(CONFIG_SERVICE_SPI)
-static bool spiFlashReadBlock_(void *dst, size_t offs, size_t count) {
-   int retval = MSS_SYS_spi_copy((uintptr_t)dst, offs, count, /* options */ 3, /* mb_offset */ 0);
-
-   if (retval) {
-        mHSS_DEBUG_PRINTF(LOG_ERROR, "Failed to read 0x%lx bytes from SPI flash @0x%lx (error code %d)!\n", count, offs, retval);
-   }
-
-   return (retval == 0);
-}
-#endif
-
 static bool getBootImageFromSpiFlash_(struct HSS_Storage *pStorage, struct HSS_BootImage **ppBootImage) {
     bool result = false;
     (void)pStorage;
@@ -572,9 +749,7 @@ static bool getBootImageFromSpiFlash_(struct HSS_Storage *pStorage, struct HSS_B
     mHSS_DEBUG_PRINTF(LOG_NORMAL, "Attempting to read image header (%d bytes) ...\n",
         sizeof(struct HSS_BootImage));
 
-    MSS_SYS_select_service_mode(MSS_SYS_SERVICE_POLLING_MODE, NULL);
-
-    result = spiFlashReadBlock_(&bootImage, srcOffset, sizeof(struct HSS_BootImage));
+    result = HSS_SPI_ReadBlock(&bootImage, srcOffset, sizeof(struct HSS_BootImage));
     if (!result) {
         return false;
     }
@@ -584,9 +759,32 @@ static bool getBootImageFromSpiFlash_(struct HSS_Storage *pStorage, struct HSS_B
         return false;
     }
 
-    result = copyBootImageToDDR_(&bootImage, (char *)(CONFIG_SERVICE_BOOT_DDR_TARGET_ADDR),
-        srcOffset, spiFlashReadBlock_);
+    int perf_ctr_index = PERF_CTR_UNINITIALIZED;
+    HSS_PerfCtr_Allocate(&perf_ctr_index, "Boot Image SPI Copy");
+
+#  if IS_ENABLED(CONFIG_COMPRESSION)
+    if (bootImage.magic == mHSS_COMPRESSED_MAGIC) {
+        result = decompressBootImageToDDR_(pStorage,
+            (char *)(CONFIG_SERVICE_BOOT_DDR_TARGET_ADDR), srcOffset);
+    } else
+#  endif
+#  if IS_ENABLED(CONFIG_SERVICE_BOOT_SPI_STREAMING)
+    if (bootImage.magic == mHSS_BOOT_MAGIC) {
+        result = copyBootImageHeaderToDDR_(&bootImage,
+            (char *)(CONFIG_SERVICE_BOOT_DDR_TARGET_ADDR), srcOffset, HSS_SPI_ReadBlock);
+
+        if (result) {
+            HSS_Register_Boot_Image_Source(pStorage, srcOffset);
+        }
+    } else
+#  endif
+    {
+        result = copyBootImageToDDR_(&bootImage, (char *)(CONFIG_SERVICE_BOOT_DDR_TARGET_ADDR),
+            srcOffset, HSS_SPI_ReadBlock);
+    }
     *ppBootImage = (struct HSS_BootImage *)(CONFIG_SERVICE_BOOT_DDR_TARGET_ADDR);
+
+    HSS_PerfCtr_Lap(perf_ctr_index);
 #endif
 
     return result;
@@ -603,12 +801,6 @@ void HSS_BootSelectSPI(void)
 #endif
 }
 
-bool HSS_Storage_Init(void);
-bool HSS_Storage_ReadBlock(void *pDest, size_t srcOffset, size_t byteCount);
-bool HSS_Storage_WriteBlock(size_t dstOffset, void *pSrc, size_t byteCount);
-void HSS_Storage_GetInfo(uint32_t *pBlockSize, uint32_t *pEraseSize, uint32_t *pBlockCount);
-void HSS_Storage_FlushWriteBuffer(void);
-
 bool HSS_Storage_Init(void)
 {
     bool result = true;
@@ -646,10 +838,75 @@ bool HSS_Storage_WriteBlock(size_t dstOffset, void *pSrc, size_t byteCount)
 
     if (pStorage->writeBlock) {
         result = pStorage->writeBlock(dstOffset, pSrc, byteCount);
+    } else {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "%s is read-only, cannot write 0x%lx bytes @0x%lx\n",
+            pStorage->name, byteCount, dstOffset);
+        result = false;
     }
     return result;
 }
 
+//
+// background transfers fall back to synchronous ones on storage without them, in which
+// case the result is held until it is polled
+static struct {
+    bool async;
+    bool result;
+} storageTransfer_ = { false, true };
+
+bool HSS_Storage_ReadBlockStart(void *pDest, size_t srcOffset, size_t byteCount)
+{
+    struct HSS_Storage *pStorage = pDefaultStorage ? pDefaultStorage : pStorages[0];
+    assert(pStorage);
+
+    storageTransfer_.async = pStorage->readBlockStart && pStorage->isTransferComplete;
+
+    if (storageTransfer_.async) {
+        storageTransfer_.result = pStorage->readBlockStart(pDest, srcOffset, byteCount);
+        storageTransfer_.async = storageTransfer_.result;
+    } else {
+        storageTransfer_.result = HSS_Storage_ReadBlock(pDest, srcOffset, byteCount);
+    }
+
+    return storageTransfer_.result;
+}
+
+bool HSS_Storage_WriteBlockStart(size_t dstOffset, void *pSrc, size_t byteCount)
+{
+    struct HSS_Storage *pStorage = pDefaultStorage ? pDefaultStorage : pStorages[0];
+    assert(pStorage);
+
+    storageTransfer_.async = pStorage->writeBlockStart && pStorage->isTransferComplete;
+
+    if (storageTransfer_.async) {
+        storageTransfer_.result = pStorage->writeBlockStart(dstOffset, pSrc, byteCount);
+        storageTransfer_.async = storageTransfer_.result;
+    } else {
+        storageTransfer_.result = HSS_Storage_WriteBlock(dstOffset, pSrc, byteCount);
+    }
+
+    return storageTransfer_.result;
+}
+
+bool HSS_Storage_IsTransferComplete(bool *pResult)
+{
+    bool complete = true;
+
+    if (storageTransfer_.async) {
+        struct HSS_Storage *pStorage = pDefaultStorage ? pDefaultStorage : pStorages[0];
+        assert(pStorage);
+
+        complete = pStorage->isTransferComplete(&storageTransfer_.result);
+        storageTransfer_.async = !complete;
+    }
+
+    if (complete && pResult) {
+        *pResult = storageTransfer_.result;
+    }
+
+    return complete;
+}
+
 void HSS_Storage_GetInfo(uint32_t *pBlockSize, uint32_t *pEraseSize, uint32_t *pBlockCount)
 {
     struct HSS_Storage *pStorage = pDefaultStorage ? pDefaultStorage : pStorages[0];
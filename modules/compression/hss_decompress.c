@@ -41,10 +41,28 @@
 
 #include <assert.h>
 
-int HSS_Decompress(const void* pInputBuffer, void* pOutputBuffer)
+#define DECOMPRESS_INPUT_BUFFER_SIZE 4096u
+
+//
+// the decompressor state is ~11KiB, so keep it off the stack, and use tinfl
+// directly rather than mz_inflate(), as the latter needs malloc()
+static tinfl_decompressor decompressor_;
+static uint8_t inputBuffer_[DECOMPRESS_INPUT_BUFFER_SIZE] __attribute__((aligned(8)));
+
+struct DecompressInput {
+    uint8_t const *pNext;        // next compressed byte to hand to the inflater
+    size_t available;            // compressed bytes available at pNext
+    size_t remaining;            // compressed bytes not yet handed to the inflater
+    struct HSS_Storage *pStorage;// if non-NULL, source of further compressed input
+    size_t srcOffset;            // storage offset of the next input window
+    size_t windowSize;           // input window size, a multiple of storage block size
+    size_t blockSize;            // storage block size
+};
+
+static bool validateHeader_(struct HSS_CompressedImage const *pHdr)
 {
-    int result = 0;
-    struct HSS_CompressedImage compressedImageHdr = *(struct HSS_CompressedImage *)pInputBuffer;
+    bool result = false;
+    struct HSS_CompressedImage compressedImageHdr = *pHdr;
 
     if (compressedImageHdr.magic != mHSS_COMPRESSED_MAGIC) {
         mHSS_DEBUG_PRINTF(LOG_NORMAL, "Compressed Image is missing magic value (%08x vs %08x)\n",
@@ -61,16 +79,171 @@ int HSS_Decompress(const void* pInputBuffer, void* pOutputBuffer)
 
         if (originalCrc != compressedCrc) {
             mHSS_DEBUG_PRINTF(LOG_NORMAL, "Compressed Image failed CRC check\n");
+        } else if (!compressedImageHdr.originalImageLen
+            || (compressedImageHdr.originalImageLen > INT32_MAX)) {
+            mHSS_DEBUG_PRINTF(LOG_NORMAL, "Compressed Image has invalid original length %lu\n",
+                compressedImageHdr.originalImageLen);
         } else {
-            const uint8_t *pByteOffset = pInputBuffer;
-            pByteOffset += sizeof(struct HSS_CompressedImage);
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+static bool refillInput_(struct DecompressInput *pInput)
+{
+    bool result = false;
+
+    if (pInput->pStorage && pInput->remaining) {
+        size_t const readSize = MIN(pInput->windowSize, pInput->remaining);
+        size_t const blockAlignedReadSize = ((readSize + pInput->blockSize - 1u) / pInput->blockSize)
+            * pInput->blockSize;
+
+        result = pInput->pStorage->readBlock(inputBuffer_, pInput->srcOffset, blockAlignedReadSize);
+
+        if (!result) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "%s: failed to read compressed input at 0x%lx\n",
+                pInput->pStorage->name, pInput->srcOffset);
+        } else {
+            pInput->pNext = inputBuffer_;
+            pInput->available = readSize;
+            pInput->srcOffset += pInput->windowSize;
+        }
+    }
+
+    return result;
+}
+
+//
+// inflate a zlib stream, fetching further input from storage as the inflater consumes it,
+// so that reading the compressed image and decompressing it are interleaved.
+//
+// The compressed and original CRCs are accumulated in the same pass, over each piece of
+// input as it is consumed and each piece of output as it is produced, so that verifying
+// them needs no further sweep over the image
+static int inflate_(struct HSS_CompressedImage const *pHdr, struct DecompressInput *pInput,
+    void *pOutputBuffer)
+{
+    int result = 0;
+    uint8_t * const pOutStart = (uint8_t *)pOutputBuffer;
+    size_t const outCapacity = pHdr->originalImageLen;
+    size_t outTotal = 0u;
+    uint32_t compressedCrc = 0u;
+    uint32_t originalCrc = 0u;
+
+    mHSS_DEBUG_PRINTF(LOG_NORMAL, "Decompressing to %p\n", pOutputBuffer);
+
+    tinfl_init(&decompressor_);
+
+    while (true) {
+        if (!pInput->available && pInput->remaining) {
+            if (!refillInput_(pInput)) {
+                break;
+            }
+        }
+
+        size_t inBytes = pInput->available;
+        size_t outBytes = outCapacity - outTotal;
+        mz_uint32 const flags = TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF
+            | ((pInput->remaining > pInput->available) ? TINFL_FLAG_HAS_MORE_INPUT : 0u);
+
+        tinfl_status const status = tinfl_decompress(&decompressor_, pInput->pNext, &inBytes,
+            pOutStart, pOutStart + outTotal, &outBytes, flags);
+
+        compressedCrc = CRC32_calculate_ex(compressedCrc, pInput->pNext, inBytes);
+        originalCrc = CRC32_calculate_ex(originalCrc, pOutStart + outTotal, outBytes);
+
+        pInput->pNext += inBytes;
+        pInput->available -= inBytes;
+        pInput->remaining -= inBytes;
+        outTotal += outBytes;
+
+        if (status == TINFL_STATUS_DONE) {
+            if (pInput->remaining || (outTotal != outCapacity)) {
+                mHSS_DEBUG_PRINTF(LOG_ERROR, "Decompression length mismatch "
+                    "(%lu compressed bytes unused, %lu of %lu bytes output)\n",
+                    pInput->remaining, outTotal, outCapacity);
+            } else if (compressedCrc != pHdr->compressedCrc) {
+                mHSS_DEBUG_PRINTF(LOG_ERROR, "Compressed Image failed compressed CRC check "
+                    "(expected 0x%08x, got 0x%08x)\n", pHdr->compressedCrc, compressedCrc);
+            } else if (originalCrc != pHdr->originalCrc) {
+                mHSS_DEBUG_PRINTF(LOG_ERROR, "Compressed Image failed original CRC check "
+                    "(expected 0x%08x, got 0x%08x)\n", pHdr->originalCrc, originalCrc);
+            } else {
+                result = (int)outTotal;
+            }
+            break;
+        } else if ((status != TINFL_STATUS_NEEDS_MORE_INPUT) || !pInput->remaining) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "Decompression failed (status %d) after %lu bytes\n",
+                status, outTotal);
+            break;
+        }
+    }
+
+    return result;
+}
+
+int HSS_Decompress(const void* pInputBuffer, void* pOutputBuffer)
+{
+    int result = 0;
+    struct HSS_CompressedImage const *pHdr = (struct HSS_CompressedImage const *)pInputBuffer;
+
+    if (validateHeader_(pHdr)) {
+        struct DecompressInput input = {
+            .pNext = (uint8_t const *)pInputBuffer + sizeof(struct HSS_CompressedImage),
+            .available = pHdr->compressedImageLen,
+            .remaining = pHdr->compressedImageLen,
+            .pStorage = NULL,
+            .srcOffset = 0u,
+            .windowSize = 0u,
+            .blockSize = 0u
+        };
+
+        result = inflate_(pHdr, &input, pOutputBuffer);
+    }
+
+    return result;
+}
+
+int HSS_Decompress_FromStorage(struct HSS_Storage *pStorage, size_t srcOffset, void* pOutputBuffer)
+{
+    int result = 0;
+
+    assert(pStorage);
+    assert(pStorage->readBlock);
+    assert(pStorage->getInfo);
+
+    uint32_t blockSize, eraseSize, blockCount;
+    pStorage->getInfo(&blockSize, &eraseSize, &blockCount);
+
+    if (!blockSize || (blockSize > DECOMPRESS_INPUT_BUFFER_SIZE)) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "%s: unsupported block size %u\n", pStorage->name, blockSize);
+        return result;
+    }
+
+    //
+    // read whole storage blocks, the first of which begins with the compressed image header
+    size_t const windowSize = (DECOMPRESS_INPUT_BUFFER_SIZE / blockSize) * blockSize;
+
+    if (!pStorage->readBlock(inputBuffer_, srcOffset, windowSize)) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "%s: failed to read compressed image header\n", pStorage->name);
+    } else {
+        struct HSS_CompressedImage const compressedImageHdr = *(struct HSS_CompressedImage *)inputBuffer_;
 
-            mHSS_DEBUG_PRINTF(LOG_NORMAL, "Decompressing from %p to %p\n", pByteOffset, pOutputBuffer);
+        if (validateHeader_(&compressedImageHdr)) {
+            size_t const headerSize = sizeof(struct HSS_CompressedImage);
+            struct DecompressInput input = {
+                .pNext = inputBuffer_ + headerSize,
+                .available = MIN(windowSize - headerSize, compressedImageHdr.compressedImageLen),
+                .remaining = compressedImageHdr.compressedImageLen,
+                .pStorage = pStorage,
+                .srcOffset = srcOffset + windowSize,
+                .windowSize = windowSize,
+                .blockSize = blockSize
+            };
 
-            size_t decompressedOutputSize = (size_t)compressedImageHdr.originalImageLen;
-            result = mz_uncompress(
-                (void *)pOutputBuffer, &decompressedOutputSize,
-                (const void *)pByteOffset, (int)compressedImageHdr.compressedImageLen);
+            result = inflate_(&compressedImageHdr, &input, pOutputBuffer);
         }
     }
 
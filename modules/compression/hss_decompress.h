@@ -33,7 +33,18 @@
 extern "C" {
 #endif
 
+struct HSS_Storage;
+
+/*
+ * Decompress a compressed boot image to pOutputBuffer, returning the decompressed size
+ * in bytes, or zero on failure.
+ *
+ * HSS_Decompress() requires the entire compressed image to be in memory, whereas
+ * HSS_Decompress_FromStorage() reads the compressed image from storage at srcOffset
+ * piecemeal as it is decompressed.
+ */
 int HSS_Decompress(const void* pInputBuffer, void* pOutputBuffer);
+int HSS_Decompress_FromStorage(struct HSS_Storage *pStorage, size_t srcOffset, void* pOutputBuffer);
 
 #if defined (__cplusplus)
 }
@@ -0,0 +1,130 @@
+/******************************************************************************************
+ *
+ * MPFS HSS Embedded Software
+ *
+ * Copyright 2021-2026 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*\!
+ *\file Image Signing Crypto
+ *\brief Image Signing Crypto - backend selection
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_debug.h"
+
+#include "hss_crypto.h"
+#include "hss_crypto_backend.h"
+
+#include <assert.h>
+
+//
+// backends in order of preference: hardware first, then software fallback
+static const struct HSS_Crypto_Backend * const cryptoBackends_[] = {
+#if IS_ENABLED(CONFIG_CRYPTO_USER_CRYPTO)
+    &calCryptoBackend,
+#endif
+#if IS_ENABLED(CONFIG_CRYPTO_LIBECC)
+    &libeccCryptoBackend,
+#endif
+    NULL
+};
+
+static const struct HSS_Crypto_Backend *get_backend_(void)
+{
+    static const struct HSS_Crypto_Backend *pBackend = NULL;
+    static bool probed = false;
+
+    if (!probed) {
+        for (size_t i = 0u; cryptoBackends_[i] != NULL; i++) {
+            if (cryptoBackends_[i]->probe()) {
+                pBackend = cryptoBackends_[i];
+                mHSS_DEBUG_PRINTF(LOG_NORMAL, "Using %s for signature verification\n", pBackend->name);
+                break;
+            }
+        }
+
+        if (!pBackend) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "No crypto backend available\n");
+        }
+        probed = true;
+    }
+
+    return pBackend;
+}
+
+static const struct HSS_Crypto_Backend *pIncrementalBackend_ = NULL;
+
+bool HSS_Crypto_Verify_ECDSA_P384(const size_t siglen, uint8_t sigBuffer[siglen],
+    const size_t dataBufSize, uint8_t dataBuf[dataBufSize])
+{
+    bool result = false;
+    const struct HSS_Crypto_Backend *pBackend = get_backend_();
+
+    if (pBackend) {
+        result = pBackend->verify(siglen, sigBuffer, dataBufSize, dataBuf);
+    }
+
+    return result;
+}
+
+bool HSS_Crypto_Verify_ECDSA_P384_Init(const size_t siglen, uint8_t sigBuffer[siglen])
+{
+    bool result = false;
+    const struct HSS_Crypto_Backend *pBackend = get_backend_();
+
+    pIncrementalBackend_ = NULL;
+
+    if (pBackend && pBackend->verifyInit) {
+        result = pBackend->verifyInit(siglen, sigBuffer);
+        if (result) {
+            pIncrementalBackend_ = pBackend;
+        }
+    }
+
+    return result;
+}
+
+bool HSS_Crypto_Verify_ECDSA_P384_Update(const size_t dataBufSize, uint8_t const dataBuf[dataBufSize])
+{
+    bool result = false;
+
+    if (pIncrementalBackend_) {
+        result = pIncrementalBackend_->verifyUpdate(dataBufSize, dataBuf);
+    }
+
+    return result;
+}
+
+bool HSS_Crypto_Verify_ECDSA_P384_Finalize(void)
+{
+    bool result = false;
+
+    if (pIncrementalBackend_) {
+        result = pIncrementalBackend_->verifyFinalize();
+        pIncrementalBackend_ = NULL;
+    }
+
+    return result;
+}
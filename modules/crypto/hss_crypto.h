@@ -35,6 +35,15 @@ extern "C" {
 
 bool HSS_Crypto_Verify_ECDSA_P384(const size_t siglen, uint8_t sigBuffer[siglen], const size_t dataBufSize, uint8_t dataBuf[dataBufSize]);
 
+/*
+ * Incremental verification, for data that arrives piecewise: Init with the signature,
+ * Update with each piece of signed data in order, and Finalize to check the signature.
+ * Init fails if the selected crypto backend only supports one-pass verification.
+ */
+bool HSS_Crypto_Verify_ECDSA_P384_Init(const size_t siglen, uint8_t sigBuffer[siglen]);
+bool HSS_Crypto_Verify_ECDSA_P384_Update(const size_t dataBufSize, uint8_t const dataBuf[dataBufSize]);
+bool HSS_Crypto_Verify_ECDSA_P384_Finalize(void);
+
 #if defined (__cplusplus)
 }
 #endif
@@ -0,0 +1,58 @@
+#ifndef HSS_CRYPTO_BACKEND_H
+#define HSS_CRYPTO_BACKEND_H
+
+/*******************************************************************************
+ * Copyright 2021-2026 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *
+ * Hart Software Services - Image Signing Crypto Backends
+ *
+ */
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+/*
+ * Each crypto backend provides ECDSA P-384 signature verification over SHA-384. The
+ * incremental functions are optional, and may be NULL if the backend can only verify
+ * in one pass. hss_crypto.c dispatches to the first backend whose probe succeeds.
+ */
+struct HSS_Crypto_Backend {
+    char const * const name;
+    bool (* const probe)(void);
+    bool (* const verify)(const size_t siglen, uint8_t const sigBuffer[siglen],
+        const size_t dataBufSize, uint8_t const dataBuf[dataBufSize]);
+    bool (* const verifyInit)(const size_t siglen, uint8_t const sigBuffer[siglen]);
+    bool (* const verifyUpdate)(const size_t dataBufSize, uint8_t const dataBuf[dataBufSize]);
+    bool (* const verifyFinalize)(void);
+};
+
+extern const struct HSS_Crypto_Backend calCryptoBackend;
+extern const struct HSS_Crypto_Backend libeccCryptoBackend;
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif
@@ -35,6 +35,7 @@
 #include "hss_debug.h"
 
 #include "hss_crypto.h"
+#include "hss_crypto_backend.h"
 
 #include <assert.h>
 #include <string.h>
@@ -49,9 +50,10 @@
 #include "pkx.h"
 #include "utils.h"
 
-static void crypto_init_(void)
+static bool crypto_init_(void)
 {
     static bool initialized = false;
+    static bool result = false;
 
     if (!initialized) {
         (void)mss_config_clk_rst(MSS_PERIPH_CRYPTO, (uint8_t) 0, PERIPHERAL_ON);
@@ -63,9 +65,16 @@ static void crypto_init_(void)
         ATHENAREG->ATHENA_CR = SYSREG_ATHENACR_RESET | SYSREG_ATHENACR_RINGOSCON;
         ATHENAREG->ATHENA_CR = SYSREG_ATHENACR_RINGOSCON;
         SATR retval = CALIni();
-        assert(retval == SATR_SUCCESS);
+
+        if (retval != SATR_SUCCESS) {
+            mHSS_DEBUG_PRINTF(LOG_WARN, "User Crypto not available (%d)\n", retval);
+        } else {
+            result = true;
+        }
         initialized = true;
     }
+
+    return result;
 }
 
 // Required constants
@@ -107,12 +116,32 @@ const SATUINT32_t P384_npc[] = {
     0x00000001
 };
 
-bool HSS_Crypto_Verify_ECDSA_P384(const size_t siglen, uint8_t sigBuffer[siglen], const size_t dataBufSize, uint8_t dataBuf[dataBufSize])
+#define SHA384_DIGEST_SIZE  48
+#define PARAM_WORD_SIZE     12
+#define PUB_KEY_X_OFFSET    24
+
+//
+// the public key is converted to the endianness expected by the PK engine and validated
+// once, and then cached. The key and signature are converted in copies, rather than in
+// place, so that repeated verifications work
+static bool keyImported_ = false;
+static SATUINT32_t pubKeyX_[PARAM_WORD_SIZE];
+static SATUINT32_t pubKeyY_[PARAM_WORD_SIZE];
+
+static void cal_reverse_param_(SATUINT32_t *pParam)
+{
+    CALWordReverse(pParam, PARAM_WORD_SIZE);
+    CALByteReverseWord(pParam, PARAM_WORD_SIZE);
+}
+
+static bool cal_import_public_key_(void)
 {
     bool result = false;
     SATR retval;
 
-    crypto_init_();
+    if (keyImported_) {
+        return true;
+    }
 
     //
     // X5.09 ASN.1 DER keys are of the format
@@ -150,73 +179,101 @@ bool HSS_Crypto_Verify_ECDSA_P384(const size_t siglen, uint8_t sigBuffer[siglen]
 
     if (strncmp(x509_asn1_ec_der_p384_root, SECP384R1_ECDSA_public_key, ARRAY_SIZE(x509_asn1_ec_der_p384_root))) {
         mHSS_DEBUG_PRINTF(LOG_ERROR, "invalid signing certificate type\n");
-        result = false;
+        return false;
+    }
+
+    /* public key, after 24-byte header, is composed of (x, y) */
+    memcpy(pubKeyX_, &SECP384R1_ECDSA_public_key[PUB_KEY_X_OFFSET], sizeof(pubKeyX_));
+    memcpy(pubKeyY_, &SECP384R1_ECDSA_public_key[PUB_KEY_X_OFFSET + SHA384_DIGEST_SIZE],
+        sizeof(pubKeyY_));
+
+    /* adjust endian of Public Key X & Y components */
+    cal_reverse_param_(pubKeyX_);
+    cal_reverse_param_(pubKeyY_);
+
+    retval = CALECPtValidate(pubKeyX_, pubKeyY_, P384_b, P384_MOD, SAT_NULL, PARAM_WORD_SIZE);
+
+    if (retval == SATR_SUCCESS) {
+        retval = CALPKTrfRes(SAT_TRUE);
+        switch (retval) {
+        case SATR_SUCCESS:
+            keyImported_ = true;
+            result = true;
+            break;
+        case SATR_VALPARMX:
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "X parameter not in range\n");
+            break;
+        case SATR_VALPARMY:
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "Y parameter not in range\n");
+            break;
+        case SATR_VALPARMB:
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "B parameter greater than modulus\n");
+            break;
+        case SATR_VALIDATEFAIL:
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "public key is not on the curve\n");
+            break;
+        default:
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "public key validation returned %d\n", retval);
+            break;
+        }
     } else {
-#define SHA384_DIGEST_SIZE  48
-#define PARAM_WORD_SIZE     12
-#define PUB_KEY_X_OFFSET    24
-	    /* signature is composed of (r, s) */
-	uint32_t *sigR = (uint32_t *)&sigBuffer[0];
-	uint32_t *sigS = (uint32_t *)&sigBuffer[SHA384_DIGEST_SIZE];
-
-	/* public key, after 24-byte header, is composed of (x, y) */
-	uint32_t *pubKeyX = (uint32_t *)&(SECP384R1_ECDSA_public_key[PUB_KEY_X_OFFSET]);
-	uint32_t *pubKeyY = (uint32_t *)&(SECP384R1_ECDSA_public_key[PUB_KEY_X_OFFSET +
-				SHA384_DIGEST_SIZE]);
-
-	/* adjust endian of Public Key X & Y components */
-	CALWordReverse(pubKeyX, PARAM_WORD_SIZE);
-	CALByteReverseWord(pubKeyX, PARAM_WORD_SIZE);
-	CALWordReverse(pubKeyY, PARAM_WORD_SIZE);
-	CALByteReverseWord(pubKeyY, PARAM_WORD_SIZE);
-
-	/* adjust endian of Signature R and S components */
-	CALWordReverse(sigR, PARAM_WORD_SIZE);
-	CALByteReverseWord(sigR, PARAM_WORD_SIZE);
-	CALWordReverse(sigS, PARAM_WORD_SIZE);
-	CALByteReverseWord(sigS, PARAM_WORD_SIZE);
-
-	retval = CALECPtValidate(pubKeyX, pubKeyY, P384_b, P384_MOD, SAT_NULL,
-					PARAM_WORD_SIZE);
-
-	if (retval == SATR_SUCCESS) {
-		retval = CALPKTrfRes(SAT_TRUE);
-		switch (retval) {
-		case SATR_SUCCESS:
-			break;
-		case SATR_VALPARMX:
-			mHSS_DEBUG_PRINTF(LOG_NORMAL, "X parameter not in range \n");
-			break;
-		case SATR_VALPARMY:
-			mHSS_DEBUG_PRINTF(LOG_ERROR, "Y parameter not in range\n");
-			break;
-		case SATR_VALPARMB:
-			mHSS_DEBUG_PRINTF(LOG_ERROR, "B parameter greater than modulus\n");
-			break;
-		case SATR_VALIDATEFAIL:
-			mHSS_DEBUG_PRINTF(LOG_ERROR, "public key is not on the curve\n");
-			break;
-		}
-	} else {
-		mHSS_DEBUG_PRINTF(LOG_ERROR, "public key validation fail \r\n");
-	}
-
-	if (retval != SATR_SUCCESS) {
-		return result;
-	}
-
-	retval = CALECDSAVerifyHash((uint32_t *)&dataBuf[0], SATHASHTYPE_SHA384,
-			dataBufSize, P384_Gx, P384_Gy, pubKeyX, pubKeyY, sigR, sigS,
-			P384_b, P384_MOD, SAT_NULL, P384_n, P384_npc, PARAM_WORD_SIZE,
-			0, SAT_FALSE, X52CCR_DEFAULT);
-
-	if (retval == SATR_SUCCESS) {
-		retval = CALPKTrfRes(SAT_TRUE);
-		if (retval == SATR_SUCCESS) {
-			result = true;
-		}
-	}
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "public key validation fail\n");
     }
-    
+
     return result;
 }
+
+static bool cal_verify_(const size_t siglen, uint8_t const sigBuffer[siglen],
+    const size_t dataBufSize, uint8_t const dataBuf[dataBufSize])
+{
+    bool result = false;
+
+    /* signature is composed of (r, s) */
+    SATUINT32_t sigR[PARAM_WORD_SIZE];
+    SATUINT32_t sigS[PARAM_WORD_SIZE];
+
+    assert(siglen == 2 * SHA384_DIGEST_SIZE);
+    assert(dataBufSize <= UINT32_MAX);
+
+    if (cal_import_public_key_()) {
+        memcpy(sigR, &sigBuffer[0], sizeof(sigR));
+        memcpy(sigS, &sigBuffer[SHA384_DIGEST_SIZE], sizeof(sigS));
+
+        /* adjust endian of Signature R and S components */
+        cal_reverse_param_(sigR);
+        cal_reverse_param_(sigS);
+
+        //
+        // the message is hashed by the crypto engine, which optionally fetches it by DMA
+        SATR retval = CALECDSAVerifyHash((SATUINT32_t const *)&dataBuf[0], SATHASHTYPE_SHA384,
+            (SATUINT32_t)dataBufSize, P384_Gx, P384_Gy, pubKeyX_, pubKeyY_, sigR, sigS,
+            P384_b, P384_MOD, SAT_NULL, P384_n, P384_npc, PARAM_WORD_SIZE,
+            0, IS_ENABLED(CONFIG_CRYPTO_USER_CRYPTO_DMA) ? SAT_TRUE : SAT_FALSE, X52CCR_DEFAULT);
+
+        if (retval == SATR_SUCCESS) {
+            retval = CALPKTrfRes(SAT_TRUE);
+            if (retval == SATR_SUCCESS) {
+                result = true;
+            }
+        }
+    }
+
+    return result;
+}
+
+static bool cal_probe_(void)
+{
+    return crypto_init_();
+}
+
+//
+// CALECDSAVerifyHash() operates on the entire message in one pass, so incremental
+// verification is not supported by this backend
+const struct HSS_Crypto_Backend calCryptoBackend = {
+    .name = "User Crypto",
+    .probe = cal_probe_,
+    .verify = cal_verify_,
+    .verifyInit = NULL,
+    .verifyUpdate = NULL,
+    .verifyFinalize = NULL,
+};
@@ -36,6 +36,7 @@
 #include "hss_debug.h"
 
 #include "hss_crypto.h"
+#include "hss_crypto_backend.h"
 
 #include <string.h>
 #include <assert.h>
@@ -47,12 +48,25 @@
 #pragma GCC diagnostic pop
 
 #define ECDSA_P384_SIG_LEN ((384u/8)*2)
-bool HSS_Crypto_Verify_ECDSA_P384(const size_t siglen, uint8_t sigBuffer[siglen],
-    const size_t dataBufSize, uint8_t dataBuf[dataBufSize])
+
+//
+// the curve parameters and public key are fixed, so import them once and cache them,
+// rather than re-importing them for every verification
+static bool keyImported_ = false;
+static ec_params params_;
+static ec_pub_key pubKey_;
+static uint8_t sigLen_;
+
+static struct ec_verify_context verifyCtx_;
+static bool verifyInProgress_ = false;
+
+static bool import_public_key_(void)
 {
     bool result = false;
 
-    assert(siglen == ECDSA_P384_SIG_LEN);
+    if (keyImported_) {
+        return true;
+    }
 
     //
     // X5.09 ASN.1 DER keys are of the format
@@ -94,18 +108,12 @@ bool HSS_Crypto_Verify_ECDSA_P384(const size_t siglen, uint8_t sigBuffer[siglen]
         mHSS_DEBUG_PRINTF(LOG_ERROR, "invalid signing certificate type\n");
         result = false;
     } else {
-        uint8_t const * const aDataBuf = 0u;
-        const uint16_t aDataBufSize = 0u;
         uint8_t const curve_name[] = "SECP384R1";
         const ec_str_params *p_str_params = ec_get_curve_params_by_name(&curve_name[0], ARRAY_SIZE(curve_name));
 
-        ec_pub_key pub_key;
-        ec_params params;
-        uint8_t u8siglen;
+        import_params(&params_, p_str_params);
 
-        import_params(&params, p_str_params);
-
-        int retval = ec_get_sig_len(&params, ECDSA, SHA384, (uint8_t*)&u8siglen);
+        int retval = ec_get_sig_len(&params_, ECDSA, SHA384, (uint8_t*)&sigLen_);
 
         if (retval) {
             mHSS_DEBUG_PRINTF(LOG_ERROR, "ec_get_sig_len returned %d\n", retval);
@@ -113,13 +121,13 @@ bool HSS_Crypto_Verify_ECDSA_P384(const size_t siglen, uint8_t sigBuffer[siglen]
         } else {
             uint8_t crv_name_len = ARRAY_SIZE(curve_name);
 
-            retval = ec_check_curve_type_and_name(SECP384R1, params.curve_name, crv_name_len);
+            retval = ec_check_curve_type_and_name(SECP384R1, params_.curve_name, crv_name_len);
 
             if (retval) {
                 mHSS_DEBUG_PRINTF(LOG_ERROR, "ec_check_curve_type_and_name returned %d\n", retval);
                 result = false;
             } else {
-                retval = ec_pub_key_import_from_aff_buf(&pub_key, &params,
+                retval = ec_pub_key_import_from_aff_buf(&pubKey_, &params_,
                     (const uint8_t *)&SECP384R1_ECDSA_public_key[X509_ASN1_DER_KEY_OFFSET],
                     ARRAY_SIZE(SECP384R1_ECDSA_public_key) - X509_ASN1_DER_KEY_OFFSET, ECDSA);
 
@@ -127,10 +135,8 @@ bool HSS_Crypto_Verify_ECDSA_P384(const size_t siglen, uint8_t sigBuffer[siglen]
                     mHSS_DEBUG_PRINTF(LOG_ERROR, "ec_pub_key_import_from_aff_buf returned %d\n", retval);
                     result = false;
                 } else {
-                    int libecc_result = ec_verify(sigBuffer, u8siglen, &pub_key, dataBuf, dataBufSize,
-                        ECDSA, SHA384, aDataBuf, aDataBufSize);
-
-                    result = (libecc_result == 0) ? true : false;
+                    keyImported_ = true;
+                    result = true;
                 }
             }
         }
@@ -138,3 +144,87 @@ bool HSS_Crypto_Verify_ECDSA_P384(const size_t siglen, uint8_t sigBuffer[siglen]
 
     return result;
 }
+
+static bool libecc_verify_init_(const size_t siglen, uint8_t const sigBuffer[siglen])
+{
+    bool result = false;
+
+    assert(siglen == ECDSA_P384_SIG_LEN);
+
+    verifyInProgress_ = false;
+
+    if (import_public_key_()) {
+        uint8_t const * const aDataBuf = 0u;
+        const uint16_t aDataBufSize = 0u;
+
+        int retval = ec_verify_init(&verifyCtx_, &pubKey_, sigBuffer, sigLen_,
+            ECDSA, SHA384, aDataBuf, aDataBufSize);
+
+        if (retval) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "ec_verify_init returned %d\n", retval);
+        } else {
+            verifyInProgress_ = true;
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+static bool libecc_verify_update_(const size_t dataBufSize, uint8_t const dataBuf[dataBufSize])
+{
+    bool result = verifyInProgress_;
+    size_t offset = 0u;
+
+    while (result && (offset < dataBufSize)) {
+        // libecc takes 32-bit lengths
+        u32 const chunkSize = (u32)MIN(dataBufSize - offset, (size_t)0x80000000u);
+
+        if (ec_verify_update(&verifyCtx_, &dataBuf[offset], chunkSize)) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "ec_verify_update failed\n");
+            verifyInProgress_ = false;
+            result = false;
+        }
+
+        offset += chunkSize;
+    }
+
+    return result;
+}
+
+static bool libecc_verify_finalize_(void)
+{
+    bool result = false;
+
+    if (verifyInProgress_) {
+        verifyInProgress_ = false;
+        result = (ec_verify_finalize(&verifyCtx_) == 0) ? true : false;
+    }
+
+    return result;
+}
+
+static bool libecc_verify_(const size_t siglen, uint8_t const sigBuffer[siglen],
+    const size_t dataBufSize, uint8_t const dataBuf[dataBufSize])
+{
+    bool result = libecc_verify_init_(siglen, sigBuffer)
+        && libecc_verify_update_(dataBufSize, dataBuf)
+        && libecc_verify_finalize_();
+
+    return result;
+}
+
+static bool libecc_probe_(void)
+{
+    // software implementation, always available
+    return true;
+}
+
+const struct HSS_Crypto_Backend libeccCryptoBackend = {
+    .name = "libecc",
+    .probe = libecc_probe_,
+    .verify = libecc_verify_,
+    .verifyInit = libecc_verify_init_,
+    .verifyUpdate = libecc_verify_update_,
+    .verifyFinalize = libecc_verify_finalize_,
+};
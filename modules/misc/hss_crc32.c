@@ -18,6 +18,8 @@
 #include "hss_debug.h"
 #include "hss_crc32.h"
 
+#include <string.h>
+
 #if IS_ENABLED(CONFIG_CRC32_USE_PRECALC_TABLE)
 static const uint32_t precalcTable_[256] = {
     0x00000000u, 0x77073096u, 0xEE0E612Cu, 0x990951BAu, 0x076DC419u, 0x706AF48Fu,
@@ -98,6 +100,35 @@ static void CRC32_genTable_(void)
 }
 #endif
 
+#if IS_ENABLED(CONFIG_CRC32_SLICE_BY_16)
+#  define CRC32_NUM_SLICES 16u
+#elif IS_ENABLED(CONFIG_CRC32_SLICE_BY_8)
+#  define CRC32_NUM_SLICES 8u
+#endif
+
+#ifdef CRC32_NUM_SLICES
+// Slice-by-N tables: sliceTable_[k][i] is the CRC of byte i followed by k zero bytes,
+// so that N input bytes can be folded into the CRC with N independent lookups.
+// These are derived from the byte-wise table on first use, whether it is
+// precalculated or not, so they cost RAM but no eNVM
+static bool slice_initialized_ = false;
+static uint32_t sliceTable_[CRC32_NUM_SLICES][256];
+
+static void CRC32_genSliceTables_(void);
+static void CRC32_genSliceTables_(void)
+{
+	for (size_t i = 0u; i < 256u; i++) {
+		uint32_t crc = precalcTable_[i];
+
+		sliceTable_[0][i] = crc;
+		for (size_t slice = 1u; slice < CRC32_NUM_SLICES; slice++) {
+			crc = (crc >> 8) ^ precalcTable_[crc & 0xFFu];
+			sliceTable_[slice][i] = crc;
+		}
+	}
+}
+#endif
+
 #define CRC32_MASK (0xFFFFFFFFu)
 #define	CRC32_SEED (CRC32_MASK)
 
@@ -111,6 +142,30 @@ static inline uint32_t CRC32_updateByte(uint32_t crc32, const uint8_t byte)
     return crc32 & CRC32_MASK;
 }
 
+#ifdef CRC32_NUM_SLICES
+static inline uint32_t CRC32_updateSlices(uint32_t crc32, uint8_t const *pInput)
+{
+    uint32_t result = 0u;
+
+    // RISC-V is little-endian, so the first input byte is in the low bits of each word
+    for (size_t word = 0u; word < (CRC32_NUM_SLICES / 4u); word++) {
+        uint32_t value;
+        memcpy(&value, pInput + (word * 4u), sizeof(value));
+        if (!word) {
+            value ^= crc32;
+        }
+
+        size_t const slice = CRC32_NUM_SLICES - 1u - (word * 4u);
+        result ^= sliceTable_[slice][value & 0xFFu]
+            ^ sliceTable_[slice - 1u][(value >> 8) & 0xFFu]
+            ^ sliceTable_[slice - 2u][(value >> 16) & 0xFFu]
+            ^ sliceTable_[slice - 3u][value >> 24];
+    }
+
+    return result;
+}
+#endif
+
 uint32_t CRC32_calculate(uint8_t const *pInput, size_t numBytes)
 {
     uint32_t crc32 = 0u;
@@ -129,6 +184,28 @@ uint32_t CRC32_calculate_ex(uint32_t seed, uint8_t const *pInput, size_t numByte
     }
 #endif
 
+#ifdef CRC32_NUM_SLICES
+    if (!slice_initialized_) {
+        slice_initialized_ = true;
+        CRC32_genSliceTables_();
+    }
+
+    if (pInput != NULL) {
+        // byte-wise until word aligned, then N bytes at a time
+        while (numBytes && ((uintptr_t)pInput & 3u)) {
+            crc32 = CRC32_updateByte(crc32, *pInput);
+            ++pInput;
+            --numBytes;
+        }
+
+        while (numBytes >= CRC32_NUM_SLICES) {
+            crc32 = CRC32_updateSlices(crc32, pInput);
+            pInput += CRC32_NUM_SLICES;
+            numBytes -= CRC32_NUM_SLICES;
+        }
+    }
+#endif
+
     if (pInput != NULL) {
         while (numBytes--) {
             crc32 = CRC32_updateByte(crc32, *pInput);
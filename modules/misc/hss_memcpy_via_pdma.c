@@ -17,6 +17,7 @@
 #include "hss_types.h"
 #include "hss_debug.h"
 #include "hss_memcpy_via_pdma.h"
+#include "hss_state_machine.h"
 
 #include <assert.h>
 #include <string.h>
@@ -35,68 +36,298 @@ static char const * const pdmaErrorTable[] = {
 };
 #endif
 
-static void *do_memcpy_via_pdma_(void * restrict dest, void const * restrict src, size_t num_bytes);
-static void *do_memcpy_via_pdma_(void * restrict dest, void const * restrict src, size_t num_bytes)
+#define PDMA_SIZE_ALIGNMENT   16u
+#define PDMA_MIN_PIECE_SIZE   4096u // don't split small copies across channels
+
+#if IS_ENABLED(CONFIG_USE_PDMA)
+#  define PDMA_NUM_CHANNELS   MSS_PDMA_lAST_CHANNEL
+
+static struct {
+    struct MemcpyViaPdmaRequest *pOwner;
+    char *pDest;
+    char const *pSrc;
+    size_t byteCount;
+} pdmaChannel_[PDMA_NUM_CHANNELS] = { { NULL, NULL, NULL, 0u }, };
+#endif
+
+static struct MemcpyViaPdmaRequest *pQueueHead_ = NULL;
+static struct MemcpyViaPdmaRequest *pQueueTail_ = NULL;
+
+static void check_no_overlap_(void const *dest, void const *src, size_t num_bytes)
+{
+    // no overlaps allowed!!
+    char const *cDest = (char const *)dest;
+    char const *cSrc = (char const *)src;
+
+    if (cDest > cSrc) {
+        assert((cSrc + num_bytes -1) < cDest);
+    } else {
+        assert((cDest + num_bytes -1) < cSrc);
+    }
+
+    (void)cDest;
+    (void)cSrc;
+}
+
+#if IS_ENABLED(CONFIG_USE_PDMA)
+static bool start_channel_(mss_pdma_channel_id_t channel, char *pDest, char const *pSrc, size_t byteCount)
+{
+    uint8_t pdma_error_code = 0u;
+
+    mss_pdma_channel_config_t pdma_config = {
+        .src_addr = (size_t)pSrc,
+        .dest_addr = (size_t)pDest,
+        .num_bytes = byteCount,
+        .enable_done_int = 0,
+        .enable_err_int = 0,
+        .force_order = 0,
+        .repeat = 0u };
+
+    pdma_error_code = MSS_PDMA_setup_transfer(channel, &pdma_config);
+    if (pdma_error_code == 0) {
+        pdma_error_code = MSS_PDMA_start_transfer(channel);
+    }
+
+    if ((pdma_error_code != 0) && (pdma_error_code < ARRAY_SIZE(pdmaErrorTable))) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "PDMA Error: %s\n", pdmaErrorTable[pdma_error_code]);
+    }
+
+    return (pdma_error_code == 0);
+}
+#endif
+
+//
+// hand out the body of queued copies to free channels, in submission order.
+// Each copy is split evenly across the channels that are free, so that a single
+// large copy can use all of them
+static void dispatch_(void)
 {
-    void *result = NULL;
+    struct MemcpyViaPdmaRequest *pRequest = pQueueHead_;
 
 #if IS_ENABLED(CONFIG_USE_PDMA)
-    // num_bytes must be multiple of 16 or more
-    if (!(num_bytes & 0xFu)) {
-        uint8_t pdma_error_code = 0u;
-
-        mss_pdma_channel_config_t pdma_config_ch0 = {
-            .src_addr = (size_t)src,
-            .dest_addr = (size_t)dest,
-            .num_bytes = num_bytes,
-            .enable_done_int = 0,
-            .enable_err_int = 0,
-            .force_order = 0,
-            .repeat = 0u };
-
-        pdma_error_code = MSS_PDMA_setup_transfer(MSS_PDMA_CHANNEL_0, &pdma_config_ch0);
-        if (pdma_error_code == 0) {
-            pdma_error_code = MSS_PDMA_start_transfer(MSS_PDMA_CHANNEL_0);
-            if (pdma_error_code == 0) {
-                while (!MSS_PDMA_get_transfer_complete_status(MSS_PDMA_CHANNEL_0)) {
-                    ;
-                }
-                MSS_PDMA_clear_transfer_complete_status(MSS_PDMA_CHANNEL_0);
-            }
+    size_t freeChannels = 0u;
+    for (size_t channel = 0u; channel < ARRAY_SIZE(pdmaChannel_); channel++) {
+        if (!pdmaChannel_[channel].pOwner) { freeChannels++; }
+    }
+
+    for (size_t channel = 0u; (channel < ARRAY_SIZE(pdmaChannel_)) && freeChannels; channel++) {
+        if (pdmaChannel_[channel].pOwner) { continue; }
+
+        while (pRequest && !pRequest->bytesToSubmit) {
+            pRequest = pRequest->pNext;
         }
 
-        if (pdma_error_code != 0) {
-            if (pdma_error_code < ARRAY_SIZE(pdmaErrorTable)) {
-                mHSS_DEBUG_PRINTF(LOG_ERROR, "PDMA Error: %s\n", pdmaErrorTable[pdma_error_code]);
-            }
+        if (!pRequest) { break; }
+
+        size_t pieceSize = (pRequest->bytesToSubmit + freeChannels - 1u) / freeChannels;
+        pieceSize = (pieceSize + PDMA_SIZE_ALIGNMENT - 1u) & ~(PDMA_SIZE_ALIGNMENT - 1u);
+        if (pieceSize < PDMA_MIN_PIECE_SIZE) { pieceSize = PDMA_MIN_PIECE_SIZE; }
+        pieceSize = MIN(pieceSize, pRequest->bytesToSubmit);
+
+        if (start_channel_((mss_pdma_channel_id_t)channel, pRequest->pDest, pRequest->pSrc, pieceSize)) {
+            pdmaChannel_[channel].pOwner = pRequest;
+            pdmaChannel_[channel].pDest = pRequest->pDest;
+            pdmaChannel_[channel].pSrc = pRequest->pSrc;
+            pdmaChannel_[channel].byteCount = pieceSize;
+            pRequest->channelMask |= (1u << channel);
+            freeChannels--;
         } else {
-            result = dest;
+            // fall back to traditional memcpy()
+            memcpy(pRequest->pDest, pRequest->pSrc, pieceSize);
+        }
+
+        pRequest->pDest += pieceSize;
+        pRequest->pSrc += pieceSize;
+        pRequest->bytesToSubmit -= pieceSize;
+    }
+#else
+    // no PDMA, so fall back to traditional memcpy()
+    for ( ; pRequest; pRequest = pRequest->pNext) {
+        if (pRequest->bytesToSubmit) {
+            memcpy(pRequest->pDest, pRequest->pSrc, pRequest->bytesToSubmit);
+            pRequest->pDest += pRequest->bytesToSubmit;
+            pRequest->pSrc += pRequest->bytesToSubmit;
+            pRequest->bytesToSubmit = 0u;
         }
     }
 #endif
+}
 
-    if (!result) {
-        // fall back to traditional memcpy()
-        result = memcpy(dest, src, num_bytes);
+bool memcpy_via_pdma_async(struct MemcpyViaPdmaRequest *pRequest, void *dest, void const *src,
+    size_t num_bytes, memcpy_via_pdma_callback_t callback, void *pContext)
+{
+    assert(pRequest);
+
+    if (pRequest->pending) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "PDMA request %p already in progress\n", pRequest);
+        return false;
     }
 
-    return result;
+    if (num_bytes) {
+        check_no_overlap_(dest, src, num_bytes);
+    }
+
+    char *pDest = (char *)dest;
+    char const *pSrc = (char const *)src;
+
+    // copy any unaligned head and tail by CPU, so that the PDMA only ever sees
+    // an aligned destination and a size that is a multiple of 16 bytes
+    size_t const headBytes = MIN((size_t)(-(uintptr_t)pDest) & (PDMA_SIZE_ALIGNMENT - 1u), num_bytes);
+    size_t const bodyBytes = (num_bytes - headBytes) & ~(PDMA_SIZE_ALIGNMENT - 1u);
+    size_t const tailBytes = num_bytes - headBytes - bodyBytes;
+
+    if (headBytes) {
+        memcpy(pDest, pSrc, headBytes);
+    }
+
+    if (tailBytes) {
+        memcpy(pDest + headBytes + bodyBytes, pSrc + headBytes + bodyBytes, tailBytes);
+    }
+
+    pRequest->pDest = pDest + headBytes;
+    pRequest->pSrc = pSrc + headBytes;
+    pRequest->bytesToSubmit = bodyBytes;
+    pRequest->channelMask = 0u;
+    pRequest->callback = callback;
+    pRequest->pContext = pContext;
+    pRequest->pNext = NULL;
+    pRequest->pending = true;
+
+    if (pQueueTail_) {
+        pQueueTail_->pNext = pRequest;
+    } else {
+        pQueueHead_ = pRequest;
+    }
+    pQueueTail_ = pRequest;
+
+    dispatch_();
+
+    return true;
 }
 
-void *memcpy_via_pdma(void *dest, void const *src, size_t num_bytes)
+void memcpy_via_pdma_async_service(void)
 {
-    // no overlaps allowed!!
-    {
-        char *cDest = (char *)dest;
-        char const *cSrc = (char const *)src;
+    if (!pQueueHead_) { return; }
+
+#if IS_ENABLED(CONFIG_USE_PDMA)
+    for (size_t channel = 0u; channel < ARRAY_SIZE(pdmaChannel_); channel++) {
+        struct MemcpyViaPdmaRequest * const pOwner = pdmaChannel_[channel].pOwner;
+
+        if (!pOwner) { continue; }
+
+        if (MSS_PDMA_get_transfer_error_status((mss_pdma_channel_id_t)channel)) {
+            MSS_PDMA_clear_transfer_error_status((mss_pdma_channel_id_t)channel);
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "PDMA Error: channel %lu transfer failed\n", channel);
 
-        if (cDest > cSrc) {
-            assert((cSrc + num_bytes -1) < cDest);
+            // fall back to traditional memcpy()
+            memcpy(pdmaChannel_[channel].pDest, pdmaChannel_[channel].pSrc,
+                pdmaChannel_[channel].byteCount);
+        } else if (MSS_PDMA_get_transfer_complete_status((mss_pdma_channel_id_t)channel)) {
+            MSS_PDMA_clear_transfer_complete_status((mss_pdma_channel_id_t)channel);
         } else {
-            assert((cDest + num_bytes -1) < cSrc);
+            continue;
         }
+
+        pOwner->channelMask &= ~(1u << channel);
+        pdmaChannel_[channel].pOwner = NULL;
+    }
+#endif
+
+    dispatch_();
+
+    //
+    // retire finished requests, and only then run their callbacks, so that
+    // a callback is free to resubmit its request
+    struct MemcpyViaPdmaRequest *pFinished = NULL;
+    struct MemcpyViaPdmaRequest **ppFinishedTail = &pFinished;
+    struct MemcpyViaPdmaRequest **ppRequest = &pQueueHead_;
+    pQueueTail_ = NULL;
+
+    while (*ppRequest) {
+        struct MemcpyViaPdmaRequest * const pRequest = *ppRequest;
+
+        if (!pRequest->bytesToSubmit && !pRequest->channelMask) {
+            *ppRequest = pRequest->pNext;
+            pRequest->pNext = NULL;
+            *ppFinishedTail = pRequest;
+            ppFinishedTail = &pRequest->pNext;
+        } else {
+            pQueueTail_ = pRequest;
+            ppRequest = &pRequest->pNext;
+        }
+    }
+
+    while (pFinished) {
+        struct MemcpyViaPdmaRequest * const pRequest = pFinished;
+        pFinished = pRequest->pNext;
+
+        pRequest->pNext = NULL;
+        pRequest->pending = false;
+        if (pRequest->callback) {
+            pRequest->callback(pRequest->pContext);
+        }
+    }
+}
+
+/*!
+ * \brief PDMA Copy Engine State Machine
+ *
+ * Detects completed copies, and hands queued copies to channels as they free up, once
+ * per superloop iteration
+ */
+static void memcpy_via_pdma_service_handler(struct StateMachine * const pMyMachine);
+
+enum MemcpyViaPdmaStatesEnum {
+    MEMCPY_VIA_PDMA_SERVICING,
+    MEMCPY_VIA_PDMA_NUM_STATES = MEMCPY_VIA_PDMA_SERVICING+1
+};
+
+static const struct StateDesc memcpy_via_pdma_state_descs[] = {
+    { (const stateType_t)MEMCPY_VIA_PDMA_SERVICING, (const char *)"Servicing", NULL, NULL, &memcpy_via_pdma_service_handler },
+};
+
+struct StateMachine memcpy_via_pdma_service = {
+    .state             = (stateType_t)MEMCPY_VIA_PDMA_SERVICING,
+    .prevState         = (stateType_t)SM_INVALID_STATE,
+    .numStates         = (const uint32_t)MEMCPY_VIA_PDMA_NUM_STATES,
+    .pMachineName      = (const char *)"memcpy_via_pdma_service",
+    .startTime         = 0u,
+    .lastExecutionTime = 0u,
+    .executionCount    = 0u,
+    .pStateDescs       = memcpy_via_pdma_state_descs,
+    .debugFlag         = false,
+    .priority          = 0u,
+    .pInstanceData     = NULL
+};
+
+static void memcpy_via_pdma_service_handler(struct StateMachine * const pMyMachine)
+{
+    (void)pMyMachine;
+
+    memcpy_via_pdma_async_service();
+}
+
+bool memcpy_via_pdma_async_poll(struct MemcpyViaPdmaRequest *pRequest)
+{
+    assert(pRequest);
+
+    if (pRequest->pending) {
+        memcpy_via_pdma_async_service();
     }
 
+    return !pRequest->pending;
+}
+
+void *memcpy_via_pdma(void *dest, void const *src, size_t num_bytes)
+{
+    struct MemcpyViaPdmaRequest request = { .pending = false };
+
     //mHSS_DEBUG_PRINTF(LOG_NORMAL, "Copy from %p to %p (%x bytes)\n", src, dest, num_bytes);
-    return do_memcpy_via_pdma_(dest, src, num_bytes);
+    if (memcpy_via_pdma_async(&request, dest, src, num_bytes, NULL, NULL)) {
+        while (!memcpy_via_pdma_async_poll(&request)) {
+            ;
+        }
+    }
+
+    return dest;
 }
@@ -32,6 +32,23 @@ typedef bool (*CheckIfGUIDMatchFnPtr_t)(HSS_GPT_PartitionEntry_t const * const p
 
 static ReadBlockFnPtr_t readBlockFnPtr;
 
+//
+// the partition entry array of the most recently loaded GPT, 32KiB for 256 entries of
+// 128 bytes, and the indices of its entries in use
+static uint8_t partitionEntries_[GPT_MAX_NUM_PARTITIONS * GPT_MAX_SIZE_OF_PARTITION_ENTRY]
+    __attribute__((aligned(8)));
+static uint8_t usedPartitionIndex_[GPT_MAX_NUM_PARTITIONS];
+_Static_assert(GPT_MAX_NUM_PARTITIONS <= 256u, "partition indices must fit in usedPartitionIndex_");
+static size_t numUsedPartitions_ = 0u;
+static HSS_GPT_t const *pLoadedGpt_ = NULL;
+
+static const HSS_GPT_GUID_t nullGUID = {
+    .data1 = 0u,
+    .data2 = 0u,
+    .data3 = 0u,
+    .data4 = 0u
+};
+
 //
 // local module function prototypes
 static bool CheckIfGUIDMatch_(HSS_GPT_GUID_t const * const pGUID1,
@@ -50,15 +67,6 @@ static bool FindPartitionById_(HSS_GPT_t const * const pGpt,
 // Debug Routines
 //
 
-#ifdef GPT_DEBUG
-static const HSS_GPT_GUID_t nullGUID = {
-    .data1 = 0u,
-    .data2 = 0u,
-    .data3 = 0u,
-    .data4 = 0u
-};
-#endif
-
 
 //
 //
@@ -211,6 +219,9 @@ bool GPT_ReadHeader(HSS_GPT_t *pGpt)
 
     bool result = false;
 
+    pLoadedGpt_ = NULL;
+    pGpt->partitionEntriesValid = false;
+
     result = readBlockFnPtr(pGpt->h.buffer, 1u * pGpt->lbaSize, pGpt->lbaSize);
     if (!result) {
         mHSS_DEBUG_PRINTF(LOG_ERROR, "Unable to read block for LBA 1\n");
@@ -222,46 +233,60 @@ bool GPT_ReadHeader(HSS_GPT_t *pGpt)
 }
 
 //
+// The partition entry array is read once, in a single transfer, and kept in memory for
+// the lookups that follow. The entries in use are indexed, so that searches by GUID only
+// need to visit those
 //
-//
-static HSS_GPT_PartitionEntry_t const * ReadPartitionEntryIntoBuffer_(HSS_GPT_t const * const pGpt,
-    size_t lbaIndex, size_t partitionIndex)
+static HSS_GPT_PartitionEntry_t const *GetPartitionEntry_(size_t const partitionIndex)
+{
+    return (HSS_GPT_PartitionEntry_t const *)(partitionEntries_
+        + (partitionIndex * pLoadedGpt_->h.header.sizeOfPartitionEntry));
+}
+
+static bool LoadPartitionEntries_(HSS_GPT_t const * const pGpt)
 {
     assert(readBlockFnPtr != NULL);
-    assert(pGpt!= NULL);
+    assert(pGpt != NULL);
 
     HSS_GPT_Header_t const * const pGptHeader = &(pGpt->h.header);
-    uint8_t const * const pLBABuffer = pGpt->lbaBuffer;
+    bool result = (pLoadedGpt_ == pGpt);
 
-    HSS_GPT_PartitionEntry_t *pResult = NULL;
-    bool retVal = false;
+    if (result) {
+        ;
+    } else if (pGptHeader->numPartitions > GPT_MAX_NUM_PARTITIONS) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "GPT numPartitions %u exceeds maximum %u\n",
+            pGptHeader->numPartitions, GPT_MAX_NUM_PARTITIONS);
+    } else if (pGptHeader->sizeOfPartitionEntry > GPT_MAX_SIZE_OF_PARTITION_ENTRY) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "GPT sizeOfPartitionEntry %u exceeds maximum %u\n",
+            pGptHeader->sizeOfPartitionEntry, GPT_MAX_SIZE_OF_PARTITION_ENTRY);
+    } else {
+        size_t byteCount = pGptHeader->numPartitions * pGptHeader->sizeOfPartitionEntry;
+        if (byteCount % pGpt->lbaSize) {
+            byteCount = ((byteCount / pGpt->lbaSize) + 1u) * pGpt->lbaSize;
+        }
 
-    const size_t offset =
-        (pGptHeader->sizeOfPartitionEntry * partitionIndex) -
-            ((lbaIndex - pGptHeader->partitionEntriesStartingLBA) * pGpt->lbaSize);
+        result = !byteCount || readBlockFnPtr(partitionEntries_,
+            pGptHeader->partitionEntriesStartingLBA * pGpt->lbaSize, byteCount);
 
-    retVal = readBlockFnPtr((void *)pLBABuffer, lbaIndex * pGpt->lbaSize, pGpt->lbaSize);
-    if (!retVal) {
-        mHSS_DEBUG_PRINTF(LOG_ERROR,
-            "Unable to read block for LBA %lu (partition entry %lu)\n",
-            lbaIndex, partitionIndex);
-    } else {
-        if (offset >= pGpt->lbaSize) {
-            retVal = readBlockFnPtr((void *)(pLBABuffer + pGpt->lbaSize),
-                (lbaIndex + 1u) * pGpt->lbaSize, pGpt->lbaSize);
-            if (!retVal) {
-                mHSS_DEBUG_PRINTF(LOG_ERROR,
-                    "Unable to read block for LBA %lu (partition entry %lu)\n",
-                    lbaIndex, partitionIndex);
+        if (!result) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "Unable to read %lu bytes of partition entries at LBA %lu\n",
+                byteCount, pGptHeader->partitionEntriesStartingLBA);
+        } else {
+            pLoadedGpt_ = pGpt;
+            numUsedPartitions_ = 0u;
+
+            for (size_t partitionIndex = 0u; partitionIndex < pGptHeader->numPartitions;
+                partitionIndex++) {
+                if (!CheckIfGUIDMatch_(&(GetPartitionEntry_(partitionIndex)->partitionTypeGUID),
+                    &nullGUID)) {
+                    usedPartitionIndex_[numUsedPartitions_] = (uint8_t)partitionIndex;
+                    numUsedPartitions_++;
+                }
             }
         }
     }
 
-    if (retVal) {
-        pResult = (HSS_GPT_PartitionEntry_t *)(pLBABuffer + offset);
-    }
-
-    return pResult;;
+    return result;
 }
 
 //
@@ -322,20 +347,12 @@ bool GPT_PartitionIdToLBAOffset(HSS_GPT_t const * const pGpt, size_t partitionIn
     assert(pGpt != NULL);
     assert(pFirstLBA != NULL);
 
-    HSS_GPT_Header_t const * const pGptHeader = &(pGpt->h.header);
-
-    const size_t lbaIndex = pGptHeader->partitionEntriesStartingLBA +
-        ((partitionIndex * pGptHeader->sizeOfPartitionEntry) / pGpt->lbaSize);
-
-    HSS_GPT_PartitionEntry_t const * const pGptPartitionEntry =
-        ReadPartitionEntryIntoBuffer_(pGpt, lbaIndex, partitionIndex);
+    HSS_GPT_PartitionEntry_t const * pGptPartitionEntry;
 
-    if (pGptPartitionEntry != NULL) {
-        result = partitionIndex < pGptHeader->numPartitions;
+    result = GPT_ReadPartitionEntryByIndex(pGpt, partitionIndex, &pGptPartitionEntry);
 
-        if (result) {
-            *pFirstLBA = pGptPartitionEntry->firstLBA;
-        }
+    if (result) {
+        *pFirstLBA = pGptPartitionEntry->firstLBA;
     }
 
     return result;
@@ -352,15 +369,13 @@ bool GPT_ReadPartitionEntryByIndex(HSS_GPT_t const * const pGpt,
     assert(pGpt != NULL);
     assert(ppGptPartitionEntryOut != NULL);
 
-    // Read Partition Entries
-    HSS_GPT_Header_t const * const pGptHeader = &(pGpt->h.header);
-    const size_t lbaIndex = pGptHeader->partitionEntriesStartingLBA +
-        ((partitionIndex * pGptHeader->sizeOfPartitionEntry) / pGpt->lbaSize);
+    result = LoadPartitionEntries_(pGpt) && (partitionIndex < pGpt->h.header.numPartitions);
 
-    *ppGptPartitionEntryOut =
-        ReadPartitionEntryIntoBuffer_(pGpt, lbaIndex, partitionIndex);
-
-    result = (*ppGptPartitionEntryOut != NULL);
+    if (result) {
+        *ppGptPartitionEntryOut = GetPartitionEntry_(partitionIndex);
+    } else {
+        *ppGptPartitionEntryOut = NULL;
+    }
 
     return result;
 }
@@ -380,24 +395,18 @@ static bool FindPartitionById_(HSS_GPT_t const * const pGpt,
     assert(pPartitionIndex != NULL);
     assert(pCheckIfMatchFunc != NULL);
 
-    HSS_GPT_Header_t const * const pGptHeader = &(pGpt->h.header);
-
-    if (pGptHeader->numPartitions > GPT_MAX_NUM_PARTITIONS) {
-        mHSS_DEBUG_PRINTF(LOG_ERROR, "GPT numPartitions %u exceeds maximum %u\n",
-            pGptHeader->numPartitions, GPT_MAX_NUM_PARTITIONS);
+    if (!LoadPartitionEntries_(pGpt)) {
         return false;
     }
 
     //
-    // Read Partition Entries
-    for (size_t partitionIndex = 0u; partitionIndex < pGptHeader->numPartitions;
-        partitionIndex++) {
-        HSS_GPT_PartitionEntry_t const * pPartitionEntry;
-	if (!(GPT_ReadPartitionEntryByIndex(pGpt, partitionIndex, &pPartitionEntry)
-            || (pPartitionEntry == NULL))) {
-            result = false;
-            break;
-        }
+    // unused partition entries are all zeros, so only a search for the null GUID needs
+    // to visit them
+    bool const searchAll = CheckIfGUIDMatch_(pGUID, &nullGUID);
+    size_t const numCandidates = searchAll ? pGpt->h.header.numPartitions : numUsedPartitions_;
+
+    for (size_t i = 0u; i < numCandidates; i++) {
+        size_t const partitionIndex = searchAll ? i : usedPartitionIndex_[i];
 
         // if we've passed the starting LBA of this parameter into the search, we already know
         // about it so look for another...
@@ -406,8 +415,9 @@ static bool FindPartitionById_(HSS_GPT_t const * const pGpt,
             mHSS_DEBUG_PRINTF(LOG_NORMAL, "Skipping partition %lu\n", partitionIndex);
 #endif
             continue;
-	}
+        }
 
+        HSS_GPT_PartitionEntry_t const * const pPartitionEntry = GetPartitionEntry_(partitionIndex);
         result = pCheckIfMatchFunc(pPartitionEntry, pGUID);
 
         if (result) {
@@ -459,51 +469,38 @@ bool GPT_FindPartitionByUniqueId(HSS_GPT_t const * const pGpt,
 bool GPT_ValidatePartitionEntries(HSS_GPT_t *pGpt)
 {
     bool result = true;
-    uint32_t rollingCrc = 0u;
+    uint32_t crc = 0u;
 
     assert(pGpt != NULL);
 
     HSS_GPT_Header_t const * const pGptHeader = &(pGpt->h.header);
 
-    //
-    // Read Partition Entries
-    for (size_t partitionIndex = 0; partitionIndex < pGptHeader->numPartitions;
-        partitionIndex++) {
-        const size_t lbaIndex = pGptHeader->partitionEntriesStartingLBA +
-            ((partitionIndex * pGptHeader->sizeOfPartitionEntry) / pGpt->lbaSize);
+    result = LoadPartitionEntries_(pGpt);
 
+#ifdef GPT_DEBUG
+    for (size_t i = 0u; result && (i < numUsedPartitions_); i++) {
         HSS_GPT_PartitionEntry_t const * const pGptPartitionEntry =
-            ReadPartitionEntryIntoBuffer_(pGpt, lbaIndex, partitionIndex);
-        if (!pGptPartitionEntry) {
-            result = false;
-            break;
-        }
+            GetPartitionEntry_(usedPartitionIndex_[i]);
 
-#ifdef GPT_DEBUG
-        if ((CheckIfGUIDMatch_(&nullGUID, &(pGptPartitionEntry->uniquePartitionGUID)))
-            || (CheckIfGUIDMatch_(&nullGUID, &(pGptPartitionEntry->uniquePartitionGUID)))) {
-            // skip debug output if null
-        } else {
-            mHSS_DEBUG_PRINTF(LOG_NORMAL, "Found partition:\n");
-            HSS_GPT_GUID_t const * pGUID = &(pGptPartitionEntry->uniquePartitionGUID);
-            mHSS_DEBUG_PRINTF(LOG_NORMAL, " - Unique GUID: %08x-%04x-%04x-%016lx\n",
-                pGUID->data1, pGUID->data2, pGUID->data3, __builtin_bswap64(pGUID->data4));
+        mHSS_DEBUG_PRINTF(LOG_NORMAL, "Found partition:\n");
+        HSS_GPT_GUID_t const * pGUID = &(pGptPartitionEntry->uniquePartitionGUID);
+        mHSS_DEBUG_PRINTF(LOG_NORMAL, " - Unique GUID: %08x-%04x-%04x-%016lx\n",
+            pGUID->data1, pGUID->data2, pGUID->data3, __builtin_bswap64(pGUID->data4));
 
-            pGUID = &(pGptPartitionEntry->partitionTypeGUID);
-            mHSS_DEBUG_PRINTF(LOG_NORMAL, " - Type GUID:   %08x-%04x-%04x-%016lx\n",
-                pGUID->data1, pGUID->data2, pGUID->data3, __builtin_bswap64(pGUID->data4));
-        }
-#endif
-        rollingCrc = CRC32_calculate_ex(rollingCrc, (uint8_t const *)pGptPartitionEntry,
-            pGptHeader->sizeOfPartitionEntry);
+        pGUID = &(pGptPartitionEntry->partitionTypeGUID);
+        mHSS_DEBUG_PRINTF(LOG_NORMAL, " - Type GUID:   %08x-%04x-%04x-%016lx\n",
+            pGUID->data1, pGUID->data2, pGUID->data3, __builtin_bswap64(pGUID->data4));
     }
+#endif
 
     if (result) {
-        result = (rollingCrc == pGptHeader->partitionEntriesArrayCrc32);
+        crc = CRC32_calculate(partitionEntries_,
+            pGptHeader->numPartitions * pGptHeader->sizeOfPartitionEntry);
+        result = (crc == pGptHeader->partitionEntriesArrayCrc32);
 
         if (!result) {
             mHSS_DEBUG_PRINTF(LOG_ERROR, "CRC32 of partition entries is %08x, vs expected %08x\n",
-                rollingCrc, pGptHeader->partitionEntriesArrayCrc32);
+                crc, pGptHeader->partitionEntriesArrayCrc32);
         } else {
             mHSS_DEBUG_PRINTF(LOG_NORMAL, "Validated GPT Partition Entries ...\n");
             pGpt->partitionEntriesValid = true;
@@ -566,6 +563,7 @@ void GPT_Init(HSS_GPT_t *pGpt, struct HSS_Storage *pStorage)
     assert(pGpt);
     assert(pStorage);
     readBlockFnPtr = pStorage->readBlock;
+    pLoadedGpt_ = NULL;
 
     pGpt->headerValid = false;
     pGpt->partitionEntriesValid = false;
@@ -39,7 +39,7 @@ extern "C" {
 #endif
 
 #define GPT_MIN_HEADER_SIZE 92
-#define GPT_MAX_NUM_PARTITIONS 128u
+#define GPT_MAX_NUM_PARTITIONS 256u
 #define GPT_MAX_SIZE_OF_PARTITION_ENTRY 128u
 
 typedef struct HSS_GPT_GUID_s {
@@ -75,8 +75,6 @@ typedef struct HSS_GPT_s {
         HSS_GPT_Header_t header;
         uint8_t buffer[GPT_MAX_LBA_SIZE] __attribute__((aligned(8)));
     } h;
-    // For now, GPT needs a 2-sector buffer (~1KB) - for partition entity
-    uint8_t lbaBuffer[2 * GPT_MAX_LBA_SIZE] __attribute__((aligned(8)));
     size_t bootPartitionIndex;
     size_t lbaSize;
 
@@ -0,0 +1,228 @@
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/*!
+ * \file  Boot Service - Chunk Download
+ * \brief Boot Service - sizing sub-chunks, checking chunks, and reading boot image chunks
+ * from a storage provider
+ *
+ * This has no hardware dependencies beyond the storage provider it is given, so that
+ * streamed downloads can be checked against a stand-in storage provider on the host.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_debug.h"
+#include "hss_crc32.h"
+
+#include <string.h>
+
+#include "hss_boot_download.h"
+
+//
+// the time taken by a sub-chunk is measured from issuing its read to the read completing,
+// so halve the next sub-chunk if it took longer than the budget, and double it if it took
+// less than half of the budget
+size_t HSS_BootDownload_AdaptSubChunkSize(size_t subChunkSize, HSSTicks_t elapsed,
+    HSSTicks_t budget, size_t minSize, size_t maxSize)
+{
+    if (elapsed > budget) {
+        if ((subChunkSize / 2u) >= minSize) {
+            subChunkSize /= 2u;
+        } else {
+            subChunkSize = minSize;
+        }
+    } else if ((elapsed * 2u) < budget) {
+        if (subChunkSize <= (maxSize / 2u)) {
+            subChunkSize *= 2u;
+        }
+    }
+
+    return subChunkSize;
+}
+
+uint32_t HSS_BootDownload_UpdateChunkCrc(struct HSS_BootChunkDesc const *pChunk, uint32_t crc,
+    ptrdiff_t subChunkOffset, size_t subChunkSize)
+{
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_VERIFY_CHUNK_CRC)
+    // checksum the sub-chunk at its destination, while it is still hot in cache
+    crc = CRC32_calculate_ex(crc,
+        (uint8_t const *)((uintptr_t)pChunk->execAddr + subChunkOffset), subChunkSize);
+#else
+    (void)pChunk;
+    (void)subChunkOffset;
+    (void)subChunkSize;
+#endif
+
+    return crc;
+}
+
+bool HSS_BootDownload_CheckChunkCrc(struct HSS_BootChunkDesc const *pChunk, uint32_t crc)
+{
+    bool result = true;
+
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_VERIFY_CHUNK_CRC)
+    if (crc != pChunk->crc32) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "chunk@0x%lx->0x%lx (%lu bytes): "
+            "CRC32 mismatch (expected 0x%08x, got 0x%08x)\n",
+            pChunk->loadAddr, pChunk->execAddr, pChunk->size, pChunk->crc32, crc);
+        result = false;
+    }
+#else
+    (void)pChunk;
+    (void)crc;
+#endif
+
+    return result;
+}
+
+//
+// one step of clearing a ZI chunk. *pOffset is the size of the cleared prefix, and starts
+// at zero. Each call either clears the seed, submits the next copy, or, once the last copy
+// has completed, finishes the chunk, so that a chunk of N bytes takes log2(N/seed) copies.
+// The caller waits for each copy to complete before the next call. If a copy cannot be
+// submitted, the CPU clears the rest of the chunk.
+//
+// Returns true once the whole chunk has been cleared.
+bool HSS_BootDownload_ZeroInitStep(size_t *pOffset, void *pExecAddr, size_t size,
+    HSS_BootZICopyFn copyFn, void *pContext)
+{
+    bool result = false;
+    char * const pBase = (char *)pExecAddr;
+
+    if (size < HSS_BOOT_ZI_COPY_THRESHOLD) {
+        memset(pBase, 0, size);
+        result = true;
+    } else if (*pOffset == 0u) {
+        memset(pBase, 0, HSS_BOOT_ZI_SEED_SIZE);
+        *pOffset = HSS_BOOT_ZI_SEED_SIZE;
+    } else if (*pOffset >= size) {
+        *pOffset = 0u;
+        result = true;
+    } else {
+        const size_t offset = *pOffset;
+        const size_t copySize = MIN(offset, size - offset);
+
+        if (copyFn(pContext, pBase + offset, pBase, copySize)) {
+            *pOffset += copySize;
+        } else {
+            memset(pBase + offset, 0, size - offset);
+            *pOffset = size;
+        }
+    }
+
+    return result;
+}
+
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_STREAMING)
+static uint8_t streamBounceBuffer_[HSS_BOOT_STREAM_BOUNCE_SIZE] __attribute__((aligned(8)));
+
+bool HSS_BootDownload_SetSource(struct HSS_BootStreamSource * const pSource,
+    struct HSS_Storage *pStorage, size_t srcOffset)
+{
+    bool result = false;
+
+    pSource->pStorage = NULL;
+    pSource->srcOffset = 0u;
+    pSource->blockSize = 0u;
+    pSource->pPendingDest = NULL;
+    pSource->pendingByteCount = 0u;
+
+    if (pStorage && pStorage->readBlock && pStorage->getInfo) {
+        uint32_t blockSize, eraseSize, blockCount;
+        pStorage->getInfo(&blockSize, &eraseSize, &blockCount);
+
+        if ((blockSize == 0u) || (blockSize > HSS_BOOT_STREAM_BOUNCE_SIZE)) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "%s: block size %u not supported for streaming\n",
+                pStorage->name, blockSize);
+        } else {
+            pSource->pStorage = pStorage;
+            pSource->srcOffset = srcOffset;
+            pSource->blockSize = blockSize;
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+//
+// reads up to byteCount bytes of a sub-chunk, reporting how many have arrived in
+// *pBytesDone. This can be fewer than asked for, including zero while a background
+// read is in flight, so callers keep calling until the whole sub-chunk has arrived
+bool HSS_BootDownload_StreamSubChunk(struct HSS_BootStreamSource * const pSource,
+    void *pDest, size_t srcOffset, size_t byteCount, size_t *pBytesDone)
+{
+    bool result = false;
+
+    struct HSS_Storage * const pStorage = pSource->pStorage;
+    const size_t blockSize = pSource->blockSize;
+    const size_t headOffset = srcOffset % blockSize;
+
+    if (pSource->pPendingDest) {
+        // a background read is in flight, and only one may be in flight at a time, so
+        // report progress only once it has completed. Destinations are unique to each
+        // sub-chunk, so identify the owner of the read
+        byteCount = 0u;
+        result = true;
+
+        if ((pSource->pPendingDest == pDest) && pStorage->isTransferComplete(&result)) {
+            byteCount = pSource->pendingByteCount;
+            pSource->pPendingDest = NULL;
+        }
+    } else if (headOffset || (byteCount < blockSize) || ((uintptr_t)pDest & (sizeof(uint32_t)-1u))) {
+        // partial block, or unaligned destination => go via the bounce buffer, and
+        // finish on a block boundary so that subsequent reads are aligned
+        byteCount = MIN(byteCount, blockSize - headOffset);
+
+        result = pStorage->readBlock(streamBounceBuffer_, srcOffset - headOffset, blockSize);
+        if (result) {
+            memcpy(pDest, streamBounceBuffer_ + headOffset, byteCount);
+        }
+    } else if (pStorage->readBlockStart && pStorage->isTransferComplete) {
+        // whole blocks are read directly to the destination, in the background, so that
+        // other services run while the read is in flight
+        byteCount = byteCount - (byteCount % blockSize);
+        result = pStorage->readBlockStart(pDest, srcOffset, byteCount);
+
+        if (result) {
+            pSource->pPendingDest = pDest;
+            pSource->pendingByteCount = byteCount;
+            byteCount = 0u;
+        }
+    } else {
+        // whole blocks can be read directly to the destination
+        byteCount = byteCount - (byteCount % blockSize);
+        result = pStorage->readBlock(pDest, srcOffset, byteCount);
+    }
+
+    if (!result) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "%s: failed to read %lu bytes from offset 0x%lx\n",
+            pStorage->name, byteCount, srcOffset);
+    }
+
+    *pBytesDone = byteCount;
+    return result;
+}
+
+//
+// if a download is abandoned while its background read is in flight, wait for the read
+// so that the storage is free for other downloads
+void HSS_BootDownload_AbandonStreamRead(struct HSS_BootStreamSource * const pSource,
+    void const *pDest)
+{
+    if (pSource->pPendingDest && (pSource->pPendingDest == pDest)) {
+        bool result;
+        while (!pSource->pStorage->isTransferComplete(&result)) {
+            ;
+        }
+        pSource->pPendingDest = NULL;
+    }
+}
+#endif
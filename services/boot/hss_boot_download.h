@@ -0,0 +1,71 @@
+#ifndef HSS_BOOT_DOWNLOAD_H
+#define HSS_BOOT_DOWNLOAD_H
+
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/*!
+ * \file  Boot Service - Chunk Download
+ * \brief Boot Service - reading boot image chunks from a storage provider
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hss_types.h"
+#include "hss_clock.h"
+
+#define HSS_BOOT_STREAM_BOUNCE_SIZE 512u
+
+/*
+ * large ZI chunks are cleared by a copy engine, using the chunk as its own zero source:
+ * the CPU clears a seed at the start of the chunk, and each copy then doubles the cleared
+ * region. Smaller chunks are cleared by the CPU
+ */
+#define HSS_BOOT_ZI_SEED_SIZE       (4096u)
+#define HSS_BOOT_ZI_COPY_THRESHOLD  (64u * 1024u)
+
+typedef bool (*HSS_BootZICopyFn)(void *pContext, void *pDest, void const *pSrc,
+    size_t byteCount);
+
+/*
+ * if a boot image source is set, only the boot image header and chunk tables are in
+ * memory, and chunk data is read from the storage provider as each chunk is downloaded
+ */
+struct HSS_BootStreamSource {
+    struct HSS_Storage *pStorage;
+    size_t srcOffset;
+    size_t blockSize;
+    void *pPendingDest;         // destination of the background read in flight, if any
+    size_t pendingByteCount;
+};
+
+size_t HSS_BootDownload_AdaptSubChunkSize(size_t subChunkSize, HSSTicks_t elapsed,
+    HSSTicks_t budget, size_t minSize, size_t maxSize);
+uint32_t HSS_BootDownload_UpdateChunkCrc(struct HSS_BootChunkDesc const *pChunk, uint32_t crc,
+    ptrdiff_t subChunkOffset, size_t subChunkSize) __attribute__((nonnull));
+bool HSS_BootDownload_CheckChunkCrc(struct HSS_BootChunkDesc const *pChunk, uint32_t crc)
+    __attribute__((nonnull));
+
+bool HSS_BootDownload_ZeroInitStep(size_t *pOffset, void *pExecAddr, size_t size,
+    HSS_BootZICopyFn copyFn, void *pContext) __attribute__((nonnull(1, 4)));
+
+bool HSS_BootDownload_SetSource(struct HSS_BootStreamSource * const pSource,
+    struct HSS_Storage *pStorage, size_t srcOffset) __attribute__((nonnull(1)));
+bool HSS_BootDownload_StreamSubChunk(struct HSS_BootStreamSource * const pSource,
+    void *pDest, size_t srcOffset, size_t byteCount, size_t *pBytesDone) __attribute__((nonnull));
+void HSS_BootDownload_AbandonStreamRead(struct HSS_BootStreamSource * const pSource,
+    void const *pDest) __attribute__((nonnull(1)));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
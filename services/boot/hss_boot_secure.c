@@ -23,6 +23,7 @@
 
 #include <assert.h>
 #include <string.h>
+#include <stddef.h>
 
 static void __attribute__((__noreturn__)) boot_secure_failure_(void)
 {
@@ -40,6 +41,116 @@ static void __attribute__((__noreturn__)) boot_secure_failure_(void)
 
 static int perf_ctr_index = PERF_CTR_UNINITIALIZED;
 
+static struct {
+    struct HSS_Signature signature;
+    struct HSS_BootImage const *pBootImage;
+    size_t bootImageLength;
+    size_t bytesHashed;
+    bool inProgress;
+    bool verified;
+} stream_ = { 0 };
+
+//
+// a streamed result only stands for the image that was streamed, so forget it whenever
+// another image is about to be loaded, whether or not that image is streamed
+void HSS_Boot_Secure_StreamReset(void)
+{
+    if (stream_.inProgress) {
+        (void)HSS_Crypto_Verify_ECDSA_P384_Finalize();
+    }
+
+    stream_.pBootImage = NULL;
+    stream_.bootImageLength = 0u;
+    stream_.bytesHashed = 0u;
+    stream_.inProgress = false;
+    stream_.verified = false;
+}
+
+bool HSS_Boot_Secure_StreamBegin(struct HSS_BootImage const *pBootImageHeader)
+{
+    assert(pBootImageHeader != NULL);
+
+    stream_.signature = pBootImageHeader->signature;
+    stream_.pBootImage = NULL;
+    stream_.bootImageLength = pBootImageHeader->bootImageLength;
+    stream_.bytesHashed = 0u;
+    stream_.verified = false;
+
+    stream_.inProgress = HSS_Crypto_Verify_ECDSA_P384_Init(ARRAY_SIZE(stream_.signature.ecdsaSig),
+        &(stream_.signature.ecdsaSig[0]));
+
+    //
+    // the perf counter is only lapped by HSS_Boot_Secure_StreamEnd(), which is not called
+    // if the stream fails to start
+    if (stream_.inProgress) {
+        HSS_PerfCtr_Allocate(&perf_ctr_index, "SecureBoot");
+        HSS_PerfCtr_Start(perf_ctr_index);
+    }
+
+    return stream_.inProgress;
+}
+
+bool HSS_Boot_Secure_StreamUpdate(void const *pData, size_t offset, size_t byteCount)
+{
+    //
+    // the signature was calculated with the signature field zeroed, so hash zeros in
+    // place of any part of that field covered by this piece
+    static const uint8_t zeros[sizeof(struct HSS_Signature)] = { 0 };
+    size_t const sigStart = offsetof(struct HSS_BootImage, signature);
+    size_t const sigEnd = sigStart + sizeof(struct HSS_Signature);
+    uint8_t const *pBytes = (uint8_t const *)pData;
+
+    assert(pData != NULL);
+
+    if (stream_.inProgress && (offset != stream_.bytesHashed)) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "out of order data at offset %lu\n", offset);
+        stream_.inProgress = false;
+    }
+
+    while (stream_.inProgress && byteCount) {
+        size_t pieceSize;
+        uint8_t const *pPiece;
+
+        if (offset < sigStart) {
+            pieceSize = MIN(byteCount, sigStart - offset);
+            pPiece = pBytes;
+        } else if (offset < sigEnd) {
+            pieceSize = MIN(byteCount, sigEnd - offset);
+            pPiece = &zeros[offset - sigStart];
+        } else {
+            pieceSize = byteCount;
+            pPiece = pBytes;
+        }
+
+        stream_.inProgress = HSS_Crypto_Verify_ECDSA_P384_Update(pieceSize, pPiece);
+
+        pBytes += pieceSize;
+        offset += pieceSize;
+        byteCount -= pieceSize;
+        stream_.bytesHashed += pieceSize;
+    }
+
+    return stream_.inProgress;
+}
+
+bool HSS_Boot_Secure_StreamEnd(struct HSS_BootImage const *pBootImage)
+{
+    assert(pBootImage != NULL);
+
+    if (stream_.inProgress && (stream_.bytesHashed == stream_.bootImageLength)) {
+        stream_.verified = HSS_Crypto_Verify_ECDSA_P384_Finalize();
+        stream_.pBootImage = pBootImage;
+    } else {
+        (void)HSS_Crypto_Verify_ECDSA_P384_Finalize();
+        stream_.verified = false;
+    }
+
+    stream_.inProgress = false;
+    HSS_PerfCtr_Lap(perf_ctr_index);
+
+    return stream_.verified;
+}
+
 bool HSS_Boot_Secure_CheckCodeSigning(struct HSS_BootImage *pBootImage)
 {
     bool result = false;
@@ -49,11 +160,21 @@ bool HSS_Boot_Secure_CheckCodeSigning(struct HSS_BootImage *pBootImage)
     struct HSS_Signature originalSig __attribute__((aligned)) = pBootImage->signature;
     memset((void *)&(pBootImage->signature), 0, sizeof(struct HSS_Signature));
 
-    HSS_PerfCtr_Allocate(&perf_ctr_index, "SecureBoot");
-    HSS_PerfCtr_Start(perf_ctr_index);
+    if (stream_.verified && (stream_.pBootImage == pBootImage)
+        && (stream_.bootImageLength == pBootImage->bootImageLength)
+        && !memcmp(&stream_.signature, &originalSig, sizeof(originalSig))) {
+        // already verified while it was being copied
+        result = true;
+    } else {
+        HSS_PerfCtr_Allocate(&perf_ctr_index, "SecureBoot");
+        HSS_PerfCtr_Start(perf_ctr_index);
+
+        result = HSS_Crypto_Verify_ECDSA_P384(ARRAY_SIZE(originalSig.ecdsaSig), &(originalSig.ecdsaSig[0]),
+            pBootImage->bootImageLength, (uint8_t *)pBootImage);
 
-    result = HSS_Crypto_Verify_ECDSA_P384(ARRAY_SIZE(originalSig.ecdsaSig), &(originalSig.ecdsaSig[0]),
-        pBootImage->bootImageLength, (uint8_t *)pBootImage);
+        HSS_PerfCtr_Lap(perf_ctr_index);
+    }
+    stream_.verified = false;
 
     if (!result) {
         boot_secure_failure_();
@@ -61,7 +182,5 @@ bool HSS_Boot_Secure_CheckCodeSigning(struct HSS_BootImage *pBootImage)
         mHSS_DEBUG_PRINTF(LOG_STATUS, "ECDSA verification passed\n");
     }
 
-    HSS_PerfCtr_Lap(perf_ctr_index);
-
     return result;
 }
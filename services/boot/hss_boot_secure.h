@@ -18,4 +18,15 @@
 
 bool HSS_Boot_Secure_CheckCodeSigning(struct HSS_BootImage *pBootImage) __attribute__((nonnull));
 
+/*
+ * Streamed verification: the image signature can be checked while the image is being
+ * copied, with each piece hashed as it lands. A successful streamed verification of an
+ * image is then reused by HSS_Boot_Secure_CheckCodeSigning() rather than re-hashing it,
+ * until HSS_Boot_Secure_StreamReset() is called as the next image is loaded.
+ */
+void HSS_Boot_Secure_StreamReset(void);
+bool HSS_Boot_Secure_StreamBegin(struct HSS_BootImage const *pBootImageHeader) __attribute__((nonnull));
+bool HSS_Boot_Secure_StreamUpdate(void const *pData, size_t offset, size_t byteCount) __attribute__((nonnull));
+bool HSS_Boot_Secure_StreamEnd(struct HSS_BootImage const *pBootImage) __attribute__((nonnull));
+
 #endif
@@ -29,6 +29,7 @@
 #include "u54_state.h"
 #include "hss_trigger.h"
 #include "hss_boot_init.h"
+#include "hss_boot_download.h"
 
 #include <assert.h>
 #include <string.h>
@@ -85,6 +86,18 @@
 
 #define BOOT_SUB_CHUNK_SIZE 256u
 
+// sub-chunks are resized on each Download iteration to fit within the configured
+// time budget, so that other state machines in the superloop stay responsive
+#define BOOT_SUB_CHUNK_MAX_SIZE    (256u * 1024u)
+#define BOOT_DOWNLOAD_BUDGET_TICKS \
+    ((HSSTicks_t)(((unsigned long long)CONFIG_SERVICE_BOOT_DOWNLOAD_BUDGET_US * TICKS_PER_SEC) / 1000000llu))
+
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_STREAMING)
+// when streaming from storage, each sub-chunk costs a storage read command, so
+// transfer in larger pieces
+#  define BOOT_STREAM_SUB_CHUNK_SIZE 32768u
+#endif
+
 /*
  * Module Prototypes (states)
  */
@@ -109,8 +122,11 @@ static void boot_complete_handler(struct StateMachine * const pMyMachine);
 static void boot_idle_onEntry(struct StateMachine * const pMyMachine);
 static void boot_idle_handler(struct StateMachine * const pMyMachine);
 
-static void boot_do_download_chunk(struct HSS_BootChunkDesc const *pChunk,
-    ptrdiff_t subChunkOffset, size_t subChunkSize);
+static bool boot_do_download_chunk(struct HSS_BootChunkDesc const *pChunk,
+    ptrdiff_t subChunkOffset, size_t subChunkSize, size_t *pBytesDone);
+static size_t boot_get_sub_chunk_size(void);
+static size_t boot_get_min_sub_chunk_size(void);
+static void boot_adapt_sub_chunk_size(struct StateMachine * const pMyMachine);
 static void boot_do_zero_init_chunk(struct HSS_BootZIChunkDesc const *pZiChunk);
 
 static bool validateCrc_(struct HSS_BootImage *pImage);
@@ -160,23 +176,38 @@ struct HSS_Boot_LocalData {
     size_t chunkCount;
     size_t ziChunkCount;
     size_t subChunkOffset;
+    size_t subChunkSize;
+    uint32_t chunkCrc;
     uint32_t msgIndex;
     uint32_t hartMask;
     int perfCtr;
     unsigned int iterator;
     uintptr_t ancilliaryData;
     uint32_t msgIndexAux[MAX_NUM_HARTS-1];
+    size_t ziOffset;
+    struct MemcpyViaPdmaRequest ziRequest;
+    HSSTicks_t subChunkStartTime;
+    bool subChunkStarted;
 };
 
 
 static struct HSS_Boot_LocalData localData[MAX_NUM_HARTS-1] = {
-    { HSS_HART_U54_1, NULL, NULL, 0u, 0u, 0u, IPI_MAX_NUM_OUTSTANDING_COMPLETES, 0u, PERF_CTR_UNINITIALIZED, 0u, 0u, { 0u, 0u, 0u, 0u } },
-    { HSS_HART_U54_2, NULL, NULL, 0u, 0u, 0u, IPI_MAX_NUM_OUTSTANDING_COMPLETES, 0u, PERF_CTR_UNINITIALIZED, 0u, 0u, { 0u, 0u, 0u, 0u } },
-    { HSS_HART_U54_3, NULL, NULL, 0u, 0u, 0u, IPI_MAX_NUM_OUTSTANDING_COMPLETES, 0u, PERF_CTR_UNINITIALIZED, 0u, 0u, { 0u, 0u, 0u, 0u } },
-    { HSS_HART_U54_4, NULL, NULL, 0u, 0u, 0u, IPI_MAX_NUM_OUTSTANDING_COMPLETES, 0u, PERF_CTR_UNINITIALIZED, 0u, 0u, { 0u, 0u, 0u, 0u } },
+    { HSS_HART_U54_1, NULL, NULL, 0u, 0u, 0u, 0u, 0u, IPI_MAX_NUM_OUTSTANDING_COMPLETES, 0u, PERF_CTR_UNINITIALIZED, 0u, 0u, { 0u, 0u, 0u, 0u } },
+    { HSS_HART_U54_2, NULL, NULL, 0u, 0u, 0u, 0u, 0u, IPI_MAX_NUM_OUTSTANDING_COMPLETES, 0u, PERF_CTR_UNINITIALIZED, 0u, 0u, { 0u, 0u, 0u, 0u } },
+    { HSS_HART_U54_3, NULL, NULL, 0u, 0u, 0u, 0u, 0u, IPI_MAX_NUM_OUTSTANDING_COMPLETES, 0u, PERF_CTR_UNINITIALIZED, 0u, 0u, { 0u, 0u, 0u, 0u } },
+    { HSS_HART_U54_4, NULL, NULL, 0u, 0u, 0u, 0u, 0u, IPI_MAX_NUM_OUTSTANDING_COMPLETES, 0u, PERF_CTR_UNINITIALIZED, 0u, 0u, { 0u, 0u, 0u, 0u } },
 };
 
 struct HSS_BootImage *pBootImage = NULL;
+
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_STREAMING)
+/*
+ * if a boot image source is registered, only the boot image header and chunk tables
+ * are present at pBootImage, and chunk data is read from the storage provider
+ */
+static struct HSS_BootStreamSource bootImageSource = { NULL, 0u, 0u, NULL, 0u };
+#endif
+
 static bool pmpSetupFlag[HSS_HART_NUM_PEERS] = { false, false, false, false, false };
 
 /*
@@ -270,16 +301,74 @@ const struct {
  * This checks are done outside this function.
  *
  */
-static void boot_do_download_chunk(struct HSS_BootChunkDesc const *pChunk, ptrdiff_t subChunkOffset,
-    size_t subChunkSize)
+static size_t boot_get_sub_chunk_size(void)
+{
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_STREAMING)
+    if (bootImageSource.pStorage) {
+        return BOOT_STREAM_SUB_CHUNK_SIZE;
+    }
+#endif
+    return BOOT_SUB_CHUNK_SIZE;
+}
+
+static size_t boot_get_min_sub_chunk_size(void)
+{
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_STREAMING)
+    if (bootImageSource.pStorage) {
+        return bootImageSource.blockSize;
+    }
+#endif
+    return BOOT_SUB_CHUNK_SIZE;
+}
+
+static void boot_adapt_sub_chunk_size(struct StateMachine * const pMyMachine)
+{
+    struct HSS_Boot_LocalData * const pInstanceData = pMyMachine->pInstanceData;
+
+    // a background read spans several iterations, so time the sub-chunk from issuing
+    // its read rather than from entry to this iteration's handler
+    HSSTicks_t const elapsed = HSS_GetTime() - pInstanceData->subChunkStartTime;
+
+    pInstanceData->subChunkSize = HSS_BootDownload_AdaptSubChunkSize(pInstanceData->subChunkSize,
+        elapsed, BOOT_DOWNLOAD_BUDGET_TICKS, boot_get_min_sub_chunk_size(),
+        BOOT_SUB_CHUNK_MAX_SIZE);
+}
+
+static bool boot_do_download_chunk(struct HSS_BootChunkDesc const *pChunk, ptrdiff_t subChunkOffset,
+    size_t subChunkSize, size_t *pBytesDone)
 {
+    bool result = true;
+
     assert(pChunk);
     assert(pChunk->size);
+    assert(pBytesDone);
 
     const uintptr_t execAddr = (uintptr_t)pChunk->execAddr + subChunkOffset;
-    const uintptr_t loadAddr = (uintptr_t)pBootImage + (uintptr_t)pChunk->loadAddr + subChunkOffset;
     const size_t actualSize = MIN(subChunkSize, pChunk->size - subChunkOffset);
+
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_STREAMING)
+    if (bootImageSource.pStorage) {
+        if ((pChunk->loadAddr > pBootImage->bootImageLength)
+            || (pChunk->size > (pBootImage->bootImageLength - pChunk->loadAddr))) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "chunk@0x%lx (%lu bytes) exceeds boot image length\n",
+                pChunk->loadAddr, pChunk->size);
+            *pBytesDone = 0u;
+            result = false;
+        } else {
+            const size_t srcOffset = bootImageSource.srcOffset + pChunk->loadAddr + subChunkOffset;
+            result = HSS_BootDownload_StreamSubChunk(&bootImageSource, (void *)execAddr, srcOffset,
+                actualSize, pBytesDone);
+        }
+
+        return result;
+    }
+#endif
+
+    const uintptr_t loadAddr = (uintptr_t)pBootImage + (uintptr_t)pChunk->loadAddr + subChunkOffset;
     memcpy_via_pdma((void *)execAddr, (void*)loadAddr, actualSize);
+    *pBytesDone = actualSize;
+
+    return result;
 }
 
 static void boot_do_zero_init_chunk(struct HSS_BootZIChunkDesc const *pZiChunk)
@@ -292,6 +381,18 @@ static void boot_do_zero_init_chunk(struct HSS_BootZIChunkDesc const *pZiChunk)
     memset((void *)execAddr, 0, ziChunkSize);
 }
 
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_ZI_VIA_PDMA)
+//
+// Large ZI chunks are cleared by PDMA, see HSS_BootDownload_ZeroInitStep(). The boot
+// service returns to the superloop while each copy is in flight.
+static bool boot_zero_init_copy_via_pdma(void *pContext, void *pDest, void const *pSrc,
+    size_t byteCount)
+{
+    return memcpy_via_pdma_async((struct MemcpyViaPdmaRequest *)pContext, pDest, pSrc,
+        byteCount, NULL, NULL);
+}
+#endif
+
 static void free_msg_index(struct HSS_Boot_LocalData * const pInstanceData)
 {
     if (pInstanceData->msgIndex != IPI_MAX_NUM_OUTSTANDING_COMPLETES) {
@@ -497,6 +598,7 @@ static void boot_zero_init_chunks_onEntry(struct StateMachine * const pMyMachine
 
     pInstanceData->pZiChunk =
             (struct HSS_BootZIChunkDesc const *)((char *)pBootImage + pBootImage->ziChunkTableOffset);
+    pInstanceData->ziOffset = 0u;
 }
 
 static void boot_zero_init_chunks_handler(struct StateMachine * const pMyMachine)
@@ -507,6 +609,12 @@ static void boot_zero_init_chunks_handler(struct StateMachine * const pMyMachine
     assert(pBootImage != NULL);
     struct HSS_BootZIChunkDesc const *pZiChunk = pInstanceData->pZiChunk;
 
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_ZI_VIA_PDMA)
+    if (!memcpy_via_pdma_async_poll(&pInstanceData->ziRequest)) {
+        return; // wait for the previous PDMA clear to complete
+    }
+#endif
+
     if (pZiChunk->size != 0u) {
         if (target == pZiChunk->owner) {
             if (HSS_DDR_IsAddrInDDR((uintptr_t)pZiChunk->execAddr) && !HSS_Trigger_IsNotified(EVENT_DDR_TRAINED)) {
@@ -517,8 +625,16 @@ static void boot_zero_init_chunks_handler(struct StateMachine * const pMyMachine
                     pMyMachine->pMachineName, pInstanceData->ziChunkCount,
                     (uintptr_t)pZiChunk->execAddr, pZiChunk->size);
 #endif
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_ZI_VIA_PDMA)
+                if (HSS_BootDownload_ZeroInitStep(&pInstanceData->ziOffset,
+                        (void *)(uintptr_t)pZiChunk->execAddr, pZiChunk->size,
+                        boot_zero_init_copy_via_pdma, &pInstanceData->ziRequest)) {
+                    pInstanceData->pZiChunk++;
+                }
+#else
                 boot_do_zero_init_chunk(pZiChunk);
                 pInstanceData->pZiChunk++;
+#endif
             }
         } else {
             pInstanceData->pZiChunk++;
@@ -554,6 +670,8 @@ static void boot_download_chunks_onEntry(struct StateMachine * const pMyMachine)
 
         pInstanceData->chunkCount = 0u;
         pInstanceData->subChunkOffset = 0u;
+        pInstanceData->subChunkSize = boot_get_sub_chunk_size();
+        pInstanceData->subChunkStarted = false;
         pInstanceData->pChunk += pBootImage->hart[target-1].firstChunk;
     } else {
         // nothing to do for this machine, numChunks is zero...
@@ -585,14 +703,34 @@ static void boot_download_chunks_handler(struct StateMachine * const pMyMachine)
                         (uintptr_t)pChunk->execAddr, pChunk->size);
                 }
 #endif
+                if (!pInstanceData->subChunkOffset) {
+                    pInstanceData->chunkCrc = 0u;
+                }
+
+                if (!pInstanceData->subChunkStarted) {
+                    pInstanceData->subChunkStartTime = HSS_GetTime();
+                    pInstanceData->subChunkStarted = true;
+                }
+
                 // check each hart to see if it wants to transmit
-                boot_do_download_chunk(pChunk,
+                size_t bytesDone = 0u;
+                bool const downloadResult = boot_do_download_chunk(pChunk,
 #ifdef BOOT_SUB_CHUNK_SIZE
-                    pInstanceData->subChunkOffset, BOOT_SUB_CHUNK_SIZE
+                    pInstanceData->subChunkOffset, pInstanceData->subChunkSize,
 #else
-                    0u, pChunk->size
+                    0u, pChunk->size,
 #endif
-                );
+                    &bytesDone);
+
+                if (!downloadResult) {
+                    mHSS_DEBUG_PRINTF(LOG_ERROR, "%s::%d:failed to download chunk\n",
+                        pMyMachine->pMachineName, pInstanceData->chunkCount);
+                    pMyMachine->state = BOOT_ERROR;
+                    return;
+                }
+
+                pInstanceData->chunkCrc = HSS_BootDownload_UpdateChunkCrc(pChunk, pInstanceData->chunkCrc,
+                    pInstanceData->subChunkOffset, bytesDone);
 
                 if ((pChunk->owner & BOOT_FLAG_ANCILLIARY_DATA)
                     && (!pInstanceData->ancilliaryData)) {
@@ -602,17 +740,36 @@ static void boot_download_chunks_handler(struct StateMachine * const pMyMachine)
                 }
 
 #ifdef BOOT_SUB_CHUNK_SIZE
-                pInstanceData->subChunkOffset += BOOT_SUB_CHUNK_SIZE;
+                // nothing has arrived while a background read is in flight, so there is
+                // nothing to measure yet
+                if (bytesDone) {
+                    boot_adapt_sub_chunk_size(pMyMachine);
+                    pInstanceData->subChunkStarted = false;
+                }
+
+                pInstanceData->subChunkOffset += bytesDone;
                 if (pInstanceData->subChunkOffset >= pChunk->size) {
 #  if IS_ENABLED(CONFIG_DEBUG_CHUNK_DOWNLOADS)
                     mHSS_DEBUG_PRINTF(LOG_NORMAL, "%s::%d:sub-chunk finished at 0x%x\n",
                         pMyMachine->pMachineName, pInstanceData->chunkCount, pInstanceData->subChunkOffset);
 #  endif
+                    if (!HSS_BootDownload_CheckChunkCrc(pChunk, pInstanceData->chunkCrc)) {
+                        mHSS_DEBUG_PRINTF(LOG_ERROR, "%s::%d:chunk failed integrity check\n",
+                            pMyMachine->pMachineName, pInstanceData->chunkCount);
+                        pMyMachine->state = BOOT_ERROR;
+                        return;
+                    }
                     pInstanceData->subChunkOffset = 0u;
                     pInstanceData->chunkCount++;
                     pInstanceData->pChunk++;
                 }
 #else
+                if (!HSS_BootDownload_CheckChunkCrc(pChunk, pInstanceData->chunkCrc)) {
+                    mHSS_DEBUG_PRINTF(LOG_ERROR, "%s::%d:chunk failed integrity check\n",
+                        pMyMachine->pMachineName, pInstanceData->chunkCount);
+                    pMyMachine->state = BOOT_ERROR;
+                    return;
+                }
                 pInstanceData->chunkCount++;
                 pInstanceData->pChunk++;
 #endif
@@ -643,6 +800,18 @@ static void boot_download_chunks_handler(struct StateMachine * const pMyMachine)
 
 static void boot_download_chunks_onExit(struct StateMachine * const pMyMachine)
 {
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_STREAMING)
+    //
+    // if this machine leaves the Download state while its background read is in flight,
+    // wait for the read so that the storage is free for the other machines
+    struct HSS_Boot_LocalData const * const pInstanceData = pMyMachine->pInstanceData;
+
+    if (pInstanceData->pChunk) {
+        HSS_BootDownload_AbandonStreamRead(&bootImageSource,
+            (void *)((uintptr_t)pInstanceData->pChunk->execAddr + pInstanceData->subChunkOffset));
+    }
+
+#endif
     /* Re-register harts now that we've fully parsed the boot image (ancillary data etc) */
     register_harts(pMyMachine);
 }
@@ -1129,6 +1298,11 @@ bool HSS_Boot_ValidateImage(struct HSS_BootImage *pImage)
     return result;
 }
 
+bool HSS_Boot_VerifyHeaderCrc(struct HSS_BootImage *pImage)
+{
+    return validateCrc_(pImage);
+}
+
 bool HSS_Boot_VerifyMagic(struct HSS_BootImage const * const pImage)
 {
     bool result = false;
@@ -1152,6 +1326,20 @@ bool HSS_Boot_VerifyMagic(struct HSS_BootImage const * const pImage)
 void HSS_Register_Boot_Image(struct HSS_BootImage *pImage)
 {
     pBootImage = pImage;
+
+    if (!pImage) {
+        HSS_Register_Boot_Image_Source(NULL, 0u);
+    }
+}
+
+void HSS_Register_Boot_Image_Source(struct HSS_Storage *pStorage, size_t srcOffset)
+{
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_STREAMING)
+    (void)HSS_BootDownload_SetSource(&bootImageSource, pStorage, srcOffset);
+#else
+    (void)pStorage;
+    (void)srcOffset;
+#endif
 }
 
 bool HSS_Boot_Custom(void)
@@ -1161,6 +1349,7 @@ bool HSS_Boot_Custom(void)
     size_t firstChunk = 0u;
     size_t chunkNum = 0u;
     size_t subChunkOffset = 0u;
+    uint32_t chunkCrc = 0u;
     enum HSSHartId target = 0;
     struct HSS_BootChunkDesc const *pChunk;
     struct HSS_BootZIChunkDesc const *pZiChunk;
@@ -1209,17 +1398,34 @@ bool HSS_Boot_Custom(void)
             }
 #endif
             // check each hart to see if it wants to transmit
+            size_t bytesDone = 0u;
 #ifdef BOOT_SUB_CHUNK_SIZE
-            boot_do_download_chunk(pChunk, subChunkOffset, BOOT_SUB_CHUNK_SIZE);
+            // custom boot flow runs to completion, so there is no time budget to respect
+            if (!boot_do_download_chunk(pChunk, subChunkOffset, BOOT_SUB_CHUNK_MAX_SIZE, &bytesDone)) {
+                return false;
+            }
 
-            subChunkOffset += BOOT_SUB_CHUNK_SIZE;
+            chunkCrc = HSS_BootDownload_UpdateChunkCrc(pChunk, chunkCrc, subChunkOffset, bytesDone);
+            subChunkOffset += bytesDone;
             if (subChunkOffset >= pChunk->size) {
+                if (!HSS_BootDownload_CheckChunkCrc(pChunk, chunkCrc)) {
+                    mHSS_DEBUG_PRINTF(LOG_ERROR, "%d:chunk failed integrity check\n", chunkNum);
+                    return false;
+                }
+                chunkCrc = 0u;
                 subChunkOffset = 0u;
                 chunkNum++;
                 pChunk++;
             }
 #else
-            boot_do_download_chunk(pChunk, 0u, pChunk->size);
+            if (!boot_do_download_chunk(pChunk, 0u, pChunk->size, &bytesDone)) {
+                return false;
+            }
+            chunkCrc = HSS_BootDownload_UpdateChunkCrc(pChunk, 0u, 0u, bytesDone);
+            if (!HSS_BootDownload_CheckChunkCrc(pChunk, chunkCrc)) {
+                mHSS_DEBUG_PRINTF(LOG_ERROR, "%d:chunk failed integrity check\n", chunkNum);
+                return false;
+            }
             chunkNum++;
             pChunk++;
             (void)subChunkOffset;
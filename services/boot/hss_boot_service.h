@@ -67,9 +67,11 @@ bool HSS_Boot_SendResumeGOTO(enum HSSHartId target, uint64_t resume_pc, uint64_t
 bool HSS_SkipBoot_IsSet(enum HSSHartId target);
 
 void HSS_Register_Boot_Image(struct HSS_BootImage *pImage);
+void HSS_Register_Boot_Image_Source(struct HSS_Storage *pStorage, size_t srcOffset);
 
 bool HSS_Boot_ValidateImage(struct HSS_BootImage *pBootImage);
 bool HSS_Boot_VerifyMagic(struct HSS_BootImage const * const pBootImage);
+bool HSS_Boot_VerifyHeaderCrc(struct HSS_BootImage *pBootImage);
 
 bool HSS_Boot_Custom(void);
 
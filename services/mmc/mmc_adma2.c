@@ -0,0 +1,73 @@
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/*!
+ * \file MMC ADMA2 Descriptor Tables
+ * \brief Construction of ADMA2 descriptor tables for scattered MMC reads
+ *
+ * This has no hardware dependencies, so that a single read command can be
+ * described as a list of destination segments, and the table checked, without
+ * the MMC controller.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+
+#include "mmc_adma2.h"
+
+//
+// Each segment is split into descriptors of at most HSS_MMC_ADMA2_MAX_LENGTH bytes,
+// and the final descriptor is marked as the end of the table.
+//
+// Returns the number of descriptors used, or zero if the segments cannot be described
+// (empty, misaligned, or too many for the table)
+//
+size_t HSS_MMC_ADMA2_BuildTable(struct HSS_MMC_ADMA2_Descriptor * const pTable,
+    const size_t maxDescriptors, struct HSS_MMC_ReadSegment const * const pSegments,
+    const size_t numSegments)
+{
+    size_t numDescriptors = 0u;
+    bool result = (pTable != NULL) && (pSegments != NULL) && numSegments;
+
+    for (size_t i = 0u; result && (i < numSegments); i++) {
+        uintptr_t address = (uintptr_t)pSegments[i].pDest;
+        size_t remaining = pSegments[i].byteCount;
+
+        if (!remaining || (address & (HSS_MMC_ADMA2_ADDRESS_ALIGN - 1u))) {
+            result = false;
+        }
+
+        while (result && remaining) {
+            if (numDescriptors >= maxDescriptors) {
+                result = false;
+            } else {
+                const size_t length = MIN(remaining, (size_t)HSS_MMC_ADMA2_MAX_LENGTH);
+                struct HSS_MMC_ADMA2_Descriptor * const pDesc = &pTable[numDescriptors];
+
+                pDesc->attribute = HSS_MMC_ADMA2_ATTR_VALID | HSS_MMC_ADMA2_ATTR_ACT_TRAN;
+                pDesc->length = (uint16_t)length;
+                pDesc->addressLow = (uint32_t)address;
+                pDesc->addressHigh = (uint32_t)((uint64_t)address >> 32);
+                pDesc->reserved = 0u;
+
+                numDescriptors++;
+                address += length;
+                remaining -= length;
+            }
+        }
+    }
+
+    if (result) {
+        pTable[numDescriptors - 1u].attribute |= HSS_MMC_ADMA2_ATTR_END;
+    } else {
+        numDescriptors = 0u;
+    }
+
+    return numDescriptors;
+}
@@ -0,0 +1,73 @@
+#ifndef HSS_MMC_ADMA2_H
+#define HSS_MMC_ADMA2_H
+
+
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *
+ * Hart Software Services - MMC ADMA2 Descriptor Tables
+ *
+ */
+
+/*!
+ * \file MMC ADMA2 Descriptor Tables
+ * \brief Construction of ADMA2 descriptor tables for scattered MMC reads
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hss_types.h"
+#include "mmc_service.h"
+
+//
+// the MMC controller runs in Host Version 4 mode with 64-bit addressing, which uses
+// 128-bit descriptors
+struct HSS_MMC_ADMA2_Descriptor
+{
+    uint16_t attribute;
+    uint16_t length;
+    uint32_t addressLow;
+    uint32_t addressHigh;
+    uint32_t reserved;
+};
+
+#define HSS_MMC_ADMA2_ATTR_VALID        (1u << 0)
+#define HSS_MMC_ADMA2_ATTR_END          (1u << 1)
+#define HSS_MMC_ADMA2_ATTR_INT          (1u << 2)
+#define HSS_MMC_ADMA2_ATTR_ACT_TRAN     (2u << 4)
+
+#define HSS_MMC_ADMA2_MAX_LENGTH        (32768u)    // per descriptor
+#define HSS_MMC_ADMA2_ADDRESS_ALIGN     (4u)
+
+size_t HSS_MMC_ADMA2_BuildTable(struct HSS_MMC_ADMA2_Descriptor * const pTable,
+    const size_t maxDescriptors, struct HSS_MMC_ReadSegment const * const pSegments,
+    const size_t numSegments);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
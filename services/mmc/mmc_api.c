@@ -35,6 +35,9 @@
 #endif
 #include "mss_io_config.h"
 #include "hss_memcpy_via_pdma.h"
+#if IS_ENABLED(CONFIG_SERVICE_MMC_ADMA2)
+#  include "mmc_adma2.h"
+#endif
 
 /*
  * MMC doesn't need a "service" to run every super-loop, but it does need to be
@@ -134,7 +137,82 @@ static bool mmc_init_common(mss_mmc_cfg_t *p_mmcConfig)
     return result;
 }
 
+//
+// Bus modes are tried fastest first, descending the ladder until the device comes up.
+// The mode that last brought the device up is remembered, and subsequent initializations
+// (e.g. on switching between SD card and eMMC) start from there rather than from the top.
+// Tuning, where the mode needs it, is re-run by the driver each time, as the sampling
+// point drifts with temperature and voltage
+//
+struct mmc_bus_mode
+{
+    char const * const name;
+    uint8_t const bus_speed_mode;
+    uint32_t const clk_rate;
+};
+
+static char const *mmc_busModeName = "";
+
+static bool mmc_negotiate_bus_mode(mss_mmc_cfg_t *p_mmcConfig, struct mmc_bus_mode const *pModes,
+    size_t const numModes, size_t *pLastGoodMode)
+{
+    bool result = false;
+
+    for (size_t i = (*pLastGoodMode < numModes) ? *pLastGoodMode : 0u; !result && (i < numModes);
+        i++) {
+        p_mmcConfig->bus_speed_mode = pModes[i].bus_speed_mode;
+        p_mmcConfig->clk_rate = pModes[i].clk_rate;
+
+        if ((i + 1u) == numModes) {
+            // slowest mode, so retry as before
+            result = mmc_init_common(p_mmcConfig);
+        } else {
+            result = (MSS_MMC_init(p_mmcConfig) == MSS_MMC_INIT_SUCCESS);
+
+            if (!result) {
+                mmc_reset_block();
+            }
+        }
+
+        if (result) {
+            *pLastGoodMode = i;
+            mmc_busModeName = pModes[i].name;
+        }
+    }
+
+    if (!result) {
+        *pLastGoodMode = numModes;
+    }
+
+    return result;
+}
+
 #if defined(CONFIG_SERVICE_MMC_MODE_EMMC)
+static struct mmc_bus_mode const emmcBusModes[] =
+{
+#if defined(CONFIG_SERVICE_MMC_BUS_VOLTAGE_1V8)
+#  ifdef CONFIG_MODULE_M100PFS
+    { "HS",     MSS_MMC_MODE_SDR,   MSS_MMC_CLOCK_50MHZ },
+#  else
+#    if IS_ENABLED(CONFIG_SERVICE_MMC_BUS_MODE_LADDER)
+    { "HS400",  MSS_MMC_MODE_HS400, MSS_MMC_CLOCK_200MHZ },
+#    endif
+    { "HS200",  MSS_MMC_MODE_HS200, MSS_MMC_CLOCK_200MHZ },
+#    if IS_ENABLED(CONFIG_SERVICE_MMC_BUS_MODE_LADDER)
+    { "DDR52",  MSS_MMC_MODE_DDR,   MSS_MMC_CLOCK_50MHZ },
+    { "HS",     MSS_MMC_MODE_SDR,   MSS_MMC_CLOCK_50MHZ },
+#    endif
+#  endif
+#elif defined(CONFIG_SERVICE_MMC_BUS_VOLTAGE_3V3)
+#  if IS_ENABLED(CONFIG_SERVICE_MMC_BUS_MODE_LADDER)
+    { "DDR52",  MSS_MMC_MODE_DDR,   MSS_MMC_CLOCK_50MHZ },
+#  endif
+    { "HS",     MSS_MMC_MODE_SDR,   MSS_MMC_CLOCK_50MHZ },
+#endif
+};
+
+static size_t emmcLastGoodBusMode = ARRAY_SIZE(emmcBusModes);
+
 static bool mmc_init_emmc(void)
 {
     static mss_mmc_cfg_t emmcConfig =
@@ -143,17 +221,8 @@ static bool mmc_init_emmc(void)
         .data_bus_width = MSS_MMC_DATA_WIDTH_8BIT,
 #if defined(CONFIG_SERVICE_MMC_BUS_VOLTAGE_1V8)
         .bus_voltage = MSS_MMC_1_8V_BUS_VOLTAGE,
-#ifdef CONFIG_MODULE_M100PFS
-        .clk_rate = MSS_MMC_CLOCK_50MHZ,
-        .bus_speed_mode = MSS_MMC_MODE_SDR,
-#else
-        .clk_rate = MSS_MMC_CLOCK_200MHZ,
-        .bus_speed_mode = MSS_MMC_MODE_HS200,
-#endif
 #elif defined(CONFIG_SERVICE_MMC_BUS_VOLTAGE_3V3)
         .bus_voltage = MSS_MMC_3_3V_BUS_VOLTAGE,
-        .clk_rate = MSS_MMC_CLOCK_50MHZ,
-        .bus_speed_mode = MSS_MMC_MODE_SDR,
 #endif
     };
 
@@ -175,25 +244,36 @@ static bool mmc_init_emmc(void)
 #endif
 
     /* Initialize eMMC/SD */
-    result = mmc_init_common(&emmcConfig);
+    result = mmc_negotiate_bus_mode(&emmcConfig, emmcBusModes, ARRAY_SIZE(emmcBusModes),
+        &emmcLastGoodBusMode);
 
     return result;
 }
 #endif
 
 #if defined(CONFIG_SERVICE_MMC_MODE_SDCARD)
+static struct mmc_bus_mode const sdcardBusModes[] =
+{
+#if IS_ENABLED(CONFIG_SERVICE_MMC_DEFAULT_SPEED)
+    { "DS",     MSS_SDCARD_MODE_DEFAULT_SPEED, MSS_MMC_CLOCK_50MHZ },
+#else
+#  if IS_ENABLED(CONFIG_SERVICE_MMC_BUS_MODE_LADDER)
+    { "SDR104", MSS_SDCARD_MODE_SDR104,        MSS_MMC_CLOCK_200MHZ },
+    { "SDR50",  MSS_SDCARD_MODE_SDR50,         MSS_MMC_CLOCK_100MHZ },
+    { "DDR50",  MSS_SDCARD_MODE_DDR50,         MSS_MMC_CLOCK_50MHZ },
+#  endif
+    { "HS",     MSS_SDCARD_MODE_HIGH_SPEED,    MSS_MMC_CLOCK_50MHZ },
+#endif
+};
+
+static size_t sdcardLastGoodBusMode = ARRAY_SIZE(sdcardBusModes);
+
 static bool mmc_init_sdcard(void)
 {
     static mss_mmc_cfg_t sdcardConfig =
     {
         .card_type = MSS_MMC_CARD_TYPE_SD,
         .data_bus_width = MSS_MMC_DATA_WIDTH_4BIT,
-#if IS_ENABLED(CONFIG_SERVICE_MMC_DEFAULT_SPEED)
-        .bus_speed_mode = MSS_SDCARD_MODE_DEFAULT_SPEED,
-#else
-        .bus_speed_mode = MSS_SDCARD_MODE_HIGH_SPEED,
-#endif
-        .clk_rate = MSS_MMC_CLOCK_50MHZ,
     };
 
 
@@ -215,18 +295,24 @@ static bool mmc_init_sdcard(void)
 #endif
 
     /* Initialize eMMC/SD */
-    result = mmc_init_common(&sdcardConfig);
+    result = mmc_negotiate_bus_mode(&sdcardConfig, sdcardBusModes, ARRAY_SIZE(sdcardBusModes),
+        &sdcardLastGoodBusMode);
 
     return result;
 }
 #endif
 
+static void mmc_cache_reset_(void);
+
 static bool mmc_initialized = false;
+static bool mmc_isEMMC = false;
 bool HSS_MMCInit(void)
 {
     bool result = false;
 
     mmc_initialized = false;
+    mmc_isEMMC = false;
+    mmc_cache_reset_();
     int perf_ctr_index = PERF_CTR_UNINITIALIZED;
     HSS_PerfCtr_Allocate(&perf_ctr_index, "MMC Init");
 
@@ -242,14 +328,17 @@ bool HSS_MMCInit(void)
     if ((mmc_selectedMedium == MMC_SELECT_SDCARD_ONLY) || (mmc_selectedMedium == MMC_SELECT_SDCARD_FALLBACK_EMMC)) {
         mHSS_DEBUG_PRINTF(LOG_STATUS, "Attempting to select SDCARD ... ");
         mmc_initialized = mmc_init_sdcard();
-        mHSS_DEBUG_PRINTF_EX("%s\n", mmc_initialized ? "Passed" : "Failed");
+        mHSS_DEBUG_PRINTF_EX("%s%s\n", mmc_initialized ? "Passed " : "Failed",
+            mmc_initialized ? mmc_busModeName : "");
     }
 #endif
 #if defined(CONFIG_SERVICE_MMC_MODE_EMMC)
     if ((!mmc_initialized) && ((mmc_selectedMedium == MMC_SELECT_EMMC_ONLY) || (mmc_selectedMedium == MMC_SELECT_SDCARD_FALLBACK_EMMC))) {
         mHSS_DEBUG_PRINTF(LOG_STATUS, "Attempting to select eMMC ... ");
         mmc_initialized = mmc_init_emmc();
-        mHSS_DEBUG_PRINTF_EX("%s\n", mmc_initialized ? "Passed" : "Failed");
+        mmc_isEMMC = mmc_initialized;
+        mHSS_DEBUG_PRINTF_EX("%s%s\n", mmc_initialized ? "Passed " : "Failed",
+            mmc_initialized ? mmc_busModeName : "");
     }
 #endif
     HSS_PerfCtr_Lap(perf_ctr_index);
@@ -267,7 +356,405 @@ bool HSS_MMCInit(void)
 //
 static char runtBuffer[HSS_MMC_SECTOR_SIZE] __attribute__((aligned(sizeof(uint32_t))));
 
+static bool mmc_read_block_(void *pDest, size_t srcOffset, size_t byteCount);
+
+#if IS_ENABLED(CONFIG_SERVICE_MMC_READ_CACHE)
+//
+// Small reads (GPT headers and partition entries, boot image headers, ...) are served
+// from a read-ahead cache of a few lines of consecutive sectors. A miss that carries on
+// from where the previous read ended fetches a whole line in one command, anticipating
+// that the next read will follow on again. Any other miss fetches only the sectors it
+// needs. Reads of a line or more bypass the cache, and writes invalidate the lines they
+// overlap
+//
+#define MMC_CACHE_NUM_LINES      (CONFIG_SERVICE_MMC_READ_CACHE_LINES)
+#define MMC_CACHE_LINE_SIZE      (CONFIG_SERVICE_MMC_READ_CACHE_SECTORS * HSS_MMC_SECTOR_SIZE)
+
+static struct {
+    size_t offset;
+    size_t byteCount; // zero if the line is invalid
+    uint32_t lastUsed;
+} cacheLines_[MMC_CACHE_NUM_LINES];
+
+static char cacheData_[MMC_CACHE_NUM_LINES][MMC_CACHE_LINE_SIZE]
+    __attribute__((aligned(sizeof(uint32_t))));
+
+static uint32_t cacheTick_ = 0u;
+static size_t cacheNextOffset_ = 0u;
+
+static void mmc_cache_reset_(void)
+{
+    for (size_t i = 0u; i < MMC_CACHE_NUM_LINES; i++) {
+        cacheLines_[i].byteCount = 0u;
+    }
+
+    cacheNextOffset_ = 0u;
+}
+
+static void mmc_cache_invalidate_(size_t offset, size_t byteCount)
+{
+    for (size_t i = 0u; i < MMC_CACHE_NUM_LINES; i++) {
+        if (cacheLines_[i].byteCount && (cacheLines_[i].offset - offset < byteCount
+            || offset - cacheLines_[i].offset < cacheLines_[i].byteCount)) {
+            cacheLines_[i].byteCount = 0u;
+        }
+    }
+}
+
+static size_t mmc_cache_find_line_(size_t offset)
+{
+    size_t line = MMC_CACHE_NUM_LINES;
+
+    for (size_t i = 0u; i < MMC_CACHE_NUM_LINES; i++) {
+        if (cacheLines_[i].byteCount && (offset - cacheLines_[i].offset < cacheLines_[i].byteCount)) {
+            line = i;
+            break;
+        }
+    }
+
+    return line;
+}
+
+static size_t mmc_cache_fill_line_(size_t offset, size_t byteCount, bool readAhead)
+{
+    // replace an invalid line if there is one, otherwise the least recently used
+    size_t line = 0u;
+
+    for (size_t i = 0u; i < MMC_CACHE_NUM_LINES; i++) {
+        if (!cacheLines_[i].byteCount) {
+            line = i;
+            break;
+        } else if ((cacheTick_ - cacheLines_[i].lastUsed) > (cacheTick_ - cacheLines_[line].lastUsed)) {
+            line = i;
+        }
+    }
+
+    size_t fillSize = byteCount;
+    if (fillSize & (HSS_MMC_SECTOR_SIZE-1)) {
+        fillSize = ((fillSize / HSS_MMC_SECTOR_SIZE) + 1u) * HSS_MMC_SECTOR_SIZE;
+    }
+
+    cacheLines_[line].byteCount = 0u;
+
+    // a read-ahead may run off the end of the device, so fall back to only what is needed
+    bool result = readAhead && mmc_read_block_(cacheData_[line], offset, MMC_CACHE_LINE_SIZE);
+    if (result) {
+        fillSize = MMC_CACHE_LINE_SIZE;
+    } else {
+        result = mmc_read_block_(cacheData_[line], offset, fillSize);
+    }
+
+    if (result) {
+        cacheLines_[line].offset = offset;
+        cacheLines_[line].byteCount = fillSize;
+    } else {
+        line = MMC_CACHE_NUM_LINES;
+    }
+
+    return line;
+}
+
+bool HSS_MMC_ReadBlock(void *pDest, size_t srcOffset, size_t byteCount)
+{
+    bool result = true;
+    bool const sequential = (srcOffset == cacheNextOffset_);
+
+    cacheNextOffset_ = srcOffset + byteCount;
+
+    if (byteCount >= MMC_CACHE_LINE_SIZE) {
+        result = mmc_read_block_(pDest, srcOffset, byteCount);
+    } else {
+        char *pCDest = (char *)pDest;
+        assert(((size_t)srcOffset & (HSS_MMC_SECTOR_SIZE-1)) == 0u);
+
+        while (result && byteCount) {
+            size_t line = mmc_cache_find_line_(srcOffset);
+
+            if (line == MMC_CACHE_NUM_LINES) {
+                line = mmc_cache_fill_line_(srcOffset, byteCount, sequential);
+            }
+
+            if (line == MMC_CACHE_NUM_LINES) {
+                result = false;
+            } else {
+                size_t const lineOffset = srcOffset - cacheLines_[line].offset;
+                size_t const copySize = MIN(byteCount, cacheLines_[line].byteCount - lineOffset);
+
+                memcpy(pCDest, cacheData_[line] + lineOffset, copySize);
+                cacheLines_[line].lastUsed = ++cacheTick_;
+
+                pCDest += copySize;
+                srcOffset += copySize;
+                byteCount -= copySize;
+            }
+        }
+    }
+
+    return result;
+}
+#else
+static void mmc_cache_reset_(void)
+{
+    ;
+}
+
+static inline void mmc_cache_invalidate_(size_t offset, size_t byteCount)
+{
+    (void)offset;
+    (void)byteCount;
+}
+
 bool HSS_MMC_ReadBlock(void *pDest, size_t srcOffset, size_t byteCount)
+{
+    return mmc_read_block_(pDest, srcOffset, byteCount);
+}
+#endif
+
+#if IS_ENABLED(CONFIG_SERVICE_MMC_ADMA2)
+//
+// ADMA2 transfers are issued as a single command, described by a descriptor table. A
+// transfer started in the background is tracked until it completes, and its result is
+// latched so that it is not lost if a blocking access has to wait for it in the meantime
+//
+#define MMC_ADMA2_NUM_DESCRIPTORS (64u)
+#define MMC_ADMA2_MAX_TRANSFER    (MMC_ADMA2_NUM_DESCRIPTORS * HSS_MMC_ADMA2_MAX_LENGTH)
+
+// one extra descriptor for a runt sector
+static struct HSS_MMC_ADMA2_Descriptor adma2Table_[MMC_ADMA2_NUM_DESCRIPTORS + 1u]
+    __attribute__((aligned(8)));
+
+static struct {
+    bool inFlight;
+    bool result;
+    char *pRuntDest;
+    size_t runtByteCount;
+} asyncTransfer_ = { false, true, NULL, 0u };
+
+static bool mmc_poll_async_transfer_(void)
+{
+    if (asyncTransfer_.inFlight) {
+        mss_mmc_status_t const status = PLIC_mmc_main_IRQHandler();
+
+        if (status != MSS_MMC_TRANSFER_IN_PROGRESS) {
+            asyncTransfer_.inFlight = false;
+            asyncTransfer_.result = (status == MSS_MMC_TRANSFER_SUCCESS);
+
+            if (!asyncTransfer_.result) {
+                mHSS_DEBUG_PRINTF(LOG_ERROR, "ADMA2 transfer unexpectedly returned %d\n", status);
+            } else if (asyncTransfer_.runtByteCount) {
+                memcpy(asyncTransfer_.pRuntDest, runtBuffer, asyncTransfer_.runtByteCount);
+            }
+        }
+    }
+
+    return !asyncTransfer_.inFlight;
+}
+
+static void mmc_wait_async_transfer_(void)
+{
+    while (!mmc_poll_async_transfer_()) {
+        ;
+    }
+}
+
+//
+// multi-block writes to eMMC pre-declare their block count with CMD23, so that the
+// device knows the extent of the write up front. CMD23 is optional for SD cards, so
+// their writes are stopped with CMD12 instead, optionally with an ACMD23 pre-erase hint
+static uint32_t mmc_write_flags_(void)
+{
+    uint32_t flags = 0u;
+
+    if (mmc_isEMMC) {
+        flags |= MSS_MMC_WRITE_SET_BLOCK_COUNT;
+    } else if (IS_ENABLED(CONFIG_SERVICE_MMC_SD_PRE_ERASE)) {
+        flags |= MSS_MMC_WRITE_SD_PRE_ERASE;
+    }
+
+    return flags;
+}
+
+static bool mmc_adma2_start_(bool write, size_t offset, struct HSS_MMC_ReadSegment const *pSegments,
+    size_t numSegments, char *pRuntDest, size_t runtByteCount)
+{
+    bool result = false;
+    size_t byteCount = 0u;
+
+    assert((offset & (HSS_MMC_SECTOR_SIZE-1)) == 0u);
+
+    for (size_t i = 0u; i < numSegments; i++) {
+        byteCount += pSegments[i].byteCount;
+    }
+
+    if (asyncTransfer_.inFlight) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "ADMA2 transfer already in progress\n");
+    } else if (!byteCount || (byteCount & (HSS_MMC_SECTOR_SIZE-1))
+        || (byteCount > (MMC_ADMA2_MAX_TRANSFER + HSS_MMC_SECTOR_SIZE))) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "ADMA2 transfer of %lu bytes not supported\n", byteCount);
+    } else if (!HSS_MMC_ADMA2_BuildTable(adma2Table_, ARRAY_SIZE(adma2Table_), pSegments,
+        numSegments)) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "ADMA2 transfer of %lu segments cannot be described\n",
+            numSegments);
+    } else {
+        mss_mmc_status_t status;
+        uint32_t const sector = (uint32_t)(offset / HSS_MMC_SECTOR_SIZE);
+
+        // drain any transfer started elsewhere
+        do {
+            status = PLIC_mmc_main_IRQHandler();
+        } while (MSS_MMC_TRANSFER_IN_PROGRESS == status);
+
+        // the descriptor table must be in memory before the controller fetches it
+        __sync_synchronize();
+
+        if (write) {
+            status = MSS_MMC_adma2_desc_write(adma2Table_, sector, (uint32_t)byteCount,
+                mmc_write_flags_());
+        } else {
+            status = MSS_MMC_adma2_desc_read(sector, adma2Table_, (uint32_t)byteCount);
+        }
+
+        if (status == MSS_MMC_TRANSFER_IN_PROGRESS) {
+            asyncTransfer_.inFlight = true;
+            asyncTransfer_.pRuntDest = pRuntDest;
+            asyncTransfer_.runtByteCount = runtByteCount;
+            result = true;
+        } else {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "ADMA2 %s unexpectedly returned %d\n",
+                write ? "write" : "read", status);
+        }
+    }
+
+    return result;
+}
+
+bool HSS_MMC_ReadScatterStart(size_t srcOffset, struct HSS_MMC_ReadSegment const *pSegments,
+    size_t numSegments)
+{
+    return mmc_adma2_start_(false, srcOffset, pSegments, numSegments, NULL, 0u);
+}
+
+bool HSS_MMC_ReadBlockStart(void *pDest, size_t srcOffset, size_t byteCount)
+{
+    char *pCDest = (char *)pDest;
+    assert(((size_t)pCDest & (sizeof(uint32_t)-1)) == 0u);
+
+    struct HSS_MMC_ReadSegment segments[2];
+    size_t numSegments = 0u;
+    size_t const runtByteCount = byteCount % HSS_MMC_SECTOR_SIZE;
+    size_t const sectorByteCount = byteCount - runtByteCount;
+
+    if (sectorByteCount) {
+        segments[numSegments].pDest = pCDest;
+        segments[numSegments].byteCount = sectorByteCount;
+        numSegments++;
+    }
+
+    // a partial last sector is read in full to the runt buffer, within the same command
+    if (runtByteCount) {
+        segments[numSegments].pDest = runtBuffer;
+        segments[numSegments].byteCount = HSS_MMC_SECTOR_SIZE;
+        numSegments++;
+    }
+
+    return mmc_adma2_start_(false, srcOffset, segments, numSegments, pCDest + sectorByteCount,
+        runtByteCount);
+}
+
+//
+// HSS_MMC_WriteBlockStart will handle requested writes of less than a multiple of the
+// sector size by rounding up to the next full sector worth. The source must not be
+// modified until the write has completed
+//
+bool HSS_MMC_WriteBlockStart(size_t dstOffset, void *pSrc, size_t byteCount)
+{
+    mmc_cache_invalidate_(dstOffset, byteCount);
+
+    // if byte count is not a multiple of the sector size, round it up...
+    // Use division to avoid integer overflow near SIZE_MAX.
+    if (byteCount & (HSS_MMC_SECTOR_SIZE-1)) {
+        byteCount = ((byteCount / HSS_MMC_SECTOR_SIZE) + 1u) * HSS_MMC_SECTOR_SIZE;
+    }
+
+    assert(((size_t)pSrc & (sizeof(uint32_t)-1)) == 0u);
+
+    struct HSS_MMC_ReadSegment const segment = { pSrc, byteCount };
+    return mmc_adma2_start_(true, dstOffset, &segment, 1u, NULL, 0u);
+}
+
+bool HSS_MMC_IsTransferComplete(bool *pResult)
+{
+    bool const complete = mmc_poll_async_transfer_();
+
+    if (complete && pResult) {
+        *pResult = asyncTransfer_.result;
+    }
+
+    return complete;
+}
+
+static bool mmc_read_block_(void *pDest, size_t srcOffset, size_t byteCount)
+{
+    char *pCDest = (char *)pDest;
+    bool result = true;
+
+    mmc_wait_async_transfer_();
+
+    while (result && byteCount) {
+        size_t const readSize = MIN(byteCount, (size_t)MMC_ADMA2_MAX_TRANSFER);
+
+        result = HSS_MMC_ReadBlockStart(pCDest, srcOffset, readSize);
+        if (result) {
+            mmc_wait_async_transfer_();
+            result = asyncTransfer_.result;
+        }
+
+        pCDest += readSize;
+        srcOffset += readSize;
+        byteCount -= readSize;
+    }
+
+    return result;
+}
+
+//
+// HSS_MMC_WriteBlock will handle requested writes of less than a multiple of the sector
+// size by rounding up to the next full sector worth. Each piece is written as a single
+// multi-block command
+//
+bool HSS_MMC_WriteBlock(size_t dstOffset, void *pSrc, size_t byteCount)
+{
+    char *pCSrc = (char *)pSrc;
+    bool result = true;
+
+    mmc_wait_async_transfer_();
+
+    while (result && byteCount) {
+#if IS_ENABLED(CONFIG_SERVICE_WDOG)
+        HSS_Wdog_E51_Tickle();
+#endif
+        size_t const writeSize = MIN(byteCount, (size_t)MMC_ADMA2_MAX_TRANSFER);
+
+        result = HSS_MMC_WriteBlockStart(dstOffset, pCSrc, writeSize);
+        if (result) {
+            mmc_wait_async_transfer_();
+            result = asyncTransfer_.result;
+        }
+
+        pCSrc += writeSize;
+        dstOffset += writeSize;
+        byteCount -= writeSize;
+    }
+
+    return result;
+}
+
+bool HSS_MMC_WriteBlockSDMA(size_t dstOffset, void *pSrc, size_t byteCount)
+{
+    return HSS_MMC_WriteBlock(dstOffset, pSrc, byteCount);
+}
+#else
+static bool mmc_read_block_(void *pDest, size_t srcOffset, size_t byteCount)
 {
     char *pCDest = (char *)pDest;
     assert(((size_t)srcOffset & (HSS_MMC_SECTOR_SIZE-1)) == 0u);
@@ -326,6 +813,8 @@ bool HSS_MMC_WriteBlock(size_t dstOffset, void *pSrc, size_t byteCount)
 {
     char *pCSrc = (char *)pSrc;
 
+    mmc_cache_invalidate_(dstOffset, byteCount);
+
     // if byte count is not a multiple of the sector size, round it up...
     // Use division to avoid integer overflow near SIZE_MAX.
     if (byteCount & (HSS_MMC_SECTOR_SIZE-1)) {
@@ -371,6 +860,8 @@ bool HSS_MMC_WriteBlockSDMA(size_t dstOffset, void *pSrc, size_t byteCount)
 {
     char *pCSrc = (char *)pSrc;
 
+    mmc_cache_invalidate_(dstOffset, byteCount);
+
     // if byte count is not a multiple of the sector size, round it up...
     if (byteCount & (HSS_MMC_SECTOR_SIZE-1)) {
         byteCount = byteCount + HSS_MMC_SECTOR_SIZE;
@@ -407,9 +898,90 @@ bool HSS_MMC_WriteBlockSDMA(size_t dstOffset, void *pSrc, size_t byteCount)
     return (result == MSS_MMC_TRANSFER_SUCCESS);
 }
 
+#endif
+
 void HSS_MMC_GetInfo(uint32_t *pBlockSize, uint32_t *pEraseSize, uint32_t *pBlockCount)
 {
     uint16_t sectorSize;
     MSS_MMC_get_info(&sectorSize, pBlockCount);
     *pEraseSize = *pBlockSize = sectorSize;
 }
+
+#if defined(CONFIG_SERVICE_MMC_MODE_EMMC)
+//
+// eMMC devices have two hardware boot partitions, BOOT1 and BOOT2, alongside the user
+// data area. The device boots from whichever is enabled in PARTITION_CONFIG, so that an
+// update can be written to the other and then made active by rewriting PARTITION_CONFIG
+//
+#define MMC_PARTITION_ACCESS_MASK       (0x07u)
+#define MMC_BOOT_PARTITION_ENABLE_SHIFT (3u)
+
+static void mmc_wait_idle_(void)
+{
+    mss_mmc_status_t status;
+
+#if IS_ENABLED(CONFIG_SERVICE_MMC_ADMA2)
+    mmc_wait_async_transfer_();
+#endif
+    do {
+        status = PLIC_mmc_main_IRQHandler();
+    } while (MSS_MMC_TRANSFER_IN_PROGRESS == status);
+}
+
+bool HSS_MMC_GetBootPartitionInfo(enum HSS_MMC_HWPartition *pPreferred, size_t *pByteCount)
+{
+    bool result = false;
+    uint8_t partitionConfig = 0u;
+    uint32_t byteCount = 0u;
+
+    assert(pPreferred);
+    assert(pByteCount);
+
+    if (mmc_initialized && mmc_isEMMC) {
+        mmc_wait_idle_();
+        result = (MSS_MMC_get_partition_config(&partitionConfig, &byteCount)
+            == MSS_MMC_TRANSFER_SUCCESS) && byteCount;
+    }
+
+    if (result) {
+        // prefer the partition enabled for boot, or BOOT1 if neither is
+        if (((partitionConfig >> MMC_BOOT_PARTITION_ENABLE_SHIFT) & MMC_PARTITION_ACCESS_MASK)
+            == HSS_MMC_PARTITION_BOOT2) {
+            *pPreferred = HSS_MMC_PARTITION_BOOT2;
+        } else {
+            *pPreferred = HSS_MMC_PARTITION_BOOT1;
+        }
+
+        *pByteCount = byteCount;
+    }
+
+    return result;
+}
+
+bool HSS_MMC_SelectHWPartition(enum HSS_MMC_HWPartition partition)
+{
+    bool result = mmc_initialized && mmc_isEMMC;
+    uint8_t partitionConfig = 0u;
+    uint32_t byteCount;
+
+    if (result) {
+        mmc_wait_idle_();
+        result = (MSS_MMC_get_partition_config(&partitionConfig, &byteCount)
+            == MSS_MMC_TRANSFER_SUCCESS);
+    }
+
+    if (result && ((partitionConfig & MMC_PARTITION_ACCESS_MASK) != (uint8_t)partition)) {
+        partitionConfig = (uint8_t)((partitionConfig & ~MMC_PARTITION_ACCESS_MASK) | partition);
+        result = (MSS_MMC_set_partition_config(partitionConfig) == MSS_MMC_TRANSFER_SUCCESS);
+
+        // cached sectors belong to the previous partition
+        mmc_cache_reset_();
+    }
+
+    if (!result) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "Unable to select eMMC partition %d\n", partition);
+    }
+
+    return result;
+}
+#endif
@@ -0,0 +1,73 @@
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/*!
+ * \file MMC Boot Partitions
+ * \brief Selection of the eMMC hardware boot partition to boot from
+ *
+ * This only uses the MMC service API, so that the fallback from one boot partition to
+ * the other, and the return to the user data area, can be checked against a model of an
+ * eMMC device, without the MMC controller.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_debug.h"
+
+#include "mmc_boot_partition.h"
+
+//
+// eMMC hardware boot partitions hold a boot image at offset 0, with no partition table to
+// parse. The partition enabled for boot is tried first, falling back to the other if its
+// image cannot be loaded. The user data area is selected again once done, whatever the
+// result.
+//
+// Returns true if a boot image was loaded
+//
+bool HSS_MMC_BootFromBootPartition(struct HSS_BootImage *pHeader,
+    HSS_MMC_BootPartitionLoadFn loadFn, void *pContext)
+{
+    bool result = false;
+    enum HSS_MMC_HWPartition partition;
+    size_t partitionSize;
+
+    if (HSS_MMC_GetBootPartitionInfo(&partition, &partitionSize)) {
+        for (size_t attempt = 0u; !result && (attempt < 2u); attempt++) {
+            mHSS_DEBUG_PRINTF(LOG_NORMAL, "Trying eMMC boot partition BOOT%d ...\n", partition);
+
+            //
+            // boot partitions are often left empty, so check for an image quietly before
+            // trying to load it
+            result = HSS_MMC_SelectHWPartition(partition)
+                && HSS_MMC_ReadBlock(pHeader, 0u, sizeof(struct HSS_BootImage))
+                && ((pHeader->magic == mHSS_BOOT_MAGIC) || (pHeader->magic == mHSS_COMPRESSED_MAGIC));
+
+            if (!result) {
+                mHSS_DEBUG_PRINTF(LOG_NORMAL, "No boot image in BOOT%d\n", partition);
+            } else {
+                result = loadFn(pContext, partition, partitionSize);
+            }
+
+            if (!result) {
+                partition = (partition == HSS_MMC_PARTITION_BOOT1) ?
+                    HSS_MMC_PARTITION_BOOT2 : HSS_MMC_PARTITION_BOOT1;
+            }
+        }
+
+        if (!HSS_MMC_SelectHWPartition(HSS_MMC_PARTITION_USER)) {
+            result = false;
+        }
+
+        if (!result) {
+            mHSS_DEBUG_PRINTF(LOG_WARN, "No valid boot image in eMMC boot partitions\n");
+        }
+    }
+
+    return result;
+}
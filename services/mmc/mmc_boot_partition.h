@@ -0,0 +1,58 @@
+#ifndef HSS_MMC_BOOT_PARTITION_H
+#define HSS_MMC_BOOT_PARTITION_H
+
+
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *
+ * Hart Software Services - MMC Boot Partitions
+ *
+ */
+
+/*!
+ * \file MMC Boot Partitions
+ * \brief Selection of the eMMC hardware boot partition to boot from
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hss_types.h"
+#include "mmc_service.h"
+
+//
+// loads the boot image from offset 0 of the boot partition selected, whose header has been
+// read into pHeader and has a valid magic number
+typedef bool (*HSS_MMC_BootPartitionLoadFn)(void *pContext, enum HSS_MMC_HWPartition partition,
+    size_t partitionSize);
+
+bool HSS_MMC_BootFromBootPartition(struct HSS_BootImage *pHeader,
+    HSS_MMC_BootPartitionLoadFn loadFn, void *pContext) __attribute__((nonnull(1, 2)));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -41,14 +41,34 @@ extern "C" {
 
 #include "hss_types.h"
 
+struct HSS_MMC_ReadSegment
+{
+    void *pDest;
+    size_t byteCount;
+};
+
+enum HSS_MMC_HWPartition
+{
+    HSS_MMC_PARTITION_USER = 0,
+    HSS_MMC_PARTITION_BOOT1 = 1,
+    HSS_MMC_PARTITION_BOOT2 = 2,
+};
+
 bool HSS_MMCInit(void);
 bool HSS_MMC_ReadBlock(void *pDest, size_t srcOffset, size_t byteCount);
+bool HSS_MMC_ReadBlockStart(void *pDest, size_t srcOffset, size_t byteCount);
+bool HSS_MMC_ReadScatterStart(size_t srcOffset, struct HSS_MMC_ReadSegment const *pSegments,
+    size_t numSegments);
 bool HSS_MMC_WriteBlock(size_t dstOffset, void *pSrc, size_t byteCount);
+bool HSS_MMC_WriteBlockStart(size_t dstOffset, void *pSrc, size_t byteCount);
+bool HSS_MMC_IsTransferComplete(bool *pResult);
 bool HSS_MMC_WriteBlockSDMA(size_t dstOffset, void *pSrc, size_t byteCount);
 void HSS_MMC_GetInfo(uint32_t *pBlockSize, uint32_t *pEraseSize, uint32_t *pBlockCount);
 void HSS_MMC_SelectSDCARD(void);
 void HSS_MMC_SelectMMC(void);
 void HSS_MMC_SelectEMMC(void);
+bool HSS_MMC_GetBootPartitionInfo(enum HSS_MMC_HWPartition *pPreferred, size_t *pByteCount);
+bool HSS_MMC_SelectHWPartition(enum HSS_MMC_HWPartition partition);
 
 #ifdef __cplusplus
 }
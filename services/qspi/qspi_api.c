@@ -18,13 +18,16 @@
 #include "ddr_service.h"
 #include "hss_progress.h"
 #include "hss_debug.h"
+#include "hss_crc32.h"
 
 #include <assert.h>
 #include <string.h>
 
 #include "qspi_service.h"
 #include "encoding.h"
+#include "sbi_bitops.h"
 #include "mss_qspi.h"
+#include "qspi_discovery.h"
 #include "mss_sys_services.h"
 
 #include "mss_peripherals.h"
@@ -70,227 +73,1335 @@ static uint32_t numBadBlocks;
 
 static uint16_t *pLogicalToPhysicalMap = NULL;
 static uint16_t *pBadBlocksMap = NULL;
-static struct HSS_QSPI_Cache_Descriptor
+
+#define QSPI_MAX_BLOCKS_PER_DIE   (1024u)
+#define QSPI_BBT_NUM_BLOCKS       (4u) // reserved at the end of the device for the bad block table
+
+//
+// The block cache is set-associative, with least-recently-used replacement within each
+// set. Each cache entry holds one erase block, tagged by its logical block number.
+//
+#define QSPI_CACHE_NUM_BLOCKS     (CONFIG_SERVICE_QSPI_CACHE_BLOCKS)
+#define QSPI_CACHE_NUM_WAYS       (CONFIG_SERVICE_QSPI_CACHE_WAYS)
+#define QSPI_CACHE_NUM_SETS       (QSPI_CACHE_NUM_BLOCKS / QSPI_CACHE_NUM_WAYS)
+#define QSPI_CACHE_INVALID_BLOCK  (UINT32_MAX)
+
+_Static_assert((QSPI_CACHE_NUM_BLOCKS % QSPI_CACHE_NUM_WAYS) == 0,
+    "QSPI cache size must be a multiple of the number of ways");
+
+static struct HSS_QSPI_Cache_Entry
 {
-    bool dirtyCache;
-    bool inCache;
-} *pLogicalBlockDesc = NULL;
+    uint32_t logicalBlock;
+    uint32_t lastUsed;
+} cacheEntries_[QSPI_CACHE_NUM_BLOCKS];
+static uint32_t cacheUseCounter_ = 0u;
 static uint8_t *pCacheDataBuffer = NULL;
 
+static void write_back_quiesce_(void);
+static void write_back_yield_(struct HSS_QSPI_Cache_Entry const * const pVictim);
+static void write_back_sync_(void);
+
+//
+// dirty cache blocks are tracked in a bitmap indexed by logical block number, so that
+// a flush visits only the dirty blocks, in ascending order
+static unsigned long dirtyBitmap_[BITS_TO_LONGS(QSPI_MAX_BLOCKS_PER_DIE)];
+static size_t dirtyBlockCount_ = 0u;
+
 static bool qspiInitialized = false;
 static size_t qspiIndex = 0u;
+static struct FlashDescriptor *pFlash = &qspiFlashes[0];
+static mss_qspi_io_format readFormat_ = MSS_QSPI_QUAD_FULL;
+
+//
+// Flash_init() resets and reconfigures both the controller and the flash device, so the
+// current IO format is tracked and the format is only switched when a different one is
+// needed
+static mss_qspi_io_format currentFormat_ = MSS_QSPI_NORMAL;
+static bool currentFormatValid_ = false;
+
+//
+// descriptor for a flash not in qspiFlashes[], filled in from its own parameter table
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_WINBOND_W25N01GV)
+static struct FlashDescriptor discoveredFlash_ = { 0u, 0u, 0u, 0u, SPI_NAND, "ONFI NAND" };
+#else
+static struct FlashDescriptor discoveredFlash_ = { 0u, 0u, 0u, 0u, SPI_NOR, "SFDP NOR" };
+#endif
 bool cacheDirtyFlag = false;
 
-////////////////////////////////////////////////////////////////////////////////////////
-//
-// Generic Local module functions
-//
-__attribute__((nonnull)) static bool flash_id_to_descriptor_(const uint32_t jedec_id, size_t *indexOut)
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Generic Local module functions
+//
+__attribute__((nonnull)) static bool flash_id_to_descriptor_(const uint32_t jedec_id, size_t *indexOut)
+{
+    bool result = false;
+    assert(indexOut);
+
+    for (size_t i = 0u; i < ARRAY_SIZE(qspiFlashes); i++) {
+        if (qspiFlashes[i].jedecId == jedec_id) {
+            *indexOut = i;
+            result = true;
+            break;
+        }
+    }
+
+    return result;
+}
+
+//
+// the number of physical blocks available for data, after any reserved for the bad block table
+static inline uint32_t usable_physical_blocks_(void)
+{
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_BAD_BLOCK_TABLE)
+    return pFlash->blocksPerDie - QSPI_BBT_NUM_BLOCKS;
+#else
+    return pFlash->blocksPerDie;
+#endif
+}
+
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_BAD_BLOCK_TABLE)
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Bad Block Table
+//
+// The list of bad blocks is stored in the first page of two good blocks within the last
+// QSPI_BBT_NUM_BLOCKS blocks of the device, so that it can be loaded with a few page
+// reads rather than by reading the spare area of every block. Each copy carries a
+// sequence number and a CRC, and on update the older copy is rewritten first, so that a
+// valid copy survives a power loss at any point.
+//
+
+#define QSPI_BBT_MAGIC             (0x54424251u) // "QBBT"
+#define QSPI_BBT_VERSION           (1u)
+#define QSPI_BBT_NUM_COPIES        (2u)
+#define QSPI_BBT_MAX_BAD_BLOCKS    (256u)
+
+struct HSS_QSPI_BBT
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t numBadBlocks;
+    uint32_t sequence;
+    uint32_t crc;
+    uint16_t badBlocks[QSPI_BBT_MAX_BAD_BLOCKS];
+};
+
+static struct HSS_QSPI_BBT *pBbt = NULL;
+static struct HSS_QSPI_BBT *pBbtScratch = NULL;
+static uint32_t bbtBlocks_[QSPI_BBT_NUM_COPIES];
+static uint32_t bbtCopySequence_[QSPI_BBT_NUM_COPIES];
+
+static uint32_t bbt_crc_(struct HSS_QSPI_BBT * const pTable)
+{
+    const uint32_t storedCrc = pTable->crc;
+
+    pTable->crc = 0u;
+    const uint32_t result = CRC32_calculate((const uint8_t *)pTable, sizeof(*pTable));
+    pTable->crc = storedCrc;
+
+    return result;
+}
+
+static bool bbt_is_valid_(struct HSS_QSPI_BBT * const pTable)
+{
+    bool result = (pTable->magic == QSPI_BBT_MAGIC) && (pTable->version == QSPI_BBT_VERSION)
+        && (pTable->numBadBlocks <= QSPI_BBT_MAX_BAD_BLOCKS) && (bbt_crc_(pTable) == pTable->crc);
+
+    for (size_t i = 0u; result && (i < pTable->numBadBlocks); i++) {
+        if ((pTable->badBlocks[i] >= pFlash->blocksPerDie)
+            || ((i > 0u) && (pTable->badBlocks[i] <= pTable->badBlocks[i - 1u]))) {
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+//
+// the table copies live in the first good blocks of the reserved area
+static bool bbt_locate_copies_(void)
+{
+    size_t copy = 0u;
+
+    for (uint32_t physicalBlock = usable_physical_blocks_();
+        (physicalBlock < pFlash->blocksPerDie) && (copy < QSPI_BBT_NUM_COPIES);
+        physicalBlock++) {
+        bool isBad = false;
+
+        for (size_t i = 0u; i < numBadBlocks; i++) {
+            if (pBadBlocksMap[i] == physicalBlock) {
+                isBad = true;
+                break;
+            }
+        }
+
+        if (!isBad) {
+            bbtBlocks_[copy] = physicalBlock;
+            copy++;
+        }
+    }
+
+    return (copy == QSPI_BBT_NUM_COPIES);
+}
+
+static bool bbt_load_(void)
+{
+    bool result = false;
+    uint32_t blockSequence[QSPI_BBT_NUM_BLOCKS] = { 0u };
+
+    for (size_t i = 0u; i < QSPI_BBT_NUM_BLOCKS; i++) {
+        const uint32_t physicalBlock = usable_physical_blocks_() + i;
+
+        Flash_read((uint8_t *)pBbtScratch, physicalBlock * blockSize, sizeof(*pBbtScratch));
+        if (bbt_is_valid_(pBbtScratch)) {
+            blockSequence[i] = pBbtScratch->sequence;
+
+            if (!result || (pBbtScratch->sequence > pBbt->sequence)) {
+                memcpy(pBbt, pBbtScratch, sizeof(*pBbt));
+                result = true;
+            }
+        }
+    }
+
+    if (result) {
+        numBadBlocks = pBbt->numBadBlocks;
+        memcpy(pBadBlocksMap, pBbt->badBlocks, numBadBlocks * sizeof(*pBadBlocksMap));
+
+        result = bbt_locate_copies_();
+        for (size_t copy = 0u; result && (copy < QSPI_BBT_NUM_COPIES); copy++) {
+            bbtCopySequence_[copy] = blockSequence[bbtBlocks_[copy] - usable_physical_blocks_()];
+        }
+    }
+
+    return result;
+}
+
+static bool bbt_store_(void)
+{
+    bool result = (numBadBlocks <= QSPI_BBT_MAX_BAD_BLOCKS) && bbt_locate_copies_();
+
+    if (result) {
+        const uint32_t sequence = MAX(pBbt->sequence, MAX(bbtCopySequence_[0], bbtCopySequence_[1])) + 1u;
+
+        memset(pBbt, 0xFF, sizeof(*pBbt));
+        pBbt->magic = QSPI_BBT_MAGIC;
+        pBbt->version = QSPI_BBT_VERSION;
+        pBbt->numBadBlocks = (uint16_t)numBadBlocks;
+        pBbt->sequence = sequence;
+        memcpy(pBbt->badBlocks, pBadBlocksMap, numBadBlocks * sizeof(*pBadBlocksMap));
+        pBbt->crc = bbt_crc_(pBbt);
+
+        //
+        // rewrite the older copy first, so that the newer one remains valid until
+        // the update has been written
+        const size_t first = (bbtCopySequence_[0] <= bbtCopySequence_[1]) ? 0u : 1u;
+
+        for (size_t i = 0u; result && (i < QSPI_BBT_NUM_COPIES); i++) {
+            const size_t copy = (first + i) % QSPI_BBT_NUM_COPIES;
+            const uint32_t physicalBlock = bbtBlocks_[copy];
+
+            if (Flash_erase_block(physicalBlock)
+                || Flash_program((uint8_t *)pBbt, physicalBlock * blockSize, sizeof(*pBbt))) {
+                mHSS_DEBUG_PRINTF(LOG_ERROR, "Error writing bad block table to block %u\n",
+                    physicalBlock);
+                result = false;
+            } else {
+                bbtCopySequence_[copy] = sequence;
+            }
+        }
+    }
+
+    return result;
+}
+#endif
+
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_WINBOND_W25N01GV)
+//
+// find the bad blocks, from the bad block table if possible, scanning the spare area of
+// every block if not (or if a full scan is requested)
+static void find_bad_blocks_(const bool fullScan)
+{
+#  if IS_ENABLED(CONFIG_SERVICE_QSPI_BAD_BLOCK_TABLE)
+    if (fullScan || !bbt_load_()) {
+        if (!fullScan) {
+            mHSS_DEBUG_PRINTF(LOG_NORMAL, "No valid bad block table found, scanning flash\n");
+        }
+
+        const uint32_t previousNumBadBlocks = pBbt->numBadBlocks;
+        numBadBlocks = Flash_scan_for_bad_blocks(pBadBlocksMap);
+
+        //
+        // only write the table if it is missing, damaged or out of date
+        if ((bbtCopySequence_[0] != bbtCopySequence_[1]) || (bbtCopySequence_[0] == 0u)
+            || (previousNumBadBlocks != numBadBlocks)
+            || memcmp(pBbt->badBlocks, pBadBlocksMap, numBadBlocks * sizeof(*pBadBlocksMap))) {
+            (void)bbt_store_();
+        }
+    } else if (bbtCopySequence_[0] != bbtCopySequence_[1]) {
+        mHSS_DEBUG_PRINTF(LOG_WARN, "Repairing bad block table\n");
+        (void)bbt_store_();
+    }
+#  else
+    (void)fullScan;
+    numBadBlocks = Flash_scan_for_bad_blocks(pBadBlocksMap);
+#  endif
+}
+#endif
+
+//
+// read the flash's own parameter table, for its geometry and fastest read mode
+static bool discover_flash_params_(struct HSS_QSPI_FlashParams * const pParams)
+{
+    uint8_t paramBuffer[256] __attribute__((aligned(4)));
+    bool result = false;
+
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_WINBOND_W25N01GV)
+    //
+    // the ONFI parameter page holds three copies, so fall back to the next on a CRC error
+    for (uint16_t offset = 0u; !result && (offset < (3u * sizeof(paramBuffer))); offset += sizeof(paramBuffer)) {
+        result = !Flash_read_parameter_page(paramBuffer, offset, sizeof(paramBuffer))
+            && HSS_QSPI_ParseONFI(paramBuffer, sizeof(paramBuffer), pParams);
+    }
+#else
+    Flash_read_sfdp(paramBuffer, 0u, sizeof(paramBuffer));
+    result = HSS_QSPI_ParseSFDP(paramBuffer, sizeof(paramBuffer), pParams);
+#endif
+
+    return result;
+}
+
+static uint32_t build_bad_block_map_(const bool fullScan)
+{
+    const uint32_t physicalBlockCount = usable_physical_blocks_();
+
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_WINBOND_W25N01GV)
+    find_bad_blocks_(fullScan);
+
+    size_t badBlockIndex = 0u;
+    size_t logicalBlockIndex = 0u;
+
+    uint32_t badBlocksRemaining = numBadBlocks;
+
+    for (size_t physicalBlockIndex = 0u; physicalBlockIndex < physicalBlockCount; physicalBlockIndex++) {
+        if (badBlocksRemaining && (pBadBlocksMap[badBlockIndex] == physicalBlockIndex)) { // skip bad physical block
+            badBlockIndex++;
+            badBlocksRemaining--;
+        } else { // good physical block, so use
+            pLogicalToPhysicalMap[logicalBlockIndex] = physicalBlockIndex;
+            logicalBlockIndex++;
+        }
+    }
+#else
+    (void)fullScan;
+
+    size_t logicalBlockIndex = 0u;
+    for (size_t physicalBlockIndex = 0u; physicalBlockIndex < physicalBlockCount; physicalBlockIndex++) {
+        pLogicalToPhysicalMap[logicalBlockIndex] = physicalBlockIndex;
+        logicalBlockIndex++;
+    }
+#endif
+
+    return (uint32_t)logicalBlockIndex;
+}
+
+static void rebuild_block_map_(void);
+
+__attribute__((pure)) static inline uint32_t column_to_block_(const uint32_t column_addr)
+{
+    assert(blockSize); // avoid divide by zero
+
+    const uint32_t result = (column_addr / blockSize);
+    return result;
+}
+
+static inline uint32_t logical_to_physical_address_(const uint32_t logical_addr)
+{
+    assert(blockSize); // avoid divide by zero
+
+    const uint16_t logical_block_num = logical_addr / blockSize;
+    const uint32_t remainder = logical_addr % blockSize;
+
+    if (logical_block_num >= blockCount) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "logical_block_num %u >= blockCount %u\n",
+            logical_block_num, blockCount);
+        return 0u;
+    }
+
+    uint16_t physical_block_number = (uint16_t)logical_block_num; // identity fallback
+    if (pLogicalToPhysicalMap != NULL) {
+        physical_block_number = pLogicalToPhysicalMap[logical_block_num];
+    }
+    uint32_t result = (physical_block_number * blockSize) + remainder;
+
+    if (pLogicalToPhysicalMap != NULL && physical_block_number >= pFlash->blocksPerDie) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "Corruption in logical to physical block mapping: %d\n", physical_block_number);
+        rebuild_block_map_();
+        // retry
+        physical_block_number = pLogicalToPhysicalMap[logical_block_num];
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "Second attempt at physical block mapping: %d\n", physical_block_number);
+        result = (physical_block_number * blockSize) + remainder;
+    }
+
+    return result;
+}
+
+static void set_io_format_(const mss_qspi_io_format format)
+{
+    if (!currentFormatValid_ || (currentFormat_ != format)) {
+        Flash_init(format);
+        currentFormat_ = format;
+        currentFormatValid_ = true;
+    }
+}
+
+static inline uint32_t logical_to_physical_block_(const uint32_t logical_block)
+{
+    if (logical_block >= blockCount) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "logical_block %u >= blockCount %u\n",
+            logical_block, blockCount);
+        return 0u;
+    }
+
+    uint32_t result = (uint32_t)logical_block; // identity fallback
+    if (pLogicalToPhysicalMap != NULL) {
+        result = pLogicalToPhysicalMap[logical_block];
+    }
+    if (pLogicalToPhysicalMap != NULL && result >= pFlash->blocksPerDie) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "Corruption in logical to physical block mapping: %d\n", result);
+        rebuild_block_map_();
+        // retry
+        result = pLogicalToPhysicalMap[logical_block];
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "Second attempt at physical block mapping: %d\n", result);
+    }
+
+    return result;
+}
+
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_MICRON_MQ25T)
+static uint8_t flashEraseSector(uint32_t addr)
+{
+    uint8_t status = 0xff;
+
+    /* For the flashes with page size less than 512, as part of
+     * initialization we have already changed the flash parameters,
+     * because of this change the erasable sector size will be 128K
+     * but the actual erasable sector size should be 64K.
+     * so derive the sector address and erase each sector.
+     */
+    if (pFlash->pageSize >= QSPI_MIN_BYTE_SECTOR_SIZE)
+    {
+        status = Flash_sector_erase(addr << 16); // 64K sector
+    }
+    else
+    {
+        /* Total erasable sectors in the given address */
+        uint32_t totalSectors = pFlash->blocksPerDie / pFlash->pageSize;
+        for(int count = 0; count < totalSectors; count++)
+        {
+            status = Flash_sector_erase(((addr * totalSectors) + count) << 16); // 64K sector
+        }
+    }
+
+    return status;
+}
+#endif
+
+static uint8_t erase_block_(const uint32_t physicalBlock)
+{
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_WINBOND_W25N01GV)
+    return Flash_erase_block(physicalBlock);
+#else
+    return flashEraseSector(physicalBlock);
+#endif
+}
+
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_WEAR_LEVELLING)
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Wear Levelling
+//
+// Each physical block has an erase counter. When a dirty logical block is written back,
+// it is moved to the least-worn free physical block if that is less worn than the block
+// it currently occupies. The logical to physical map and the erase counters are kept in
+// a table that is appended, in fixed-size slots, to one of two metadata blocks at the
+// end of the device. At start-up, the copy with the highest sequence number and a valid
+// CRC is used.
+//
+// A physical block released by a remap still holds the data that the table in flash
+// refers to, so it is retired, and only returned to the free pool once the updated
+// table has been written.
+//
+
+#define QSPI_WL_MAGIC              (0x4C575351u) // "QSWL"
+#define QSPI_WL_VERSION            (1u)
+#define QSPI_WL_NUM_META_BLOCKS    (2u)
+#define QSPI_WL_ERASED_WORD        (0xFFFFFFFFu)
+
+struct HSS_QSPI_WL_Table
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t logicalBlockCount;
+    uint32_t sequence;
+    uint32_t crc;
+    uint16_t logicalToPhysical[QSPI_MAX_BLOCKS_PER_DIE];
+    uint32_t eraseCount[QSPI_MAX_BLOCKS_PER_DIE];
+};
+
+static struct HSS_QSPI_WL_Table *pWlTable = NULL;
+static struct HSS_QSPI_WL_Table *pWlScratch = NULL;
+static uint32_t wlSlotPages_ = 0u;
+static uint32_t wlSlotsPerBlock_ = 0u;
+static uint32_t wlMetaBlocks_[QSPI_WL_NUM_META_BLOCKS];
+static size_t wlActiveMeta_ = 0u;
+static size_t wlNextSlot_ = 0u;
+static bool wlTableDirty_ = false;
+#  if IS_ENABLED(CONFIG_SERVICE_QSPI_STATIC_WEAR_LEVELLING)
+static bool wlStaticMoveDone_ = false;
+#  endif
+
+static unsigned long wlFreeBitmap_[BITS_TO_LONGS(QSPI_MAX_BLOCKS_PER_DIE)];
+static unsigned long wlRetiredBitmap_[BITS_TO_LONGS(QSPI_MAX_BLOCKS_PER_DIE)];
+
+static struct {
+    bool pending;
+    uint32_t logicalBlock;
+    uint32_t physicalBlock;
+} wlStaticMove_ = { false, 0u, 0u };
+
+static bool is_bad_block_(const uint32_t physicalBlock)
+{
+    bool result = false;
+
+    for (size_t i = 0u; i < numBadBlocks; i++) {
+        if (pBadBlocksMap[i] == physicalBlock) {
+            result = true;
+            break;
+        }
+    }
+
+    return result;
+}
+
+static bool is_meta_block_(const uint32_t physicalBlock)
+{
+    bool result = false;
+
+    for (size_t i = 0u; i < QSPI_WL_NUM_META_BLOCKS; i++) {
+        if (wlMetaBlocks_[i] == physicalBlock) {
+            result = true;
+            break;
+        }
+    }
+
+    return result;
+}
+
+static uint32_t wl_table_crc_(struct HSS_QSPI_WL_Table * const pTable)
+{
+    const uint32_t storedCrc = pTable->crc;
+
+    pTable->crc = 0u;
+    const uint32_t result = CRC32_calculate((const uint8_t *)pTable, sizeof(*pTable));
+    pTable->crc = storedCrc;
+
+    return result;
+}
+
+static inline uint32_t wl_slot_address_(const size_t meta, const size_t slot)
+{
+    return ((wlMetaBlocks_[meta] * pFlash->pagesPerBlock) + (slot * wlSlotPages_)) * pageSize;
+}
+
+static bool wl_is_table_valid_(struct HSS_QSPI_WL_Table * const pTable)
+{
+    bool result = (pTable->magic == QSPI_WL_MAGIC) && (pTable->version == QSPI_WL_VERSION)
+        && (pTable->logicalBlockCount <= usable_physical_blocks_())
+        && (wl_table_crc_(pTable) == pTable->crc);
+
+    for (size_t i = 0u; result && (i < pTable->logicalBlockCount); i++) {
+        const uint32_t physicalBlock = pTable->logicalToPhysical[i];
+
+        if ((physicalBlock >= usable_physical_blocks_()) || is_meta_block_(physicalBlock)) {
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+static bool wl_load_table_(void)
+{
+    bool result = false;
+    size_t firstUnusedSlot[QSPI_WL_NUM_META_BLOCKS];
+
+    for (size_t meta = 0u; meta < QSPI_WL_NUM_META_BLOCKS; meta++) {
+        firstUnusedSlot[meta] = wlSlotsPerBlock_;
+
+        for (size_t slot = 0u; slot < wlSlotsPerBlock_; slot++) {
+            const uint32_t slotAddress = wl_slot_address_(meta, slot);
+
+            //
+            // slots are written in order, so the first erased slot ends the log in this block
+            Flash_read((uint8_t *)pWlScratch, slotAddress, pageSize);
+            if (pWlScratch->magic == QSPI_WL_ERASED_WORD) {
+                firstUnusedSlot[meta] = slot;
+                break;
+            } else if (pWlScratch->magic != QSPI_WL_MAGIC) {
+                continue;
+            }
+
+            Flash_read((uint8_t *)pWlScratch, slotAddress, sizeof(*pWlScratch));
+            if (wl_is_table_valid_(pWlScratch)
+                && (!result || (pWlScratch->sequence > pWlTable->sequence))) {
+                memcpy(pWlTable, pWlScratch, sizeof(*pWlTable));
+                wlActiveMeta_ = meta;
+                result = true;
+            }
+        }
+    }
+
+    if (result) {
+        wlNextSlot_ = firstUnusedSlot[wlActiveMeta_];
+        wlTableDirty_ = false;
+    }
+
+    return result;
+}
+
+static bool wl_persist_table_(void)
+{
+    bool result = true;
+
+    if (wlNextSlot_ >= wlSlotsPerBlock_) {
+        //
+        // the active metadata block is full, so continue the log in the other one
+        const size_t nextMeta = (wlActiveMeta_ + 1u) % QSPI_WL_NUM_META_BLOCKS;
+
+        pWlTable->eraseCount[wlMetaBlocks_[nextMeta]]++;
+        if (erase_block_(wlMetaBlocks_[nextMeta])) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "Error erasing wear levelling block %u\n",
+                wlMetaBlocks_[nextMeta]);
+            result = false;
+        } else {
+            wlActiveMeta_ = nextMeta;
+            wlNextSlot_ = 0u;
+        }
+    }
+
+    if (result) {
+        pWlTable->sequence++;
+        pWlTable->crc = wl_table_crc_(pWlTable);
+
+        const uint32_t slotAddress = wl_slot_address_(wlActiveMeta_, wlNextSlot_);
+        wlNextSlot_++;
+
+        if (Flash_program((uint8_t *)pWlTable, slotAddress, sizeof(*pWlTable))) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "Error writing wear levelling table\n");
+            result = false;
+        }
+    }
+
+    if (result) {
+        // the retired blocks are no longer referred to by the table in flash
+        for (size_t i = 0u; i < ARRAY_SIZE(wlFreeBitmap_); i++) {
+            wlFreeBitmap_[i] |= wlRetiredBitmap_[i];
+            wlRetiredBitmap_[i] = 0u;
+        }
+
+        wlTableDirty_ = false;
+    }
+
+    return result;
+}
+
+static void wl_build_free_pool_(void)
+{
+    memset(wlFreeBitmap_, 0, sizeof(wlFreeBitmap_));
+    memset(wlRetiredBitmap_, 0, sizeof(wlRetiredBitmap_));
+
+    for (uint32_t physicalBlock = 0u; physicalBlock < usable_physical_blocks_(); physicalBlock++) {
+        if (!is_bad_block_(physicalBlock) && !is_meta_block_(physicalBlock)) {
+            __set_bit(physicalBlock, wlFreeBitmap_);
+        }
+    }
+
+    for (size_t logicalBlock = 0u; logicalBlock < pWlTable->logicalBlockCount; logicalBlock++) {
+        __clear_bit(pWlTable->logicalToPhysical[logicalBlock], wlFreeBitmap_);
+    }
+}
+
+static void wl_init_(void)
+{
+    const uint32_t physicalBlockCount = usable_physical_blocks_();
+
+    wlSlotPages_ = (sizeof(struct HSS_QSPI_WL_Table) + pageSize - 1u) / pageSize;
+    wlSlotsPerBlock_ = pFlash->pagesPerBlock / wlSlotPages_;
+
+    //
+    // the table lives in the last two good blocks available for data
+    size_t meta = 0u;
+    for (uint32_t physicalBlock = physicalBlockCount; physicalBlock-- > 0u; ) {
+        if (meta == QSPI_WL_NUM_META_BLOCKS) {
+            break;
+        } else if (!is_bad_block_(physicalBlock)) {
+            wlMetaBlocks_[meta] = physicalBlock;
+            meta++;
+        }
+    }
+    assert(meta == QSPI_WL_NUM_META_BLOCKS);
+
+    if (!wl_load_table_()) {
+        mHSS_DEBUG_PRINTF(LOG_NORMAL, "No wear levelling table found, creating one\n");
+
+        //
+        // map the logical blocks onto the good blocks in order, holding back spare blocks
+        // for the free pool. This is not the mapping used without wear levelling: the
+        // metadata blocks were the last two logical blocks, and are erased when the table
+        // is first written, and the spare blocks shrink the device, so the flash must be
+        // reformatted when wear levelling is first enabled
+        memset(pWlTable, 0, sizeof(*pWlTable));
+        pWlTable->magic = QSPI_WL_MAGIC;
+        pWlTable->version = QSPI_WL_VERSION;
+
+        size_t logicalBlock = 0u;
+        for (uint32_t physicalBlock = 0u; physicalBlock < physicalBlockCount; physicalBlock++) {
+            if (!is_bad_block_(physicalBlock) && !is_meta_block_(physicalBlock)) {
+                pWlTable->logicalToPhysical[logicalBlock] = physicalBlock;
+                logicalBlock++;
+            }
+        }
+
+        const size_t spareBlocks = MIN((size_t)CONFIG_SERVICE_QSPI_WEAR_LEVELLING_SPARE_BLOCKS, logicalBlock);
+        pWlTable->logicalBlockCount = (uint16_t)(logicalBlock - spareBlocks);
+
+        wlActiveMeta_ = 0u;
+        wlNextSlot_ = wlSlotsPerBlock_; // force a fresh metadata block
+        wlTableDirty_ = true;
+    }
+
+    wl_build_free_pool_();
+    blockCount = pWlTable->logicalBlockCount;
+
+    if (wlTableDirty_) {
+        (void)wl_persist_table_();
+    }
+}
+
+static bool wl_find_free_block_(const bool mostWorn, uint32_t *pPhysicalBlock)
+{
+    bool result = false;
+
+    for (uint32_t physicalBlock = 0u; physicalBlock < usable_physical_blocks_(); physicalBlock++) {
+        if (!__test_bit(physicalBlock, wlFreeBitmap_)) {
+            ;
+        } else if (!result
+            || (mostWorn && (pWlTable->eraseCount[physicalBlock] > pWlTable->eraseCount[*pPhysicalBlock]))
+            || (!mostWorn && (pWlTable->eraseCount[physicalBlock] < pWlTable->eraseCount[*pPhysicalBlock]))) {
+            *pPhysicalBlock = physicalBlock;
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+static uint32_t select_write_target_(const uint32_t logicalBlock)
+{
+    uint32_t result = logical_to_physical_block_(logicalBlock);
+    uint32_t freeBlock;
+
+    if (wlStaticMove_.pending && (wlStaticMove_.logicalBlock == logicalBlock)) {
+        wlStaticMove_.pending = false;
+
+        if (__test_bit(wlStaticMove_.physicalBlock, wlFreeBitmap_)) {
+            result = wlStaticMove_.physicalBlock;
+        }
+    } else {
+        if (!wl_find_free_block_(false, &freeBlock) && wlTableDirty_) {
+            // free pool is exhausted by remaps not yet persisted, so release the retired blocks
+            (void)wl_persist_table_();
+        }
+
+        if (wl_find_free_block_(false, &freeBlock)
+            && (is_bad_block_(result) || (pWlTable->eraseCount[freeBlock] < pWlTable->eraseCount[result]))) {
+            result = freeBlock;
+        }
+    }
+
+    return result;
+}
+
+static inline void note_block_erased_(const uint32_t physicalBlock)
+{
+    pWlTable->eraseCount[physicalBlock]++;
+    wlTableDirty_ = true;
+}
+
+static void commit_block_write_(const uint32_t logicalBlock, const uint32_t physicalBlock)
+{
+    const uint32_t previousBlock = pLogicalToPhysicalMap[logicalBlock];
+
+    if (physicalBlock != previousBlock) {
+        pLogicalToPhysicalMap[logicalBlock] = (uint16_t)physicalBlock;
+        __clear_bit(physicalBlock, wlFreeBitmap_);
+        __set_bit(previousBlock, wlRetiredBitmap_);
+        wlTableDirty_ = true;
+    }
+}
+
+//
+// a block that failed to erase or program is added to the bad blocks, so that it leaves
+// the free pool and its logical block is moved off it when next written back. The
+// logical block keeps its existing mapping until then
+static void retire_failed_block_(const uint32_t physicalBlock)
+{
+    if (!is_bad_block_(physicalBlock) && (numBadBlocks < pFlash->blocksPerDie)) {
+        size_t i = numBadBlocks;
+
+        // keep the list sorted, as the bad block table requires
+        while ((i > 0u) && (pBadBlocksMap[i - 1u] > physicalBlock)) {
+            pBadBlocksMap[i] = pBadBlocksMap[i - 1u];
+            i--;
+        }
+        pBadBlocksMap[i] = (uint16_t)physicalBlock;
+        numBadBlocks++;
+
+        __clear_bit(physicalBlock, wlFreeBitmap_);
+        __clear_bit(physicalBlock, wlRetiredBitmap_);
+
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "Retiring QSPI block %u\n", physicalBlock);
+#  if IS_ENABLED(CONFIG_SERVICE_QSPI_BAD_BLOCK_TABLE)
+        (void)bbt_store_();
+#  endif
+    }
+}
+
+static void wl_print_erase_counts_(void)
+{
+    uint32_t minCount = UINT32_MAX, maxCount = 0u;
+    uint64_t totalCount = 0u;
+    size_t goodBlocks = 0u;
+
+    for (uint32_t physicalBlock = 0u; physicalBlock < usable_physical_blocks_(); physicalBlock++) {
+        if (!is_bad_block_(physicalBlock)) {
+            const uint32_t eraseCount = pWlTable->eraseCount[physicalBlock];
+
+            minCount = MIN(minCount, eraseCount);
+            maxCount = MAX(maxCount, eraseCount);
+            totalCount += eraseCount;
+            goodBlocks++;
+        }
+    }
+
+    if (goodBlocks) {
+        mHSS_DEBUG_PRINTF(LOG_NORMAL, "QSPI Flash: erase counts min %u, max %u, average %lu"
+            " (%u logical blocks, %u spare)\n", minCount, maxCount, totalCount / goodBlocks,
+            blockCount, (uint32_t)(goodBlocks - blockCount - QSPI_WL_NUM_META_BLOCKS));
+    }
+}
+#else
+static inline uint32_t select_write_target_(const uint32_t logicalBlock)
+{
+    return logical_to_physical_block_(logicalBlock);
+}
+
+static inline void note_block_erased_(const uint32_t physicalBlock)
+{
+    (void)physicalBlock;
+}
+
+static inline void commit_block_write_(const uint32_t logicalBlock, const uint32_t physicalBlock)
+{
+    (void)logicalBlock;
+    (void)physicalBlock;
+}
+
+//
+// without wear levelling, logical blocks have fixed homes, so a failed block cannot be
+// replaced, and its logical block is simply left dirty
+static inline void retire_failed_block_(const uint32_t physicalBlock)
+{
+    mHSS_DEBUG_PRINTF(LOG_ERROR, "QSPI block %u failed, and no spare block is available\n",
+        physicalBlock);
+}
+#endif
+
+static void rebuild_block_map_(void)
+{
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_WEAR_LEVELLING)
+    if (wl_load_table_()) {
+        wl_build_free_pool_();
+    } else {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "Unable to reload wear levelling table\n");
+    }
+#else
+    (void)build_bad_block_map_(false);
+#endif
+}
+
+static inline uint8_t *cache_entry_data_(struct HSS_QSPI_Cache_Entry const * const pEntry)
+{
+    return pCacheDataBuffer + ((size_t)(pEntry - cacheEntries_) * blockSize);
+}
+
+static void invalidate_cache_(void)
+{
+    for (size_t i = 0u; i < ARRAY_SIZE(cacheEntries_); i++) {
+        cacheEntries_[i].logicalBlock = QSPI_CACHE_INVALID_BLOCK;
+        cacheEntries_[i].lastUsed = 0u;
+    }
+
+    memset(dirtyBitmap_, 0, sizeof(dirtyBitmap_));
+    dirtyBlockCount_ = 0u;
+}
+
+static inline bool is_block_dirty_(const uint32_t logicalBlock)
+{
+    return __test_bit(logicalBlock, dirtyBitmap_) ? true : false;
+}
+
+static inline void mark_block_dirty_(const uint32_t logicalBlock)
+{
+    if (!is_block_dirty_(logicalBlock)) {
+        __set_bit(logicalBlock, dirtyBitmap_);
+        dirtyBlockCount_++;
+    }
+}
+
+static inline void mark_block_clean_(const uint32_t logicalBlock)
+{
+    if (is_block_dirty_(logicalBlock)) {
+        __clear_bit(logicalBlock, dirtyBitmap_);
+        dirtyBlockCount_--;
+    }
+}
+
+static struct HSS_QSPI_Cache_Entry *find_cache_entry_(const uint32_t logicalBlock)
 {
-    bool result = false;
-    assert(indexOut);
+    struct HSS_QSPI_Cache_Entry * const pSet =
+        &cacheEntries_[(logicalBlock % QSPI_CACHE_NUM_SETS) * QSPI_CACHE_NUM_WAYS];
+    struct HSS_QSPI_Cache_Entry *pEntry = NULL;
 
-    for (size_t i = 0u; i < ARRAY_SIZE(qspiFlashes); i++) {
-        if (qspiFlashes[i].jedecId == jedec_id) {
-            *indexOut = i;
-            result = true;
+    for (size_t way = 0u; way < QSPI_CACHE_NUM_WAYS; way++) {
+        if (pSet[way].logicalBlock == logicalBlock) {
+            pEntry = &pSet[way];
             break;
         }
     }
 
-    return result;
+    return pEntry;
 }
 
-static void build_bad_block_map_(void)
+static bool write_back_entry_(struct HSS_QSPI_Cache_Entry * const pEntry)
 {
-#if IS_ENABLED(CONFIG_SERVICE_QSPI_WINBOND_W25N01GV)
-    numBadBlocks = Flash_scan_for_bad_blocks(pBadBlocksMap);
+    bool result = true;
+    const uint32_t logicalBlock = pEntry->logicalBlock;
 
-    size_t badBlockIndex = 0u;
-    size_t logicalBlockIndex = 0u;
+    if (is_block_dirty_(logicalBlock)) {
+#if IS_ENABLED(CONFIG_SERVICE_WDOG)
+        HSS_Wdog_E51_Tickle();
+#endif
 
-    uint32_t badBlocksRemaining = numBadBlocks;
+        const uint32_t physicalBlock = select_write_target_(logicalBlock);
 
-    for (size_t physicalBlockIndex = 0u; physicalBlockIndex < blockCount; physicalBlockIndex++) {
-        if (badBlocksRemaining && (pBadBlocksMap[badBlockIndex] == physicalBlockIndex)) { // skip bad physical block
-            badBlockIndex++;
-            badBlocksRemaining--;
-        } else { // good physical block, so use
-            pLogicalToPhysicalMap[logicalBlockIndex] = physicalBlockIndex;
-            logicalBlockIndex++;
+        uint8_t status = erase_block_(physicalBlock);
+        note_block_erased_(physicalBlock);
+        if (status) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "Error erasing block %u\n", physicalBlock);
+        } else {
+            status = Flash_program(cache_entry_data_(pEntry), physicalBlock * blockSize, blockSize);
+            if (status) {
+                mHSS_DEBUG_PRINTF(LOG_ERROR, "Error programming block %u\n", physicalBlock);
+            }
         }
-    }
-#else
 
-    size_t logicalBlockIndex = 0u;
-    for (size_t physicalBlockIndex = 0u; physicalBlockIndex < blockCount; physicalBlockIndex++) {
-        pLogicalToPhysicalMap[logicalBlockIndex] = physicalBlockIndex;
-        logicalBlockIndex++;
+        //
+        // on failure, the block stays dirty and keeps its old mapping
+        if (status) {
+            retire_failed_block_(physicalBlock);
+            result = false;
+        } else {
+            mark_block_clean_(logicalBlock);
+            commit_block_write_(logicalBlock, physicalBlock);
+        }
     }
-#endif
-}
-
-__attribute__((pure)) static inline uint32_t column_to_block_(const uint32_t column_addr)
-{
-    assert(blockSize); // avoid divide by zero
 
-    const uint32_t result = (column_addr / blockSize);
     return result;
 }
 
-static inline uint32_t logical_to_physical_address_(const uint32_t logical_addr)
+//
+// find the cache entry for a logical block, reading it from flash on a miss and
+// evicting (and writing back, if dirty) the least recently used entry in its set
+static uint8_t *get_cache_block_(const uint32_t logicalBlock, const bool markDirty)
 {
-    assert(blockSize); // avoid divide by zero
+    struct HSS_QSPI_Cache_Entry * const pSet =
+        &cacheEntries_[(logicalBlock % QSPI_CACHE_NUM_SETS) * QSPI_CACHE_NUM_WAYS];
+    struct HSS_QSPI_Cache_Entry *pEntry = NULL;
+    struct HSS_QSPI_Cache_Entry *pVictim = &pSet[0];
+
+    for (size_t way = 0u; way < QSPI_CACHE_NUM_WAYS; way++) {
+        if (pSet[way].logicalBlock == logicalBlock) {
+            pEntry = &pSet[way];
+            break;
+        } else if (pVictim->logicalBlock == QSPI_CACHE_INVALID_BLOCK) {
+            ; // already have a free entry
+        } else if ((pSet[way].logicalBlock == QSPI_CACHE_INVALID_BLOCK)
+            || (pSet[way].lastUsed < pVictim->lastUsed)) {
+            pVictim = &pSet[way];
+        }
+    }
 
-    const uint16_t logical_block_num = logical_addr / blockSize;
-    const uint32_t remainder = logical_addr % blockSize;
+    if (!pEntry) {
+        //mHSS_DEBUG_PRINTF(LOG_NORMAL, "Reading block %u into cache\n", logicalBlock);
 
-    if (logical_block_num >= blockCount) {
-        mHSS_DEBUG_PRINTF(LOG_ERROR, "logical_block_num %u >= blockCount %u\n",
-            logical_block_num, blockCount);
-        return 0u;
+        write_back_yield_(pVictim);
+
+        if ((pVictim->logicalBlock != QSPI_CACHE_INVALID_BLOCK) && !write_back_entry_(pVictim)) {
+            return NULL;
+        }
+
+        pEntry = pVictim;
+        pEntry->logicalBlock = logicalBlock;
+        set_io_format_(readFormat_);
+        Flash_read(cache_entry_data_(pEntry), logical_to_physical_block_(logicalBlock) * blockSize, blockSize);
     }
 
-    uint16_t physical_block_number = (uint16_t)logical_block_num; // identity fallback
-    if (pLogicalToPhysicalMap != NULL) {
-        physical_block_number = pLogicalToPhysicalMap[logical_block_num];
+    cacheUseCounter_++;
+    pEntry->lastUsed = cacheUseCounter_;
+
+    if (markDirty) {
+        mark_block_dirty_(logicalBlock);
     }
-    uint32_t result = (physical_block_number * blockSize) + remainder;
 
-    if (pLogicalToPhysicalMap != NULL && physical_block_number > blockCount) {
-        mHSS_DEBUG_PRINTF(LOG_ERROR, "Corruption in logical to physical block mapping: %d\n", physical_block_number);
-        build_bad_block_map_();
-        // retry
-        physical_block_number = pLogicalToPhysicalMap[logical_block_num];
-        mHSS_DEBUG_PRINTF(LOG_ERROR, "Second attempt at physical block mapping: %d\n", physical_block_number);
-        result = (physical_block_number * blockSize) + remainder;
+    return cache_entry_data_(pEntry);
+}
+
+static bool cached_access_(size_t byteOffset, uint8_t *pBuffer, size_t byteCount, const bool isWrite)
+{
+    bool result = true;
+
+    while (result && byteCount) {
+        const size_t blockOffset = byteOffset % blockSize;
+        const size_t accessSize = MIN(byteCount, blockSize - blockOffset);
+        uint8_t * const pBlock = get_cache_block_(column_to_block_(byteOffset), isWrite);
+
+        if (!pBlock) {
+            result = false;
+        } else if (isWrite) {
+            memcpy(pBlock + blockOffset, pBuffer, accessSize);
+        } else {
+            memcpy(pBuffer, pBlock + blockOffset, accessSize);
+        }
+
+        byteOffset += accessSize;
+        pBuffer += accessSize;
+        byteCount -= accessSize;
     }
 
     return result;
 }
 
-static inline uint32_t logical_to_physical_block_(const uint32_t logical_block)
+static bool find_next_dirty_block_(uint32_t *pLogicalBlock)
 {
-    if (logical_block >= blockCount) {
-        mHSS_DEBUG_PRINTF(LOG_ERROR, "logical_block %u >= blockCount %u\n",
-            logical_block, blockCount);
-        return 0u;
-    }
+    bool result = false;
 
-    uint32_t result = (uint32_t)logical_block; // identity fallback
-    if (pLogicalToPhysicalMap != NULL) {
-        result = pLogicalToPhysicalMap[logical_block];
-    }
-    if (pLogicalToPhysicalMap != NULL && result > blockCount) {
-        mHSS_DEBUG_PRINTF(LOG_ERROR, "Corruption in logical to physical block mapping: %d\n", result);
-        build_bad_block_map_();
-        // retry
-        result = pLogicalToPhysicalMap[logical_block];
-        mHSS_DEBUG_PRINTF(LOG_ERROR, "Second attempt at physical block mapping: %d\n", result);
+    for (size_t word = 0u; dirtyBlockCount_ && (word < ARRAY_SIZE(dirtyBitmap_)); word++) {
+        if (dirtyBitmap_[word]) {
+            *pLogicalBlock = (uint32_t)((word * BITS_PER_LONG) + sbi_ffs(dirtyBitmap_[word]));
+            result = true;
+            break;
+        }
     }
 
     return result;
 }
 
-static void demandCopyFlashBlocksToCache_(size_t byteOffset, size_t byteCount, bool markDirty)
+//
+// called once all dirty blocks have been written back, returning true if more blocks
+// have been scheduled for write-back
+static bool finish_flush_(void)
 {
-    for (size_t offset = byteOffset; offset < (byteOffset + byteCount); offset += blockSize) {
-        const size_t physicalBlockOffset = logical_to_physical_block_(column_to_block_(offset));
+    bool result = false;
 
-        if (!pLogicalBlockDesc[physicalBlockOffset].inCache) {
-            //mHSS_DEBUG_PRINTF(LOG_NORMAL, "Reading block %u into cache\n", physicalBlockOffset);
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_WEAR_LEVELLING)
+#  if IS_ENABLED(CONFIG_SERVICE_QSPI_STATIC_WEAR_LEVELLING)
+    //
+    // static wear levelling: at most once per flush, move the coldest logical block onto
+    // the most-worn free block, so that the lightly worn block it occupies is released
+    uint32_t wornBlock;
 
-            const size_t physicalBlockByteOffset = physicalBlockOffset * blockSize;
-            Flash_read(pCacheDataBuffer + physicalBlockByteOffset, physicalBlockByteOffset, blockSize);
-            pLogicalBlockDesc[physicalBlockOffset].inCache = true;
+    if (!wlStaticMoveDone_ && wl_find_free_block_(true, &wornBlock)) {
+        uint32_t coldLogicalBlock = 0u;
+
+        for (uint32_t logicalBlock = 1u; logicalBlock < blockCount; logicalBlock++) {
+            if (pWlTable->eraseCount[pLogicalToPhysicalMap[logicalBlock]]
+                < pWlTable->eraseCount[pLogicalToPhysicalMap[coldLogicalBlock]]) {
+                coldLogicalBlock = logicalBlock;
+            }
         }
 
-        if (markDirty) {
-            pLogicalBlockDesc[physicalBlockOffset].dirtyCache = true;
+        const uint32_t coldCount = pWlTable->eraseCount[pLogicalToPhysicalMap[coldLogicalBlock]];
+        if (pWlTable->eraseCount[wornBlock] > (coldCount + CONFIG_SERVICE_QSPI_STATIC_WEAR_LEVELLING_THRESHOLD)) {
+            wlStaticMove_.pending = true;
+            wlStaticMove_.logicalBlock = coldLogicalBlock;
+            wlStaticMove_.physicalBlock = wornBlock;
+
+            result = (get_cache_block_(coldLogicalBlock, true) != NULL);
+            wlStaticMove_.pending = result;
         }
     }
+
+    wlStaticMoveDone_ = result;
+#  endif
+
+    if (!result && wlTableDirty_) {
+        (void)wl_persist_table_();
+    }
+#endif
+
+    return result;
 }
 
-#if IS_ENABLED(CONFIG_SERVICE_QSPI_MICRON_MQ25T)
-static uint8_t flashEraseSector(uint32_t addr)
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// QSPI Write-back State Machine
+//
+// Dirty cache blocks are written back to flash in the background, in ascending logical
+// block order. Each superloop iteration polls the flash status register once, and starts
+// at most one erase or page program, so a large flush does not stall other services.
+//
+
+static void qspi_idle_handler(struct StateMachine * const pMyMachine);
+static void qspi_erase_wait_handler(struct StateMachine * const pMyMachine);
+static void qspi_program_wait_handler(struct StateMachine * const pMyMachine);
+
+/*!
+ * \brief QSPI Write-back States
+ *
+ */
+enum QspiStatesEnum {
+    QSPI_IDLE,
+    QSPI_ERASE_WAIT,
+    QSPI_PROGRAM_WAIT,
+    QSPI_NUM_STATES = QSPI_PROGRAM_WAIT+1
+};
+
+/*!
+ * \brief QSPI Write-back State Descriptors
+ *
+ */
+static const struct StateDesc qspi_state_descs[] = {
+    { (const stateType_t)QSPI_IDLE,           (const char *)"idle",         NULL, NULL, &qspi_idle_handler },
+    { (const stateType_t)QSPI_ERASE_WAIT,     (const char *)"eraseWait",    NULL, NULL, &qspi_erase_wait_handler },
+    { (const stateType_t)QSPI_PROGRAM_WAIT,   (const char *)"programWait",  NULL, NULL, &qspi_program_wait_handler },
+};
+
+/*!
+ * \brief QSPI Write-back State Machine
+ *
+ */
+struct StateMachine qspi_service = {
+    .state             = (stateType_t)QSPI_IDLE,
+    .prevState         = (stateType_t)SM_INVALID_STATE,
+    .numStates         = (const uint32_t)QSPI_NUM_STATES,
+    .pMachineName      = (const char *)"qspi_service",
+    .startTime         = 0u,
+    .lastExecutionTime = 0u,
+    .executionCount    = 0u,
+    .pStateDescs       = qspi_state_descs,
+    .debugFlag         = false,
+    .priority          = 0u,
+    .pInstanceData     = NULL
+};
+
+static struct {
+    bool requested;
+    struct HSS_QSPI_Cache_Entry *pEntry;
+    uint32_t physicalBlock;
+    uint32_t page;
+    bool opComplete;
+    uint8_t opStatus;
+} writeBack_ = { false, NULL, 0u, 0u, true, 0u };
+
+static void qspi_idle_handler(struct StateMachine * const pMyMachine)
 {
-    uint8_t status = 0xff;
+    uint32_t logicalBlock;
+
+    if (!writeBack_.requested) {
+        ; // nothing to do
+    } else if (!find_next_dirty_block_(&logicalBlock)) {
+        if (!finish_flush_()) {
+            writeBack_.requested = false;
+            cacheDirtyFlag = false;
+            mHSS_DEBUG_PRINTF(LOG_NORMAL, "Synchronized Cache with Flash ...\n");
+        }
+    } else {
+        struct HSS_QSPI_Cache_Entry * const pEntry = find_cache_entry_(logicalBlock);
+        assert(pEntry != NULL);
 
-    /* For the flashes with page size less than 512, as part of
-     * initialization we have already changed the flash parameters,
-     * because of this change the erasable sector size will be 128K
-     * but the actual erasable sector size should be 64K.
-     * so derive the sector address and erase each sector.
-     */
-    if (qspiFlashes[qspiIndex].pageSize >= QSPI_MIN_BYTE_SECTOR_SIZE)
-    {
-        status = Flash_sector_erase(addr << 16); // 64K sector
-    }
-    else
-    {
-        /* Total erasable sectors in the given address */
-        uint32_t totalSectors = qspiFlashes[qspiIndex].blocksPerDie / qspiFlashes[qspiIndex].pageSize;
-        for(int count = 0; count < totalSectors; count++)
-        {
-            status = Flash_sector_erase(((addr * totalSectors) + count) << 16); // 64K sector
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_WINBOND_W25N01GV)
+        //
+        // mark the block clean before programming it, so that any writes to it while
+        // it is being programmed cause it to be written back again
+        mark_block_clean_(logicalBlock);
+
+        const uint32_t physicalBlock = select_write_target_(logicalBlock);
+
+        if (Flash_erase_block_start(physicalBlock)) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "Error erasing block %u\n", physicalBlock);
+            mark_block_dirty_(logicalBlock);
+            retire_failed_block_(physicalBlock);
+            writeBack_.requested = false;
+        } else {
+            writeBack_.pEntry = pEntry;
+            writeBack_.physicalBlock = physicalBlock;
+            writeBack_.opComplete = false;
+            pMyMachine->state = QSPI_ERASE_WAIT;
+        }
+#else
+        // no non-blocking flash operations, so write back a whole block at a time
+        if (!write_back_entry_(pEntry)) {
+            writeBack_.requested = false;
         }
+#endif
     }
+}
 
-    return status;
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_WINBOND_W25N01GV)
+//
+// on an erase or program failure, the logical block keeps its old mapping and stays
+// dirty, and the failed block is retired so that the next write-back goes elsewhere.
+// The flush is stopped, so that it is retried on the next flush rather than repeatedly
+static void write_back_abandon_(void)
+{
+    mark_block_dirty_(writeBack_.pEntry->logicalBlock);
+    retire_failed_block_(writeBack_.physicalBlock);
+    writeBack_.requested = false;
+    writeBack_.pEntry = NULL;
 }
-#endif
 
-static void copyCacheToFlashBlocks_(size_t byteOffset, size_t byteCount)
+static void program_next_page_(void)
 {
-    const size_t endOffset = byteOffset + byteCount;
-    size_t dirtyBlockCount = 0u;
-    mHSS_DEBUG_PRINTF_EX("\n");
+    Flash_program_page_start(cache_entry_data_(writeBack_.pEntry) + (writeBack_.page * pageSize),
+        (writeBack_.physicalBlock * pFlash->pagesPerBlock) + writeBack_.page, pageSize);
+    writeBack_.opComplete = false;
+}
 
-    for (size_t blockOffset = 0u; blockOffset < blockCount; blockOffset++) {
-        if (pLogicalBlockDesc[blockOffset].dirtyCache) {
-            dirtyBlockCount++;
-        }
+//
+// poll the erase or page program in progress. Its status is held until the state
+// machine consumes it, so that the flash may also be waited on outside the state machine
+static bool poll_flash_op_(void)
+{
+    if (writeBack_.opComplete) {
+        ; // nothing in progress
+    } else if (qspi_service.state == QSPI_ERASE_WAIT) {
+        writeBack_.opComplete = Flash_poll_erase_complete(&writeBack_.opStatus);
+    } else {
+        writeBack_.opComplete = Flash_poll_program_complete(&writeBack_.opStatus);
     }
 
-    const size_t initialDirtyBlockCount = dirtyBlockCount;
-    uint8_t status = 0xFF;
+    return writeBack_.opComplete;
+}
+#endif
 
-    for (size_t offset = byteOffset; dirtyBlockCount && (offset < endOffset); offset += blockSize) {
+static void qspi_erase_wait_handler(struct StateMachine * const pMyMachine)
+{
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_WINBOND_W25N01GV)
+    if (poll_flash_op_()) {
+        note_block_erased_(writeBack_.physicalBlock);
 
-        HSS_ShowProgress(initialDirtyBlockCount, dirtyBlockCount);
+        if (writeBack_.opStatus) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "Error erasing block %u\n", writeBack_.physicalBlock);
+            write_back_abandon_();
+            pMyMachine->state = QSPI_IDLE;
+        } else {
+            writeBack_.page = 0u;
+            program_next_page_();
+            pMyMachine->state = QSPI_PROGRAM_WAIT;
+        }
+    }
+#else
+    pMyMachine->state = QSPI_IDLE;
+#endif
+}
 
-#if IS_ENABLED(CONFIG_SERVICE_WDOG)
-        HSS_Wdog_E51_Tickle();
+static void qspi_program_wait_handler(struct StateMachine * const pMyMachine)
+{
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_WINBOND_W25N01GV)
+    if (poll_flash_op_()) {
+        writeBack_.page++;
+
+        if (writeBack_.opStatus) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "Error programming block %u\n", writeBack_.physicalBlock);
+            write_back_abandon_();
+            pMyMachine->state = QSPI_IDLE;
+        } else if (writeBack_.page < pFlash->pagesPerBlock) {
+            program_next_page_();
+        } else {
+            commit_block_write_(writeBack_.pEntry->logicalBlock, writeBack_.physicalBlock);
+            writeBack_.pEntry = NULL;
+            pMyMachine->state = QSPI_IDLE;
+        }
+    }
+#else
+    pMyMachine->state = QSPI_IDLE;
 #endif
+}
 
-        const size_t physicalBlockOffset = logical_to_physical_block_(column_to_block_(offset));
+//
+// complete any block write-back that is in progress, so that the flash is idle and the
+// cache entry being written back may be reused
+static void write_back_quiesce_(void)
+{
+    while (qspi_service.state != QSPI_IDLE) {
+        RunStateMachine(&qspi_service);
+    }
+}
 
-        if (pLogicalBlockDesc[physicalBlockOffset].inCache) {
-            if (pLogicalBlockDesc[physicalBlockOffset].dirtyCache) {
-                const size_t physicalBlockByteOffset = physicalBlockOffset * blockSize;
+//
+// a cache miss needs the flash to be idle, but only needs the write-back to finish if
+// it is using the victim entry, or if the victim is dirty and must itself be written
+// back. Otherwise the write-back pauses between flash operations, and resumes later
+static void write_back_yield_(struct HSS_QSPI_Cache_Entry const * const pVictim)
+{
 #if IS_ENABLED(CONFIG_SERVICE_QSPI_WINBOND_W25N01GV)
-                status = Flash_erase_block(physicalBlockOffset);
+    if ((pVictim == writeBack_.pEntry) || ((pVictim->logicalBlock != QSPI_CACHE_INVALID_BLOCK)
+        && is_block_dirty_(pVictim->logicalBlock))) {
+        write_back_quiesce_();
+    } else {
+        while (!poll_flash_op_()) {
+            ;
+        }
+    }
 #else
-                status = flashEraseSector(physicalBlockOffset);
+    (void)pVictim;
+    write_back_quiesce_();
 #endif
-                if (status) {
-                    mHSS_DEBUG_PRINTF(LOG_ERROR, "Error erasing block %u\n", physicalBlockOffset);
-                    break;
-                }
+}
 
-                status = Flash_program(pCacheDataBuffer + physicalBlockByteOffset, physicalBlockByteOffset, blockSize);
-                if (status) {
-                    mHSS_DEBUG_PRINTF(LOG_ERROR, "Error programming block %u\n", physicalBlockOffset);
+//
+// complete all outstanding write-backs
+static void write_back_sync_(void)
+{
+    const size_t initialDirtyBlockCount = dirtyBlockCount_;
 
-                }
+    if (writeBack_.requested) {
+        mHSS_DEBUG_PRINTF_EX("\n");
 
-                pLogicalBlockDesc[physicalBlockOffset].dirtyCache = false;
-                dirtyBlockCount--;
-            }
+        while (writeBack_.requested) {
+            HSS_ShowProgress(initialDirtyBlockCount, dirtyBlockCount_);
+#if IS_ENABLED(CONFIG_SERVICE_WDOG)
+            HSS_Wdog_E51_Tickle();
+#endif
+            RunStateMachine(&qspi_service);
         }
+
+        HSS_ShowProgress(initialDirtyBlockCount, 0u);
+        mHSS_DEBUG_PRINTF_EX("\n");
     }
 
-    HSS_ShowProgress(initialDirtyBlockCount, 0u);
+    write_back_quiesce_();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////
@@ -310,18 +1421,39 @@ bool HSS_QSPIInit(void)
 
         uint8_t rd_buf[10] __attribute__ ((aligned(4)));
 
-        Flash_init(MSS_QSPI_QUAD_FULL);
+        set_io_format_(MSS_QSPI_QUAD_FULL);
         Flash_readid(rd_buf);
 
         uint32_t jedec_id = ((rd_buf[0] << 16) | (rd_buf[1] <<8) | (rd_buf[2]));
 
+        struct HSS_QSPI_FlashParams params = { .readFormat = MSS_QSPI_QUAD_FULL };
+        const bool discovered = discover_flash_params_(&params);
+
         if (flash_id_to_descriptor_(jedec_id, &qspiIndex)) {
-            mHSS_DEBUG_PRINTF(LOG_NORMAL, "%s detected (JEDEC %06X)\n", qspiFlashes[qspiIndex].name, jedec_id);
+            pFlash = &qspiFlashes[qspiIndex];
+        } else if (discovered) {
+            discoveredFlash_.jedecId = jedec_id;
+            discoveredFlash_.pageSize = params.pageSize;
+            discoveredFlash_.pagesPerBlock = params.pagesPerBlock;
+            discoveredFlash_.blocksPerDie = params.blocksPerDie;
+            pFlash = &discoveredFlash_;
+        } else {
+            pFlash = NULL;
+        }
+
+        if (discovered) {
+            readFormat_ = params.readFormat;
+            mHSS_DEBUG_PRINTF(LOG_NORMAL, "Flash parameters: %u byte pages, %u pages per block, %u blocks\n",
+                params.pageSize, params.pagesPerBlock, params.blocksPerDie);
+        }
+
+        if (pFlash && (pFlash->blocksPerDie <= QSPI_MAX_BLOCKS_PER_DIE)) {
+            mHSS_DEBUG_PRINTF(LOG_NORMAL, "%s detected (JEDEC %06X)\n", pFlash->name, jedec_id);
 
-            if (qspiFlashes[qspiIndex].pageSize >= QSPI_MIN_BYTE_SECTOR_SIZE) {
-                pageSize = qspiFlashes[qspiIndex].pageSize;
-                blockSize = qspiFlashes[qspiIndex].pageSize * qspiFlashes[qspiIndex].pagesPerBlock;
-                blockCount = qspiFlashes[qspiIndex].blocksPerDie;
+            if (pFlash->pageSize >= QSPI_MIN_BYTE_SECTOR_SIZE) {
+                pageSize = pFlash->pageSize;
+                blockSize = pFlash->pageSize * pFlash->pagesPerBlock;
+                blockCount = pFlash->blocksPerDie;
             } else {
               /* The minimum sector size (page size) allowed for a block device is
                * 512. so for the flashes with page size less than 512 will get an
@@ -331,15 +1463,15 @@ bool HSS_QSPIInit(void)
                * flash so that the block device is recognized on the host PC.
                */
                 pageSize = QSPI_MIN_BYTE_SECTOR_SIZE;
-                blockSize = pageSize * qspiFlashes[qspiIndex].pagesPerBlock;
+                blockSize = pageSize * pFlash->pagesPerBlock;
                 blockCount = pageSize / 2;
             }
 
             eraseSize = blockSize;
-            blockCount = qspiFlashes[qspiIndex].blocksPerDie;
-            pageCount = qspiFlashes[qspiIndex].pagesPerBlock * blockCount;
+            blockCount = pFlash->blocksPerDie;
+            pageCount = pFlash->pagesPerBlock * blockCount;
             dieSize = blockSize * blockCount;
-            spi_type = qspiFlashes[qspiIndex].type;
+            spi_type = pFlash->type;
 
             // mHSS_DEBUG_PRINTF(LOG_NORMAL, "pageSize: %u\n", pageSize);
             // mHSS_DEBUG_PRINTF(LOG_NORMAL, "blockSize: %u\n", blockSize);
@@ -352,36 +1484,57 @@ bool HSS_QSPIInit(void)
             // we're going to place buffers in DDR for
             //   * a set of logical to physical block qspiIndex mappings;
             //   * a list of bad blocks;
-            //   * a set of logical block descriptors;
-            //   * a data cache the same size as the QSPI Flash device
+            //   * a data cache of CONFIG_SERVICE_QSPI_CACHE_BLOCKS erase blocks
+            //
+            // with wear levelling, the mappings are held in the wear levelling table, and
+            // a second copy of the table is used as scratch space for loading it
             //
             uint8_t *pU8Buffer = (uint8_t*)HSS_DDR_GetStart();
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_WEAR_LEVELLING)
+            pWlTable = (struct HSS_QSPI_WL_Table *)pU8Buffer;
+            memset(pWlTable, 0, sizeof(*pWlTable));
+            pU8Buffer += sizeof(*pWlTable);
+
+            pWlScratch = (struct HSS_QSPI_WL_Table *)pU8Buffer;
+            pU8Buffer += sizeof(*pWlScratch);
+
+            pLogicalToPhysicalMap = pWlTable->logicalToPhysical;
+#else
             pLogicalToPhysicalMap = (uint16_t *)pU8Buffer;
             memset(pLogicalToPhysicalMap, 0, (sizeof(*pLogicalToPhysicalMap) * blockCount));
             pU8Buffer += (sizeof(*pLogicalToPhysicalMap) * blockCount);
+#endif
 
             pBadBlocksMap = (uint16_t *)pU8Buffer;
             memset(pBadBlocksMap, 0, (sizeof(*pBadBlocksMap) * blockCount));
             pU8Buffer += (sizeof(*pBadBlocksMap) * blockCount);
 
-            pLogicalBlockDesc = (struct HSS_QSPI_Cache_Descriptor*)pU8Buffer;
-            memset(pLogicalBlockDesc, 0, (sizeof(*pLogicalBlockDesc) * blockCount));
-            pU8Buffer += (sizeof(*pLogicalBlockDesc) * blockCount);
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_BAD_BLOCK_TABLE)
+            pBbt = (struct HSS_QSPI_BBT *)pU8Buffer;
+            memset(pBbt, 0, sizeof(*pBbt));
+            pU8Buffer += sizeof(*pBbt);
+
+            pBbtScratch = (struct HSS_QSPI_BBT *)pU8Buffer;
+            pU8Buffer += sizeof(*pBbtScratch);
+#endif
 
             pCacheDataBuffer = (uint8_t *)pU8Buffer;
+            invalidate_cache_();
 
             // mHSS_DEBUG_PRINTF(LOG_NORMAL, "pLogicalToPhysicalMap: %p\n", pLogicalToPhysicalMap);
-            // mHSS_DEBUG_PRINTF(LOG_NORMAL, "pLogicalBlockDesc: %p\n", pLogicalBlockDesc);
             // mHSS_DEBUG_PRINTF(LOG_NORMAL, "pCacheDataBuffer: %p\n", pCacheDataBuffer);
 
             //
             // check for bad blocks and reduce the number of blocks accordingly...
-            // our caches and logical block descriptors above may now be slightly too large, but this
-            // is of no consequence
+            // our maps above may now be slightly too large, but this is of no consequence
 
-            build_bad_block_map_();
-            blockCount -= numBadBlocks; // adjust block count to take account of bad blocks
-            pageCount = qspiFlashes[qspiIndex].pagesPerBlock * blockCount;
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_WEAR_LEVELLING)
+            find_bad_blocks_(false);
+            wl_init_(); // sets block count to the number of logical blocks
+#else
+            blockCount = build_bad_block_map_(false); // take account of bad blocks
+#endif
+            pageCount = pFlash->pagesPerBlock * blockCount;
             dieSize = blockSize * blockCount;
 
             // mHSS_DEBUG_PRINTF(LOG_NORMAL, "blockCount (after bad blocks): %u\n", blockCount);
@@ -405,15 +1558,29 @@ __attribute__((nonnull)) bool HSS_QSPI_ReadBlock(void *pDest, size_t srcOffset,
         mHSS_DEBUG_PRINTF(LOG_ERROR, "QSPI Read Block: offset/size out of bounds\n");
         result = false;
     } else {
-        const uint32_t read_addr = logical_to_physical_address_((uint32_t)srcOffset);
+        uint8_t *pU8Dest = (uint8_t *)pDest;
+
+        write_back_sync_(); // ensure flash is up to date with the cache
+        set_io_format_(readFormat_);
+
+        //
+        // consecutive logical blocks need not be physically consecutive, so each read
+        // covers the longest physically contiguous run of blocks
+        while (byteCount) {
+            const uint32_t physicalAddress = logical_to_physical_address_((uint32_t)srcOffset);
+            size_t readSize = MIN(byteCount, blockSize - (srcOffset % blockSize));
+
+            while ((readSize < byteCount) && (logical_to_physical_address_((uint32_t)(srcOffset + readSize))
+                    == physicalAddress + readSize)) {
+                readSize += MIN(byteCount - readSize, blockSize);
+            }
 
-        Flash_init(MSS_QSPI_QUAD_FULL);
-        Flash_read((uint8_t *)pDest, read_addr, (uint32_t) byteCount);
+            Flash_read(pU8Dest, physicalAddress, (uint32_t)readSize);
 
-        /* Configure the QSPI and Flash back to default values, so that
-         * rest of the applications will access the flash with defaults.
-         */
-        Flash_init(MSS_QSPI_NORMAL);
+            srcOffset += readSize;
+            pU8Dest += readSize;
+            byteCount -= readSize;
+        }
     }
 
     return result;
@@ -427,8 +1594,19 @@ __attribute__((nonnull)) bool HSS_QSPI_WriteBlock(size_t dstOffset, void *pSrc,
         mHSS_DEBUG_PRINTF(LOG_ERROR, "QSPI Write Block: offset/size out of bounds\n");
         result = false;
     } else {
-        const uint32_t write_addr = logical_to_physical_address_((uint32_t)dstOffset);
-        Flash_program((uint8_t *)pSrc, write_addr, (uint32_t)byteCount);
+        uint8_t *pU8Src = (uint8_t *)pSrc;
+
+        write_back_sync_();
+
+        while (byteCount) {
+            const size_t writeSize = MIN(byteCount, blockSize - (dstOffset % blockSize));
+
+            Flash_program(pU8Src, logical_to_physical_address_((uint32_t)dstOffset), (uint32_t)writeSize);
+
+            dstOffset += writeSize;
+            pU8Src += writeSize;
+            byteCount -= writeSize;
+        }
     }
 
     return result;
@@ -440,48 +1618,96 @@ __attribute__((nonnull)) void HSS_QSPI_GetInfo(uint32_t *pBlockSize, uint32_t *p
     *pEraseSize = eraseSize;
     *pBlockCount = pageCount;
 
-    mHSS_DEBUG_PRINTF(LOG_NORMAL, "QSPI: %s - %u byte pages, %u byte blocks, %u pages per block\n",  qspiFlashes[qspiIndex].name, qspiFlashes[qspiIndex].pageSize, qspiFlashes[qspiIndex].blocksPerDie, qspiFlashes[qspiIndex].pagesPerBlock);
+    mHSS_DEBUG_PRINTF(LOG_NORMAL, "QSPI: %s - %u byte pages, %u byte blocks, %u pages per block\n",  pFlash->name, pFlash->pageSize, pFlash->blocksPerDie, pFlash->pagesPerBlock);
 }
 
 void HSS_QSPI_FlushWriteBuffer(void)
 {
 }
 
+void HSS_QSPI_RestoreDefaultIOFormat(void)
+{
+    /* Configure the QSPI and Flash back to default values, so that
+     * rest of the applications will access the flash with defaults.
+     */
+    if (qspiInitialized) {
+        write_back_sync_();
+        set_io_format_(MSS_QSPI_NORMAL);
+    }
+}
+
 void HSS_QSPI_FlashChipErase(void)
 {
-#if IS_ENABLED(CONFIG_SERVICE_QSPI_WINBOND_W25N01GV)
+    // the cache contents are about to be discarded, so abandon any write-back
+    writeBack_.requested = false;
+    write_back_quiesce_();
+
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_WEAR_LEVELLING)
+    //
+    // erase every block except the wear levelling table, keeping the block mapping
+    const uint32_t physicalBlockCount = usable_physical_blocks_();
+
+    for (uint32_t blockIndex = 0u; blockIndex < physicalBlockCount; blockIndex++) {
+        HSS_ShowProgress(physicalBlockCount, physicalBlockCount - blockIndex);
+        if (!is_bad_block_(blockIndex) && !is_meta_block_(blockIndex)) {
+            Flash_erase_block(blockIndex);
+            note_block_erased_(blockIndex);
+        }
+    }
+    HSS_ShowProgress(physicalBlockCount, 0u);
+
+    wlStaticMove_.pending = false;
+    (void)wl_persist_table_();
+#elif IS_ENABLED(CONFIG_SERVICE_QSPI_WINBOND_W25N01GV)
     for (uint32_t blockIndex = 0u; blockIndex < blockCount; blockIndex++) {
         HSS_ShowProgress(blockCount, blockCount - blockIndex);
         Flash_erase_block(blockIndex);
     }
+    HSS_ShowProgress(blockCount, 0u);
 #else
     Flash_erase();
-#endif
     HSS_ShowProgress(blockCount, 0u);
+#endif
+
+    invalidate_cache_();
+    cacheDirtyFlag = false;
 }
 
 void HSS_QSPI_BadBlocksInfo(void)
 {
     if ((qspiInitialized) && (spi_type == SPI_NAND))
     {
-        blockCount = qspiFlashes[qspiIndex].blocksPerDie;
-        pageCount = qspiFlashes[qspiIndex].pagesPerBlock * blockCount;
+        write_back_sync_();
+
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_WEAR_LEVELLING)
+        //
+        // the wear levelling table owns the block mapping, so newly found bad blocks are
+        // only taken out of the free pool, once any released blocks have been persisted
+        find_bad_blocks_(true);
+        if (wlTableDirty_) {
+            (void)wl_persist_table_();
+        }
+        wl_build_free_pool_();
+#else
+        // update bad blocks mapping and numBadBlocks, adjusting block count to take account of bad blocks
+        blockCount = build_bad_block_map_(true);
+        pageCount = pFlash->pagesPerBlock * blockCount;
         dieSize = blockSize * blockCount;
-
-        build_bad_block_map_(); // update bad blocks mapping and numBadBlocks
+#endif
 
         mHSS_DEBUG_PRINTF(LOG_ERROR, "QSPI Flash: %u bad block%s found\n", numBadBlocks,
             numBadBlocks == 1 ? "":"s");
         if (numBadBlocks) {
-            blockCount -= numBadBlocks; // adjust block count to take account of bad blocks
-            pageCount = qspiFlashes[qspiIndex].pagesPerBlock * blockCount;
-            dieSize = blockSize * blockCount;
-
             mHSS_DEBUG_PRINTF_EX("Bad Block%s: %u", numBadBlocks == 1 ? "":"s", pBadBlocksMap[0]);
             for (size_t i = 1u; i < numBadBlocks; i++) {
                 mHSS_DEBUG_PRINTF_EX(", %u", pBadBlocksMap[i]);
             }
+            mHSS_DEBUG_PRINTF_EX("\n");
         }
+
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_WEAR_LEVELLING)
+        wl_print_erase_counts_();
+#endif
     }
 }
 
@@ -505,8 +1731,7 @@ bool HSS_CachedQSPI_ReadBlock(void *pDest, size_t srcOffset, size_t byteCount)
     bool result = true;
 
     if ((pDest != NULL) && (byteCount <= dieSize) && (srcOffset <= (dieSize - byteCount))) {
-        demandCopyFlashBlocksToCache_(srcOffset, byteCount, false);
-        memcpy(pDest, pCacheDataBuffer + srcOffset, byteCount);
+        result = cached_access_(srcOffset, (uint8_t *)pDest, byteCount, false);
     } else {
         result = false;
     }
@@ -520,8 +1745,7 @@ bool HSS_CachedQSPI_WriteBlock(size_t dstOffset, void *pSrc, size_t byteCount)
 
     if ((pSrc != NULL) && (byteCount <= dieSize) && (dstOffset <= (dieSize - byteCount))) {
         cacheDirtyFlag = true;
-        demandCopyFlashBlocksToCache_(dstOffset, byteCount, true);
-        memcpy(pCacheDataBuffer + dstOffset, pSrc, byteCount);
+        result = cached_access_(dstOffset, (uint8_t *)pSrc, byteCount, true);
     } else {
         result = false;
     }
@@ -536,11 +1760,20 @@ __attribute__((nonnull)) void HSS_CachedQSPI_GetInfo(uint32_t *pBlockSize, uint3
 
 void HSS_CachedQSPI_FlushWriteBuffer(void)
 {
+    //
+    // write-back is performed in the background by qspi_service, so that other services
+    // continue to run while the flash is being programmed
     if (cacheDirtyFlag) {
-        copyCacheToFlashBlocks_(0u, dieSize);
-        mHSS_DEBUG_PRINTF_EX("\n");
-        mHSS_DEBUG_PRINTF(LOG_NORMAL, "Synchronized Cache with Flash ...\n");
-
-        cacheDirtyFlag = false;
+        writeBack_.requested = true;
     }
 }
+
+bool HSS_CachedQSPI_IsWriteBackComplete(void)
+{
+    return (!writeBack_.requested && (qspi_service.state == QSPI_IDLE));
+}
+
+void HSS_CachedQSPI_WaitForWriteBack(void)
+{
+    write_back_sync_();
+}
@@ -0,0 +1,192 @@
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/*!
+ * \file QSPI Flash Parameter Discovery
+ * \brief Parsers for JESD216 SFDP (NOR) and ONFI (NAND) flash parameter tables
+ *
+ * These derive the geometry and fastest read mode of a flash device from the
+ * parameter tables it describes itself with, so that devices not listed in the
+ * QSPI service's table of known flashes can still be used.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_debug.h"
+
+#include <string.h>
+
+#include "encoding.h"
+#include "qspi_discovery.h"
+
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// JESD216 Serial Flash Discoverable Parameters
+//
+
+#define SFDP_SIGNATURE              (0x50444653u) // "SFDP"
+#define SFDP_HEADER_SIZE            (8u)
+#define SFDP_PARAM_HEADER_SIZE      (8u)
+#define SFDP_BFPT_ID                (0xFF00u)
+#define SFDP_BFPT_MIN_DWORDS        (9u)
+
+#define SFDP_DEFAULT_PAGE_SIZE      (256u)
+
+static inline uint32_t get_le32_(uint8_t const * const p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint16_t get_le16_(uint8_t const * const p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+bool HSS_QSPI_ParseSFDP(uint8_t const * const pSfdp, const size_t length,
+    struct HSS_QSPI_FlashParams * const pParams)
+{
+    bool result = (length >= (SFDP_HEADER_SIZE + SFDP_PARAM_HEADER_SIZE))
+        && (get_le32_(pSfdp) == SFDP_SIGNATURE);
+
+    //
+    // the first parameter header must describe the Basic Flash Parameter Table (BFPT)
+    uint8_t const * const pParamHeader = pSfdp + SFDP_HEADER_SIZE;
+    const size_t numDwords = result ? pParamHeader[3] : 0u;
+    const size_t tableOffset = result ? (get_le32_(pParamHeader + 4u) & 0xFFFFFFu) : 0u;
+
+    if (!result) {
+        ;
+    } else if ((((uint16_t)pParamHeader[7] << 8) | pParamHeader[0]) != SFDP_BFPT_ID) {
+        result = false;
+    } else if ((numDwords < SFDP_BFPT_MIN_DWORDS) || (tableOffset + (numDwords * 4u) > length)) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "SFDP: basic parameter table at %lu is not readable\n", tableOffset);
+        result = false;
+    }
+
+    if (result) {
+        uint32_t dword[16] = { 0u };
+        for (size_t i = 0u; i < MIN(numDwords, ARRAY_SIZE(dword)); i++) {
+            dword[i] = get_le32_(pSfdp + tableOffset + (i * 4u));
+        }
+
+        //
+        // density, in bits
+        uint64_t density = 0u;
+        if (!(dword[1] & 0x80000000u)) {
+            density = (uint64_t)dword[1] + 1u;
+        } else if ((dword[1] & 0x7FFFFFFFu) < 64u) {
+            density = 1ull << (dword[1] & 0x7FFFFFFFu);
+        }
+        density /= 8u;
+
+        //
+        // use the largest erase type as the erase block
+        uint32_t eraseSize = 0u;
+        for (size_t type = 0u; type < 4u; type++) {
+            const uint32_t field = (dword[7u + (type / 2u)] >> ((type % 2u) * 16u)) & 0xFFFFu;
+            const uint32_t sizeShift = field & 0xFFu;
+
+            if (sizeShift && (sizeShift < 32u) && ((1u << sizeShift) > eraseSize)) {
+                eraseSize = 1u << sizeShift;
+            }
+        }
+
+        pParams->pageSize = SFDP_DEFAULT_PAGE_SIZE;
+        if (numDwords >= 11u) {
+            pParams->pageSize = 1u << ((dword[10] >> 4) & 0xFu);
+        }
+
+        if (!eraseSize || (eraseSize < pParams->pageSize) || (density < eraseSize)) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "SFDP: inconsistent geometry\n");
+            result = false;
+        } else {
+            pParams->pagesPerBlock = eraseSize / pParams->pageSize;
+            pParams->blocksPerDie = (uint32_t)(density / eraseSize);
+        }
+
+        //
+        // fastest read mode first. The opcodes and dummy cycles the table gives for each
+        // mode are not used, as the driver has its own for each IO format
+        if (dword[4] & (1u << 4)) {
+            pParams->readFormat = MSS_QSPI_QUAD_FULL;       // 4-4-4
+        } else if (dword[0] & (1u << 21)) {
+            pParams->readFormat = MSS_QSPI_QUAD_EX_RW;      // 1-4-4
+        } else if (dword[0] & (1u << 22)) {
+            pParams->readFormat = MSS_QSPI_QUAD_EX_RO;      // 1-1-4
+        } else if (dword[4] & (1u << 0)) {
+            pParams->readFormat = MSS_QSPI_DUAL_FULL;       // 2-2-2
+        } else if (dword[0] & (1u << 20)) {
+            pParams->readFormat = MSS_QSPI_DUAL_EX_RW;      // 1-2-2
+        } else if (dword[0] & (1u << 16)) {
+            pParams->readFormat = MSS_QSPI_DUAL_EX_RO;      // 1-1-2
+        } else {
+            pParams->readFormat = MSS_QSPI_NORMAL;
+        }
+    }
+
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// ONFI Parameter Page
+//
+
+#define ONFI_SIGNATURE              (0x49464E4Fu) // "ONFI"
+#define ONFI_COPY_SIZE              (256u)
+#define ONFI_CRC_OFFSET             (254u)
+#define ONFI_CRC_POLYNOMIAL         (0x8005u)
+#define ONFI_CRC_SEED               (0x4F4Eu)
+
+#define ONFI_BYTES_PER_PAGE_OFFSET  (80u)
+#define ONFI_PAGES_PER_BLOCK_OFFSET (92u)
+#define ONFI_BLOCKS_PER_LUN_OFFSET  (96u)
+#define ONFI_NUM_LUNS_OFFSET        (100u)
+
+static uint16_t onfi_crc16_(uint8_t const *pData, size_t length)
+{
+    uint16_t crc = ONFI_CRC_SEED;
+
+    while (length--) {
+        crc ^= (uint16_t)(*pData << 8);
+        pData++;
+
+        for (size_t bit = 0u; bit < 8u; bit++) {
+            crc = (crc & 0x8000u) ? (uint16_t)((crc << 1) ^ ONFI_CRC_POLYNOMIAL) : (uint16_t)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+bool HSS_QSPI_ParseONFI(uint8_t const * const pParamPage, const size_t length,
+    struct HSS_QSPI_FlashParams * const pParams)
+{
+    bool result = false;
+
+    //
+    // the parameter page is repeated, so use the first copy with a valid CRC
+    for (size_t offset = 0u; !result && ((offset + ONFI_COPY_SIZE) <= length); offset += ONFI_COPY_SIZE) {
+        uint8_t const * const pCopy = pParamPage + offset;
+
+        if ((get_le32_(pCopy) == ONFI_SIGNATURE)
+            && (onfi_crc16_(pCopy, ONFI_CRC_OFFSET) == get_le16_(pCopy + ONFI_CRC_OFFSET))) {
+            const uint32_t numLuns = MAX(1u, pCopy[ONFI_NUM_LUNS_OFFSET]);
+
+            pParams->pageSize = get_le32_(pCopy + ONFI_BYTES_PER_PAGE_OFFSET);
+            pParams->pagesPerBlock = get_le32_(pCopy + ONFI_PAGES_PER_BLOCK_OFFSET);
+            pParams->blocksPerDie = get_le32_(pCopy + ONFI_BLOCKS_PER_LUN_OFFSET) * numLuns;
+
+            // ONFI does not describe SPI read modes, so readFormat is left to the caller
+            result = (pParams->pageSize && pParams->pagesPerBlock && pParams->blocksPerDie);
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,62 @@
+#ifndef HSS_QSPI_DISCOVERY_H
+#define HSS_QSPI_DISCOVERY_H
+
+
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *
+ * Hart Software Services - QSPI Flash Parameter Discovery
+ *
+ */
+
+/*!
+ * \file QSPI Flash Parameter Discovery
+ * \brief Parsers for JESD216 SFDP (NOR) and ONFI (NAND) flash parameter tables
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hss_types.h"
+#include "mss_qspi.h"
+
+struct HSS_QSPI_FlashParams
+{
+    uint32_t pageSize;              // minimum writable size
+    uint32_t pagesPerBlock;
+    uint32_t blocksPerDie;          // erase blocks, of pageSize * pagesPerBlock bytes
+    mss_qspi_io_format readFormat;  // fastest read mode, using the driver's opcode for it
+};
+
+bool HSS_QSPI_ParseSFDP(uint8_t const * const pSfdp, const size_t length,
+    struct HSS_QSPI_FlashParams * const pParams);
+bool HSS_QSPI_ParseONFI(uint8_t const * const pParamPage, const size_t length,
+    struct HSS_QSPI_FlashParams * const pParams);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,185 @@
+/*******************************************************************************
+ * Copyright 2019-2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/*!
+ * \file SPI Flash Storage
+ * \brief Block access to the System Controller SPI flash
+ *
+ * The SPI flash connected to the System Controller is not directly accessible from
+ * the MSS, and is read using the SPI copy system service, which has the System
+ * Controller copy data from the flash to MSS memory. The System Controller offers no
+ * service to write this flash, so it is read-only from the HSS.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_debug.h"
+
+#include <assert.h>
+
+#include "spi_service.h"
+#include "mss_sys_services_regs.h"
+#include "mss_sys_services.h"
+
+#define SPI_BLOCK_SIZE              (512u)
+#define SPI_COPY_CHUNK_SIZE         ((size_t)CONFIG_SERVICE_SPI_COPY_CHUNK_SIZE)
+#define SPI_COPY_MB_OFFSET          (0u)
+
+#if IS_ENABLED(CONFIG_SERVICE_SPI_COPY_CLOCK_40MHZ)
+#  define SPI_COPY_CLOCK_OPTION     (1u)
+#elif IS_ENABLED(CONFIG_SERVICE_SPI_COPY_CLOCK_20MHZ)
+#  define SPI_COPY_CLOCK_OPTION     (2u)
+#else
+#  define SPI_COPY_CLOCK_OPTION     (3u)
+#endif
+
+//
+// a background read is issued as a sequence of SPI copy requests of at most
+// SPI_COPY_CHUNK_SIZE bytes each. The System Controller services one request at a
+// time, so the next is issued as soon as completion of the previous one is polled
+//
+static struct {
+    bool inFlight;
+    bool result;
+    char *pDest;
+    size_t srcOffset;
+    size_t remaining;
+    size_t chunkSize;
+} asyncCopy_ = { false, true, NULL, 0u, 0u, 0u };
+
+//
+// the message interrupt is not enabled by the HSS, but the driver calls the handler
+// unconditionally if it ever fires
+static void spi_copy_irq_handler_(void)
+{
+    ;
+}
+
+static bool spi_copy_request_(void)
+{
+    asyncCopy_.chunkSize = MIN(asyncCopy_.remaining, SPI_COPY_CHUNK_SIZE);
+
+    //
+    // in interrupt mode, the driver returns once the request is posted, rather than
+    // spinning until the System Controller completes it. Other users of the system
+    // services select polling mode before their requests
+    MSS_SYS_select_service_mode(MSS_SYS_SERVICE_INTERRUPT_MODE, spi_copy_irq_handler_);
+    uint16_t const status = MSS_SYS_spi_copy((uintptr_t)asyncCopy_.pDest,
+        (uint32_t)asyncCopy_.srcOffset, (uint32_t)asyncCopy_.chunkSize,
+        SPI_COPY_CLOCK_OPTION, SPI_COPY_MB_OFFSET);
+    MSS_SYS_select_service_mode(MSS_SYS_SERVICE_POLLING_MODE, NULL);
+
+    if (status) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "Failed to request 0x%lx bytes from SPI flash @0x%lx (error code %u)!\n",
+            asyncCopy_.chunkSize, asyncCopy_.srcOffset, status);
+    }
+
+    return (status == 0u);
+}
+
+static bool spi_poll_async_copy_(void)
+{
+    if (asyncCopy_.inFlight
+        && !(MSS_SCBCTRL->SERVICES_CR & SCBCTRL_SERVICESCR_REQ_MASK)
+        && !(MSS_SCBCTRL->SERVICES_SR & SCBCTRL_SERVICESSR_BUSY_MASK)) {
+        uint16_t const status = (uint16_t)((MSS_SCBCTRL->SERVICES_SR & SCBCTRL_SERVICESSR_STATUS_MASK)
+            >> SCBCTRL_SERVICESSR_STATUS);
+
+        if (status) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "Failed to read 0x%lx bytes from SPI flash @0x%lx (error code %u)!\n",
+                asyncCopy_.chunkSize, asyncCopy_.srcOffset, status);
+            asyncCopy_.result = false;
+            asyncCopy_.inFlight = false;
+        } else {
+            asyncCopy_.pDest += asyncCopy_.chunkSize;
+            asyncCopy_.srcOffset += asyncCopy_.chunkSize;
+            asyncCopy_.remaining -= asyncCopy_.chunkSize;
+
+            if (asyncCopy_.remaining) {
+                asyncCopy_.result = spi_copy_request_();
+                asyncCopy_.inFlight = asyncCopy_.result;
+            } else {
+                asyncCopy_.inFlight = false;
+            }
+        }
+    }
+
+    return !asyncCopy_.inFlight;
+}
+
+static void spi_wait_async_copy_(void)
+{
+    while (!spi_poll_async_copy_()) {
+        ;
+    }
+}
+
+bool HSS_SPI_Init(void)
+{
+    spi_wait_async_copy_();
+    asyncCopy_.result = true;
+
+    return true;
+}
+
+bool HSS_SPI_ReadBlockStart(void *pDest, size_t srcOffset, size_t byteCount)
+{
+    bool result = true;
+
+    spi_wait_async_copy_();
+
+    if ((srcOffset > CONFIG_SERVICE_SPI_FLASH_SIZE)
+        || (byteCount > (CONFIG_SERVICE_SPI_FLASH_SIZE - srcOffset))) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "0x%lx bytes @0x%lx exceeds SPI flash size\n",
+            byteCount, srcOffset);
+        result = false;
+    } else if (byteCount) {
+        asyncCopy_.pDest = (char *)pDest;
+        asyncCopy_.srcOffset = srcOffset;
+        asyncCopy_.remaining = byteCount;
+
+        result = spi_copy_request_();
+        asyncCopy_.inFlight = result;
+    }
+
+    asyncCopy_.result = result;
+
+    return result;
+}
+
+bool HSS_SPI_IsTransferComplete(bool *pResult)
+{
+    bool const complete = spi_poll_async_copy_();
+
+    if (complete && pResult) {
+        *pResult = asyncCopy_.result;
+    }
+
+    return complete;
+}
+
+bool HSS_SPI_ReadBlock(void *pDest, size_t srcOffset, size_t byteCount)
+{
+    bool result = HSS_SPI_ReadBlockStart(pDest, srcOffset, byteCount);
+
+    if (result) {
+        spi_wait_async_copy_();
+        result = asyncCopy_.result;
+    }
+
+    return result;
+}
+
+void HSS_SPI_GetInfo(uint32_t *pBlockSize, uint32_t *pEraseSize, uint32_t *pBlockCount)
+{
+    assert(pBlockSize && pEraseSize && pBlockCount);
+
+    *pEraseSize = *pBlockSize = SPI_BLOCK_SIZE;
+    *pBlockCount = (uint32_t)(CONFIG_SERVICE_SPI_FLASH_SIZE / SPI_BLOCK_SIZE);
+}
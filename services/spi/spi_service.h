@@ -42,6 +42,12 @@ extern "C" {
 #include "ssmb_ipi.h"
 #include "hss_types.h"
 
+bool HSS_SPI_Init(void);
+bool HSS_SPI_ReadBlock(void *pDest, size_t srcOffset, size_t byteCount);
+bool HSS_SPI_ReadBlockStart(void *pDest, size_t srcOffset, size_t byteCount);
+bool HSS_SPI_IsTransferComplete(bool *pResult);
+void HSS_SPI_GetInfo(uint32_t *pBlockSize, uint32_t *pEraseSize, uint32_t *pBlockCount);
+
 extern struct StateMachine spi_service;
 
 #ifdef __cplusplus
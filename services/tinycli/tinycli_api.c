@@ -483,6 +483,9 @@ static void tinyCLI_PrintHelp_(void)
 
 static void tinyCLI_Reset_(void)
 {
+#if IS_ENABLED(CONFIG_SERVICE_QSPI)
+    HSS_CachedQSPI_WaitForWriteBack();
+#endif
 #if IS_ENABLED(CONFIG_SERVICE_REBOOT)
     HSS_reboot_cold(HSS_HART_ALL);
 #endif
@@ -26,6 +26,7 @@
 #include "drivers/mss/mss_mmc/mss_mmc.h"
 
 #include "hss_types.h"
+#include "hss_boot_init.h"
 #if IS_ENABLED(CONFIG_SERVICE_GPIO_UI)
 #  include "gpio_ui_service.h"
 #endif
@@ -52,6 +53,13 @@ extern "C" {
 #define MMC_ERASE_SIZE                4096u
 #define SD_RD_WR_SIZE                 32768u
 
+// with two buffers, USB transfers to/from one overlap storage reads/writes of the other
+#if IS_ENABLED(CONFIG_SERVICE_USBDMSC_DOUBLE_BUFFER)
+#  define NUM_DATA_BUFFERS            2u
+#else
+#  define NUM_DATA_BUFFERS            1u
+#endif
+
 uint32_t g_host_connection_detected = 0u;
 
 /*Type to store information of each LUN*/
@@ -96,7 +104,21 @@ extern mss_usbd_user_descr_cb_t flash_drive_descriptors_cb;
 use internal DMA, the address of this buffer must be modulo-4.Otherwise DMA
 Transfer will fail.*/
 
-uint8_t  lun0_data_buffer[SD_RD_WR_SIZE] __attribute__((aligned(8))) = { 0u };
+uint8_t  lun0_data_buffer[NUM_DATA_BUFFERS][SD_RD_WR_SIZE] __attribute__((aligned(8))) = { 0u };
+
+/*Storage transfer in flight in the background, if any. Only one may be in flight
+at a time. A read is a prefetch of the next part of the current READ(10), and a
+write is the previous part of the current WRITE(10)*/
+static struct {
+    bool in_flight;
+    bool is_read;
+    uint32_t buffer_index;
+    uint64_t byte_address;
+    uint32_t len;
+} storage_xfer = { false, false, 0u, 0u, 0u };
+
+/*Index of the buffer next handed to the USB driver*/
+static uint32_t next_buffer_index = 0u;
 
 flash_lun_data_t lun_data[NUMBER_OF_LUNS_ON_DRIVE] = {{MMC_NUM_LBA_BLOCKS, MMC_ERASE_SIZE, MMC_LBA_BLOCK_SIZE}};
 
@@ -125,11 +147,11 @@ bool FLASH_DRIVE_init(void)
 {
     bool result = false;
 
-    bool HSS_Storage_Init(void);
-    void HSS_Storage_GetInfo(uint32_t *pBlockSize, uint32_t *pEraseSize, uint32_t *pBlockCount);
-
     result = HSS_Storage_Init();
 
+    storage_xfer.in_flight = false;
+    next_buffer_index = 0u;
+
     if (result) {
         HSS_Storage_GetInfo(&(lun_data[0].lba_block_size),
             &(lun_data[0].erase_block_size),
@@ -210,11 +232,32 @@ static uint8_t* usb_flash_media_inquiry(uint8_t lun, uint32_t *len)
     return ((uint8_t*)&usb_flash_media_inquiry_data[lun]);
 }
 
+static bool wait_for_storage_xfer(void)
+{
+    bool result = true;
+
+    if (storage_xfer.in_flight) {
+        while (!HSS_Storage_IsTransferComplete(&result)) {
+            ;
+        }
+
+        if (!result) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "background %s of %u bytes @0x%lx failed\n",
+                storage_xfer.is_read ? "read" : "write", storage_xfer.len, storage_xfer.byte_address);
+        }
+
+        storage_xfer.in_flight = false;
+    }
+
+    return result;
+}
+
 static uint8_t usb_flash_media_release(uint8_t cfgidx)
 {
     (void)cfgidx;
 
-    void HSS_Storage_FlushWriteBuffer(void);
+    (void)wait_for_storage_xfer();
+
     HSS_Storage_FlushWriteBuffer();
 
     g_host_connection_detected = 0u;
@@ -253,12 +296,28 @@ static void physical_device_read(uint64_t byte_address, uint8_t *p_rx_buffer,
 {
     update_read_count(size_in_bytes);
 
-    bool HSS_Storage_ReadBlock(void * p_rx_buffer, size_t byte_address, size_t size_in_bytes);
     (void)HSS_Storage_ReadBlock((void *)p_rx_buffer, (size_t)byte_address, size_in_bytes);
 }
 
+static void physical_device_read_start(uint64_t byte_address, uint32_t buffer_index,
+    uint32_t size_in_bytes)
+{
+    storage_xfer.in_flight = HSS_Storage_ReadBlockStart((void *)lun0_data_buffer[buffer_index],
+        (size_t)byte_address, size_in_bytes);
+    storage_xfer.is_read = true;
+    storage_xfer.buffer_index = buffer_index;
+    storage_xfer.byte_address = byte_address;
+    storage_xfer.len = size_in_bytes;
+}
+
+/*len is what remains of the READ(10), so once this part has been read, the next
+part is prefetched into another buffer while this one is sent to the host*/
 static uint32_t usb_flash_media_read(uint8_t lun, uint8_t **buf, uint64_t lba_addr, uint32_t len)
 {
+    uint32_t const remaining = len;
+    uint32_t buffer_index = next_buffer_index;
+    bool prefetched = false;
+
     *buf = NULL;
 
     if (lun != 0u) {
@@ -269,8 +328,28 @@ static uint32_t usb_flash_media_read(uint8_t lun, uint8_t **buf, uint64_t lba_ad
         len = SD_RD_WR_SIZE;
     }
 
-    physical_device_read(lba_addr, lun0_data_buffer, len);
-    *buf = lun0_data_buffer;
+    if (storage_xfer.in_flight && storage_xfer.is_read
+        && (storage_xfer.byte_address == lba_addr) && (storage_xfer.len == len)) {
+        buffer_index = storage_xfer.buffer_index;
+        prefetched = wait_for_storage_xfer();
+    } else {
+        // any write must complete before reading, and any other prefetch is stale
+        (void)wait_for_storage_xfer();
+    }
+
+    if (prefetched) {
+        update_read_count(len);
+    } else {
+        physical_device_read(lba_addr, lun0_data_buffer[buffer_index], len);
+    }
+    *buf = lun0_data_buffer[buffer_index];
+    next_buffer_index = (buffer_index + 1u) % NUM_DATA_BUFFERS;
+
+    if ((NUM_DATA_BUFFERS > 1u) && (remaining > len)) {
+        uint32_t const prefetch_len = ((remaining - len) > SD_RD_WR_SIZE) ?
+            SD_RD_WR_SIZE : (remaining - len);
+        physical_device_read_start(lba_addr + len, next_buffer_index, prefetch_len);
+    }
 
     return len;
 }
@@ -281,23 +360,34 @@ static uint8_t* usb_flash_media_acquire_write_buf(uint8_t lun, uint64_t blk_addr
     *len = 0u;
 
     if ((blk_addr < ((uint64_t)lun_data[0].number_of_blocks * lun_data[0].lba_block_size)) && (lun == 0u)) {
+        // the buffer handed out must not be the source of a write still in flight
+        if (storage_xfer.in_flight
+            && (storage_xfer.is_read || (storage_xfer.buffer_index == next_buffer_index))) {
+            (void)wait_for_storage_xfer();
+        }
+
         *len = SD_RD_WR_SIZE;
-        result = lun0_data_buffer;
+        result = lun0_data_buffer[next_buffer_index];
     }
 
     return result;
 }
 
-static void physical_device_program(uint64_t byte_address, uint8_t * p_write_buffer,
+static void physical_device_program_start(uint64_t byte_address, uint32_t buffer_index,
     uint32_t size_in_bytes)
 {
     update_write_count(size_in_bytes);
 
-    bool HSS_Storage_WriteBlock(size_t dstOffset, void * pSrc, size_t byteCount);
-    (void)HSS_Storage_WriteBlock((size_t)byte_address, (void *)p_write_buffer,
-        (size_t)size_in_bytes);
+    storage_xfer.in_flight = HSS_Storage_WriteBlockStart((size_t)byte_address,
+        (void *)lun0_data_buffer[buffer_index], (size_t)size_in_bytes);
+    storage_xfer.is_read = false;
+    storage_xfer.buffer_index = buffer_index;
+    storage_xfer.byte_address = byte_address;
+    storage_xfer.len = size_in_bytes;
 }
 
+/*the received data is written in the background, while the next part of the
+WRITE(10) is received into another buffer*/
 static uint32_t usb_flash_media_write_ready(uint8_t lun, uint64_t blk_addr, uint32_t len)
 {
     uint32_t result = 0u;
@@ -306,7 +396,10 @@ static uint32_t usb_flash_media_write_ready(uint8_t lun, uint64_t blk_addr, uint
             len = SD_RD_WR_SIZE;
         }
 
-        physical_device_program(blk_addr, lun0_data_buffer, len);
+        (void)wait_for_storage_xfer();
+
+        physical_device_program_start(blk_addr, next_buffer_index, len);
+        next_buffer_index = (next_buffer_index + 1u) % NUM_DATA_BUFFERS;
         result = 1u;
     }
 
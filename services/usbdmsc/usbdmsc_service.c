@@ -24,11 +24,16 @@
 #include "usbdmsc_service.h"
 #include "mpfs_reg_map.h"
 #include "hss_boot_service.h"
+#include "hss_boot_init.h"
 #include "hss_trigger.h"
 
 #include "drivers/mss/mss_mmuart/mss_uart.h"
 #include "flash_drive_app.h"
 
+#if IS_ENABLED(CONFIG_SERVICE_QSPI)
+#  include "qspi_service.h"
+#endif
+
 static void usbdmsc_init_handler(struct StateMachine * const pMyMachine);
 static void usbdmsc_idle_onEntry(struct StateMachine * const pMyMachine);
 static void usbdmsc_idle_handler(struct StateMachine * const pMyMachine);
@@ -180,9 +185,15 @@ static void usbdmsc_active_onExit(struct StateMachine * const pMyMachine)
 {
     (void)pMyMachine;
 
-    void HSS_Storage_FlushWriteBuffer(void);
     HSS_Storage_FlushWriteBuffer();
 
+#if IS_ENABLED(CONFIG_SERVICE_QSPI)
+    //
+    // the pre-boot TinyCLI does not run qspi_service, so finish any QSPI write-back
+    // here rather than leaving it to the superloop
+    HSS_CachedQSPI_WaitForWriteBack();
+#endif
+
     USBDMSC_Shutdown();
 
     mHSS_PUTS("\nUSB Host disconnected...\n");
@@ -2256,8 +2256,6 @@ extern "C" {
     do                                       \
     {                                        \
         status = result;                     \
-	if (status == TINFL_STATUS_FAILED)   \
-            asm("ebreak");                   \
         r->m_state = state_index;            \
         goto common_exit;                    \
         case state_index:;                   \
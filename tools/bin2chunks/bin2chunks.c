@@ -292,10 +292,32 @@ void fileOut_WriteBinaryFileArray_(FILE *pFileOut, FILE **ppFileIn, size_t *binS
     }
 }
 
+/*****************************************************************************************/
+/*! \brief Calculates the CRC32 of one chunk of an input binary, as checked by the boot service
+ */
+static uint32_t calculateChunkCrc_(FILE *pFileIn, size_t offset, size_t size)
+{
+    uint32_t crc = 0u;
+    uint8_t buffer[4096];
+
+    fseeko(pFileIn, (off_t)offset, SEEK_SET);
+    while (size) {
+        size_t readSize = (size < sizeof(buffer)) ? size : sizeof(buffer);
+        size_t bytesRead = fread(buffer, 1, readSize, pFileIn);
+        assert(bytesRead == readSize);
+
+        crc = CRC32_calculate_ex(crc, buffer, bytesRead);
+        size -= bytesRead;
+    }
+    fseeko(pFileIn, 0, SEEK_SET);
+
+    return crc;
+}
+
 /*****************************************************************************************/
 /*! \brief Generates the code/ro data/rw data chunk table
  */
-void fileOut_WriteBootChunkTable_(FILE *pFileOut, int *pOwnerArray, size_t *binSize, size_t chunkSize)
+void fileOut_WriteBootChunkTable_(FILE *pFileOut, FILE **ppFileIn, int *pOwnerArray, size_t *binSize, size_t chunkSize)
 {
     off_t posn = ftello(pFileOut);
     assert(chunkTableOffset == (size_t)posn);
@@ -317,8 +339,6 @@ void fileOut_WriteBootChunkTable_(FILE *pFileOut, int *pOwnerArray, size_t *binS
                 .owner = owner,
                 .loadAddr = (bootImagePaddedSize + chunkTablePaddedSize + ziChunkTablePaddedSize + idx + totalIdx),
                 .execAddr = (execAddr[i] + idx),
-                //.size = thisCountSize,
-                //.crc32 = crc
             };
 
             if (idx == 0) {
@@ -331,8 +351,7 @@ void fileOut_WriteBootChunkTable_(FILE *pFileOut, int *pOwnerArray, size_t *binS
             if (thisChunkSize > chunkSize) { thisChunkSize = chunkSize; }
 
             bootChunk.size = thisChunkSize;
-            bootChunk.crc32 = 0u;
-            //bootChunk.crc32 = CRC32_calculate(BLAH, thisChunkSize);
+            bootChunk.crc32 = calculateChunkCrc_(ppFileIn[i], idx, thisChunkSize);
 
 #if DEBUG
             if (DEBUG) {
@@ -562,7 +581,7 @@ int main(int argc, char **argv)
     calculateChunkCounts_(binSize, gChunkSize);
     // writing test header
     (void)fileOut_WriteBootImageHeader_(pFileOut, ownerArray, imageNameBuf, &pFileNameArray[0], chunkCountArray, ziChunkCount, 0u, 0u);
-    fileOut_WriteBootChunkTable_(pFileOut, ownerArray, binSize, gChunkSize);
+    fileOut_WriteBootChunkTable_(pFileOut, ppFileIn, ownerArray, binSize, gChunkSize);
     fileOut_WriteBootZIChunkTable_(pFileOut, ownerArray);
     fileOut_WriteBinaryFileArray_(pFileOut, ppFileIn, binSize, gChunkSize);
 
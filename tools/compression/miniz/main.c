@@ -86,9 +86,10 @@ int main(int argc, char **argv)
         .originalImageLen = inputSize,
     };
 
-    imgHdr.headerCrc = CRC32_calculate((const uint8_t *)&imgHdr, sizeof(struct HSS_CompressedImage));
+    // the header CRC covers the compressed and original CRCs, so calculate it last
     imgHdr.compressedCrc = CRC32_calculate((const uint8_t *)pOutput, outputSize);
     imgHdr.originalCrc = CRC32_calculate((const uint8_t *)pInput, inputSize);
+    imgHdr.headerCrc = CRC32_calculate((const uint8_t *)&imgHdr, sizeof(struct HSS_CompressedImage));
 
     bytesProcessed = fwrite((const void*)&imgHdr, 1, sizeof(struct HSS_CompressedImage), pFileOut);
     if (bytesProcessed != (size_t)sizeof(struct HSS_CompressedImage)) {
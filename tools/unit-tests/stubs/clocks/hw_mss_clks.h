@@ -0,0 +1,18 @@
+#ifndef HW_MSS_CLKS_H_
+#define HW_MSS_CLKS_H_
+
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ * Host unit tests - stand-in for the Libero generated clock settings, which
+ * hss_clock.h uses to derive TICKS_PER_SEC
+ *
+ */
+
+#define LIBERO_SETTING_MSS_RTC_TOGGLE_CLK    1000000UL
+
+#endif
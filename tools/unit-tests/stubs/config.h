@@ -0,0 +1,16 @@
+#ifndef UNIT_TEST_CONFIG_H
+#define UNIT_TEST_CONFIG_H
+
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ * Host unit tests - stand-in for the Kconfig generated config.h
+ *
+ * Only the options that the sources under test depend on are set here
+ */
+
+#endif
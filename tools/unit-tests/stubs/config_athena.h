@@ -0,0 +1,32 @@
+#ifndef CONFIG_ATHENA_H
+#define CONFIG_ATHENA_H
+
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ * Host unit tests - the User Crypto control register, backed by memory that the
+ * test provides rather than at its hardware address
+ *
+ */
+
+#include <stdint.h>
+
+typedef struct _athenareg
+{
+    uint32_t ATHENA_CR;
+    uint32_t ATHENA_STALL_CR;
+    uint32_t ATHENA_UPPER_ADDRESS;
+} athenareg_t;
+
+extern athenareg_t unitTestAthenaReg;
+
+#define ATHENAREG                   (&unitTestAthenaReg)
+
+#define SYSREG_ATHENACR_RESET       (1U << 0U)
+#define SYSREG_ATHENACR_RINGOSCON   (1U << 3U)
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef HSS_DDR_SERVICE_H
+#define HSS_DDR_SERVICE_H
+
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ * Host unit tests - the DDR service, which the test backs with memory of its own
+ *
+ */
+
+#include "hss_types.h"
+
+uintptr_t HSS_DDR_GetStart(void);
+
+#endif
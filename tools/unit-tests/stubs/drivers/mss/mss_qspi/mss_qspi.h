@@ -0,0 +1,18 @@
+#ifndef UNIT_TEST_DRIVERS_MSS_QSPI_H
+#define UNIT_TEST_DRIVERS_MSS_QSPI_H
+
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ * Host unit tests - the MSS QSPI driver, as flash drivers include it, which is
+ * the stand-in in stubs/
+ *
+ */
+
+#include <mss_qspi.h>
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef ENCODING_H
+#define ENCODING_H
+
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ * Host unit tests - stand-in for the RISC-V CSR encodings, none of which the
+ * sources under test use
+ *
+ */
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef HSS_DEBUG_H
+#define HSS_DEBUG_H
+
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ * Host unit tests - debug output, printed only if UNIT_TEST_VERBOSE is defined
+ *
+ */
+
+#include <stdio.h>
+#include "hss_types.h"
+
+#ifdef UNIT_TEST_VERBOSE
+#  define mHSS_DEBUG_PRINTF(logLevel, ...) { printf(#logLevel ": " __VA_ARGS__); }
+#  define mHSS_DEBUG_PRINTF_EX(...) printf(__VA_ARGS__)
+#else
+#  define mHSS_DEBUG_PRINTF(logLevel, ...) { if (0) { printf(__VA_ARGS__); } }
+#  define mHSS_DEBUG_PRINTF_EX(...) { if (0) { printf(__VA_ARGS__); } }
+#endif
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef MSS_QSPI_H_
+#define MSS_QSPI_H_
+
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ * Host unit tests - the QSPI IO formats from the MSS QSPI driver, without the
+ * register and interrupt definitions it pulls in
+ *
+ */
+
+typedef enum mss_qspi_io_format_t
+{
+    MSS_QSPI_NORMAL      = 0u,
+    MSS_QSPI_DUAL_EX_RO  = 2u,
+    MSS_QSPI_QUAD_EX_RO  = 3u,
+    MSS_QSPI_DUAL_EX_RW  = 4u,
+    MSS_QSPI_QUAD_EX_RW  = 5u,
+    MSS_QSPI_DUAL_FULL   = 6u,
+    MSS_QSPI_QUAD_FULL   = 7u
+
+} mss_qspi_io_format;
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef MSS_SYS_SERVICES_H
+#define MSS_SYS_SERVICES_H
+
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ * Host unit tests - stand-in for the MSS system services driver, with only the SPI copy
+ * service and the System Controller registers its callers poll. Tests that use them
+ * redirect MSS_SCBCTRL to a model, and provide the functions
+ *
+ */
+
+#include <stdint.h>
+
+#define MSS_SYS_SERVICE_INTERRUPT_MODE  1u
+#define MSS_SYS_SERVICE_POLLING_MODE    0u
+
+typedef void (*mss_sys_service_handler_t)(void);
+
+void MSS_SYS_select_service_mode(uint8_t sys_service_mode,
+    mss_sys_service_handler_t mss_sys_service_interrupt_handler);
+uint16_t MSS_SYS_spi_copy(uint64_t mss_dest_addr, uint32_t mss_spi_flash, uint32_t n_bytes,
+    uint8_t options, uint16_t mb_offset);
+
+typedef struct
+{
+    volatile uint32_t SOFT_RESET;
+    volatile uint32_t VDETECTOR;
+    volatile uint32_t TVS_CONTROL;
+    volatile uint32_t TVS_TEMP_A;
+    volatile uint32_t TVS_TEMP_B;
+    volatile uint32_t TVS_TEMP_C;
+    volatile uint32_t TVS_VOLT_A;
+    volatile uint32_t TVS_VOLT_B;
+    volatile uint32_t TVS_VOLT_C;
+    volatile uint32_t TVS_OUTPUT0;
+    volatile uint32_t TVS_OUTPUT1;
+    volatile uint32_t TVS_TRIGGER;
+    volatile uint32_t TRIM_VDET1P05;
+    volatile uint32_t TRIM_VDET1P8;
+    volatile uint32_t TRIM_VDET2P5;
+    volatile uint32_t TRIM_TVS;
+    volatile uint32_t TRIM_GDET1P05;
+    volatile uint32_t RESERVED0;
+    volatile uint32_t RESERVED1;
+    volatile uint32_t RESERVED2;
+    volatile uint32_t SERVICES_CR;
+    volatile uint32_t SERVICES_SR;
+    volatile uint32_t USER_DETECTOR_SR;
+    volatile uint32_t USER_DETECTOR_CR;
+    volatile uint32_t MSS_SPI_CR;
+} SCBCTRL_TypeDef;
+
+#define MSS_SCBCTRL                     ((SCBCTRL_TypeDef volatile *) (0x37020000UL))
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef SBI_BITOPS_H
+#define SBI_BITOPS_H
+
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ * Host unit tests - the OpenSBI bit operations used by the HSS, without the
+ * RISC-V type definitions that the OpenSBI header pulls in
+ *
+ */
+
+#include <limits.h>
+
+#define BITS_PER_LONG           (CHAR_BIT * sizeof(long))
+#define BITS_TO_LONGS(nbits)    (((nbits) + BITS_PER_LONG - 1) / BITS_PER_LONG)
+
+static inline int sbi_ffs(unsigned long word)
+{
+    return __builtin_ctzl(word);
+}
+
+static inline void __set_bit(int nr, volatile unsigned long *addr)
+{
+    addr[nr / BITS_PER_LONG] |= (1UL << (nr % BITS_PER_LONG));
+}
+
+static inline void __clear_bit(int nr, volatile unsigned long *addr)
+{
+    addr[nr / BITS_PER_LONG] &= ~(1UL << (nr % BITS_PER_LONG));
+}
+
+static inline int __test_bit(int nr, const volatile unsigned long *addr)
+{
+    return (addr[nr / BITS_PER_LONG] >> (nr % BITS_PER_LONG)) & 1UL;
+}
+
+#endif
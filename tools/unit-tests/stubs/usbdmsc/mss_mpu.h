@@ -0,0 +1,16 @@
+#ifndef MSS_MPU_H
+#define MSS_MPU_H
+
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ * Host unit tests - stand-in for the MPFS HAL MPU definitions, none of which the USB mass
+ * storage application uses. Only the USBDMSC tests search this directory
+ *
+ */
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef HSS_ECDSA_PUBLIC_KEY_H
+#define HSS_ECDSA_PUBLIC_KEY_H
+
+// Host unit tests - a test signing key, generated by tools/secure-boot/der_to_c_header.py.
+// Its private key is in test_crypto.c, so it must never be used to sign real images
+
+const char SECP384R1_ECDSA_public_key[] = {
+    0x30, 0x76, 0x30, 0x10, 0x06, 0x07, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x02,
+    0x01, 0x06, 0x05, 0x2B, 0x81, 0x04, 0x00, 0x22, 0x03, 0x62, 0x00, 0x04,
+    0xDF, 0x3A, 0xA1, 0xD9, 0xA3, 0xF8, 0xEA, 0x72, 0x89, 0xD8, 0x52, 0xFB,
+    0x72, 0x7F, 0xD5, 0xD2, 0x9F, 0x66, 0x7D, 0x83, 0x17, 0x6E, 0x53, 0x4E,
+    0x94, 0x27, 0x88, 0xD4, 0x40, 0x3E, 0xE6, 0x26, 0xC6, 0x81, 0xC7, 0x77,
+    0x15, 0xC9, 0xFB, 0x61, 0x42, 0x01, 0x57, 0xE1, 0x40, 0xF6, 0x72, 0x8D,
+    0x64, 0x9B, 0x96, 0x10, 0xB5, 0x72, 0xE5, 0xB7, 0x49, 0x44, 0x16, 0x1D,
+    0x56, 0xB6, 0x5D, 0xC1, 0x25, 0x37, 0x92, 0xBD, 0xC7, 0xE9, 0x62, 0x3F,
+    0xA0, 0x99, 0x67, 0x4C, 0x84, 0x94, 0x02, 0x04, 0xFD, 0x1A, 0x98, 0xFF,
+    0x97, 0x5C, 0x04, 0x6E, 0x81, 0xA8, 0x7F, 0x59, 0xFE, 0x48, 0x61, 0x69,
+};
+
+#endif
@@ -0,0 +1,456 @@
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/*!
+ * \file Host unit tests for streamed boot image chunk downloads
+ * \brief Checks that chunks streamed from a file-backed storage provider are byte
+ * identical to chunks copied from a boot image loaded whole into memory, that chunk
+ * CRCs catch corruption, and that sub-chunks are sized by the time their reads take
+ */
+
+#include "config.h"
+#include "hss_types.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "hss_boot_download.h"
+#include "unit_test.h"
+
+#define BLOCK_SIZE              (512u)
+#define IMAGE_SIZE              (256u * 1024u)
+#define SUB_CHUNK_SIZE          (32768u)
+#define ASYNC_POLLS             (3u)
+
+static int imageFd_ = -1;
+static uint8_t image_[IMAGE_SIZE] __attribute__((aligned(8)));
+
+static struct {
+    size_t reads;
+    size_t bytesRead;
+    size_t misalignedReads;
+    void *pAsyncDest;
+    size_t asyncSrcOffset;
+    size_t asyncByteCount;
+    unsigned asyncPolls;
+} storage_;
+
+static bool file_read_(void *pDest, size_t srcOffset, size_t byteCount)
+{
+    storage_.reads++;
+    storage_.bytesRead += byteCount;
+    if ((srcOffset % BLOCK_SIZE) || (byteCount % BLOCK_SIZE)) {
+        storage_.misalignedReads++;
+    }
+
+    return pread(imageFd_, pDest, byteCount, (off_t)srcOffset) == (ssize_t)byteCount;
+}
+
+static void file_get_info_(uint32_t *pBlockSize, uint32_t *pEraseSize, uint32_t *pBlockCount)
+{
+    *pBlockSize = BLOCK_SIZE;
+    *pEraseSize = BLOCK_SIZE;
+    *pBlockCount = IMAGE_SIZE / BLOCK_SIZE;
+}
+
+//
+// background reads only land in the destination once they have been polled to completion
+static bool file_read_start_(void *pDest, size_t srcOffset, size_t byteCount)
+{
+    bool result = (storage_.pAsyncDest == NULL);
+
+    if (result) {
+        storage_.pAsyncDest = pDest;
+        storage_.asyncSrcOffset = srcOffset;
+        storage_.asyncByteCount = byteCount;
+        storage_.asyncPolls = 0u;
+    }
+
+    return result;
+}
+
+static bool file_is_transfer_complete_(bool *pResult)
+{
+    bool complete = false;
+
+    if (storage_.pAsyncDest && (++storage_.asyncPolls >= ASYNC_POLLS)) {
+        *pResult = file_read_(storage_.pAsyncDest, storage_.asyncSrcOffset,
+            storage_.asyncByteCount);
+        storage_.pAsyncDest = NULL;
+        complete = true;
+    }
+
+    return complete;
+}
+
+static struct HSS_Storage syncStorage_ = {
+    .name = "test file",
+    .readBlock = file_read_,
+    .getInfo = file_get_info_,
+};
+
+static struct HSS_Storage asyncStorage_ = {
+    .name = "test file (async)",
+    .readBlock = file_read_,
+    .getInfo = file_get_info_,
+    .readBlockStart = file_read_start_,
+    .isTransferComplete = file_is_transfer_complete_,
+};
+
+static void large_block_get_info_(uint32_t *pBlockSize, uint32_t *pEraseSize,
+    uint32_t *pBlockCount)
+{
+    *pBlockSize = 2048u;
+    *pEraseSize = 2048u * 64u;
+    *pBlockCount = 1024u;
+}
+
+static struct HSS_Storage largeBlockStorage_ = {
+    .name = "test NAND",
+    .readBlock = file_read_,
+    .getInfo = large_block_get_info_,
+};
+
+//
+// chunks at block-aligned and unaligned offsets, with sizes that are smaller than a block,
+// a whole number of blocks, and larger than a sub-chunk, to aligned and unaligned
+// destinations
+static const struct {
+    size_t loadAddr;
+    size_t destOffset;
+    size_t size;
+} chunks_[] = {
+    { 0x00400u, 0x00000u,  BLOCK_SIZE * 8u },
+    { 0x01400u, 0x01000u,  100u },
+    { 0x01464u, 0x02001u,  SUB_CHUNK_SIZE + 777u },
+    { 0x0A001u, 0x0C000u,  SUB_CHUNK_SIZE * 3u + 5u },
+    { 0x25000u, 0x26000u,  BLOCK_SIZE - 1u },
+    { 0x26000u, 0x27003u,  BLOCK_SIZE * 17u },
+    { 0x30000u, 0x32000u,  1u },
+};
+
+#define DEST_SIZE               (0x32001u + 64u)
+
+static uint8_t copied_[DEST_SIZE] __attribute__((aligned(8)));
+static uint8_t streamed_[DEST_SIZE] __attribute__((aligned(8)));
+
+static void create_image_(void)
+{
+    char path[] = "/tmp/hss_boot_download_XXXXXX";
+
+    srand(1u);
+    for (size_t i = 0u; i < IMAGE_SIZE; i++) {
+        image_[i] = (uint8_t)rand();
+    }
+
+    imageFd_ = mkstemp(path);
+    if (imageFd_ >= 0) {
+        unlink(path);
+        if (pwrite(imageFd_, image_, IMAGE_SIZE, 0) != (ssize_t)IMAGE_SIZE) {
+            close(imageFd_);
+            imageFd_ = -1;
+        }
+    }
+}
+
+//
+// the reference: the whole image is read into memory, and each chunk is copied out of it
+static void copied_load_(size_t imageOffset)
+{
+    memset(copied_, 0xA5, sizeof(copied_));
+
+    for (size_t i = 0u; i < ARRAY_SIZE(chunks_); i++) {
+        memcpy(copied_ + chunks_[i].destOffset, image_ + imageOffset + chunks_[i].loadAddr,
+            chunks_[i].size);
+    }
+}
+
+//
+// each chunk is streamed in sub-chunks, calling repeatedly while progress is pending, in
+// the same way as the boot service Download state
+static bool streamed_load_(struct HSS_BootStreamSource * const pSource, size_t imageOffset)
+{
+    bool result = true;
+
+    memset(streamed_, 0xA5, sizeof(streamed_));
+
+    for (size_t i = 0u; result && (i < ARRAY_SIZE(chunks_)); i++) {
+        size_t subChunkOffset = 0u;
+        unsigned idleCalls = 0u;
+
+        while (result && (subChunkOffset < chunks_[i].size)) {
+            size_t bytesDone = 0u;
+            const size_t subChunkSize = MIN(SUB_CHUNK_SIZE, chunks_[i].size - subChunkOffset);
+
+            result = HSS_BootDownload_StreamSubChunk(pSource,
+                streamed_ + chunks_[i].destOffset + subChunkOffset,
+                imageOffset + chunks_[i].loadAddr + subChunkOffset, subChunkSize, &bytesDone);
+
+            if (bytesDone) {
+                CHECK(bytesDone <= subChunkSize);
+                subChunkOffset += bytesDone;
+                idleCalls = 0u;
+            } else if (++idleCalls > ASYNC_POLLS) {
+                result = false;                         // no progress
+            }
+        }
+    }
+
+    return result;
+}
+
+static void test_sync_streamed_matches_copied(void)
+{
+    struct HSS_BootStreamSource source;
+
+    memset(&storage_, 0, sizeof(storage_));
+    CHECK(HSS_BootDownload_SetSource(&source, &syncStorage_, 0u));
+    CHECK(streamed_load_(&source, 0u));
+
+    copied_load_(0u);
+    CHECK(memcmp(streamed_, copied_, sizeof(copied_)) == 0);
+
+    //
+    // partial blocks are bounced, but everything else is read directly, so at most two
+    // extra blocks are read per chunk
+    CHECK(storage_.misalignedReads == 0u);
+    size_t totalSize = 0u;
+    for (size_t i = 0u; i < ARRAY_SIZE(chunks_); i++) {
+        totalSize += chunks_[i].size;
+    }
+    CHECK(storage_.bytesRead <= totalSize + (ARRAY_SIZE(chunks_) * 2u * BLOCK_SIZE));
+}
+
+static void test_async_streamed_matches_copied(void)
+{
+    struct HSS_BootStreamSource source;
+
+    memset(&storage_, 0, sizeof(storage_));
+    CHECK(HSS_BootDownload_SetSource(&source, &asyncStorage_, 0u));
+    CHECK(streamed_load_(&source, 0u));
+    CHECK(source.pPendingDest == NULL);
+
+    copied_load_(0u);
+    CHECK(memcmp(streamed_, copied_, sizeof(copied_)) == 0);
+    CHECK(storage_.misalignedReads == 0u);
+}
+
+static void test_unaligned_image_offset(void)
+{
+    struct HSS_BootStreamSource source;
+    const size_t imageOffset = 0x123u;
+
+    //
+    // a boot image that does not start on a block boundary, so that every chunk starts
+    // part way through a block
+    memset(&storage_, 0, sizeof(storage_));
+    CHECK(HSS_BootDownload_SetSource(&source, &asyncStorage_, imageOffset));
+    CHECK(streamed_load_(&source, imageOffset));
+
+    copied_load_(imageOffset);
+    CHECK(memcmp(streamed_, copied_, sizeof(copied_)) == 0);
+}
+
+static void test_abandoned_read(void)
+{
+    struct HSS_BootStreamSource source;
+    size_t bytesDone = 1u;
+
+    memset(&storage_, 0, sizeof(storage_));
+    memset(streamed_, 0, sizeof(streamed_));
+    CHECK(HSS_BootDownload_SetSource(&source, &asyncStorage_, 0u));
+
+    CHECK(HSS_BootDownload_StreamSubChunk(&source, streamed_, 0u, SUB_CHUNK_SIZE, &bytesDone));
+    CHECK_EQUAL(bytesDone, 0u);
+    CHECK(source.pPendingDest == streamed_);
+
+    //
+    // another destination must not claim the read in flight
+    CHECK(HSS_BootDownload_StreamSubChunk(&source, streamed_ + SUB_CHUNK_SIZE, SUB_CHUNK_SIZE,
+        SUB_CHUNK_SIZE, &bytesDone));
+    CHECK_EQUAL(bytesDone, 0u);
+
+    HSS_BootDownload_AbandonStreamRead(&source, streamed_ + SUB_CHUNK_SIZE);
+    CHECK(source.pPendingDest == streamed_);
+
+    HSS_BootDownload_AbandonStreamRead(&source, streamed_);
+    CHECK(source.pPendingDest == NULL);
+    CHECK(storage_.pAsyncDest == NULL);
+    CHECK(memcmp(streamed_, image_, SUB_CHUNK_SIZE) == 0);
+}
+
+static void test_source_validation(void)
+{
+    struct HSS_BootStreamSource source;
+
+    CHECK(!HSS_BootDownload_SetSource(&source, NULL, 0u));
+    CHECK(source.pStorage == NULL);
+
+    //
+    // partial blocks are bounced, so blocks larger than the bounce buffer cannot be streamed
+    CHECK(!HSS_BootDownload_SetSource(&source, &largeBlockStorage_, 0u));
+    CHECK(source.pStorage == NULL);
+
+    CHECK(HSS_BootDownload_SetSource(&source, &syncStorage_, 0x400u));
+    CHECK(source.pStorage == &syncStorage_);
+    CHECK_EQUAL(source.blockSize, BLOCK_SIZE);
+    CHECK_EQUAL(source.srcOffset, 0x400u);
+}
+
+static void test_adapt_sub_chunk_size(void)
+{
+    const HSSTicks_t budget = 1000u;
+
+    CHECK_EQUAL(HSS_BootDownload_AdaptSubChunkSize(4096u, 1001u, budget, 512u, 65536u), 2048u);
+    CHECK_EQUAL(HSS_BootDownload_AdaptSubChunkSize(4096u, 499u, budget, 512u, 65536u), 8192u);
+    CHECK_EQUAL(HSS_BootDownload_AdaptSubChunkSize(4096u, 500u, budget, 512u, 65536u), 4096u);
+    CHECK_EQUAL(HSS_BootDownload_AdaptSubChunkSize(4096u, budget, budget, 512u, 65536u), 4096u);
+
+    CHECK_EQUAL(HSS_BootDownload_AdaptSubChunkSize(768u, 5000u, budget, 512u, 65536u), 512u);
+    CHECK_EQUAL(HSS_BootDownload_AdaptSubChunkSize(512u, 5000u, budget, 512u, 65536u), 512u);
+    CHECK_EQUAL(HSS_BootDownload_AdaptSubChunkSize(65536u, 0u, budget, 512u, 65536u), 65536u);
+    CHECK_EQUAL(HSS_BootDownload_AdaptSubChunkSize(32768u, 0u, budget, 512u, 65536u), 65536u);
+}
+
+//
+// a background read which takes longer than the budget must shrink the sub-chunks, even
+// though each iteration of the Download state is well within the budget. Here, each
+// iteration costs a third of the budget, and a read completes on the third poll after the
+// iteration that issued it
+static void test_adapt_times_background_reads(void)
+{
+    struct HSS_BootStreamSource source;
+    const HSSTicks_t budget = 1000u;
+    HSSTicks_t now = 0u;
+    HSSTicks_t startTime = 0u;
+    bool started = false;
+    size_t subChunkSize = SUB_CHUNK_SIZE;
+    size_t offset = 0u;
+    unsigned adaptations = 0u;
+
+    memset(&storage_, 0, sizeof(storage_));
+    CHECK(HSS_BootDownload_SetSource(&source, &asyncStorage_, 0u));
+
+    while (offset < (4u * SUB_CHUNK_SIZE)) {
+        size_t bytesDone = 0u;
+
+        if (!started) {
+            startTime = now;
+            started = true;
+        }
+
+        CHECK(HSS_BootDownload_StreamSubChunk(&source, streamed_ + offset, offset,
+            subChunkSize, &bytesDone));
+        now += budget / 3u;
+
+        if (bytesDone) {
+            subChunkSize = HSS_BootDownload_AdaptSubChunkSize(subChunkSize, now - startTime,
+                budget, BLOCK_SIZE, SUB_CHUNK_SIZE);
+            started = false;
+            offset += bytesDone;
+            adaptations++;
+        }
+    }
+
+    CHECK_EQUAL(subChunkSize, BLOCK_SIZE);
+    CHECK(memcmp(streamed_, image_, offset) == 0);
+
+    //
+    // only completed reads are measured, so there is one adaptation per read
+    CHECK_EQUAL(adaptations, storage_.reads);
+}
+
+//
+// reference CRC-32 (IEEE 802.3, reflected), calculated bit by bit, as written to the chunk
+// table by the payload generator and bin2chunks
+static uint32_t reference_crc32_(uint8_t const *pData, size_t length)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+
+    while (length--) {
+        crc ^= *pData++;
+        for (size_t bit = 0u; bit < 8u; bit++) {
+            crc = (crc & 1u) ? ((crc >> 1) ^ 0xEDB88320u) : (crc >> 1);
+        }
+    }
+
+    return ~crc;
+}
+
+//
+// checks a chunk at its destination in uneven sub-chunks, in the same way as the Download
+// state
+static bool check_chunk_(struct HSS_BootChunkDesc const * const pChunk)
+{
+    static const size_t subChunkSizes[] = { 1u, 511u, 4096u, 777u, 32768u };
+    uint32_t crc = 0u;
+    size_t offset = 0u;
+
+    for (size_t i = 0u; offset < pChunk->size; i = (i + 1u) % ARRAY_SIZE(subChunkSizes)) {
+        const size_t subChunkSize = MIN(subChunkSizes[i], pChunk->size - offset);
+
+        crc = HSS_BootDownload_UpdateChunkCrc(pChunk, crc, offset, subChunkSize);
+        offset += subChunkSize;
+    }
+
+    return HSS_BootDownload_CheckChunkCrc(pChunk, crc);
+}
+
+static void test_chunk_crc_detects_bit_flips(void)
+{
+    struct HSS_BootChunkDesc chunk = {
+        .owner = HSS_HART_U54_1,
+        .loadAddr = 0x400u,
+        .execAddr = (uintptr_t)streamed_,
+        .size = 100000u,
+    };
+
+    memcpy(streamed_, image_, chunk.size);
+    chunk.crc32 = reference_crc32_(streamed_, chunk.size);
+    CHECK(check_chunk_(&chunk));
+
+    //
+    // every single bit flip is caught, wherever it is in the chunk
+    static const size_t flipOffsets[] = { 0u, 1u, 510u, 511u, 512u, 4095u, 50000u, 99999u };
+    for (size_t i = 0u; i < ARRAY_SIZE(flipOffsets); i++) {
+        for (unsigned bit = 0u; bit < 8u; bit++) {
+            streamed_[flipOffsets[i]] ^= (uint8_t)(1u << bit);
+            CHECK(!check_chunk_(&chunk));
+            streamed_[flipOffsets[i]] ^= (uint8_t)(1u << bit);
+        }
+    }
+    CHECK(check_chunk_(&chunk));
+
+    //
+    // a zero CRC in the chunk table is a CRC like any other, not a missing one
+    chunk.crc32 = 0u;
+    CHECK(!check_chunk_(&chunk));
+}
+
+int main(void)
+{
+    create_image_();
+    if (imageFd_ < 0) {
+        fprintf(stderr, "failed to create the test boot image file\n");
+        return EXIT_FAILURE;
+    }
+
+    RUN_TEST(test_sync_streamed_matches_copied);
+    RUN_TEST(test_async_streamed_matches_copied);
+    RUN_TEST(test_unaligned_image_offset);
+    RUN_TEST(test_abandoned_read);
+    RUN_TEST(test_source_validation);
+    RUN_TEST(test_chunk_crc_detects_bit_flips);
+    RUN_TEST(test_adapt_sub_chunk_size);
+    RUN_TEST(test_adapt_times_background_reads);
+
+    close(imageFd_);
+    return unit_test_report("boot_download");
+}
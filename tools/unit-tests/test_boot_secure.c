@@ -0,0 +1,254 @@
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/*!
+ * \file Host unit tests for streamed boot image signature checks
+ * \brief Checks that an image hashed piece by piece as it is copied gives the same SHA-384
+ * digest as hashing it in one pass, and that a streamed result is only reused for the
+ * image that was streamed
+ *
+ * The crypto backend is replaced by a model whose "signature" is the SHA-384 digest of the
+ * signed data, so that the digests of both paths can be compared directly.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+
+#include <string.h>
+
+#include "hss_crypto.h"
+#include "hss_boot_secure.h"
+#include "hash/sha384.h"
+#include "unit_test.h"
+
+#define IMAGE_SIZE              (200u * 1024u + 13u)
+
+static struct {
+    sha384_context ctx;
+    uint8_t expectedDigest[SHA384_DIGEST_SIZE];
+    uint8_t streamedDigest[SHA384_DIGEST_SIZE];
+    uint8_t oneShotDigest[SHA384_DIGEST_SIZE];
+    bool inProgress;
+    bool acceptAll;
+    unsigned streamedChecks;
+    unsigned oneShotChecks;
+} crypto_;
+
+bool HSS_Crypto_Verify_ECDSA_P384_Init(const size_t siglen, uint8_t sigBuffer[siglen])
+{
+    memcpy(crypto_.expectedDigest, sigBuffer, SHA384_DIGEST_SIZE);
+    sha384_init(&crypto_.ctx);
+    crypto_.inProgress = true;
+
+    return true;
+}
+
+bool HSS_Crypto_Verify_ECDSA_P384_Update(const size_t dataBufSize,
+    uint8_t const dataBuf[dataBufSize])
+{
+    if (crypto_.inProgress) {
+        sha384_update(&crypto_.ctx, dataBuf, (u32)dataBufSize);
+    }
+
+    return crypto_.inProgress;
+}
+
+bool HSS_Crypto_Verify_ECDSA_P384_Finalize(void)
+{
+    bool result = crypto_.inProgress;
+
+    if (result) {
+        sha384_final(&crypto_.ctx, crypto_.streamedDigest);
+        crypto_.streamedChecks++;
+        result = !memcmp(crypto_.streamedDigest, crypto_.expectedDigest, SHA384_DIGEST_SIZE);
+    }
+
+    crypto_.inProgress = false;
+    return result;
+}
+
+bool HSS_Crypto_Verify_ECDSA_P384(const size_t siglen, uint8_t sigBuffer[siglen],
+    const size_t dataBufSize, uint8_t dataBuf[dataBufSize])
+{
+    sha384(dataBuf, (u32)dataBufSize, crypto_.oneShotDigest);
+    crypto_.oneShotChecks++;
+
+    // a failed check never returns, so tests of images that would fail accept them
+    // and inspect the digest instead
+    return crypto_.acceptAll
+        || !memcmp(crypto_.oneShotDigest, sigBuffer, SHA384_DIGEST_SIZE);
+}
+
+bool HSS_PerfCtr_Allocate(int *pIdx, char const * name)
+{
+    (void)name;
+    *pIdx = 0;
+
+    return true;
+}
+
+void HSS_PerfCtr_Start(int index)
+{
+    (void)index;
+}
+
+void HSS_PerfCtr_Lap(int index)
+{
+    (void)index;
+}
+
+//
+// xorshift, so that the images are the same from run to run
+static uint32_t random_state_ = 0x0BADC0DEu;
+
+static uint32_t random_(void)
+{
+    random_state_ ^= random_state_ << 13;
+    random_state_ ^= random_state_ >> 17;
+    random_state_ ^= random_state_ << 5;
+
+    return random_state_;
+}
+
+static uint8_t source_[IMAGE_SIZE] __attribute__((aligned(8)));
+static uint8_t dest_[IMAGE_SIZE] __attribute__((aligned(8)));
+static uint8_t zeroedSig_[IMAGE_SIZE] __attribute__((aligned(8)));
+
+//
+// signs the image as the payload generator does, over the image with its signature field
+// zeroed
+static void build_image_(void)
+{
+    struct HSS_BootImage * const pImage = (struct HSS_BootImage *)source_;
+
+    for (size_t i = 0u; i < IMAGE_SIZE; i++) {
+        source_[i] = (uint8_t)random_();
+    }
+
+    pImage->magic = mHSS_BOOT_MAGIC;
+    pImage->bootImageLength = IMAGE_SIZE;
+    memset(&pImage->signature, 0, sizeof(pImage->signature));
+
+    memcpy(zeroedSig_, source_, IMAGE_SIZE);
+    sha384(zeroedSig_, IMAGE_SIZE, pImage->signature.ecdsaSig);
+}
+
+//
+// copies the image to its destination in pieces, hashing each piece as it lands, as
+// copyBootImageToDDR_() does
+static bool stream_copy_(size_t pieceSize)
+{
+    bool result = HSS_Boot_Secure_StreamBegin((struct HSS_BootImage const *)source_);
+
+    for (size_t offset = 0u; result && (offset < IMAGE_SIZE); offset += pieceSize) {
+        size_t const size = MIN(IMAGE_SIZE - offset, pieceSize);
+
+        memcpy(dest_ + offset, source_ + offset, size);
+        result = HSS_Boot_Secure_StreamUpdate(dest_ + offset, offset, size);
+    }
+
+    return HSS_Boot_Secure_StreamEnd((struct HSS_BootImage const *)dest_) && result;
+}
+
+static void test_streamed_digest_matches_one_shot(void)
+{
+    // pieces that split the signature field, and that are larger than the image
+    static const size_t pieceSizes[] = {
+        1u, 7u, 48u, 100u, 333u, 4096u, 64u * 1024u, IMAGE_SIZE, IMAGE_SIZE * 2u
+    };
+    uint8_t oneShotDigest[SHA384_DIGEST_SIZE];
+
+    build_image_();
+    sha384(zeroedSig_, IMAGE_SIZE, oneShotDigest);
+
+    for (size_t i = 0u; i < ARRAY_SIZE(pieceSizes); i++) {
+        memset(crypto_.streamedDigest, 0, sizeof(crypto_.streamedDigest));
+
+        CHECK(stream_copy_(pieceSizes[i]));
+        CHECK(!memcmp(crypto_.streamedDigest, oneShotDigest, SHA384_DIGEST_SIZE));
+        CHECK(!memcmp(dest_, source_, IMAGE_SIZE));
+    }
+
+    //
+    // and the one-pass check over the copy, as made when no streamed result is cached,
+    // hashes the same data
+    HSS_Boot_Secure_StreamReset();
+    CHECK(HSS_Boot_Secure_CheckCodeSigning((struct HSS_BootImage *)dest_));
+    CHECK(!memcmp(crypto_.oneShotDigest, oneShotDigest, SHA384_DIGEST_SIZE));
+}
+
+static void test_out_of_order_pieces_fail(void)
+{
+    build_image_();
+
+    CHECK(HSS_Boot_Secure_StreamBegin((struct HSS_BootImage const *)source_));
+    CHECK(HSS_Boot_Secure_StreamUpdate(source_, 0u, 4096u));
+    CHECK(!HSS_Boot_Secure_StreamUpdate(source_ + 8192u, 8192u, IMAGE_SIZE - 8192u));
+    CHECK(!HSS_Boot_Secure_StreamEnd((struct HSS_BootImage const *)source_));
+
+    // a short image is not verified either
+    CHECK(HSS_Boot_Secure_StreamBegin((struct HSS_BootImage const *)source_));
+    CHECK(HSS_Boot_Secure_StreamUpdate(source_, 0u, IMAGE_SIZE - 1u));
+    CHECK(!HSS_Boot_Secure_StreamEnd((struct HSS_BootImage const *)source_));
+}
+
+static void test_streamed_result_reused_for_same_image(void)
+{
+    build_image_();
+    CHECK(stream_copy_(64u * 1024u));
+
+    unsigned const oneShotChecks = crypto_.oneShotChecks;
+    CHECK(HSS_Boot_Secure_CheckCodeSigning((struct HSS_BootImage *)dest_));
+    CHECK_EQUAL(crypto_.oneShotChecks, oneShotChecks);
+
+    // and only once. The check zeroes the signature in place, so restore it first
+    memcpy(dest_, source_, sizeof(struct HSS_BootImage));
+    CHECK(HSS_Boot_Secure_CheckCodeSigning((struct HSS_BootImage *)dest_));
+    CHECK_EQUAL(crypto_.oneShotChecks, oneShotChecks + 1u);
+}
+
+//
+// another image loaded to the same address without being streamed, with the same length
+// and signature but tampered with, must be checked itself, rather than taking the earlier
+// image's result
+static void test_reset_forgets_streamed_result(void)
+{
+    uint8_t expectedDigest[SHA384_DIGEST_SIZE];
+
+    build_image_();
+    sha384(zeroedSig_, IMAGE_SIZE, expectedDigest);
+    CHECK(stream_copy_(64u * 1024u));
+
+    HSS_Boot_Secure_StreamReset();
+    dest_[IMAGE_SIZE / 2u] ^= 1u;
+
+    unsigned const oneShotChecks = crypto_.oneShotChecks;
+    crypto_.acceptAll = true;
+    CHECK(HSS_Boot_Secure_CheckCodeSigning((struct HSS_BootImage *)dest_));
+    crypto_.acceptAll = false;
+    CHECK_EQUAL(crypto_.oneShotChecks, oneShotChecks + 1u);
+    CHECK(memcmp(crypto_.oneShotDigest, expectedDigest, SHA384_DIGEST_SIZE));
+
+    // including while a stream is in progress
+    CHECK(HSS_Boot_Secure_StreamBegin((struct HSS_BootImage const *)source_));
+    CHECK(HSS_Boot_Secure_StreamUpdate(source_, 0u, 4096u));
+    HSS_Boot_Secure_StreamReset();
+    CHECK(!crypto_.inProgress);
+    CHECK(!HSS_Boot_Secure_StreamUpdate(source_ + 4096u, 4096u, IMAGE_SIZE - 4096u));
+}
+
+int main(void)
+{
+    RUN_TEST(test_streamed_digest_matches_one_shot);
+    RUN_TEST(test_out_of_order_pieces_fail);
+    RUN_TEST(test_streamed_result_reused_for_same_image);
+    RUN_TEST(test_reset_forgets_streamed_result);
+
+    return unit_test_report("boot_secure");
+}
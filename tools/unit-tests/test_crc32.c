@@ -0,0 +1,177 @@
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/*!
+ * \file Host unit tests for CRC32
+ * \brief Checks the table-driven CRC32 against a bit by bit reference over random buffers,
+ * lengths and alignments, and reports its throughput.
+ *
+ * This is built once per table mode and slicing option, so that each configuration is
+ * checked
+ */
+
+#include "config.h"
+#include "hss_types.h"
+
+#include <string.h>
+#include <time.h>
+
+#include "hss_crc32.h"
+#include "unit_test.h"
+
+#if IS_ENABLED(CONFIG_CRC32_SLICE_BY_16)
+#  define SLICING "slice-by-16"
+#elif IS_ENABLED(CONFIG_CRC32_SLICE_BY_8)
+#  define SLICING "slice-by-8"
+#else
+#  define SLICING "byte-wise"
+#endif
+
+#if IS_ENABLED(CONFIG_CRC32_USE_PRECALC_TABLE)
+#  define TABLE "precalculated table"
+#else
+#  define TABLE "runtime table"
+#endif
+
+#define BUFFER_SIZE             (1024u * 1024u)
+
+static uint8_t buffer_[BUFFER_SIZE + 64u] __attribute__((aligned(64)));
+
+static uint32_t reference_crc32_ex_(uint32_t seed, uint8_t const *pData, size_t length)
+{
+    uint32_t crc = ~seed;
+
+    while (length--) {
+        crc ^= *pData++;
+        for (size_t bit = 0u; bit < 8u; bit++) {
+            crc = (crc & 1u) ? ((crc >> 1) ^ 0xEDB88320u) : (crc >> 1);
+        }
+    }
+
+    return ~crc;
+}
+
+//
+// xorshift, so that the buffers are the same from run to run
+static uint32_t random_state_ = 0x12345678u;
+
+static uint32_t random_(void)
+{
+    random_state_ ^= random_state_ << 13;
+    random_state_ ^= random_state_ >> 17;
+    random_state_ ^= random_state_ << 5;
+
+    return random_state_;
+}
+
+static void fill_random_(uint8_t *pData, size_t length)
+{
+    while (length--) {
+        *pData++ = (uint8_t)random_();
+    }
+}
+
+static void test_known_values(void)
+{
+    static const uint8_t check[] = "123456789";
+
+    CHECK_EQUAL(CRC32_calculate(check, 9u), 0xCBF43926u);
+    CHECK_EQUAL(CRC32_calculate(check, 0u), 0u);
+    CHECK_EQUAL(CRC32_calculate(NULL, 16u), 0u);
+
+    memset(buffer_, 0, 32u);
+    CHECK_EQUAL(CRC32_calculate(buffer_, 32u), 0x190A55ADu);
+    memset(buffer_, 0xFF, 32u);
+    CHECK_EQUAL(CRC32_calculate(buffer_, 32u), 0xFF6CAB0Bu);
+}
+
+static void test_random_lengths_and_alignments(void)
+{
+    unsigned mismatches = 0u;
+
+    fill_random_(buffer_, sizeof(buffer_));
+
+    //
+    // every alignment, with lengths either side of the slice sizes, and longer ones
+    for (size_t alignment = 0u; alignment < 16u; alignment++) {
+        for (size_t length = 0u; length < 80u; length++) {
+            uint8_t const * const pData = buffer_ + alignment;
+            mismatches += (CRC32_calculate(pData, length) != reference_crc32_ex_(0u, pData, length));
+        }
+
+        for (unsigned i = 0u; i < 64u; i++) {
+            size_t const length = random_() % 8192u;
+            uint8_t const * const pData = buffer_ + alignment + (random_() % (BUFFER_SIZE - 8192u));
+            mismatches += (CRC32_calculate(pData, length) != reference_crc32_ex_(0u, pData, length));
+        }
+    }
+
+    CHECK_EQUAL(mismatches, 0u);
+}
+
+static void test_chained_calculation(void)
+{
+    unsigned mismatches = 0u;
+
+    fill_random_(buffer_, sizeof(buffer_));
+
+    //
+    // a buffer checksummed in pieces, as the boot service does with sub-chunks, gives the
+    // same result as one pass, wherever it is split
+    for (unsigned i = 0u; i < 256u; i++) {
+        size_t const length = 1u + (random_() % 4096u);
+        size_t const split = random_() % length;
+        uint8_t const * const pData = buffer_ + (random_() % 64u);
+        uint32_t const seed = (i & 1u) ? random_() : 0u;
+
+        uint32_t const whole = CRC32_calculate_ex(seed, pData, length);
+        uint32_t const pieces = CRC32_calculate_ex(CRC32_calculate_ex(seed, pData, split),
+            pData + split, length - split);
+
+        mismatches += (whole != pieces);
+        mismatches += (whole != reference_crc32_ex_(seed, pData, length));
+    }
+
+    CHECK_EQUAL(mismatches, 0u);
+}
+
+//
+// throughput over 1MiB buffers, for comparing configurations. This is built with the
+// sanitizers, so only the relative figures between configurations are meaningful
+static void test_benchmark(void)
+{
+    const unsigned passes = 32u;
+    struct timespec start, end;
+    uint32_t crc = 0u;
+
+    fill_random_(buffer_, sizeof(buffer_));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (unsigned pass = 0u; pass < passes; pass++) {
+        crc = CRC32_calculate_ex(crc, buffer_ + (pass & 3u), BUFFER_SIZE);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double const seconds = (double)(end.tv_sec - start.tv_sec)
+        + ((double)(end.tv_nsec - start.tv_nsec) / 1e9);
+    printf("  %s, %s: %.1f MiB/s (crc 0x%08x)\n", SLICING, TABLE,
+        seconds > 0.0 ? (double)passes / seconds : 0.0, crc);
+
+    CHECK(crc != 0u);
+}
+
+int main(void)
+{
+    RUN_TEST(test_known_values);
+    RUN_TEST(test_random_lengths_and_alignments);
+    RUN_TEST(test_chained_calculation);
+    RUN_TEST(test_benchmark);
+
+    return unit_test_report("crc32 (" SLICING ", " TABLE ")");
+}
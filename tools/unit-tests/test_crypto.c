@@ -0,0 +1,424 @@
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/*!
+ * \file Host unit tests for boot image signature verification
+ * \brief Checks the libecc and User Crypto backends, and the backend selection, against
+ * images signed with a test key
+ *
+ * The User Crypto library (CAL) is replaced by a software model. It converts the
+ * parameters it is given back from the layout the PK engine expects, checks the curve
+ * constants against the published P-384 values, and verifies with libecc, so that any
+ * layout or endianness error in the backend fails verification. This is built once for
+ * each choice of backends.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "hss_crypto.h"
+#include "hss_crypto_backend.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wredundant-decls"
+#include "libsig.h"
+#pragma GCC diagnostic pop
+
+#include "config_athena.h"
+#include "mss_peripherals.h"
+#include "calini.h"
+#include "calenum.h"
+#include "pk.h"
+#include "pkx.h"
+#include "utils.h"
+
+#include "unit_test.h"
+
+#if IS_ENABLED(CONFIG_CRYPTO_USER_CRYPTO)
+#  define BACKENDS "User Crypto model"
+#  define CAL_SELECTED 1
+#  if IS_ENABLED(CONFIG_CRYPTO_LIBECC)
+#    undef BACKENDS
+#    define BACKENDS "User Crypto model and libecc"
+#  endif
+#else
+#  define BACKENDS "libecc"
+#  define CAL_SELECTED 0
+#endif
+
+#define P384_BYTES              (48u)
+#define P384_WORDS              (12u)
+#define SIG_BYTES               (2u * P384_BYTES)
+#define MAX_MESSAGE_SIZE        (1024u * 1024u + 5u)
+
+//
+// the test signing key, whose public half is stubs/x509-ec-secp384r1-public.h
+static const uint8_t testPrivateKey_[P384_BYTES] = {
+    0x56, 0x9a, 0xe1, 0x5b, 0xd6, 0x5c, 0x4a, 0xe4, 0x83, 0xf9, 0xa9, 0xdc,
+    0x0f, 0x97, 0x6a, 0x0f, 0xf5, 0x61, 0x7c, 0x03, 0x9d, 0x2d, 0x28, 0xd5,
+    0xdb, 0x28, 0x13, 0x4f, 0xa6, 0xf9, 0xa2, 0x7d, 0x93, 0x6c, 0xf7, 0xbe,
+    0xda, 0x53, 0x4f, 0x65, 0xfb, 0x6c, 0x74, 0x9f, 0xd1, 0xbf, 0x5b, 0xcb,
+};
+
+//
+// the P-384 domain parameters, from SEC 2, big-endian
+static const uint8_t p384Gx_[P384_BYTES] = {
+    0xaa, 0x87, 0xca, 0x22, 0xbe, 0x8b, 0x05, 0x37, 0x8e, 0xb1, 0xc7, 0x1e,
+    0xf3, 0x20, 0xad, 0x74, 0x6e, 0x1d, 0x3b, 0x62, 0x8b, 0xa7, 0x9b, 0x98,
+    0x59, 0xf7, 0x41, 0xe0, 0x82, 0x54, 0x2a, 0x38, 0x55, 0x02, 0xf2, 0x5d,
+    0xbf, 0x55, 0x29, 0x6c, 0x3a, 0x54, 0x5e, 0x38, 0x72, 0x76, 0x0a, 0xb7,
+};
+static const uint8_t p384Gy_[P384_BYTES] = {
+    0x36, 0x17, 0xde, 0x4a, 0x96, 0x26, 0x2c, 0x6f, 0x5d, 0x9e, 0x98, 0xbf,
+    0x92, 0x92, 0xdc, 0x29, 0xf8, 0xf4, 0x1d, 0xbd, 0x28, 0x9a, 0x14, 0x7c,
+    0xe9, 0xda, 0x31, 0x13, 0xb5, 0xf0, 0xb8, 0xc0, 0x0a, 0x60, 0xb1, 0xce,
+    0x1d, 0x7e, 0x81, 0x9d, 0x7a, 0x43, 0x1d, 0x7c, 0x90, 0xea, 0x0e, 0x5f,
+};
+static const uint8_t p384B_[P384_BYTES] = {
+    0xb3, 0x31, 0x2f, 0xa7, 0xe2, 0x3e, 0xe7, 0xe4, 0x98, 0x8e, 0x05, 0x6b,
+    0xe3, 0xf8, 0x2d, 0x19, 0x18, 0x1d, 0x9c, 0x6e, 0xfe, 0x81, 0x41, 0x12,
+    0x03, 0x14, 0x08, 0x8f, 0x50, 0x13, 0x87, 0x5a, 0xc6, 0x56, 0x39, 0x8d,
+    0x8a, 0x2e, 0xd1, 0x9d, 0x2a, 0x85, 0xc8, 0xed, 0xd3, 0xec, 0x2a, 0xef,
+};
+static const uint8_t p384N_[P384_BYTES] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xc7, 0x63, 0x4d, 0x81, 0xf4, 0x37, 0x2d, 0xdf, 0x58, 0x1a, 0x0d, 0xb2,
+    0x48, 0xb0, 0xa7, 0x7a, 0xec, 0xec, 0x19, 0x6a, 0xcc, 0xc5, 0x29, 0x73,
+};
+
+static ec_params params_;
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// User Crypto library model
+//
+
+athenareg_t unitTestAthenaReg;
+const SATUINT32_t uiROMMods[5];
+
+static struct {
+    SATR pendingResult;     // reported by the next CALPKTrfRes()
+    unsigned verifications;
+    unsigned parameterErrors;
+    SATBOOL dma;
+} cal_;
+
+uint8_t mss_config_clk_rst(mss_peripherals peripheral, uint8_t hart, PERIPH_RESET_STATE req_state)
+{
+    (void)peripheral;
+    (void)hart;
+    (void)req_state;
+
+    return 0u;
+}
+
+SATR CALIni(void)
+{
+    // the engine must have been brought out of reset, with its ring oscillator on
+    return (unitTestAthenaReg.ATHENA_CR == SYSREG_ATHENACR_RINGOSCON) ? SATR_SUCCESS : SATR_FAIL;
+}
+
+void CALWordReverse(SATUINT32_t *puiArray, SATINT32_t iNumberWords)
+{
+    for (SATINT32_t i = 0; i < (iNumberWords / 2); i++) {
+        SATUINT32_t const word = puiArray[i];
+        puiArray[i] = puiArray[iNumberWords - 1 - i];
+        puiArray[iNumberWords - 1 - i] = word;
+    }
+}
+
+void CALByteReverseWord(SATUINT32_t *puiArray, SATINT32_t iNumberWords)
+{
+    for (SATINT32_t i = 0; i < iNumberWords; i++) {
+        puiArray[i] = __builtin_bswap32(puiArray[i]);
+    }
+}
+
+//
+// the PK engine takes numbers as arrays of native words, least significant first
+static void cal_param_to_bytes_(SATUINT32_t const *pParam, uint8_t bytes[P384_BYTES])
+{
+    for (size_t i = 0u; i < P384_WORDS; i++) {
+        SATUINT32_t const word = pParam[P384_WORDS - 1u - i];
+
+        bytes[(i * 4u) + 0u] = (uint8_t)(word >> 24);
+        bytes[(i * 4u) + 1u] = (uint8_t)(word >> 16);
+        bytes[(i * 4u) + 2u] = (uint8_t)(word >> 8);
+        bytes[(i * 4u) + 3u] = (uint8_t)word;
+    }
+}
+
+static bool cal_param_matches_(SATUINT32_t const *pParam, uint8_t const expected[P384_BYTES])
+{
+    uint8_t bytes[P384_BYTES];
+
+    cal_param_to_bytes_(pParam, bytes);
+    return !memcmp(bytes, expected, P384_BYTES);
+}
+
+static bool cal_import_point_(ec_pub_key *pPubKey, SATUINT32_t const *puiPx,
+    SATUINT32_t const *puiPy)
+{
+    uint8_t point[2u * P384_BYTES];
+
+    cal_param_to_bytes_(puiPx, &point[0]);
+    cal_param_to_bytes_(puiPy, &point[P384_BYTES]);
+
+    // libecc checks that the point is on the curve as it imports it
+    return ec_pub_key_import_from_aff_buf(pPubKey, &params_, point, sizeof(point), ECDSA) == 0;
+}
+
+SATR CALECPtValidate(const SATUINT32_t* puiPx, const SATUINT32_t* puiPy,
+    const SATUINT32_t* puiB, const SATUINT32_t* puiMod, const SATUINT32_t* puiMu,
+    SATUINT32_t uiLen)
+{
+    ec_pub_key pubKey;
+
+    if ((uiLen != P384_WORDS) || (puiMod != P384_MOD) || (puiMu != SAT_NULL)) {
+        cal_.parameterErrors++;
+        return SATR_BADPARAM;
+    }
+
+    if (!cal_param_matches_(puiB, p384B_)) {
+        cal_.parameterErrors++;
+        cal_.pendingResult = SATR_VALPARMB;
+    } else {
+        cal_.pendingResult = cal_import_point_(&pubKey, puiPx, puiPy) ? SATR_SUCCESS
+            : SATR_VALIDATEFAIL;
+    }
+
+    return SATR_SUCCESS;
+}
+
+SATR CALECDSAVerifyHash(const SATUINT32_t* puiMsg, SATHASHTYPE eHashType,
+    SATUINT32_t uiMsgLen, const SATUINT32_t* puiGx, const SATUINT32_t* puiGy,
+    const SATUINT32_t* puiQx, const SATUINT32_t* puiQy,
+    const SATUINT32_t* puiSigR, const SATUINT32_t* puiSigS,
+    const SATUINT32_t* puiB, const SATUINT32_t* puiP, const SATUINT32_t* puiPMu,
+    const SATUINT32_t* puiN, const SATUINT32_t* puiNMu,
+    SATUINT32_t uiLen, SATUINT32_t uiPtCompress, SATBOOL bDMA,
+    SATUINT32_t uiDMAChConfig)
+{
+    ec_pub_key pubKey;
+    uint8_t sig[SIG_BYTES];
+
+    (void)puiNMu;
+    (void)uiDMAChConfig;
+
+    cal_.verifications++;
+    cal_.dma = bDMA;
+
+    if ((eHashType != SATHASHTYPE_SHA384) || (uiLen != P384_WORDS) || (puiP != P384_MOD)
+        || (puiPMu != SAT_NULL) || uiPtCompress
+        || !cal_param_matches_(puiGx, p384Gx_) || !cal_param_matches_(puiGy, p384Gy_)
+        || !cal_param_matches_(puiB, p384B_) || !cal_param_matches_(puiN, p384N_)) {
+        cal_.parameterErrors++;
+        return SATR_BADPARAM;
+    }
+
+    cal_param_to_bytes_(puiSigR, &sig[0]);
+    cal_param_to_bytes_(puiSigS, &sig[P384_BYTES]);
+
+    if (!cal_import_point_(&pubKey, puiQx, puiQy)) {
+        cal_.pendingResult = SATR_VALIDATEFAIL;
+    } else {
+        cal_.pendingResult = (ec_verify(sig, SIG_BYTES, &pubKey, (u8 const *)puiMsg, uiMsgLen,
+            ECDSA, SHA384, NULL, 0u) == 0) ? SATR_SUCCESS : SATR_VERIFYFAIL;
+    }
+
+    return SATR_SUCCESS;
+}
+
+SATR CALPKTrfRes(SATBOOL bBlock)
+{
+    SATR const result = cal_.pendingResult;
+
+    (void)bBlock;
+    cal_.pendingResult = SATR_FAIL;
+
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static ec_key_pair keyPair_;
+static uint8_t message_[MAX_MESSAGE_SIZE];
+
+//
+// xorshift, so that the messages are the same from run to run
+static uint32_t random_state_ = 0x5EED1234u;
+
+static uint32_t random_(void)
+{
+    random_state_ ^= random_state_ << 13;
+    random_state_ ^= random_state_ >> 17;
+    random_state_ ^= random_state_ << 5;
+
+    return random_state_;
+}
+
+static void fill_random_(uint8_t *pData, size_t length)
+{
+    while (length--) {
+        *pData++ = (uint8_t)random_();
+    }
+}
+
+static void sign_(uint8_t const *pMessage, size_t length, uint8_t sig[SIG_BYTES])
+{
+    CHECK_EQUAL(ec_sign(sig, SIG_BYTES, &keyPair_, pMessage, (u32)length, ECDSA, SHA384,
+        NULL, 0u), 0);
+}
+
+static void test_import_test_key(void)
+{
+    uint8_t const curveName[] = "SECP384R1";
+
+    import_params(&params_, ec_get_curve_params_by_name(curveName, sizeof(curveName)));
+    CHECK_EQUAL(ec_key_pair_import_from_priv_key_buf(&keyPair_, &params_, testPrivateKey_,
+        sizeof(testPrivateKey_), ECDSA), 0);
+}
+
+static const size_t lengths_[] = { 1u, 47u, 48u, 1000u, 65536u + 3u, MAX_MESSAGE_SIZE };
+
+static void test_valid_signatures_verify(void)
+{
+    uint8_t sig[SIG_BYTES];
+    unsigned const calVerifications = cal_.verifications;
+
+    for (size_t i = 0u; i < ARRAY_SIZE(lengths_); i++) {
+        fill_random_(message_, lengths_[i]);
+        sign_(message_, lengths_[i], sig);
+
+        // and again, with the key already imported
+        CHECK(HSS_Crypto_Verify_ECDSA_P384(SIG_BYTES, sig, lengths_[i], message_));
+        CHECK(HSS_Crypto_Verify_ECDSA_P384(SIG_BYTES, sig, lengths_[i], message_));
+    }
+
+    CHECK_EQUAL(cal_.verifications - calVerifications,
+        CAL_SELECTED ? (2u * ARRAY_SIZE(lengths_)) : 0u);
+    CHECK_EQUAL(cal_.parameterErrors, 0u);
+#if CAL_SELECTED
+    CHECK_EQUAL(cal_.dma, IS_ENABLED(CONFIG_CRYPTO_USER_CRYPTO_DMA) ? SAT_TRUE : SAT_FALSE);
+#endif
+}
+
+static void test_tampered_images_rejected(void)
+{
+    uint8_t sig[SIG_BYTES];
+    uint8_t badSig[SIG_BYTES];
+    size_t const length = 4096u + 17u;
+    unsigned accepted = 0u;
+
+    fill_random_(message_, length);
+    sign_(message_, length, sig);
+
+    for (unsigned i = 0u; i < 16u; i++) {
+        size_t const bit = random_() % (length * 8u);
+
+        message_[bit / 8u] ^= (uint8_t)(1u << (bit % 8u));
+        accepted += HSS_Crypto_Verify_ECDSA_P384(SIG_BYTES, sig, length, message_);
+        message_[bit / 8u] ^= (uint8_t)(1u << (bit % 8u));
+    }
+
+    // flipped bits in each of r and s
+    for (size_t bit = 0u; bit < (SIG_BYTES * 8u); bit += 37u) {
+        memcpy(badSig, sig, SIG_BYTES);
+        badSig[bit / 8u] ^= (uint8_t)(1u << (bit % 8u));
+        accepted += HSS_Crypto_Verify_ECDSA_P384(SIG_BYTES, badSig, length, message_);
+    }
+
+    accepted += HSS_Crypto_Verify_ECDSA_P384(SIG_BYTES, sig, length - 1u, message_);
+    accepted += HSS_Crypto_Verify_ECDSA_P384(SIG_BYTES, sig, length + 1u, message_);
+
+    CHECK_EQUAL(accepted, 0u);
+    CHECK(HSS_Crypto_Verify_ECDSA_P384(SIG_BYTES, sig, length, message_));
+    CHECK_EQUAL(cal_.parameterErrors, 0u);
+}
+
+//
+// only libecc verifies incrementally, so with User Crypto selected, streamed verification
+// is refused and callers fall back to the one-pass check
+static void test_incremental_verification(void)
+{
+    uint8_t sig[SIG_BYTES];
+    size_t const length = 200u * 1024u + 3u;
+
+    fill_random_(message_, length);
+    sign_(message_, length, sig);
+
+#if CAL_SELECTED
+    CHECK(!HSS_Crypto_Verify_ECDSA_P384_Init(SIG_BYTES, sig));
+    CHECK(!HSS_Crypto_Verify_ECDSA_P384_Update(length, message_));
+    CHECK(!HSS_Crypto_Verify_ECDSA_P384_Finalize());
+#else
+    static const size_t pieceSizes[] = { 1u, 4096u, 65536u, 300000u };
+
+    for (size_t i = 0u; i < ARRAY_SIZE(pieceSizes); i++) {
+        bool result = HSS_Crypto_Verify_ECDSA_P384_Init(SIG_BYTES, sig);
+
+        for (size_t offset = 0u; result && (offset < length); offset += pieceSizes[i]) {
+            result = HSS_Crypto_Verify_ECDSA_P384_Update(MIN(pieceSizes[i], length - offset),
+                &message_[offset]);
+        }
+
+        CHECK(result);
+        CHECK(HSS_Crypto_Verify_ECDSA_P384_Finalize());
+        CHECK(!HSS_Crypto_Verify_ECDSA_P384_Finalize());
+    }
+
+    message_[length / 3u] ^= 0x10u;
+    CHECK(HSS_Crypto_Verify_ECDSA_P384_Init(SIG_BYTES, sig));
+    CHECK(HSS_Crypto_Verify_ECDSA_P384_Update(length, message_));
+    CHECK(!HSS_Crypto_Verify_ECDSA_P384_Finalize());
+#endif
+}
+
+//
+// whichever is selected, both backends give the same answer for the same images
+static void test_backends_agree(void)
+{
+    uint8_t sig[SIG_BYTES];
+    unsigned disagreements = 0u;
+
+    for (unsigned i = 0u; i < 24u; i++) {
+        size_t const length = 1u + (random_() % 8192u);
+
+        fill_random_(message_, length);
+        sign_(message_, length, sig);
+
+        if (i % 3u == 1u) {
+            message_[random_() % length] ^= 0x01u;
+        } else if (i % 3u == 2u) {
+            sig[random_() % SIG_BYTES] ^= 0x80u;
+        }
+
+        bool const expected = (i % 3u) == 0u;
+        disagreements += (libeccCryptoBackend.verify(SIG_BYTES, sig, length, message_) != expected);
+        disagreements += (calCryptoBackend.verify(SIG_BYTES, sig, length, message_) != expected);
+    }
+
+    CHECK_EQUAL(disagreements, 0u);
+    CHECK_EQUAL(cal_.parameterErrors, 0u);
+}
+
+int main(void)
+{
+    RUN_TEST(test_import_test_key);
+    RUN_TEST(test_valid_signatures_verify);
+    RUN_TEST(test_tampered_images_rejected);
+    RUN_TEST(test_incremental_verification);
+    RUN_TEST(test_backends_agree);
+
+    return unit_test_report("crypto (" BACKENDS ")");
+}
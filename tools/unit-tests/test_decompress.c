@@ -0,0 +1,338 @@
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/*!
+ * \file Host unit tests for compressed boot images
+ * \brief Checks that images decompressed from memory, and streamed from a stand-in storage
+ * provider, are byte identical to what mz_uncompress() produces from the same data, and
+ * that truncated and corrupted images are rejected without writing beyond the output
+ */
+
+#include "config.h"
+#include "hss_types.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "miniz.h"
+#include "hss_crc32.h"
+
+//
+// the decompressor provides malloc() and free() stubs for the firmware, which would
+// replace the host's own, so rename them
+#define malloc hss_decompress_malloc_stub_
+#define free hss_decompress_free_stub_
+#include "hss_decompress.c"
+#undef malloc
+#undef free
+
+#include "unit_test.h"
+
+#define DEVICE_SIZE             (2u * 1024u * 1024u)
+#define MAX_IMAGE_SIZE          (512u * 1024u)
+
+static uint8_t device_[DEVICE_SIZE] __attribute__((aligned(8)));
+static uint32_t deviceBlockSize_ = 512u;
+
+static bool device_read_(void *pDest, size_t srcOffset, size_t byteCount)
+{
+    bool result = ((srcOffset % deviceBlockSize_) == 0u) && ((byteCount % deviceBlockSize_) == 0u)
+        && (srcOffset <= DEVICE_SIZE) && (byteCount <= (DEVICE_SIZE - srcOffset));
+
+    if (result) {
+        memcpy(pDest, device_ + srcOffset, byteCount);
+    }
+
+    return result;
+}
+
+static void device_get_info_(uint32_t *pBlockSize, uint32_t *pEraseSize, uint32_t *pBlockCount)
+{
+    *pBlockSize = deviceBlockSize_;
+    *pEraseSize = deviceBlockSize_;
+    *pBlockCount = DEVICE_SIZE / deviceBlockSize_;
+}
+
+static struct HSS_Storage deviceStorage_ = {
+    .name = "test device",
+    .readBlock = device_read_,
+    .getInfo = device_get_info_,
+};
+
+//
+// xorshift, so that the images are the same from run to run
+static uint32_t random_state_ = 0x2468ACE1u;
+
+static uint32_t random_(void)
+{
+    random_state_ ^= random_state_ << 13;
+    random_state_ ^= random_state_ >> 17;
+    random_state_ ^= random_state_ << 5;
+
+    return random_state_;
+}
+
+enum Pattern { PATTERN_RANDOM, PATTERN_TEXT, PATTERN_ZEROES };
+
+static void fill_(uint8_t *pData, size_t length, enum Pattern pattern)
+{
+    static const char words[] = "hart software services boot image payload opensbi u-boot ";
+
+    for (size_t i = 0u; i < length; i++) {
+        switch (pattern) {
+        case PATTERN_RANDOM:
+            pData[i] = (uint8_t)random_();
+            break;
+        case PATTERN_TEXT:
+            // mostly repeated runs, with the odd random byte so that matches vary
+            pData[i] = (random_() % 64u) ? (uint8_t)words[(i * 7u / 5u) % (sizeof(words) - 1u)]
+                : (uint8_t)random_();
+            break;
+        default:
+            pData[i] = 0u;
+            break;
+        }
+    }
+}
+
+//
+// lays out an image as the compression tool does, a header followed by a zlib stream
+static size_t build_image_(uint8_t *pImage, uint8_t const *pOriginal, size_t originalLen,
+    int level)
+{
+    struct HSS_CompressedImage hdr = {
+        .magic = mHSS_COMPRESSED_MAGIC,
+        .version = mHSS_COMPRESSED_VERSION_DEFLATE,
+        .headerLength = sizeof(struct HSS_CompressedImage),
+        .originalImageLen = originalLen,
+    };
+    mz_ulong compressedLen = mz_compressBound(originalLen);
+
+    if (mz_compress2(pImage + sizeof(hdr), &compressedLen, pOriginal, originalLen, level)
+        != MZ_OK) {
+        return 0u;
+    }
+
+    hdr.compressedImageLen = compressedLen;
+    hdr.compressedCrc = CRC32_calculate(pImage + sizeof(hdr), compressedLen);
+    hdr.originalCrc = CRC32_calculate(pOriginal, originalLen);
+    hdr.headerCrc = CRC32_calculate((uint8_t const *)&hdr, sizeof(hdr));
+    memcpy(pImage, &hdr, sizeof(hdr));
+
+    return sizeof(hdr) + compressedLen;
+}
+
+static uint8_t original_[MAX_IMAGE_SIZE];
+static uint8_t image_[MAX_IMAGE_SIZE + 1024u] __attribute__((aligned(8)));
+static uint8_t reference_[MAX_IMAGE_SIZE];
+
+//
+// the output buffer is allocated at exactly the original length, so that any write
+// beyond it is caught
+static bool decompress_matches_(size_t imageLen, size_t originalLen, size_t srcOffset)
+{
+    bool result = true;
+    uint8_t * const pOutput = (uint8_t *)malloc(originalLen);
+    mz_ulong referenceLen = MAX_IMAGE_SIZE;
+
+    result = result && (mz_uncompress(reference_, &referenceLen,
+        image_ + sizeof(struct HSS_CompressedImage),
+        (mz_ulong)(imageLen - sizeof(struct HSS_CompressedImage))) == MZ_OK);
+    result = result && (referenceLen == originalLen);
+    result = result && !memcmp(reference_, original_, originalLen);
+
+    memset(pOutput, 0xA5, originalLen);
+    result = result && (HSS_Decompress(image_, pOutput) == (int)originalLen);
+    result = result && !memcmp(pOutput, reference_, originalLen);
+
+    memset(device_, 0xFF, sizeof(device_));
+    memcpy(device_ + srcOffset, image_, imageLen);
+    memset(pOutput, 0xA5, originalLen);
+    result = result && (HSS_Decompress_FromStorage(&deviceStorage_, srcOffset, pOutput)
+        == (int)originalLen);
+    result = result && !memcmp(pOutput, reference_, originalLen);
+
+    free(pOutput);
+    return result;
+}
+
+static void test_matches_mz_uncompress(void)
+{
+    static const size_t lengths[] = {
+        1u, 100u, 4095u, 4096u, 4097u, 65536u + 13u, MAX_IMAGE_SIZE
+    };
+    static const int levels[] = { 0, 1, 6, 9 };
+    unsigned mismatches = 0u;
+
+    deviceBlockSize_ = 512u;
+
+    for (unsigned pattern = PATTERN_RANDOM; pattern <= PATTERN_ZEROES; pattern++) {
+        for (size_t i = 0u; i < ARRAY_SIZE(lengths); i++) {
+            for (size_t j = 0u; j < ARRAY_SIZE(levels); j++) {
+                fill_(original_, lengths[i], (enum Pattern)pattern);
+
+                size_t const imageLen = build_image_(image_, original_, lengths[i], levels[j]);
+                CHECK(imageLen != 0u);
+
+                mismatches += !decompress_matches_(imageLen, lengths[i], 0x10000u);
+            }
+        }
+    }
+
+    CHECK_EQUAL(mismatches, 0u);
+}
+
+//
+// the input window is a whole number of blocks, so with blocks that do not divide the
+// input buffer, or that fill it, refills land at different points in the stream
+static void test_storage_block_sizes(void)
+{
+    static const uint32_t blockSizes[] = { 512u, 1536u, 2048u, 4096u };
+    unsigned mismatches = 0u;
+
+    fill_(original_, MAX_IMAGE_SIZE - 1000u, PATTERN_TEXT);
+    size_t const imageLen = build_image_(image_, original_, MAX_IMAGE_SIZE - 1000u, 6);
+    CHECK(imageLen != 0u);
+
+    for (size_t i = 0u; i < ARRAY_SIZE(blockSizes); i++) {
+        deviceBlockSize_ = blockSizes[i];
+        mismatches += !decompress_matches_(imageLen, MAX_IMAGE_SIZE - 1000u, 0u);
+        mismatches += !decompress_matches_(imageLen, MAX_IMAGE_SIZE - 1000u,
+            (size_t)blockSizes[i] * 37u);
+    }
+
+    deviceBlockSize_ = 8192u;
+    CHECK_EQUAL(HSS_Decompress_FromStorage(&deviceStorage_, 0u, reference_), 0);
+
+    deviceBlockSize_ = 512u;
+    CHECK_EQUAL(mismatches, 0u);
+}
+
+//
+// decompresses an image both ways, expecting it to be rejected
+static unsigned count_accepted_(uint8_t const *pImage, size_t imageLen, size_t originalLen)
+{
+    unsigned accepted = 0u;
+    uint8_t * const pOutput = (uint8_t *)malloc(originalLen);
+
+    accepted += (HSS_Decompress(pImage, pOutput) != 0);
+
+    memset(device_, 0xFF, sizeof(device_));
+    memcpy(device_, pImage, imageLen);
+    accepted += (HSS_Decompress_FromStorage(&deviceStorage_, 0u, pOutput) != 0);
+
+    free(pOutput);
+    return accepted;
+}
+
+#define CORRUPT_ORIGINAL_SIZE   (64u * 1024u)
+
+static uint8_t corrupt_[MAX_IMAGE_SIZE + 1024u] __attribute__((aligned(8)));
+
+static void rewrite_header_(uint8_t *pImage, size_t compressedImageLen, size_t originalImageLen)
+{
+    struct HSS_CompressedImage hdr;
+
+    memcpy(&hdr, pImage, sizeof(hdr));
+    hdr.compressedImageLen = compressedImageLen;
+    hdr.originalImageLen = originalImageLen;
+    hdr.headerCrc = 0u;
+    hdr.headerCrc = CRC32_calculate((uint8_t const *)&hdr, sizeof(hdr));
+    memcpy(pImage, &hdr, sizeof(hdr));
+}
+
+//
+// an image cut short, as by an interrupted write, leaves the rest of the device erased.
+// Images whose header has been rewritten to match the shorter length, or to claim a
+// different original length, are rejected too
+static void test_truncated_images(void)
+{
+    size_t const headerSize = sizeof(struct HSS_CompressedImage);
+    unsigned accepted = 0u;
+
+    deviceBlockSize_ = 512u;
+    fill_(original_, CORRUPT_ORIGINAL_SIZE, PATTERN_TEXT);
+    size_t const imageLen = build_image_(image_, original_, CORRUPT_ORIGINAL_SIZE, 6);
+    size_t const compressedLen = imageLen - headerSize;
+    CHECK(imageLen != 0u);
+    CHECK(decompress_matches_(imageLen, CORRUPT_ORIGINAL_SIZE, 0u));
+
+    size_t const cuts[] = {
+        0u, 4u, 40u, headerSize - 1u, headerSize, headerSize + 2u, 4096u, imageLen / 2u,
+        imageLen - 100u, imageLen - 4u, imageLen - 1u
+    };
+    for (size_t i = 0u; i < ARRAY_SIZE(cuts); i++) {
+        size_t const cutLen = cuts[i];
+
+        memset(corrupt_, 0xFF, sizeof(corrupt_));
+        memcpy(corrupt_, image_, cutLen);
+        accepted += count_accepted_(corrupt_, imageLen, CORRUPT_ORIGINAL_SIZE);
+
+        if (cutLen > headerSize) {
+            rewrite_header_(corrupt_, cutLen - headerSize, CORRUPT_ORIGINAL_SIZE);
+            accepted += count_accepted_(corrupt_, imageLen, CORRUPT_ORIGINAL_SIZE);
+        }
+    }
+
+    memcpy(corrupt_, image_, imageLen);
+    rewrite_header_(corrupt_, compressedLen, CORRUPT_ORIGINAL_SIZE - 1u);
+    accepted += count_accepted_(corrupt_, imageLen, CORRUPT_ORIGINAL_SIZE);
+    rewrite_header_(corrupt_, compressedLen, CORRUPT_ORIGINAL_SIZE / 2u);
+    accepted += count_accepted_(corrupt_, imageLen, CORRUPT_ORIGINAL_SIZE);
+    rewrite_header_(corrupt_, compressedLen, CORRUPT_ORIGINAL_SIZE + 1u);
+    accepted += count_accepted_(corrupt_, imageLen, CORRUPT_ORIGINAL_SIZE + 1u);
+    rewrite_header_(corrupt_, compressedLen + 1u, CORRUPT_ORIGINAL_SIZE);
+    accepted += count_accepted_(corrupt_, imageLen + 1u, CORRUPT_ORIGINAL_SIZE);
+    rewrite_header_(corrupt_, compressedLen, 0u);
+    accepted += count_accepted_(corrupt_, imageLen, 1u);
+
+    CHECK_EQUAL(accepted, 0u);
+}
+
+//
+// every bit of the header, and a spread of bits through the compressed data, including
+// its zlib header and Adler-32 trailer, is flipped in turn
+static void test_bit_flips(void)
+{
+    size_t const headerSize = sizeof(struct HSS_CompressedImage);
+    unsigned accepted = 0u;
+    unsigned flips = 0u;
+
+    deviceBlockSize_ = 512u;
+    fill_(original_, CORRUPT_ORIGINAL_SIZE, PATTERN_TEXT);
+    size_t const imageLen = build_image_(image_, original_, CORRUPT_ORIGINAL_SIZE, 6);
+    CHECK(imageLen != 0u);
+
+    for (size_t bit = 0u; bit < (imageLen * 8u); ) {
+        memcpy(corrupt_, image_, imageLen);
+        corrupt_[bit / 8u] ^= (uint8_t)(1u << (bit % 8u));
+
+        accepted += count_accepted_(corrupt_, imageLen, CORRUPT_ORIGINAL_SIZE);
+        flips++;
+
+        if ((bit < ((headerSize + 2u) * 8u)) || (bit >= ((imageLen - 4u) * 8u))) {
+            bit++;
+        } else {
+            bit += 1u + (random_() % 997u);
+        }
+    }
+
+    CHECK(flips > ((headerSize + 6u) * 8u));
+    CHECK_EQUAL(accepted, 0u);
+}
+
+int main(void)
+{
+    RUN_TEST(test_matches_mz_uncompress);
+    RUN_TEST(test_storage_block_sizes);
+    RUN_TEST(test_truncated_images);
+    RUN_TEST(test_bit_flips);
+
+    return unit_test_report("decompress");
+}
@@ -0,0 +1,382 @@
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/*!
+ * \file Host unit tests for GPT parsing
+ * \brief Checks GPT header and partition entry validation, and partition searches,
+ * against an in-memory disk
+ */
+
+#include "config.h"
+#include "hss_types.h"
+
+#include <string.h>
+
+#include "gpt.h"
+#include "unit_test.h"
+
+#define LBA_SIZE                (512u)
+#define ENTRIES_LBA             (2u)
+#define NUM_PARTITIONS          (128u)
+#define MAX_NUM_PARTITIONS      (256u)
+#define ENTRY_SIZE              (128u)
+#define DISK_LBAS               (ENTRIES_LBA + ((MAX_NUM_PARTITIONS * ENTRY_SIZE) / LBA_SIZE))
+
+static uint8_t disk_[DISK_LBAS * LBA_SIZE] __attribute__((aligned(8)));
+
+static struct {
+    size_t count;
+    size_t entryArrayReads;
+    size_t lastByteCount;
+} reads_;
+
+static bool disk_read_(void *pDest, size_t srcOffset, size_t byteCount)
+{
+    bool const result = (srcOffset <= sizeof(disk_)) && (byteCount <= (sizeof(disk_) - srcOffset));
+
+    reads_.count++;
+    if (srcOffset == (ENTRIES_LBA * LBA_SIZE)) {
+        reads_.entryArrayReads++;
+        reads_.lastByteCount = byteCount;
+    }
+
+    if (result) {
+        memcpy(pDest, &disk_[srcOffset], byteCount);
+    }
+
+    return result;
+}
+
+static struct HSS_Storage disk_storage_ = {
+    .name = "test disk",
+    .readBlock = disk_read_,
+};
+
+//
+// reference CRC-32 (IEEE 802.3, reflected), calculated bit by bit, so that the GPT
+// checksums do not depend on the table-driven implementation under test
+static uint32_t reference_crc32_(uint8_t const *pData, size_t length)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+
+    while (length--) {
+        crc ^= *pData++;
+        for (size_t bit = 0u; bit < 8u; bit++) {
+            crc = (crc & 1u) ? ((crc >> 1) ^ 0xEDB88320u) : (crc >> 1);
+        }
+    }
+
+    return ~crc;
+}
+
+static const HSS_GPT_GUID_t hssTypeGUID_ = {            // 21686148-6449-6E6F-744E-656564454649
+    .data1 = 0x21686148u,
+    .data2 = 0x6449u,
+    .data3 = 0x6E6Fu,
+    .data4 = 0x4946456465654e74u
+};
+
+static const HSS_GPT_GUID_t linuxTypeGUID_ = {          // 0FC63DAF-8483-4772-8E79-3D69D8477DE4
+    .data1 = 0x0FC63DAFu,
+    .data2 = 0x8483u,
+    .data3 = 0x4772u,
+    .data4 = 0xE47D47D8693D798Eu
+};
+
+static HSS_GPT_PartitionEntry_t *entry_(const size_t index)
+{
+    return (HSS_GPT_PartitionEntry_t *)&disk_[(ENTRIES_LBA * LBA_SIZE) + (index * ENTRY_SIZE)];
+}
+
+static HSS_GPT_Header_t *header_(void)
+{
+    return (HSS_GPT_Header_t *)&disk_[LBA_SIZE];
+}
+
+static void add_partition_(const size_t index, HSS_GPT_GUID_t const * const pType,
+    const uint32_t uniqueId, const uint64_t firstLBA)
+{
+    HSS_GPT_PartitionEntry_t * const pEntry = entry_(index);
+
+    pEntry->partitionTypeGUID = *pType;
+    pEntry->uniquePartitionGUID.data1 = uniqueId;
+    pEntry->uniquePartitionGUID.data4 = 0x0123456789ABCDEFull;
+    pEntry->firstLBA = firstLBA;
+    pEntry->lastLBA = firstLBA + 0x1000u;
+}
+
+static void seal_disk_(const uint32_t numPartitions)
+{
+    HSS_GPT_Header_t * const pHeader = header_();
+
+    memcpy(pHeader->s.c, GPT_EXPECTED_SIGNATURE, 8u);
+    pHeader->revision = GPT_EXPECTED_REVISION;
+    pHeader->headerSize = GPT_MIN_HEADER_SIZE;
+    pHeader->currentLBA = 1u;
+    pHeader->backupLBA = 0x100000u;
+    pHeader->firstUsableLBA = 34u;
+    pHeader->lastUsableLBA = 0xFFFDEu;
+    pHeader->partitionEntriesStartingLBA = ENTRIES_LBA;
+    pHeader->numPartitions = numPartitions;
+    pHeader->sizeOfPartitionEntry = ENTRY_SIZE;
+    pHeader->partitionEntriesArrayCrc32 = reference_crc32_(&disk_[ENTRIES_LBA * LBA_SIZE],
+        numPartitions * ENTRY_SIZE);
+
+    pHeader->headerCrc32 = 0u;
+    pHeader->headerCrc32 = reference_crc32_((uint8_t const *)pHeader, pHeader->headerSize);
+}
+
+//
+// partitions 0 (Linux), 3 and 7 (HSS payloads), and 9 (Linux) are in use
+static void build_disk_(void)
+{
+    memset(disk_, 0, sizeof(disk_));
+
+    add_partition_(0u, &linuxTypeGUID_, 0x1000u, 0x800u);
+    add_partition_(3u, &hssTypeGUID_, 0x1003u, 0x2000u);
+    add_partition_(7u, &hssTypeGUID_, 0x1007u, 0x4000u);
+    add_partition_(9u, &linuxTypeGUID_, 0x1009u, 0x8000u);
+
+    seal_disk_(NUM_PARTITIONS);
+}
+
+static void open_disk_(HSS_GPT_t * const pGpt)
+{
+    memset(&reads_, 0, sizeof(reads_));
+    memset(pGpt, 0, sizeof(*pGpt));
+
+    pGpt->lbaSize = LBA_SIZE;
+    GPT_Init(pGpt, &disk_storage_);
+}
+
+static void test_header_validation(void)
+{
+    HSS_GPT_t gpt;
+
+    build_disk_();
+    open_disk_(&gpt);
+    CHECK(GPT_ReadHeader(&gpt));
+    CHECK(gpt.headerValid);
+
+    header_()->backupLBA++;                             // covered by the header CRC
+    open_disk_(&gpt);
+    CHECK(!GPT_ReadHeader(&gpt));
+
+    build_disk_();
+    disk_[LBA_SIZE] = 'X';                              // signature
+    open_disk_(&gpt);
+    CHECK(!GPT_ReadHeader(&gpt));
+
+    build_disk_();
+    header_()->numPartitions = GPT_MAX_NUM_PARTITIONS + 1u;
+    header_()->headerCrc32 = 0u;
+    header_()->headerCrc32 = reference_crc32_((uint8_t const *)header_(), GPT_MIN_HEADER_SIZE);
+    open_disk_(&gpt);
+    CHECK(!GPT_ReadHeader(&gpt));
+}
+
+static void test_partition_entry_crc(void)
+{
+    HSS_GPT_t gpt;
+
+    build_disk_();
+    open_disk_(&gpt);
+    CHECK(GPT_ReadHeader(&gpt));
+    CHECK(GPT_ValidatePartitionEntries(&gpt));
+    CHECK(gpt.partitionEntriesValid);
+
+    //
+    // an unused entry is covered by the array CRC too
+    entry_(100u)->attributes = 1u;
+    open_disk_(&gpt);
+    CHECK(GPT_ReadHeader(&gpt));
+    CHECK(!GPT_ValidatePartitionEntries(&gpt));
+    CHECK(!gpt.partitionEntriesValid);
+}
+
+static void test_boot_partition_single_read(void)
+{
+    HSS_GPT_t gpt;
+    HSS_GPT_PartitionEntry_t const *pEntry = NULL;
+    size_t index = 0u;
+    size_t firstLBA = 0u;
+
+    build_disk_();
+    open_disk_(&gpt);
+    CHECK(GPT_ReadHeader(&gpt));
+
+    CHECK(GPT_FindBootSectorIndex(&gpt, &index, &pEntry));
+    CHECK_EQUAL(index, 3u);
+    CHECK(pEntry != NULL);
+    CHECK_EQUAL(pEntry ? pEntry->firstLBA : 0u, 0x2000u);
+
+    CHECK(GPT_PartitionIdToLBAOffset(&gpt, index, &firstLBA));
+    CHECK_EQUAL(firstLBA, 0x2000u);
+
+    //
+    // the whole entry array is read in one transfer, and then searched in memory
+    CHECK_EQUAL(reads_.entryArrayReads, 1u);
+    CHECK_EQUAL(reads_.lastByteCount, NUM_PARTITIONS * ENTRY_SIZE);
+    CHECK_EQUAL(reads_.count, 2u);                      // header, and entry array
+}
+
+static void test_search_continues_from_index(void)
+{
+    HSS_GPT_t gpt;
+    HSS_GPT_PartitionEntry_t const *pEntry = NULL;
+    size_t index;
+
+    build_disk_();
+    open_disk_(&gpt);
+    CHECK(GPT_ReadHeader(&gpt));
+
+    index = 4u;
+    CHECK(GPT_FindPartitionByTypeId(&gpt, &hssTypeGUID_, &index, &pEntry));
+    CHECK_EQUAL(index, 7u);
+    CHECK_EQUAL(pEntry ? pEntry->firstLBA : 0u, 0x4000u);
+
+    index = 8u;
+    CHECK(!GPT_FindPartitionByTypeId(&gpt, &hssTypeGUID_, &index, NULL));
+
+    index = 1u;
+    CHECK(GPT_FindPartitionByTypeId(&gpt, &linuxTypeGUID_, &index, NULL));
+    CHECK_EQUAL(index, 9u);
+
+    CHECK_EQUAL(reads_.entryArrayReads, 1u);
+}
+
+static void test_search_by_unique_id(void)
+{
+    HSS_GPT_t gpt;
+    HSS_GPT_GUID_t uniqueGUID = { .data1 = 0x1009u, .data4 = 0x0123456789ABCDEFull };
+    size_t index = 0u;
+
+    build_disk_();
+    open_disk_(&gpt);
+    CHECK(GPT_ReadHeader(&gpt));
+
+    CHECK(GPT_FindPartitionByUniqueId(&gpt, &uniqueGUID, &index, NULL));
+    CHECK_EQUAL(index, 9u);
+
+    index = 0u;
+    uniqueGUID.data1 = 0x1005u;
+    CHECK(!GPT_FindPartitionByUniqueId(&gpt, &uniqueGUID, &index, NULL));
+}
+
+static void test_search_for_unused_entry(void)
+{
+    HSS_GPT_t gpt;
+    const HSS_GPT_GUID_t nullGUID = { 0 };
+    size_t index = 0u;
+
+    //
+    // the used entry index must not hide unused entries from a search for the null GUID
+    build_disk_();
+    open_disk_(&gpt);
+    CHECK(GPT_ReadHeader(&gpt));
+
+    CHECK(GPT_FindPartitionByTypeId(&gpt, &nullGUID, &index, NULL));
+    CHECK_EQUAL(index, 1u);
+
+    index = 4u;
+    CHECK(GPT_FindPartitionByTypeId(&gpt, &nullGUID, &index, NULL));
+    CHECK_EQUAL(index, 4u);
+}
+
+static void test_partial_lba_entry_array(void)
+{
+    HSS_GPT_t gpt;
+    size_t index = 0u;
+
+    //
+    // five entries fill 640 bytes, so two whole LBAs are read
+    build_disk_();
+    seal_disk_(5u);
+    open_disk_(&gpt);
+    CHECK(GPT_ReadHeader(&gpt));
+
+    CHECK(GPT_ValidatePartitionEntries(&gpt));
+    CHECK_EQUAL(reads_.lastByteCount, 2u * LBA_SIZE);
+
+    CHECK(GPT_FindPartitionByTypeId(&gpt, &hssTypeGUID_, &index, NULL));
+    CHECK_EQUAL(index, 3u);
+
+    index = 4u;
+    CHECK(!GPT_FindPartitionByTypeId(&gpt, &hssTypeGUID_, &index, NULL));
+
+    HSS_GPT_PartitionEntry_t const *pEntry;
+    CHECK(!GPT_ReadPartitionEntryByIndex(&gpt, 5u, &pEntry));
+    CHECK(pEntry == NULL);
+}
+
+//
+// a 256-entry array, of 32KiB, is read in one transfer too, and the entries beyond the
+// first 128 are found, where they are ignored in a 128-entry array
+static void test_256_entry_array(void)
+{
+    HSS_GPT_t gpt;
+    HSS_GPT_PartitionEntry_t const *pEntry = NULL;
+    HSS_GPT_GUID_t const uniqueGUID = { .data1 = 0x10FFu, .data4 = 0x0123456789ABCDEFull };
+    size_t index;
+
+    build_disk_();
+    add_partition_(200u, &hssTypeGUID_, 0x10C8u, 0x10000u);
+    add_partition_(255u, &linuxTypeGUID_, 0x10FFu, 0x20000u);
+
+    for (uint32_t numPartitions = NUM_PARTITIONS; numPartitions <= MAX_NUM_PARTITIONS;
+        numPartitions += NUM_PARTITIONS) {
+        bool const large = (numPartitions == MAX_NUM_PARTITIONS);
+
+        seal_disk_(numPartitions);
+        open_disk_(&gpt);
+        CHECK(GPT_ReadHeader(&gpt));
+        CHECK(GPT_ValidatePartitionEntries(&gpt));
+
+        index = 0u;
+        CHECK(GPT_FindBootSectorIndex(&gpt, &index, NULL));
+        CHECK_EQUAL(index, 3u);
+
+        index = 8u;
+        CHECK_EQUAL(GPT_FindPartitionByTypeId(&gpt, &hssTypeGUID_, &index, &pEntry), large);
+        CHECK_EQUAL(large ? index : 200u, 200u);
+        CHECK_EQUAL((large && pEntry) ? pEntry->firstLBA : 0x10000u, 0x10000u);
+
+        index = 10u;
+        CHECK_EQUAL(GPT_FindPartitionByTypeId(&gpt, &linuxTypeGUID_, &index, NULL), large);
+        CHECK_EQUAL(large ? index : 255u, 255u);
+
+        index = 0u;
+        CHECK_EQUAL(GPT_FindPartitionByUniqueId(&gpt, &uniqueGUID, &index, NULL), large);
+        CHECK_EQUAL(large ? index : 255u, 255u);
+
+        index = 201u;
+        CHECK(!GPT_FindPartitionByTypeId(&gpt, &hssTypeGUID_, &index, NULL));
+
+        CHECK_EQUAL(GPT_ReadPartitionEntryByIndex(&gpt, 255u, &pEntry), large);
+        CHECK(!GPT_ReadPartitionEntryByIndex(&gpt, numPartitions, &pEntry));
+
+        CHECK_EQUAL(reads_.entryArrayReads, 1u);
+        CHECK_EQUAL(reads_.lastByteCount, numPartitions * ENTRY_SIZE);
+        CHECK_EQUAL(reads_.count, 2u);
+    }
+}
+
+int main(void)
+{
+    RUN_TEST(test_header_validation);
+    RUN_TEST(test_partition_entry_crc);
+    RUN_TEST(test_boot_partition_single_read);
+    RUN_TEST(test_search_continues_from_index);
+    RUN_TEST(test_search_by_unique_id);
+    RUN_TEST(test_search_for_unused_entry);
+    RUN_TEST(test_partial_lba_entry_array);
+    RUN_TEST(test_256_entry_array);
+
+    return unit_test_report("gpt");
+}
@@ -0,0 +1,396 @@
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/*!
+ * \file Host unit tests for the PDMA copy engine
+ * \brief Checks queueing, channel allocation, submission order and error fallback of
+ * asynchronous copies, against a model of the MSS PDMA channels
+ */
+
+#include "config.h"
+#include "hss_types.h"
+
+#include <string.h>
+
+#include "drivers/mss/mss_pdma/mss_pdma.h"
+#include "hss_memcpy_via_pdma.h"
+#include "unit_test.h"
+
+//
+// the PDMA model: a channel copies its data only once the test completes it, so that a
+// copy which is retired early leaves its destination stale
+static struct {
+    mss_pdma_channel_config_t config;
+    bool running;
+    bool complete;
+    bool error;
+} pdma_[MSS_PDMA_lAST_CHANNEL];
+
+static struct {
+    unsigned channel;
+    uintptr_t src;
+    uintptr_t dest;
+    size_t byteCount;
+} startLog_[64];
+static size_t startCount_;
+
+static mss_pdma_error_id_t setupError_ = MSS_PDMA_OK;
+
+mss_pdma_error_id_t MSS_PDMA_setup_transfer(mss_pdma_channel_id_t channel_id,
+    mss_pdma_channel_config_t *channel_config)
+{
+    mss_pdma_error_id_t result = setupError_;
+
+    if (channel_id >= MSS_PDMA_lAST_CHANNEL) {
+        result = MSS_PDMA_ERROR_INVALID_CHANNEL_ID;
+    } else if (pdma_[channel_id].running) {
+        result = MSS_PDMA_ERROR_TRANSACTION_IN_PROGRESS;
+    } else if (result == MSS_PDMA_OK) {
+        pdma_[channel_id].config = *channel_config;
+    }
+
+    return result;
+}
+
+mss_pdma_error_id_t MSS_PDMA_start_transfer(mss_pdma_channel_id_t channel_id)
+{
+    CHECK(!pdma_[channel_id].running);
+    CHECK(!pdma_[channel_id].complete);
+
+    //
+    // the copy engine only gives the PDMA aligned destinations and whole 16 byte units
+    CHECK_EQUAL(pdma_[channel_id].config.dest_addr % 16u, 0u);
+    CHECK_EQUAL(pdma_[channel_id].config.num_bytes % 16u, 0u);
+
+    pdma_[channel_id].running = true;
+
+    if (startCount_ < ARRAY_SIZE(startLog_)) {
+        startLog_[startCount_].channel = channel_id;
+        startLog_[startCount_].src = pdma_[channel_id].config.src_addr;
+        startLog_[startCount_].dest = pdma_[channel_id].config.dest_addr;
+        startLog_[startCount_].byteCount = pdma_[channel_id].config.num_bytes;
+    }
+    startCount_++;
+
+    return MSS_PDMA_OK;
+}
+
+uint8_t MSS_PDMA_get_transfer_complete_status(mss_pdma_channel_id_t channel_id)
+{
+    return pdma_[channel_id].complete;
+}
+
+uint8_t MSS_PDMA_get_transfer_error_status(mss_pdma_channel_id_t channel_id)
+{
+    return pdma_[channel_id].error;
+}
+
+uint8_t MSS_PDMA_clear_transfer_complete_status(mss_pdma_channel_id_t channel_id)
+{
+    pdma_[channel_id].complete = false;
+    return 0u;
+}
+
+uint8_t MSS_PDMA_clear_transfer_error_status(mss_pdma_channel_id_t channel_id)
+{
+    pdma_[channel_id].error = false;
+    return 0u;
+}
+
+static void pdma_complete_(const unsigned channel)
+{
+    if (pdma_[channel].running) {
+        memcpy((void *)(uintptr_t)pdma_[channel].config.dest_addr,
+            (void const *)(uintptr_t)pdma_[channel].config.src_addr,
+            pdma_[channel].config.num_bytes);
+        pdma_[channel].running = false;
+        pdma_[channel].complete = true;
+    }
+}
+
+//
+// a transfer which fails leaves nothing at its destination
+static void pdma_fail_(const unsigned channel)
+{
+    if (pdma_[channel].running) {
+        pdma_[channel].running = false;
+        pdma_[channel].error = true;
+    }
+}
+
+static unsigned pdma_running_count_(void)
+{
+    unsigned count = 0u;
+
+    for (unsigned channel = 0u; channel < MSS_PDMA_lAST_CHANNEL; channel++) {
+        count += pdma_[channel].running;
+    }
+
+    return count;
+}
+
+//
+// the superloop runs the copy engine through its state machine
+static void run_service_(void)
+{
+    struct StateMachine * const pMachine = &memcpy_via_pdma_service;
+
+    pMachine->pStateDescs[pMachine->state].state_handler(pMachine);
+}
+
+static void complete_all_(void)
+{
+    for (unsigned iteration = 0u; iteration < 16u; iteration++) {
+        for (unsigned channel = 0u; channel < MSS_PDMA_lAST_CHANNEL; channel++) {
+            pdma_complete_(channel);
+        }
+        run_service_();
+    }
+}
+
+#define BUFFER_SIZE     (512u * 1024u)
+
+static uint8_t src_[BUFFER_SIZE] __attribute__((aligned(16)));
+static uint8_t dest_[BUFFER_SIZE] __attribute__((aligned(16)));
+
+static void reset_(void)
+{
+    memset(pdma_, 0, sizeof(pdma_));
+    memset(startLog_, 0, sizeof(startLog_));
+    startCount_ = 0u;
+    setupError_ = MSS_PDMA_OK;
+
+    for (size_t i = 0u; i < BUFFER_SIZE; i++) {
+        src_[i] = (uint8_t)((i * 7u) + (i >> 9));
+    }
+    memset(dest_, 0, sizeof(dest_));
+}
+
+static unsigned callbackCount_;
+static void *pLastCallbackContext_;
+
+static void count_callback_(void *pContext)
+{
+    callbackCount_++;
+    pLastCallbackContext_ = pContext;
+}
+
+static void test_large_copy_uses_all_channels(void)
+{
+    struct MemcpyViaPdmaRequest request = { .pending = false };
+
+    reset_();
+    CHECK(memcpy_via_pdma_async(&request, dest_, src_, 256u * 1024u, NULL, NULL));
+    CHECK_EQUAL(pdma_running_count_(), MSS_PDMA_lAST_CHANNEL);
+    CHECK_EQUAL(startCount_, MSS_PDMA_lAST_CHANNEL);
+
+    //
+    // split evenly, and in order, across the channels
+    for (unsigned i = 0u; i < MSS_PDMA_lAST_CHANNEL; i++) {
+        CHECK_EQUAL(startLog_[i].channel, i);
+        CHECK_EQUAL(startLog_[i].byteCount, 64u * 1024u);
+        CHECK_EQUAL(startLog_[i].dest, (uintptr_t)dest_ + (i * 64u * 1024u));
+        CHECK_EQUAL(startLog_[i].src, (uintptr_t)src_ + (i * 64u * 1024u));
+    }
+
+    //
+    // not complete until every piece is
+    pdma_complete_(0u);
+    pdma_complete_(2u);
+    pdma_complete_(3u);
+    CHECK(!memcpy_via_pdma_async_poll(&request));
+
+    pdma_complete_(1u);
+    CHECK(memcpy_via_pdma_async_poll(&request));
+    CHECK(memcmp(dest_, src_, 256u * 1024u) == 0);
+    CHECK_EQUAL(pdma_running_count_(), 0u);
+}
+
+static void test_small_copy_uses_one_channel(void)
+{
+    struct MemcpyViaPdmaRequest request = { .pending = false };
+
+    //
+    // small copies are not split below the minimum piece size
+    reset_();
+    CHECK(memcpy_via_pdma_async(&request, dest_, src_, 6000u, NULL, NULL));
+    CHECK_EQUAL(startCount_, 2u);
+    CHECK_EQUAL(startLog_[0].byteCount, 4096u);
+    CHECK_EQUAL(startLog_[1].byteCount, 6000u - 4096u);
+
+    complete_all_();
+    CHECK(memcpy_via_pdma_async_poll(&request));
+    CHECK(memcmp(dest_, src_, 6000u) == 0);
+
+    reset_();
+    CHECK(memcpy_via_pdma_async(&request, dest_, src_, 4096u, NULL, NULL));
+    CHECK_EQUAL(startCount_, 1u);
+    complete_all_();
+    CHECK(memcmp(dest_, src_, 4096u) == 0);
+}
+
+static void test_unaligned_head_and_tail(void)
+{
+    struct MemcpyViaPdmaRequest request = { .pending = false };
+    const size_t destOffset = 5u;
+    const size_t srcOffset = 100003u;
+    const size_t byteCount = 70001u;
+
+    reset_();
+    CHECK(memcpy_via_pdma_async(&request, dest_ + destOffset, src_ + srcOffset, byteCount,
+        NULL, NULL));
+
+    //
+    // the head up to the first 16 byte boundary, and the tail, are copied by the CPU
+    const size_t headBytes = 16u - destOffset;
+    CHECK_EQUAL(startLog_[0].dest, (uintptr_t)dest_ + 16u);
+    CHECK_EQUAL(startLog_[0].src, (uintptr_t)src_ + srcOffset + headBytes);
+    CHECK(memcmp(dest_ + destOffset, src_ + srcOffset, headBytes) == 0);
+
+    size_t pdmaBytes = 0u;
+    for (size_t i = 0u; i < startCount_; i++) {
+        pdmaBytes += startLog_[i].byteCount;
+    }
+    CHECK_EQUAL(pdmaBytes, (byteCount - headBytes) & ~15u);
+
+    complete_all_();
+    CHECK(memcpy_via_pdma_async_poll(&request));
+    CHECK(memcmp(dest_ + destOffset, src_ + srcOffset, byteCount) == 0);
+    CHECK_EQUAL(dest_[destOffset - 1u], 0u);
+    CHECK_EQUAL(dest_[destOffset + byteCount], 0u);
+}
+
+static void test_queued_in_submission_order(void)
+{
+    struct MemcpyViaPdmaRequest first = { .pending = false };
+    struct MemcpyViaPdmaRequest second = { .pending = false };
+    struct MemcpyViaPdmaRequest third = { .pending = false };
+
+    reset_();
+    callbackCount_ = 0u;
+
+    CHECK(memcpy_via_pdma_async(&first, dest_, src_, 128u * 1024u, count_callback_, &first));
+    CHECK(memcpy_via_pdma_async(&second, dest_ + 0x20000u, src_ + 0x20000u, 64u * 1024u,
+        count_callback_, &second));
+    CHECK(memcpy_via_pdma_async(&third, dest_ + 0x40000u, src_ + 0x40000u, 8u * 1024u,
+        count_callback_, &third));
+
+    //
+    // the first copy takes every channel, so the others wait
+    CHECK_EQUAL(startCount_, MSS_PDMA_lAST_CHANNEL);
+    for (unsigned i = 0u; i < MSS_PDMA_lAST_CHANNEL; i++) {
+        CHECK(startLog_[i].dest < ((uintptr_t)dest_ + 0x20000u));
+    }
+
+    //
+    // a channel which frees up goes to the oldest waiting copy
+    pdma_complete_(2u);
+    run_service_();
+    CHECK_EQUAL(startCount_, MSS_PDMA_lAST_CHANNEL + 1u);
+    CHECK_EQUAL(startLog_[MSS_PDMA_lAST_CHANNEL].channel, 2u);
+    CHECK_EQUAL(startLog_[MSS_PDMA_lAST_CHANNEL].dest, (uintptr_t)dest_ + 0x20000u);
+    CHECK_EQUAL(startLog_[MSS_PDMA_lAST_CHANNEL].byteCount, 64u * 1024u);
+    CHECK(first.pending && second.pending && third.pending);
+
+    pdma_complete_(0u);
+    run_service_();
+    CHECK_EQUAL(startLog_[MSS_PDMA_lAST_CHANNEL + 1u].channel, 0u);
+    CHECK_EQUAL(startLog_[MSS_PDMA_lAST_CHANNEL + 1u].dest, (uintptr_t)dest_ + 0x40000u);
+
+    //
+    // the third copy can finish first, but the first copy must wait for all its pieces
+    pdma_complete_(0u);
+    run_service_();
+    CHECK(!third.pending);
+    CHECK(first.pending);
+    CHECK_EQUAL(callbackCount_, 1u);
+    CHECK(pLastCallbackContext_ == &third);
+
+    complete_all_();
+    CHECK(!first.pending && !second.pending);
+    CHECK_EQUAL(callbackCount_, 3u);
+    CHECK(memcmp(dest_, src_, 0x30000u) == 0);
+    CHECK(memcmp(dest_ + 0x40000u, src_ + 0x40000u, 8u * 1024u) == 0);
+}
+
+static struct MemcpyViaPdmaRequest resubmittedRequest_ = { .pending = false };
+static unsigned resubmissions_;
+
+static void resubmit_callback_(void *pContext)
+{
+    (void)pContext;
+
+    if (++resubmissions_ < 3u) {
+        CHECK(memcpy_via_pdma_async(&resubmittedRequest_, dest_ + (resubmissions_ * 0x10000u),
+            src_ + (resubmissions_ * 0x10000u), 0x10000u, resubmit_callback_, NULL));
+    }
+}
+
+static void test_resubmit_from_callback(void)
+{
+    reset_();
+    resubmissions_ = 0u;
+    CHECK(memcpy_via_pdma_async(&resubmittedRequest_, dest_, src_, 0x10000u,
+        resubmit_callback_, NULL));
+    complete_all_();
+
+    CHECK_EQUAL(resubmissions_, 3u);
+    CHECK(!resubmittedRequest_.pending);
+    CHECK(memcmp(dest_, src_, 3u * 0x10000u) == 0);
+}
+
+static void test_errors_fall_back_to_cpu(void)
+{
+    struct MemcpyViaPdmaRequest request = { .pending = false };
+
+    //
+    // a channel which fails mid-transfer is copied by the CPU instead
+    reset_();
+    CHECK(memcpy_via_pdma_async(&request, dest_, src_, 64u * 1024u, NULL, NULL));
+    pdma_fail_(1u);
+    complete_all_();
+    CHECK(memcpy_via_pdma_async_poll(&request));
+    CHECK(memcmp(dest_, src_, 64u * 1024u) == 0);
+    CHECK(!pdma_[1].error);
+
+    //
+    // as is a copy that the PDMA refuses, a piece per channel per superloop iteration
+    reset_();
+    setupError_ = MSS_PDMA_ERROR_INVALID_SRC_ADDR;
+    CHECK(memcpy_via_pdma_async(&request, dest_, src_, 64u * 1024u, NULL, NULL));
+    CHECK_EQUAL(startCount_, 0u);
+    complete_all_();
+    CHECK(memcpy_via_pdma_async_poll(&request));
+    CHECK(memcmp(dest_, src_, 64u * 1024u) == 0);
+}
+
+static void test_busy_request_is_refused(void)
+{
+    struct MemcpyViaPdmaRequest request = { .pending = false };
+
+    reset_();
+    CHECK(memcpy_via_pdma_async(&request, dest_, src_, 64u * 1024u, NULL, NULL));
+    CHECK(!memcpy_via_pdma_async(&request, dest_ + 0x20000u, src_, 64u * 1024u, NULL, NULL));
+    complete_all_();
+    CHECK(!request.pending);
+    CHECK_EQUAL(dest_[0x20000u], 0u);
+}
+
+int main(void)
+{
+    RUN_TEST(test_large_copy_uses_all_channels);
+    RUN_TEST(test_small_copy_uses_one_channel);
+    RUN_TEST(test_unaligned_head_and_tail);
+    RUN_TEST(test_queued_in_submission_order);
+    RUN_TEST(test_resubmit_from_callback);
+    RUN_TEST(test_errors_fall_back_to_cpu);
+    RUN_TEST(test_busy_request_is_refused);
+
+    return unit_test_report("memcpy_via_pdma");
+}
@@ -0,0 +1,162 @@
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/*!
+ * \file Host unit tests for MMC ADMA2 descriptor tables
+ * \brief Checks HSS_MMC_ADMA2_BuildTable splitting, end marking and rejection
+ */
+
+#include "config.h"
+#include "hss_types.h"
+
+#include <string.h>
+
+#include "mmc_adma2.h"
+#include "unit_test.h"
+
+#define ATTR_TRANSFER       (HSS_MMC_ADMA2_ATTR_VALID | HSS_MMC_ADMA2_ATTR_ACT_TRAN)
+#define ATTR_LAST           (ATTR_TRANSFER | HSS_MMC_ADMA2_ATTR_END)
+
+//
+// descriptor addresses are only recorded, never dereferenced, so DDR addresses above
+// 4GiB can be used as they would be on the target
+#define DDR_HI_ADDR         ((uintptr_t)0x1020000000ull)
+
+static struct HSS_MMC_ADMA2_Descriptor table_[16];
+
+static uint64_t desc_address_(struct HSS_MMC_ADMA2_Descriptor const * const pDesc)
+{
+    return ((uint64_t)pDesc->addressHigh << 32) | pDesc->addressLow;
+}
+
+static void test_single_descriptor(void)
+{
+    struct HSS_MMC_ReadSegment const segment = { (void *)DDR_HI_ADDR, 4096u };
+
+    memset(table_, 0xA5, sizeof(table_));
+
+    CHECK_EQUAL(HSS_MMC_ADMA2_BuildTable(table_, ARRAY_SIZE(table_), &segment, 1u), 1u);
+    CHECK_EQUAL(table_[0].attribute, ATTR_LAST);
+    CHECK_EQUAL(table_[0].length, 4096u);
+    CHECK_EQUAL(desc_address_(&table_[0]), DDR_HI_ADDR);
+    CHECK_EQUAL(table_[0].addressHigh, 0x10u);
+    CHECK_EQUAL(table_[0].reserved, 0u);
+}
+
+static void test_splits_at_32KiB(void)
+{
+    struct HSS_MMC_ReadSegment const segment = { (void *)DDR_HI_ADDR, 100000u };
+
+    CHECK_EQUAL(HSS_MMC_ADMA2_BuildTable(table_, ARRAY_SIZE(table_), &segment, 1u), 4u);
+
+    for (size_t i = 0u; i < 3u; i++) {
+        CHECK_EQUAL(table_[i].attribute, ATTR_TRANSFER);
+        CHECK_EQUAL(table_[i].length, HSS_MMC_ADMA2_MAX_LENGTH);
+        CHECK_EQUAL(desc_address_(&table_[i]), DDR_HI_ADDR + (i * HSS_MMC_ADMA2_MAX_LENGTH));
+    }
+
+    CHECK_EQUAL(table_[3].attribute, ATTR_LAST);
+    CHECK_EQUAL(table_[3].length, 100000u - (3u * HSS_MMC_ADMA2_MAX_LENGTH));
+    CHECK_EQUAL(desc_address_(&table_[3]), DDR_HI_ADDR + (3u * HSS_MMC_ADMA2_MAX_LENGTH));
+}
+
+static void test_exact_multiple_of_32KiB(void)
+{
+    struct HSS_MMC_ReadSegment const segment = { (void *)DDR_HI_ADDR, 2u * HSS_MMC_ADMA2_MAX_LENGTH };
+
+    //
+    // a length field of zero means 64KiB to the controller, so a 64KiB segment must not be
+    // described by a single descriptor
+    CHECK_EQUAL(HSS_MMC_ADMA2_BuildTable(table_, ARRAY_SIZE(table_), &segment, 1u), 2u);
+    CHECK_EQUAL(table_[0].length, HSS_MMC_ADMA2_MAX_LENGTH);
+    CHECK_EQUAL(table_[1].length, HSS_MMC_ADMA2_MAX_LENGTH);
+    CHECK_EQUAL(table_[0].attribute, ATTR_TRANSFER);
+    CHECK_EQUAL(table_[1].attribute, ATTR_LAST);
+}
+
+static void test_scatter_segments(void)
+{
+    struct HSS_MMC_ReadSegment const segments[] = {
+        { (void *)0x80000000u, 40000u },
+        { (void *)(DDR_HI_ADDR + 0x100u), 512u },
+        { (void *)0x80100004u, 4u },
+    };
+
+    CHECK_EQUAL(HSS_MMC_ADMA2_BuildTable(table_, ARRAY_SIZE(table_), segments,
+        ARRAY_SIZE(segments)), 4u);
+
+    CHECK_EQUAL(desc_address_(&table_[0]), 0x80000000u);
+    CHECK_EQUAL(table_[0].length, HSS_MMC_ADMA2_MAX_LENGTH);
+    CHECK_EQUAL(desc_address_(&table_[1]), 0x80000000u + HSS_MMC_ADMA2_MAX_LENGTH);
+    CHECK_EQUAL(table_[1].length, 40000u - HSS_MMC_ADMA2_MAX_LENGTH);
+    CHECK_EQUAL(desc_address_(&table_[2]), DDR_HI_ADDR + 0x100u);
+    CHECK_EQUAL(table_[2].length, 512u);
+    CHECK_EQUAL(desc_address_(&table_[3]), 0x80100004u);
+    CHECK_EQUAL(table_[3].length, 4u);
+
+    // only the final descriptor of the final segment ends the table
+    CHECK_EQUAL(table_[0].attribute, ATTR_TRANSFER);
+    CHECK_EQUAL(table_[1].attribute, ATTR_TRANSFER);
+    CHECK_EQUAL(table_[2].attribute, ATTR_TRANSFER);
+    CHECK_EQUAL(table_[3].attribute, ATTR_LAST);
+}
+
+static void test_rejects_misaligned(void)
+{
+    for (uintptr_t offset = 1u; offset < HSS_MMC_ADMA2_ADDRESS_ALIGN; offset++) {
+        struct HSS_MMC_ReadSegment const segment = { (void *)(DDR_HI_ADDR + offset), 512u };
+
+        CHECK_EQUAL(HSS_MMC_ADMA2_BuildTable(table_, ARRAY_SIZE(table_), &segment, 1u), 0u);
+    }
+
+    // a misaligned later segment rejects the whole table
+    struct HSS_MMC_ReadSegment const segments[] = {
+        { (void *)DDR_HI_ADDR, 512u },
+        { (void *)(DDR_HI_ADDR + 0x202u), 512u },
+    };
+    CHECK_EQUAL(HSS_MMC_ADMA2_BuildTable(table_, ARRAY_SIZE(table_), segments,
+        ARRAY_SIZE(segments)), 0u);
+}
+
+static void test_rejects_empty(void)
+{
+    struct HSS_MMC_ReadSegment const segments[] = {
+        { (void *)DDR_HI_ADDR, 512u },
+        { (void *)(DDR_HI_ADDR + 0x200u), 0u },
+    };
+
+    CHECK_EQUAL(HSS_MMC_ADMA2_BuildTable(table_, ARRAY_SIZE(table_), segments, 0u), 0u);
+    CHECK_EQUAL(HSS_MMC_ADMA2_BuildTable(table_, ARRAY_SIZE(table_), segments,
+        ARRAY_SIZE(segments)), 0u);
+    CHECK_EQUAL(HSS_MMC_ADMA2_BuildTable(table_, ARRAY_SIZE(table_), NULL, 1u), 0u);
+    CHECK_EQUAL(HSS_MMC_ADMA2_BuildTable(NULL, ARRAY_SIZE(table_), segments, 1u), 0u);
+}
+
+static void test_table_capacity(void)
+{
+    struct HSS_MMC_ReadSegment const segment = { (void *)DDR_HI_ADDR, 100000u };
+
+    CHECK_EQUAL(HSS_MMC_ADMA2_BuildTable(table_, 3u, &segment, 1u), 0u);
+    CHECK_EQUAL(HSS_MMC_ADMA2_BuildTable(table_, 4u, &segment, 1u), 4u);
+    CHECK_EQUAL(table_[3].attribute, ATTR_LAST);
+    CHECK_EQUAL(HSS_MMC_ADMA2_BuildTable(table_, 0u, &segment, 1u), 0u);
+}
+
+int main(void)
+{
+    RUN_TEST(test_single_descriptor);
+    RUN_TEST(test_splits_at_32KiB);
+    RUN_TEST(test_exact_multiple_of_32KiB);
+    RUN_TEST(test_scatter_segments);
+    RUN_TEST(test_rejects_misaligned);
+    RUN_TEST(test_rejects_empty);
+    RUN_TEST(test_table_capacity);
+
+    return unit_test_report("mmc_adma2");
+}
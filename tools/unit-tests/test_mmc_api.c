@@ -0,0 +1,962 @@
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/*!
+ * \file Host unit tests for the MMC service
+ * \brief Checks the commands that the MMC service's ADMA2 writes put on the bus, for their
+ * ordering and block accounting, against a stand-in card that enforces the command
+ * protocol of eMMC devices and SD cards, and measures the commands and bytes that the
+ * read cache saves, and checks that writes invalidate it. The bus mode ladder is checked
+ * against a card that fails to come up in chosen modes
+ *
+ * mmc_api.c is included rather than linked, so that the test can redirect its system
+ * register accesses and inspect its state. The MSS MMC driver programs the controller's
+ * registers directly and cannot run on the host, so the stand-in implements the driver's
+ * API, and expands each call into the commands that the driver sends for it.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+
+#include <string.h>
+
+#include "mss_sysreg.h"
+
+static mss_sysreg_t sysreg_;
+#undef SYSREG
+#define SYSREG (&sysreg_)
+
+#include "mmc_api.c"
+#include "unit_test.h"
+
+#define SECTOR_SIZE             (512u)
+#define CARD_SIZE               (8u * 1024u * 1024u)
+#define CARD_NUM_SECTORS        (CARD_SIZE / SECTOR_SIZE)
+#define MAX_COMMANDS            (64u)
+#define MAX_INIT_ATTEMPTS       (16u)
+#define RCA                     (0x0001u)
+
+//
+// the commands the driver sends for a transfer. ACMD23 is sent as CMD23 after CMD55, and
+// is logged with APP_COMMAND set to tell it from CMD23
+#define CMD12_STOP_TRANSMISSION (12u)
+#define CMD13_SEND_STATUS       (13u)
+#define CMD17_READ_SINGLE       (17u)
+#define CMD18_READ_MULTIPLE     (18u)
+#define CMD23_SET_BLOCK_COUNT   (23u)
+#define CMD24_WRITE_SINGLE      (24u)
+#define CMD25_WRITE_MULTIPLE    (25u)
+#define CMD55_APP_CMD           (55u)
+#define APP_COMMAND             (0x100u)
+#define ACMD23_SET_WR_BLK_ERASE_COUNT (APP_COMMAND | 23u)
+
+static uint8_t cardData_[CARD_SIZE] __attribute__((aligned(8)));
+static uint8_t source_[6u * 1024u * 1024u] __attribute__((aligned(8)));
+
+struct Command {
+    unsigned index;
+    uint32_t argument;
+};
+
+struct InitAttempt {
+    uint8_t cardType;
+    uint8_t busSpeedMode;
+    uint32_t clkRate;
+};
+
+//
+// the driver's own state, including whether it stops the transfer in progress with CMD12
+static struct {
+    mss_mmc_status_t state;
+    bool stopWhenComplete;
+    unsigned pollsToComplete;
+} driver_;
+
+//
+// the stand-in card, which checks each command against the state the previous commands
+// left it in, and counts any that the card would reject
+static struct {
+    uint8_t cardType;
+    bool appCommand;            // the previous command was CMD55
+    uint32_t declaredBlocks;    // by the previous command, CMD23, or zero
+    uint32_t transferBlocks;    // declared for the transfer in progress, or zero
+    bool openEnded;             // a multi-block transfer that must be stopped by CMD12
+
+    struct Command log[MAX_COMMANDS];
+    size_t numCommands;
+    unsigned protocolErrors;
+    size_t blocksWritten;
+    size_t blocksRead;
+    size_t readCommands;
+
+    // bus modes, as bits indexed by bus_speed_mode, that fail to come up, always or once
+    uint32_t failModes;
+    uint32_t failModesOnce;
+    struct InitAttempt attempts[MAX_INIT_ATTEMPTS];
+    size_t numAttempts;
+    unsigned attemptsWithoutReset;
+    unsigned delays;
+} card_;
+
+static void card_reset_(uint8_t cardType)
+{
+    memset(&card_, 0, sizeof(card_));
+    card_.cardType = cardType;
+
+    memset(&driver_, 0, sizeof(driver_));
+    driver_.state = MSS_MMC_TRANSFER_SUCCESS;
+}
+
+static void card_clear_log_(void)
+{
+    card_.numCommands = 0u;
+    card_.protocolErrors = 0u;
+    card_.blocksWritten = 0u;
+    card_.blocksRead = 0u;
+    card_.readCommands = 0u;
+}
+
+static void card_command_(unsigned index, uint32_t argument)
+{
+    if (card_.appCommand) {
+        index |= APP_COMMAND;
+    }
+
+    if (card_.numCommands < MAX_COMMANDS) {
+        card_.log[card_.numCommands] = (struct Command){ index, argument };
+    }
+    card_.numCommands++;
+
+    // a stop is only valid, and only needed, to end an open-ended transfer
+    if (card_.openEnded != (index == CMD12_STOP_TRANSMISSION)) {
+        card_.protocolErrors++;
+    }
+    card_.openEnded = false;
+
+    // the block count must be declared immediately before the transfer it applies to
+    uint32_t const declaredBlocks = card_.declaredBlocks;
+    card_.declaredBlocks = 0u;
+    card_.appCommand = false;
+
+    switch (index) {
+    case CMD55_APP_CMD:
+        card_.appCommand = true;
+        break;
+
+    case CMD23_SET_BLOCK_COUNT:
+        card_.declaredBlocks = argument;
+        if (!argument) {
+            card_.protocolErrors++;
+        }
+        break;
+
+    case ACMD23_SET_WR_BLK_ERASE_COUNT:
+        if ((card_.cardType != MSS_MMC_CARD_TYPE_SD) || !argument) {
+            card_.protocolErrors++;
+        }
+        break;
+
+    case CMD12_STOP_TRANSMISSION:
+    case CMD13_SEND_STATUS:
+        break;
+
+    case CMD17_READ_SINGLE:
+        card_.readCommands++;
+        // fallthrough
+    case CMD24_WRITE_SINGLE:
+        card_.transferBlocks = declaredBlocks;
+        break;
+
+    case CMD18_READ_MULTIPLE:
+        card_.readCommands++;
+        // fallthrough
+    case CMD25_WRITE_MULTIPLE:
+        card_.transferBlocks = declaredBlocks;
+        card_.openEnded = !declaredBlocks;
+        break;
+
+    default:
+        card_.protocolErrors++;
+        break;
+    }
+}
+
+//
+// moves the data of a transfer through its descriptor table, as the controller would
+static void card_transfer_(bool write, void const *pDescTable, uint32_t sector, uint32_t blocks)
+{
+    struct HSS_MMC_ADMA2_Descriptor const *pDesc = pDescTable;
+    size_t offset = (size_t)sector * SECTOR_SIZE;
+    size_t const end = offset + ((size_t)blocks * SECTOR_SIZE);
+    bool last = false;
+
+    // a pre-declared block count must match the blocks transferred
+    if (card_.transferBlocks && (card_.transferBlocks != blocks)) {
+        card_.protocolErrors++;
+    }
+
+    if (end > CARD_SIZE) {
+        card_.protocolErrors++;
+    } else {
+        while (!last) {
+            uint8_t * const pBuffer = (uint8_t *)(uintptr_t)(((uint64_t)pDesc->addressHigh << 32)
+                | pDesc->addressLow);
+            size_t const length = pDesc->length ? pDesc->length : 65536u;
+
+            last = (pDesc->attribute & HSS_MMC_ADMA2_ATTR_END) || (offset + length > end);
+            if (offset + length > end) {
+                card_.protocolErrors++;
+            } else if (write) {
+                memcpy(cardData_ + offset, pBuffer, length);
+            } else {
+                memcpy(pBuffer, cardData_ + offset, length);
+            }
+
+            offset += length;
+            pDesc++;
+        }
+
+        if (offset != end) {
+            card_.protocolErrors++;
+        }
+    }
+
+    if (write) {
+        card_.blocksWritten += blocks;
+    } else {
+        card_.blocksRead += blocks;
+    }
+}
+
+//
+// the MSS MMC driver's ADMA2 transfers, issuing the commands that the driver does for
+// them: a status poll, then for a multi-block write, an SD pre-erase hint and a block count
+// if asked for, then the transfer itself. A multi-block transfer without a block count is
+// stopped with CMD12 once it completes
+static mss_mmc_status_t adma2_transfer_(bool write, void const *pDescTable, uint32_t sector,
+    uint32_t size, uint32_t flags)
+{
+    mss_mmc_status_t result = MSS_MMC_TRANSFER_IN_PROGRESS;
+
+    if (driver_.state != MSS_MMC_TRANSFER_IN_PROGRESS) {
+        if ((size % SECTOR_SIZE) || !size || (size > (32u * 1024u * 1024u - SECTOR_SIZE))
+            || !pDescTable) {
+            result = MSS_MMC_INVALID_PARAMETER;
+        } else {
+            uint32_t const blocks = size / SECTOR_SIZE;
+
+            card_command_(CMD13_SEND_STATUS, RCA << 16);
+
+            if (write && (blocks > 1u) && (flags & MSS_MMC_WRITE_SD_PRE_ERASE)) {
+                card_command_(CMD55_APP_CMD, RCA << 16);
+                card_command_(CMD23_SET_BLOCK_COUNT, blocks);
+            }
+
+            if (write && (blocks > 1u) && (flags & MSS_MMC_WRITE_SET_BLOCK_COUNT)) {
+                card_command_(CMD23_SET_BLOCK_COUNT, blocks);
+            }
+
+            if (write) {
+                card_command_((blocks > 1u) ? CMD25_WRITE_MULTIPLE : CMD24_WRITE_SINGLE, sector);
+            } else {
+                card_command_((blocks > 1u) ? CMD18_READ_MULTIPLE : CMD17_READ_SINGLE, sector);
+            }
+
+            card_transfer_(write, pDescTable, sector, blocks);
+            driver_.stopWhenComplete = (blocks > 1u)
+                && !(write && (flags & MSS_MMC_WRITE_SET_BLOCK_COUNT));
+            driver_.pollsToComplete = 3u;
+            driver_.state = MSS_MMC_TRANSFER_IN_PROGRESS;
+        }
+    }
+
+    return result;
+}
+
+mss_mmc_status_t MSS_MMC_adma2_desc_write(const void *desc_table, uint32_t dest, uint32_t size,
+    uint32_t flags)
+{
+    return adma2_transfer_(true, desc_table, dest, size, flags);
+}
+
+mss_mmc_status_t MSS_MMC_adma2_desc_read(uint32_t src, const void *desc_table, uint32_t size)
+{
+    return adma2_transfer_(false, desc_table, src, size, 0u);
+}
+
+uint8_t PLIC_mmc_main_IRQHandler(void)
+{
+    if ((driver_.state == MSS_MMC_TRANSFER_IN_PROGRESS) && !--driver_.pollsToComplete) {
+        if (driver_.stopWhenComplete) {
+            card_command_(CMD12_STOP_TRANSMISSION, RCA << 16);
+        }
+
+        driver_.state = MSS_MMC_TRANSFER_SUCCESS;
+    }
+
+    return (uint8_t)driver_.state;
+}
+
+//
+// a failed initialization stops the controller's clock, which must be reset before it is
+// initialized again
+mss_mmc_status_t MSS_MMC_init(const mss_mmc_cfg_t * cfg)
+{
+    uint32_t const modeBit = 1u << cfg->bus_speed_mode;
+    bool result = (cfg->card_type == card_.cardType) && !(card_.failModes & modeBit);
+
+    if (card_.numAttempts < MAX_INIT_ATTEMPTS) {
+        card_.attempts[card_.numAttempts] =
+            (struct InitAttempt){ cfg->card_type, cfg->bus_speed_mode, cfg->clk_rate };
+    }
+    card_.numAttempts++;
+
+    if (!(sysreg_.SUBBLK_CLOCK_CR & SUBBLK_CLOCK_CR_MMC_MASK)) {
+        card_.attemptsWithoutReset++;
+    }
+
+    if (result && (card_.failModesOnce & modeBit)) {
+        card_.failModesOnce &= ~modeBit;
+        result = false;
+    }
+
+    if (!result) {
+        sysreg_.SUBBLK_CLOCK_CR &= ~(uint32_t)SUBBLK_CLOCK_CR_MMC_MASK;
+    }
+
+    return result ? MSS_MMC_INIT_SUCCESS : MSS_MMC_INIT_FAILURE;
+}
+
+void MSS_MMC_get_info(uint16_t *sector_size, uint32_t *sector_count)
+{
+    *sector_size = SECTOR_SIZE;
+    *sector_count = CARD_NUM_SECTORS;
+}
+
+mss_mmc_status_t MSS_MMC_get_partition_config(uint8_t *partition_config,
+    uint32_t *boot_partition_size)
+{
+    *partition_config = 0u;
+    *boot_partition_size = 0u;
+
+    return MSS_MMC_TRANSFER_SUCCESS;
+}
+
+mss_mmc_status_t MSS_MMC_set_partition_config(uint8_t partition_config)
+{
+    (void)partition_config;
+
+    return MSS_MMC_TRANSFER_SUCCESS;
+}
+
+uint8_t mss_does_xml_ver_support_switch(void)
+{
+    return true;
+}
+
+uint8_t switch_mssio_config(MSS_IO_OPTIONS option)
+{
+    (void)option;
+
+    return true;
+}
+
+void HSS_SpinDelay_MilliSecs(uint32_t milliseconds)
+{
+    (void)milliseconds;
+    card_.delays++;
+}
+
+bool HSS_PerfCtr_Allocate(int *pIdx, char const * name)
+{
+    (void)name;
+    *pIdx = 0;
+
+    return true;
+}
+
+void HSS_PerfCtr_Lap(int index)
+{
+    (void)index;
+}
+
+//
+// xorshift, so that the data is the same from run to run
+static uint32_t random_state_ = 0x5EC70125u;
+
+static uint32_t random_(void)
+{
+    random_state_ ^= random_state_ << 13;
+    random_state_ ^= random_state_ >> 17;
+    random_state_ ^= random_state_ << 5;
+
+    return random_state_;
+}
+
+static void fill_source_(void)
+{
+    for (size_t i = 0u; i < sizeof(source_); i++) {
+        source_[i] = (uint8_t)random_();
+    }
+}
+
+static void expect_command_(size_t *pIndex, unsigned index, uint32_t argument)
+{
+    if (*pIndex < MIN(card_.numCommands, (size_t)MAX_COMMANDS)) {
+        CHECK_EQUAL(card_.log[*pIndex].index, index);
+        CHECK_EQUAL(card_.log[*pIndex].argument, argument);
+    } else {
+        CHECK(false);
+    }
+
+    (*pIndex)++;
+}
+
+//
+// writes of a sector or less, of runts rounded up to a whole sector, and of more than a
+// single command can carry, which are split into several
+static const size_t writeSizes_[] = {
+    1u, 511u, 512u, 513u, 4096u, 65536u + 100u,
+    MMC_ADMA2_MAX_TRANSFER - 512u, MMC_ADMA2_MAX_TRANSFER, MMC_ADMA2_MAX_TRANSFER + 1u,
+    (2u * MMC_ADMA2_MAX_TRANSFER) + 512u, sizeof(source_),
+};
+
+//
+// checks the commands of a blocking write: one transfer per piece of at most
+// MMC_ADMA2_MAX_TRANSFER, each bounded as flags says it should be
+static void check_write_(size_t offset, size_t byteCount, uint32_t flags)
+{
+    size_t const roundedCount = ((byteCount + SECTOR_SIZE - 1u) / SECTOR_SIZE) * SECTOR_SIZE;
+    size_t index = 0u;
+
+    CHECK(HSS_MMC_WriteBlock(offset, source_, byteCount));
+    CHECK(!memcmp(cardData_ + offset, source_, roundedCount));
+
+    CHECK_EQUAL(card_.protocolErrors, 0u);
+    CHECK_EQUAL(card_.blocksWritten, roundedCount / SECTOR_SIZE);
+    CHECK_EQUAL(card_.blocksRead, 0u);
+
+    for (size_t done = 0u; done < roundedCount; done += MMC_ADMA2_MAX_TRANSFER) {
+        uint32_t const sector = (uint32_t)((offset + done) / SECTOR_SIZE);
+        uint32_t const blocks = (uint32_t)(MIN(roundedCount - done, (size_t)MMC_ADMA2_MAX_TRANSFER)
+            / SECTOR_SIZE);
+
+        expect_command_(&index, CMD13_SEND_STATUS, RCA << 16);
+
+        if (blocks == 1u) {
+            expect_command_(&index, CMD24_WRITE_SINGLE, sector);
+        } else {
+            if (flags & MSS_MMC_WRITE_SD_PRE_ERASE) {
+                expect_command_(&index, CMD55_APP_CMD, RCA << 16);
+                expect_command_(&index, ACMD23_SET_WR_BLK_ERASE_COUNT, blocks);
+            }
+
+            if (flags & MSS_MMC_WRITE_SET_BLOCK_COUNT) {
+                expect_command_(&index, CMD23_SET_BLOCK_COUNT, blocks);
+                expect_command_(&index, CMD25_WRITE_MULTIPLE, sector);
+            } else {
+                expect_command_(&index, CMD25_WRITE_MULTIPLE, sector);
+                expect_command_(&index, CMD12_STOP_TRANSMISSION, RCA << 16);
+            }
+        }
+    }
+
+    CHECK_EQUAL(card_.numCommands, index);
+}
+
+static void test_emmc_writes_declare_block_count(void)
+{
+    card_reset_(MSS_MMC_CARD_TYPE_MMC);
+    CHECK(HSS_MMCInit());
+    CHECK(mmc_isEMMC);
+    fill_source_();
+
+    for (size_t i = 0u; i < ARRAY_SIZE(writeSizes_); i++) {
+        size_t const offset = (i * 7u * SECTOR_SIZE) % (CARD_SIZE - sizeof(source_));
+
+        card_clear_log_();
+        check_write_(offset, writeSizes_[i], MSS_MMC_WRITE_SET_BLOCK_COUNT);
+    }
+}
+
+static void test_sd_writes_pre_erase_and_stop(void)
+{
+    card_reset_(MSS_MMC_CARD_TYPE_SD);
+    CHECK(HSS_MMCInit());
+    CHECK(!mmc_isEMMC);
+    fill_source_();
+
+    for (size_t i = 0u; i < ARRAY_SIZE(writeSizes_); i++) {
+        size_t const offset = (i * 13u * SECTOR_SIZE) % (CARD_SIZE - sizeof(source_));
+
+        card_clear_log_();
+        check_write_(offset, writeSizes_[i], MSS_MMC_WRITE_SD_PRE_ERASE);
+    }
+}
+
+//
+// a background write returns while the card is still programming, refuses a second
+// transfer until it is complete, and a blocking access waits for it before starting
+static void test_background_write(void)
+{
+    bool result = false;
+    unsigned polls = 0u;
+    size_t const byteCount = 256u * 1024u;
+    uint32_t const blocks = byteCount / SECTOR_SIZE;
+
+    card_reset_(MSS_MMC_CARD_TYPE_MMC);
+    CHECK(HSS_MMCInit());
+    fill_source_();
+    card_clear_log_();
+
+    CHECK(HSS_MMC_WriteBlockStart(0u, source_, byteCount));
+    CHECK_EQUAL(driver_.state, MSS_MMC_TRANSFER_IN_PROGRESS);
+    CHECK(!HSS_MMC_WriteBlockStart(byteCount, source_ + byteCount, byteCount));
+    CHECK_EQUAL(card_.numCommands, 3u);
+
+    while (!HSS_MMC_IsTransferComplete(&result)) {
+        polls++;
+    }
+
+    CHECK(result);
+    CHECK(polls > 0u);
+
+    // and a blocking write after a background one carries on where it ended
+    CHECK(HSS_MMC_WriteBlockStart(byteCount, source_ + byteCount, byteCount));
+    CHECK(HSS_MMC_WriteBlock(2u * byteCount, source_ + (2u * byteCount), byteCount));
+    CHECK(!memcmp(cardData_, source_, 3u * byteCount));
+
+    size_t index = 0u;
+    for (uint32_t i = 0u; i < 3u; i++) {
+        expect_command_(&index, CMD13_SEND_STATUS, RCA << 16);
+        expect_command_(&index, CMD23_SET_BLOCK_COUNT, blocks);
+        expect_command_(&index, CMD25_WRITE_MULTIPLE, i * blocks);
+    }
+
+    CHECK_EQUAL(card_.numCommands, index);
+    CHECK_EQUAL(card_.blocksWritten, 3u * blocks);
+    CHECK_EQUAL(card_.protocolErrors, 0u);
+}
+
+//
+// the read workloads, as the reads that reach HSS_MMC_ReadBlock
+struct Read {
+    size_t offset;
+    size_t byteCount;
+};
+
+#define MAX_READS               (256u)
+#define BOOT_PARTITION_OFFSET   (1024u * 1024u)
+#define BOOT_IMAGE_LENGTH       ((3u * 1024u * 1024u) + 1234u)
+#define BOOT_COPY_PIECE_SIZE    (64u * 1024u)
+
+static uint8_t readBuffer_[BOOT_COPY_PIECE_SIZE] __attribute__((aligned(8)));
+
+//
+// a boot from eMMC with the default options, of a signed image that is not streamed: the
+// GPT header, then its 128 partition entries in one read, then the boot image header, and
+// then the image in the pieces that copyBootImageToDDR_() hashes as it copies
+static size_t boot_reads_(struct Read *pReads)
+{
+    size_t numReads = 0u;
+
+    pReads[numReads++] = (struct Read){ SECTOR_SIZE, SECTOR_SIZE };
+    pReads[numReads++] = (struct Read){ 2u * SECTOR_SIZE, 128u * 128u };
+    pReads[numReads++] = (struct Read){ BOOT_PARTITION_OFFSET, sizeof(struct HSS_BootImage) };
+
+    for (size_t offset = 0u; offset < BOOT_IMAGE_LENGTH; offset += BOOT_COPY_PIECE_SIZE) {
+        pReads[numReads++] = (struct Read){ BOOT_PARTITION_OFFSET + offset,
+            MIN(BOOT_IMAGE_LENGTH - offset, (size_t)BOOT_COPY_PIECE_SIZE) };
+    }
+
+    return numReads;
+}
+
+//
+// a USB host reading the start of the device a sector at a time, as some do while
+// probing its partitions, with the GPT header read again at the end
+static size_t host_probe_reads_(struct Read *pReads)
+{
+    size_t numReads = 0u;
+
+    for (size_t sector = 0u; sector < 64u; sector++) {
+        pReads[numReads++] = (struct Read){ sector * SECTOR_SIZE, SECTOR_SIZE };
+    }
+
+    pReads[numReads++] = (struct Read){ SECTOR_SIZE, SECTOR_SIZE };
+    pReads[numReads++] = (struct Read){ 0u, SECTOR_SIZE };
+
+    return numReads;
+}
+
+struct ReadCost {
+    size_t commands;
+    size_t readCommands;
+    size_t bytes;
+};
+
+static struct ReadCost run_reads_(struct Read const *pReads, size_t numReads,
+    bool (*read)(void *pDest, size_t srcOffset, size_t byteCount))
+{
+    card_reset_(MSS_MMC_CARD_TYPE_MMC);
+    CHECK(HSS_MMCInit());
+    card_clear_log_();
+
+    for (size_t i = 0u; i < numReads; i++) {
+        assert(pReads[i].byteCount <= sizeof(readBuffer_));
+        memset(readBuffer_, 0, pReads[i].byteCount);
+
+        CHECK(read(readBuffer_, pReads[i].offset, pReads[i].byteCount));
+        CHECK(!memcmp(readBuffer_, cardData_ + pReads[i].offset, pReads[i].byteCount));
+    }
+
+    CHECK_EQUAL(card_.protocolErrors, 0u);
+
+    return (struct ReadCost){ card_.numCommands, card_.readCommands,
+        card_.blocksRead * SECTOR_SIZE };
+}
+
+static void fill_card_(void)
+{
+    for (size_t i = 0u; i < sizeof(cardData_); i++) {
+        cardData_[i] = (uint8_t)random_();
+    }
+}
+
+//
+// the commands and bytes read by each workload, without the cache, as HSS_MMC_ReadBlock
+// reads when it is not configured, and with it
+static void test_read_cache_benchmark(void)
+{
+    static const struct {
+        char const *pName;
+        size_t (*reads)(struct Read *pReads);
+    } workloads[] = {
+        { "boot",               boot_reads_ },
+        { "USB host probe",     host_probe_reads_ },
+    };
+    struct Read reads[MAX_READS];
+
+    fill_card_();
+
+    printf("  %u lines of %u sectors\n", MMC_CACHE_NUM_LINES, MMC_CACHE_LINE_SIZE / SECTOR_SIZE);
+    printf("  %-16s %6s %18s %18s %18s\n", "", "reads", "commands", "read commands",
+        "bytes read");
+
+    for (size_t w = 0u; w < ARRAY_SIZE(workloads); w++) {
+        size_t const numReads = workloads[w].reads(reads);
+        assert(numReads <= ARRAY_SIZE(reads));
+
+        struct ReadCost const uncached = run_reads_(reads, numReads, mmc_read_block_);
+        struct ReadCost const cached = run_reads_(reads, numReads, HSS_MMC_ReadBlock);
+
+        printf("  %-16s %6zu %8zu / %-8zu %8zu / %-8zu %8zu / %-8zu\n", workloads[w].pName,
+            numReads, uncached.commands, cached.commands, uncached.readCommands,
+            cached.readCommands, uncached.bytes, cached.bytes);
+
+        // the cache never costs commands, and any bytes it reads ahead are at most a line
+        // per read
+        CHECK(cached.readCommands <= uncached.readCommands);
+        CHECK(cached.bytes <= uncached.bytes + (numReads * MMC_CACHE_LINE_SIZE));
+    }
+
+    // and a host reading a sector at a time needs a command per line rather than per
+    // sector, and at most one more for each sector it reads again
+    size_t const numReads = host_probe_reads_(reads);
+    struct ReadCost const cached = run_reads_(reads, numReads, HSS_MMC_ReadBlock);
+    CHECK(cached.readCommands <= ((64u * SECTOR_SIZE) / MMC_CACHE_LINE_SIZE) + 2u);
+}
+
+static size_t read_commands_for_(size_t offset, size_t byteCount)
+{
+    size_t const readCommands = card_.readCommands;
+
+    CHECK(HSS_MMC_ReadBlock(readBuffer_, offset, byteCount));
+    CHECK(!memcmp(readBuffer_, cardData_ + offset, byteCount));
+
+    return card_.readCommands - readCommands;
+}
+
+//
+// a write invalidates the cached sectors that it overlaps, however it overlaps them, and
+// leaves the others
+static void test_read_cache_invalidated_by_writes(void)
+{
+    size_t const lineOffset = 64u * SECTOR_SIZE;
+    static const struct {
+        size_t offset;
+        size_t byteCount;
+        bool overlaps;
+    } writes[] = {
+        { 64u * SECTOR_SIZE,    SECTOR_SIZE,            true },     // first sector
+        { 71u * SECTOR_SIZE,    SECTOR_SIZE,            true },     // last sector
+        { 60u * SECTOR_SIZE,    8u * SECTOR_SIZE,       true },     // across the start
+        { 68u * SECTOR_SIZE,    8u * SECTOR_SIZE,       true },     // across the end
+        { 0u,                   128u * SECTOR_SIZE,     true },     // all of it
+        { 66u * SECTOR_SIZE,    1u,                     true },     // a runt in the middle
+        { 56u * SECTOR_SIZE,    8u * SECTOR_SIZE,       false },    // just before
+        { 72u * SECTOR_SIZE,    8u * SECTOR_SIZE,       false },    // just after
+    };
+
+    card_reset_(MSS_MMC_CARD_TYPE_MMC);
+    CHECK(HSS_MMCInit());
+    fill_card_();
+
+    for (size_t background = 0u; background < 2u; background++) {
+        for (size_t i = 0u; i < ARRAY_SIZE(writes); i++) {
+            // a sequential pair of reads fills the line ahead, and the line is then served
+            // from the cache
+            mmc_cache_reset_();
+            CHECK_EQUAL(read_commands_for_(lineOffset - SECTOR_SIZE, SECTOR_SIZE), 1u);
+            CHECK_EQUAL(read_commands_for_(lineOffset, SECTOR_SIZE), 1u);
+            CHECK_EQUAL(read_commands_for_(lineOffset, MMC_CACHE_LINE_SIZE - SECTOR_SIZE), 0u);
+
+            fill_source_();
+            if (background) {
+                bool result = false;
+
+                CHECK(HSS_MMC_WriteBlockStart(writes[i].offset, source_, writes[i].byteCount));
+                while (!HSS_MMC_IsTransferComplete(&result)) {
+                    ;
+                }
+                CHECK(result);
+            } else {
+                CHECK(HSS_MMC_WriteBlock(writes[i].offset, source_, writes[i].byteCount));
+            }
+
+            CHECK_EQUAL(read_commands_for_(lineOffset, MMC_CACHE_LINE_SIZE - SECTOR_SIZE),
+                writes[i].overlaps ? 1u : 0u);
+        }
+    }
+
+    // and re-initializing empties the cache
+    CHECK_EQUAL(read_commands_for_(lineOffset, SECTOR_SIZE), 0u);
+    CHECK(HSS_MMCInit());
+    CHECK_EQUAL(read_commands_for_(lineOffset, SECTOR_SIZE), 1u);
+    CHECK_EQUAL(card_.protocolErrors, 0u);
+}
+
+//
+// the bus mode ladders, fastest first, and where the service remembers the mode that came
+// up for each medium
+struct BusMode {
+    char const *pName;
+    uint8_t busSpeedMode;
+    uint32_t clkRate;
+};
+
+#define LADDER_STEPS            (4u)
+
+static const struct BusMode emmcLadder_[LADDER_STEPS] = {
+    { "HS400",  MSS_MMC_MODE_HS400,          MSS_MMC_CLOCK_200MHZ },
+    { "HS200",  MSS_MMC_MODE_HS200,          MSS_MMC_CLOCK_200MHZ },
+    { "DDR52",  MSS_MMC_MODE_DDR,            MSS_MMC_CLOCK_50MHZ },
+    { "HS",     MSS_MMC_MODE_SDR,            MSS_MMC_CLOCK_50MHZ },
+};
+
+static const struct BusMode sdcardLadder_[LADDER_STEPS] = {
+    { "SDR104", MSS_SDCARD_MODE_SDR104,      MSS_MMC_CLOCK_200MHZ },
+    { "SDR50",  MSS_SDCARD_MODE_SDR50,       MSS_MMC_CLOCK_100MHZ },
+    { "DDR50",  MSS_SDCARD_MODE_DDR50,       MSS_MMC_CLOCK_50MHZ },
+    { "HS",     MSS_SDCARD_MODE_HIGH_SPEED,  MSS_MMC_CLOCK_50MHZ },
+};
+
+_Static_assert(ARRAY_SIZE(emmcBusModes) == LADDER_STEPS, "eMMC ladder");
+_Static_assert(ARRAY_SIZE(sdcardBusModes) == LADDER_STEPS, "SD card ladder");
+
+static const struct Medium {
+    uint8_t cardType;
+    struct BusMode const *pLadder;
+    bool (*init)(void);
+    size_t *pLastGoodMode;
+} media_[] = {
+    { MSS_MMC_CARD_TYPE_MMC, emmcLadder_,   mmc_init_emmc,   &emmcLastGoodBusMode },
+    { MSS_MMC_CARD_TYPE_SD,  sdcardLadder_, mmc_init_sdcard, &sdcardLastGoodBusMode },
+};
+
+static uint32_t mode_bits_(struct Medium const *pMedium, size_t first, size_t count)
+{
+    uint32_t bits = 0u;
+
+    for (size_t i = first; i < first + count; i++) {
+        bits |= 1u << pMedium->pLadder[i].busSpeedMode;
+    }
+
+    return bits;
+}
+
+//
+// initializes the medium after a reset of the MMC block, as HSS_MMCInit() does
+static bool init_medium_(struct Medium const *pMedium)
+{
+    card_.numAttempts = 0u;
+    card_.attemptsWithoutReset = 0u;
+    card_.delays = 0u;
+    mmc_reset_block();
+
+    return pMedium->init();
+}
+
+static void check_attempt_(struct Medium const *pMedium, size_t attempt, size_t step)
+{
+    CHECK(attempt < MIN(card_.numAttempts, MAX_INIT_ATTEMPTS));
+    CHECK(step < LADDER_STEPS);
+
+    if ((attempt < MIN(card_.numAttempts, MAX_INIT_ATTEMPTS)) && (step < LADDER_STEPS)) {
+        CHECK_EQUAL(card_.attempts[attempt].cardType, pMedium->cardType);
+        CHECK_EQUAL(card_.attempts[attempt].busSpeedMode, pMedium->pLadder[step].busSpeedMode);
+        CHECK_EQUAL(card_.attempts[attempt].clkRate, pMedium->pLadder[step].clkRate);
+    }
+}
+
+//
+// each mode is tried in turn, fastest first, until one comes up, resetting the block
+// after each that fails
+static void test_bus_mode_ladder_descends(void)
+{
+    for (size_t m = 0u; m < ARRAY_SIZE(media_); m++) {
+        struct Medium const * const pMedium = &media_[m];
+
+        for (size_t good = 0u; good < LADDER_STEPS; good++) {
+            card_reset_(pMedium->cardType);
+            card_.failModes = mode_bits_(pMedium, 0u, good);
+            *pMedium->pLastGoodMode = LADDER_STEPS;
+
+            CHECK(init_medium_(pMedium));
+            CHECK_EQUAL(card_.numAttempts, good + 1u);
+
+            for (size_t i = 0u; i <= good; i++) {
+                check_attempt_(pMedium, i, i);
+            }
+
+            CHECK_EQUAL(*pMedium->pLastGoodMode, good);
+            CHECK(!strcmp(mmc_busModeName, pMedium->pLadder[good].pName));
+            CHECK_EQUAL(card_.attemptsWithoutReset, 0u);
+            CHECK_EQUAL(card_.delays, 0u);
+        }
+    }
+}
+
+//
+// only the slowest mode is retried after a delay, as it was before the ladder. If it fails
+// again, the next initialization starts from the top
+static void test_bus_mode_slowest_retried(void)
+{
+    for (size_t m = 0u; m < ARRAY_SIZE(media_); m++) {
+        struct Medium const * const pMedium = &media_[m];
+
+        card_reset_(pMedium->cardType);
+        card_.failModes = mode_bits_(pMedium, 0u, LADDER_STEPS - 1u);
+        card_.failModesOnce = mode_bits_(pMedium, LADDER_STEPS - 1u, 1u);
+        *pMedium->pLastGoodMode = LADDER_STEPS;
+
+        CHECK(init_medium_(pMedium));
+        CHECK_EQUAL(card_.numAttempts, LADDER_STEPS + 1u);
+        check_attempt_(pMedium, LADDER_STEPS - 1u, LADDER_STEPS - 1u);
+        check_attempt_(pMedium, LADDER_STEPS, LADDER_STEPS - 1u);
+        CHECK_EQUAL(card_.delays, 1u);
+        CHECK_EQUAL(card_.attemptsWithoutReset, 0u);
+        CHECK_EQUAL(*pMedium->pLastGoodMode, LADDER_STEPS - 1u);
+
+        card_.failModes = mode_bits_(pMedium, 0u, LADDER_STEPS);
+
+        CHECK(!init_medium_(pMedium));
+        CHECK_EQUAL(card_.numAttempts, 2u);
+        CHECK_EQUAL(card_.delays, 1u);
+        CHECK_EQUAL(*pMedium->pLastGoodMode, LADDER_STEPS);
+
+        CHECK(!init_medium_(pMedium));
+        CHECK_EQUAL(card_.numAttempts, LADDER_STEPS + 1u);
+        check_attempt_(pMedium, 0u, 0u);
+        CHECK_EQUAL(card_.attemptsWithoutReset, 0u);
+    }
+}
+
+//
+// the mode that came up is tried first next time, even if faster modes would now come up,
+// and the ladder is only descended from there
+static void test_bus_mode_remembered(void)
+{
+    for (size_t m = 0u; m < ARRAY_SIZE(media_); m++) {
+        struct Medium const * const pMedium = &media_[m];
+        struct Medium const * const pOther = &media_[(m + 1u) % ARRAY_SIZE(media_)];
+
+        card_reset_(pMedium->cardType);
+        *pMedium->pLastGoodMode = LADDER_STEPS;
+        *pOther->pLastGoodMode = 1u;
+
+        card_.failModes = mode_bits_(pMedium, 0u, 2u);
+        CHECK(init_medium_(pMedium));
+        CHECK_EQUAL(*pMedium->pLastGoodMode, 2u);
+
+        card_.failModes = 0u;
+        CHECK(init_medium_(pMedium));
+        CHECK_EQUAL(card_.numAttempts, 1u);
+        check_attempt_(pMedium, 0u, 2u);
+
+        card_.failModes = mode_bits_(pMedium, 2u, 1u);
+        CHECK(init_medium_(pMedium));
+        CHECK_EQUAL(card_.numAttempts, 2u);
+        check_attempt_(pMedium, 0u, 2u);
+        check_attempt_(pMedium, 1u, 3u);
+        CHECK_EQUAL(*pMedium->pLastGoodMode, 3u);
+        CHECK(!strcmp(mmc_busModeName, pMedium->pLadder[3].pName));
+
+        // each medium remembers its own mode
+        CHECK_EQUAL(*pOther->pLastGoodMode, 1u);
+        CHECK_EQUAL(card_.attemptsWithoutReset, 0u);
+    }
+}
+
+//
+// through HSS_MMCInit(), an eMMC device is found after the SD card ladder is exhausted,
+// and the SD card ladder is tried in full each time, as no SD card mode is remembered
+static void test_bus_mode_via_init(void)
+{
+    size_t sdAttempts;
+
+    card_reset_(MSS_MMC_CARD_TYPE_MMC);
+    card_.failModes = mode_bits_(&media_[0], 0u, 1u);
+    emmcLastGoodBusMode = LADDER_STEPS;
+    sdcardLastGoodBusMode = LADDER_STEPS;
+    mmc_selectedMedium = MMC_SELECT_SDCARD_FALLBACK_EMMC;
+
+    for (unsigned pass = 0u; pass < 2u; pass++) {
+        card_.numAttempts = 0u;
+        sdAttempts = 0u;
+
+        CHECK(HSS_MMCInit());
+        CHECK(mmc_isEMMC);
+        CHECK(!strcmp(mmc_busModeName, "HS200"));
+
+        for (size_t i = 0u; i < MIN(card_.numAttempts, MAX_INIT_ATTEMPTS); i++) {
+            sdAttempts += (card_.attempts[i].cardType == MSS_MMC_CARD_TYPE_SD);
+        }
+
+        CHECK_EQUAL(sdAttempts, LADDER_STEPS + 1u);
+        CHECK_EQUAL(card_.numAttempts - sdAttempts, pass ? 1u : 2u);
+        CHECK_EQUAL(sdcardLastGoodBusMode, LADDER_STEPS);
+        CHECK_EQUAL(emmcLastGoodBusMode, 1u);
+    }
+}
+
+int main(void)
+{
+    RUN_TEST(test_emmc_writes_declare_block_count);
+    RUN_TEST(test_sd_writes_pre_erase_and_stop);
+    RUN_TEST(test_background_write);
+    RUN_TEST(test_read_cache_benchmark);
+    RUN_TEST(test_read_cache_invalidated_by_writes);
+    RUN_TEST(test_bus_mode_ladder_descends);
+    RUN_TEST(test_bus_mode_slowest_retried);
+    RUN_TEST(test_bus_mode_remembered);
+    RUN_TEST(test_bus_mode_via_init);
+
+    return unit_test_report("mmc_api");
+}
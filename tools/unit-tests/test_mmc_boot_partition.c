@@ -0,0 +1,346 @@
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/*!
+ * \file Host unit tests for booting from eMMC hardware boot partitions
+ * \brief Checks that the partition enabled for boot is tried first, that the other is
+ * tried if it has no image or its image fails to load, and that the user data area is
+ * always selected again
+ *
+ * The MMC service is replaced by a model of an eMMC device with a user data area and two
+ * boot partitions, selected through PARTITION_CONFIG.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+
+#include <string.h>
+
+#include "mmc_boot_partition.h"
+#include "unit_test.h"
+
+#define AREA_SIZE               (64u * 1024u)
+#define NUM_AREAS               (3u)
+
+#define PARTITION_ACCESS_MASK   (0x07u)
+#define BOOT_ENABLE_SHIFT       (3u)
+
+//
+// the eMMC model. Areas are indexed by enum HSS_MMC_HWPartition
+static struct {
+    bool isEMMC;
+    size_t bootPartitionSize;
+    uint8_t partitionConfig;
+    uint8_t data[NUM_AREAS][AREA_SIZE] __attribute__((aligned(8)));
+    bool failSelect[NUM_AREAS];
+    bool failRead[NUM_AREAS];
+    unsigned selects;
+    unsigned reads;
+} emmc_;
+
+static enum HSS_MMC_HWPartition selected_(void)
+{
+    return (enum HSS_MMC_HWPartition)(emmc_.partitionConfig & PARTITION_ACCESS_MASK);
+}
+
+bool HSS_MMC_GetBootPartitionInfo(enum HSS_MMC_HWPartition *pPreferred, size_t *pByteCount)
+{
+    bool const result = emmc_.isEMMC && emmc_.bootPartitionSize;
+
+    if (result) {
+        if (((emmc_.partitionConfig >> BOOT_ENABLE_SHIFT) & PARTITION_ACCESS_MASK)
+            == HSS_MMC_PARTITION_BOOT2) {
+            *pPreferred = HSS_MMC_PARTITION_BOOT2;
+        } else {
+            *pPreferred = HSS_MMC_PARTITION_BOOT1;
+        }
+
+        *pByteCount = emmc_.bootPartitionSize;
+    }
+
+    return result;
+}
+
+bool HSS_MMC_SelectHWPartition(enum HSS_MMC_HWPartition partition)
+{
+    bool const result = emmc_.isEMMC && ((unsigned)partition < NUM_AREAS)
+        && !emmc_.failSelect[partition];
+
+    CHECK((unsigned)partition < NUM_AREAS);
+
+    if (result) {
+        emmc_.partitionConfig = (uint8_t)((emmc_.partitionConfig & ~PARTITION_ACCESS_MASK)
+            | partition);
+        emmc_.selects++;
+    }
+
+    return result;
+}
+
+bool HSS_MMC_ReadBlock(void *pDest, size_t srcOffset, size_t byteCount)
+{
+    enum HSS_MMC_HWPartition const partition = selected_();
+    size_t const areaSize = (partition == HSS_MMC_PARTITION_USER) ?
+        AREA_SIZE : emmc_.bootPartitionSize;
+    bool const result = !emmc_.failRead[partition] && (srcOffset + byteCount <= areaSize);
+
+    if (result) {
+        memcpy(pDest, emmc_.data[partition] + srcOffset, byteCount);
+        emmc_.reads++;
+    }
+
+    return result;
+}
+
+//
+// the loader, which reads the image from the selected partition, and rejects those not
+// marked as loadable, as a failed CRC or signature check would
+static struct {
+    bool loadable[NUM_AREAS];
+    unsigned calls;
+    enum HSS_MMC_HWPartition partitions[4];
+    enum HSS_MMC_HWPartition loaded;
+    uint8_t image[AREA_SIZE];
+} loader_;
+
+static struct HSS_BootImage header_ __attribute__((aligned(8)));
+
+static bool load_(void *pContext, enum HSS_MMC_HWPartition partition, size_t partitionSize)
+{
+    CHECK(pContext == &loader_);
+    CHECK_EQUAL(partition, selected_());
+    CHECK_EQUAL(partitionSize, emmc_.bootPartitionSize);
+    CHECK(!memcmp(&header_, emmc_.data[partition], sizeof(header_)));
+
+    if (loader_.calls < ARRAY_SIZE(loader_.partitions)) {
+        loader_.partitions[loader_.calls] = partition;
+    }
+    loader_.calls++;
+
+    bool const result = HSS_MMC_ReadBlock(loader_.image, 0u, partitionSize)
+        && loader_.loadable[partition];
+
+    if (result) {
+        loader_.loaded = partition;
+    }
+
+    return result;
+}
+
+static void write_image_(enum HSS_MMC_HWPartition partition, uint32_t magic)
+{
+    struct HSS_BootImage * const pImage = (struct HSS_BootImage *)emmc_.data[partition];
+
+    for (size_t i = 0u; i < AREA_SIZE; i++) {
+        emmc_.data[partition][i] = (uint8_t)(i * 7u + partition);
+    }
+
+    pImage->magic = magic;
+    pImage->bootImageLength = AREA_SIZE / 2u;
+    loader_.loadable[partition] = true;
+}
+
+//
+// a device booting from the given partition, with the user data area selected, and
+// erased boot partitions
+static void reset_(enum HSS_MMC_HWPartition bootEnable)
+{
+    memset(&emmc_, 0, sizeof(emmc_));
+    memset(&loader_, 0, sizeof(loader_));
+    memset(&header_, 0, sizeof(header_));
+
+    emmc_.isEMMC = true;
+    emmc_.bootPartitionSize = AREA_SIZE;
+    emmc_.partitionConfig = (uint8_t)(bootEnable << BOOT_ENABLE_SHIFT);
+    memset(emmc_.data, 0xFF, sizeof(emmc_.data));
+    loader_.loaded = HSS_MMC_PARTITION_USER;
+}
+
+static void test_enabled_partition_preferred(void)
+{
+    static const enum HSS_MMC_HWPartition enables[] = {
+        HSS_MMC_PARTITION_BOOT1, HSS_MMC_PARTITION_BOOT2,
+    };
+
+    for (size_t i = 0u; i < ARRAY_SIZE(enables); i++) {
+        reset_(enables[i]);
+        write_image_(HSS_MMC_PARTITION_BOOT1, mHSS_BOOT_MAGIC);
+        write_image_(HSS_MMC_PARTITION_BOOT2, mHSS_BOOT_MAGIC);
+
+        CHECK(HSS_MMC_BootFromBootPartition(&header_, load_, &loader_));
+        CHECK_EQUAL(loader_.calls, 1u);
+        CHECK_EQUAL(loader_.loaded, enables[i]);
+        CHECK(!memcmp(loader_.image, emmc_.data[enables[i]], AREA_SIZE));
+        CHECK_EQUAL(selected_(), HSS_MMC_PARTITION_USER);
+        CHECK_EQUAL(emmc_.selects, 2u);
+    }
+
+    //
+    // BOOT1 is preferred if neither boot partition is enabled, or the user data area is
+    reset_(HSS_MMC_PARTITION_USER);
+    write_image_(HSS_MMC_PARTITION_BOOT1, mHSS_BOOT_MAGIC);
+    write_image_(HSS_MMC_PARTITION_BOOT2, mHSS_BOOT_MAGIC);
+    CHECK(HSS_MMC_BootFromBootPartition(&header_, load_, &loader_));
+    CHECK_EQUAL(loader_.loaded, HSS_MMC_PARTITION_BOOT1);
+
+    reset_((enum HSS_MMC_HWPartition)7);
+    write_image_(HSS_MMC_PARTITION_BOOT1, mHSS_BOOT_MAGIC);
+    write_image_(HSS_MMC_PARTITION_BOOT2, mHSS_BOOT_MAGIC);
+    CHECK(HSS_MMC_BootFromBootPartition(&header_, load_, &loader_));
+    CHECK_EQUAL(loader_.loaded, HSS_MMC_PARTITION_BOOT1);
+    CHECK_EQUAL(selected_(), HSS_MMC_PARTITION_USER);
+    CHECK_EQUAL(emmc_.partitionConfig >> BOOT_ENABLE_SHIFT, 7u);
+}
+
+static void test_compressed_image_accepted(void)
+{
+    reset_(HSS_MMC_PARTITION_BOOT2);
+    write_image_(HSS_MMC_PARTITION_BOOT2, mHSS_COMPRESSED_MAGIC);
+
+    CHECK(HSS_MMC_BootFromBootPartition(&header_, load_, &loader_));
+    CHECK_EQUAL(loader_.loaded, HSS_MMC_PARTITION_BOOT2);
+    CHECK_EQUAL(header_.magic, mHSS_COMPRESSED_MAGIC);
+}
+
+//
+// each way the enabled partition can fail, with a good image in the other
+enum Fault {
+    FAULT_EMPTY,
+    FAULT_BAD_MAGIC,
+    FAULT_LOAD,
+    FAULT_SELECT,
+    FAULT_READ,
+    NUM_FAULTS
+};
+
+static void inject_(enum HSS_MMC_HWPartition partition, enum Fault fault)
+{
+    switch (fault) {
+    case FAULT_EMPTY:
+        break;
+
+    case FAULT_BAD_MAGIC:
+        write_image_(partition, mHSS_BOOT_MAGIC ^ 1u);
+        break;
+
+    case FAULT_LOAD:
+        write_image_(partition, mHSS_BOOT_MAGIC);
+        loader_.loadable[partition] = false;
+        break;
+
+    case FAULT_SELECT:
+        write_image_(partition, mHSS_BOOT_MAGIC);
+        emmc_.failSelect[partition] = true;
+        break;
+
+    case FAULT_READ:
+        write_image_(partition, mHSS_BOOT_MAGIC);
+        emmc_.failRead[partition] = true;
+        break;
+
+    default:
+        CHECK(false);
+        break;
+    }
+}
+
+static void test_fallback_to_other_partition(void)
+{
+    static const enum HSS_MMC_HWPartition enables[] = {
+        HSS_MMC_PARTITION_BOOT1, HSS_MMC_PARTITION_BOOT2,
+    };
+
+    for (size_t i = 0u; i < ARRAY_SIZE(enables); i++) {
+        enum HSS_MMC_HWPartition const other = (enables[i] == HSS_MMC_PARTITION_BOOT1) ?
+            HSS_MMC_PARTITION_BOOT2 : HSS_MMC_PARTITION_BOOT1;
+
+        for (unsigned fault = 0u; fault < NUM_FAULTS; fault++) {
+            reset_(enables[i]);
+            inject_(enables[i], (enum Fault)fault);
+            write_image_(other, mHSS_BOOT_MAGIC);
+
+            CHECK(HSS_MMC_BootFromBootPartition(&header_, load_, &loader_));
+            CHECK_EQUAL(loader_.loaded, other);
+            CHECK(!memcmp(loader_.image, emmc_.data[other], AREA_SIZE));
+            CHECK_EQUAL(selected_(), HSS_MMC_PARTITION_USER);
+
+            // only an image with a valid header is passed to the loader
+            CHECK_EQUAL(loader_.calls, (fault == FAULT_LOAD) ? 2u : 1u);
+            CHECK_EQUAL(loader_.partitions[MAX(loader_.calls, 1u) - 1u], other);
+        }
+    }
+}
+
+static void test_no_valid_image(void)
+{
+    for (unsigned fault1 = 0u; fault1 < NUM_FAULTS; fault1++) {
+        for (unsigned fault2 = 0u; fault2 < NUM_FAULTS; fault2++) {
+            reset_(HSS_MMC_PARTITION_BOOT1);
+            inject_(HSS_MMC_PARTITION_BOOT1, (enum Fault)fault1);
+            inject_(HSS_MMC_PARTITION_BOOT2, (enum Fault)fault2);
+
+            CHECK(!HSS_MMC_BootFromBootPartition(&header_, load_, &loader_));
+            CHECK_EQUAL(loader_.loaded, HSS_MMC_PARTITION_USER);
+            CHECK_EQUAL(loader_.calls,
+                (unsigned)(fault1 == FAULT_LOAD) + (unsigned)(fault2 == FAULT_LOAD));
+
+            // each boot partition is tried once, and the user data area is left selected
+            CHECK(emmc_.selects <= 3u);
+            CHECK_EQUAL(selected_(), HSS_MMC_PARTITION_USER);
+        }
+    }
+}
+
+static void test_user_area_restore_failure(void)
+{
+    //
+    // an image loaded from a boot partition is not used if the user data area cannot be
+    // selected again, as later reads would be from the wrong partition
+    reset_(HSS_MMC_PARTITION_BOOT1);
+    write_image_(HSS_MMC_PARTITION_BOOT1, mHSS_BOOT_MAGIC);
+    emmc_.failSelect[HSS_MMC_PARTITION_USER] = true;
+
+    CHECK(!HSS_MMC_BootFromBootPartition(&header_, load_, &loader_));
+    CHECK_EQUAL(loader_.calls, 1u);
+    CHECK_EQUAL(selected_(), HSS_MMC_PARTITION_BOOT1);
+}
+
+static void test_no_boot_partitions(void)
+{
+    //
+    // SD cards, and eMMC devices without boot partitions, are left alone
+    reset_(HSS_MMC_PARTITION_BOOT1);
+    write_image_(HSS_MMC_PARTITION_BOOT1, mHSS_BOOT_MAGIC);
+    emmc_.isEMMC = false;
+
+    CHECK(!HSS_MMC_BootFromBootPartition(&header_, load_, &loader_));
+    CHECK_EQUAL(emmc_.selects, 0u);
+    CHECK_EQUAL(emmc_.reads, 0u);
+
+    reset_(HSS_MMC_PARTITION_BOOT1);
+    write_image_(HSS_MMC_PARTITION_BOOT1, mHSS_BOOT_MAGIC);
+    emmc_.bootPartitionSize = 0u;
+
+    CHECK(!HSS_MMC_BootFromBootPartition(&header_, load_, &loader_));
+    CHECK_EQUAL(emmc_.selects, 0u);
+    CHECK_EQUAL(emmc_.reads, 0u);
+    CHECK_EQUAL(loader_.calls, 0u);
+}
+
+int main(void)
+{
+    RUN_TEST(test_enabled_partition_preferred);
+    RUN_TEST(test_compressed_image_accepted);
+    RUN_TEST(test_fallback_to_other_partition);
+    RUN_TEST(test_no_valid_image);
+    RUN_TEST(test_user_area_restore_failure);
+    RUN_TEST(test_no_boot_partitions);
+
+    return unit_test_report("mmc_boot_partition");
+}
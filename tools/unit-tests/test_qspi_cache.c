@@ -0,0 +1,1253 @@
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/*!
+ * \file Host unit tests for the QSPI NAND block cache
+ * \brief Checks the QSPI service against an in-memory model of the Winbond W25N01GV,
+ * for data integrity and cache hit rates under random read and write workloads, and
+ * for the cost of flushing sparse updates, for the latency a background flush adds to
+ * each pass of the superloop, for the IO format switches and commands of uncached reads,
+ * and for how erases are spread over the device by long runs
+ * of updates. It is built without wear levelling, and with each kind of wear levelling,
+ * when it also checks that the wear levelling and bad block tables survive power losses
+ *
+ * qspi_api.c is included rather than linked, so that the test can restart it as a
+ * power cycle would, and inspect its state. Time is simulated from a model of the flash's
+ * timings, not measured.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "qspi_api.c"
+#include "unit_test.h"
+
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_STATIC_WEAR_LEVELLING)
+#  define WEAR_LEVELLING "static and dynamic wear levelling"
+#elif IS_ENABLED(CONFIG_SERVICE_QSPI_WEAR_LEVELLING)
+#  define WEAR_LEVELLING "dynamic wear levelling"
+#else
+#  define WEAR_LEVELLING "no wear levelling"
+#endif
+
+//
+// the W25N01GV: 1Gbit, as 1024 blocks of 64 pages of 2KiB
+#define NAND_PAGE_SIZE          (2048u)
+#define NAND_PAGES_PER_BLOCK    (64u)
+#define NAND_NUM_BLOCKS         (1024u)
+#define NAND_BLOCK_SIZE         (NAND_PAGE_SIZE * NAND_PAGES_PER_BLOCK)
+#define NAND_SIZE               (NAND_BLOCK_SIZE * NAND_NUM_BLOCKS)
+
+#define DDR_SIZE                ((QSPI_CACHE_NUM_BLOCKS * NAND_BLOCK_SIZE) + (1024u * 1024u))
+
+//
+// the timing model, from the W25N01GV's typical timings, with the controller clocked at
+// 50MHz: a page read into the flash's buffer takes tRD, a page program tPROG, and a block
+// erase tBERS. Reads transfer data in the current IO format, but page program data is
+// always loaded on one line, as the driver uses the x1 Load Program Data command. The
+// flash accepts only status polls while programming or erasing. Switching the IO format
+// resets the flash, taking tRST, and rewrites its configuration
+#define NAND_T_RD_US            (25u)
+#define NAND_T_PROG_US          (250u)
+#define NAND_T_BERS_US          (2000u)
+#define NAND_COMMAND_US         (1u)
+#define NAND_POLL_US            (1u)
+#define NAND_T_RST_US           (5u)
+#define QSPI_QUAD_BYTES_PER_US  (25u)
+#define QSPI_BYTES_PER_US       (6u)
+
+//
+// the logical blocks that the workloads use, which are given known contents at the start
+#define WORKING_BLOCKS          (128u)
+#define SECTOR_SIZE             (512u)
+
+static uint8_t nandData_[NAND_SIZE] __attribute__((aligned(8)));
+static uint8_t ddr_[DDR_SIZE] __attribute__((aligned(64)));
+static uint8_t shadow_[WORKING_BLOCKS * NAND_BLOCK_SIZE] __attribute__((aligned(8)));
+static uint8_t buffer_[256u * 1024u] __attribute__((aligned(8)));
+
+//
+// blocks marked bad at the factory
+static const uint16_t factoryBadBlocks_[] = { 5u, 77u, 300u };
+
+static struct {
+    mss_qspi_io_format format;
+    unsigned modeSwitches;
+    unsigned commands;          // commands other than status polls
+    unsigned reads;             // read commands, one per call
+    unsigned blockReads;        // reads of a whole block, as the cache makes on a miss
+    size_t bytesRead;
+    unsigned erases;
+    unsigned pagePrograms;
+    unsigned scans;
+    unsigned misalignedReads;
+    unsigned overwrites;        // pages programmed without an erase since they were last
+    unsigned badPolls;          // polls for an operation other than the one started
+    uint16_t eraseLog[64];      // the first blocks erased
+    uint32_t blockErases[NAND_NUM_BLOCKS];
+    unsigned flashOps;          // erases and page programs started
+    unsigned powerFailOp;       // the one cut short by a power loss, or zero for none
+    uint64_t nowUs;
+    uint64_t busyUntilUs;       // the end of the program or erase in progress
+    unsigned busyCommands;      // commands other than status polls while busy
+} nand_;
+
+static void command_(size_t byteCount, unsigned bytesPerUs)
+{
+    if (nand_.nowUs < nand_.busyUntilUs) {
+        nand_.busyCommands++;
+    }
+
+    nand_.commands++;
+    nand_.nowUs += NAND_COMMAND_US + (byteCount / bytesPerUs);
+}
+
+static unsigned read_bytes_per_us_(void)
+{
+    return (nand_.format == MSS_QSPI_NORMAL) ? QSPI_BYTES_PER_US : QSPI_QUAD_BYTES_PER_US;
+}
+
+static bool page_is_erased_(uint32_t page)
+{
+    static uint8_t erasedPage[NAND_PAGE_SIZE];
+
+    if (erasedPage[0] != 0xFFu) {
+        memset(erasedPage, 0xFF, sizeof(erasedPage));
+    }
+
+    return !memcmp(nandData_ + ((size_t)page * NAND_PAGE_SIZE), erasedPage, NAND_PAGE_SIZE);
+}
+
+static bool is_factory_bad_(uint32_t block)
+{
+    bool result = false;
+
+    for (size_t i = 0u; i < ARRAY_SIZE(factoryBadBlocks_); i++) {
+        result |= (factoryBadBlocks_[i] == block);
+    }
+
+    return result;
+}
+
+//
+// how much of an erase or page program of size bytes is done: all of it, the first half
+// if the power is lost part way through it, and none once the power has been lost. The
+// code under test sees it succeed in each case, as it would stop running on real hardware
+static size_t power_loss_size_(size_t size)
+{
+    size_t result = size;
+
+    nand_.flashOps++;
+    if (!nand_.powerFailOp || (nand_.flashOps < nand_.powerFailOp)) {
+        ;
+    } else if (nand_.flashOps == nand_.powerFailOp) {
+        result = size / 2u;
+    } else {
+        result = 0u;
+    }
+
+    return result;
+}
+
+static uint8_t erase_(uint32_t block)
+{
+    uint8_t status = 1u;
+
+    if ((block < NAND_NUM_BLOCKS) && !is_factory_bad_(block)) {
+        size_t const size = power_loss_size_(NAND_BLOCK_SIZE);
+
+        memset(nandData_ + ((size_t)block * NAND_BLOCK_SIZE), 0xFF, size);
+        if (size == NAND_BLOCK_SIZE) {
+            if (nand_.erases < ARRAY_SIZE(nand_.eraseLog)) {
+                nand_.eraseLog[nand_.erases] = (uint16_t)block;
+            }
+            nand_.erases++;
+            nand_.blockErases[block]++;
+        }
+        status = 0u;
+    }
+
+    return status;
+}
+
+//
+// NAND programming can only clear bits
+static uint8_t program_page_(uint8_t const *pSrc, uint32_t page, uint32_t len)
+{
+    uint8_t status = 1u;
+
+    if ((page < (NAND_NUM_BLOCKS * NAND_PAGES_PER_BLOCK))
+        && !is_factory_bad_(page / NAND_PAGES_PER_BLOCK) && (len <= NAND_PAGE_SIZE)) {
+        uint8_t * const pPage = nandData_ + ((size_t)page * NAND_PAGE_SIZE);
+        size_t const size = power_loss_size_(len);
+
+        if (size && !page_is_erased_(page)) {
+            nand_.overwrites++;
+        }
+
+        for (size_t i = 0u; i < size; i++) {
+            pPage[i] &= pSrc[i];
+        }
+
+        if (size == len) {
+            nand_.pagePrograms++;
+        }
+        status = 0u;
+    }
+
+    return status;
+}
+
+//
+// as the driver: a device reset, then a read and a write of status register 2
+void Flash_init(mss_qspi_io_format io_format)
+{
+    command_(0u, 1u);
+    nand_.nowUs += NAND_T_RST_US;
+    command_(1u, QSPI_BYTES_PER_US);
+    command_(1u, QSPI_BYTES_PER_US);
+    nand_.format = io_format;
+    nand_.modeSwitches++;
+}
+
+void Flash_readid(uint8_t *buf)
+{
+    buf[0] = 0xEFu;
+    buf[1] = 0xAAu;
+    buf[2] = 0x21u;
+}
+
+//
+// as the driver, reads start at a page boundary
+uint8_t Flash_read(uint8_t *buf, uint32_t addr, uint32_t len)
+{
+    uint8_t status = 1u;
+
+    if (addr % NAND_PAGE_SIZE) {
+        nand_.misalignedReads++;
+    } else if ((addr <= NAND_SIZE) && (len <= (NAND_SIZE - addr))) {
+        memcpy(buf, nandData_ + addr, len);
+        status = 0u;
+    }
+
+    for (size_t offset = 0u; offset < len; offset += NAND_PAGE_SIZE) {
+        command_(0u, 1u);
+        nand_.nowUs += NAND_T_RD_US;
+        command_(MIN(len - offset, NAND_PAGE_SIZE), read_bytes_per_us_());
+    }
+
+    nand_.reads++;
+    nand_.bytesRead += len;
+    if (len == NAND_BLOCK_SIZE) {
+        nand_.blockReads++;
+    }
+
+    return status;
+}
+
+uint8_t Flash_erase_block(uint16_t block_nb)
+{
+    command_(0u, 1u);
+    nand_.nowUs += NAND_T_BERS_US;
+
+    return erase_(block_nb);
+}
+
+//
+// as the driver, programming starts at the beginning of the page holding addr
+uint8_t Flash_program(uint8_t *buf, uint32_t addr, uint32_t len)
+{
+    uint8_t status = 0u;
+
+    for (uint32_t page = addr / NAND_PAGE_SIZE; len; page++) {
+        uint32_t const size = MIN(len, NAND_PAGE_SIZE);
+
+        command_(size, QSPI_BYTES_PER_US);
+        nand_.nowUs += NAND_T_PROG_US;
+        status = program_page_(buf, page, size);
+        buf += size;
+        len -= size;
+    }
+
+    return status;
+}
+
+static struct {
+    bool erase;
+    uint8_t status;
+} op_;
+
+uint8_t Flash_erase_block_start(uint16_t block_nb)
+{
+    command_(0u, 1u);
+    nand_.busyUntilUs = nand_.nowUs + NAND_T_BERS_US;
+    op_.erase = true;
+    op_.status = erase_(block_nb);
+
+    return 0u;
+}
+
+void Flash_program_page_start(uint8_t const * const buf, uint32_t page, uint32_t len)
+{
+    command_(len, QSPI_BYTES_PER_US);
+    nand_.busyUntilUs = nand_.nowUs + NAND_T_PROG_US;
+    op_.erase = false;
+    op_.status = program_page_(buf, page, len);
+}
+
+static bool poll_(bool erase, uint8_t *pStatus)
+{
+    if (op_.erase != erase) {
+        nand_.badPolls++;
+    }
+
+    nand_.nowUs += NAND_POLL_US;
+    *pStatus = op_.status;
+
+    return (nand_.nowUs >= nand_.busyUntilUs);
+}
+
+bool Flash_poll_erase_complete(uint8_t *pStatus)
+{
+    return poll_(true, pStatus);
+}
+
+bool Flash_poll_program_complete(uint8_t *pStatus)
+{
+    return poll_(false, pStatus);
+}
+
+//
+// no parameter page, so that the flash is identified by its JEDEC ID
+uint8_t Flash_read_parameter_page(uint8_t *buf, uint16_t offset, uint32_t len)
+{
+    (void)buf;
+    (void)offset;
+    (void)len;
+
+    return 1u;
+}
+
+uint32_t Flash_scan_for_bad_blocks(uint16_t *buf)
+{
+    nand_.scans++;
+    memcpy(buf, factoryBadBlocks_, sizeof(factoryBadBlocks_));
+
+    return ARRAY_SIZE(factoryBadBlocks_);
+}
+
+uint8_t mss_config_clk_rst(mss_peripherals peripheral, uint8_t hart, PERIPH_RESET_STATE req_state)
+{
+    (void)peripheral;
+    (void)hart;
+    (void)req_state;
+
+    return 0u;
+}
+
+void clear_bootup_cache_ways(void)
+{
+}
+
+uintptr_t HSS_DDR_GetStart(void)
+{
+    return (uintptr_t)ddr_;
+}
+
+void HSS_ShowProgress(const size_t totalNumTasks, const size_t numTasksRemaining)
+{
+    (void)totalNumTasks;
+    (void)numTasksRemaining;
+}
+
+void RunStateMachine(struct StateMachine * const pCurrentMachine)
+{
+    pCurrentMachine->pStateDescs[pCurrentMachine->state].state_handler(pCurrentMachine);
+}
+
+//
+// xorshift, so that the workloads are the same from run to run
+static uint32_t random_state_ = 0x51CA0E11u;
+
+static uint32_t random_(void)
+{
+    random_state_ ^= random_state_ << 13;
+    random_state_ ^= random_state_ >> 17;
+    random_state_ ^= random_state_ << 5;
+
+    return random_state_;
+}
+
+static void fill_random_(uint8_t *pData, size_t length)
+{
+    for (size_t i = 0u; i < length; i += sizeof(uint32_t)) {
+        uint32_t const value = random_();
+        memcpy(pData + i, &value, MIN(length - i, sizeof(value)));
+    }
+}
+
+//
+// restarts the QSPI service as a power cycle would, with its state back at its initial
+// values and DDR holding garbage
+static void power_cycle_(void)
+{
+    qspiInitialized = false;
+    currentFormatValid_ = false;
+    numBadBlocks = 0u;
+    cacheUseCounter_ = 0u;
+    cacheDirtyFlag = false;
+    writeBack_.requested = false;
+    writeBack_.pEntry = NULL;
+    writeBack_.opComplete = true;
+    qspi_service.state = QSPI_IDLE;
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_BAD_BLOCK_TABLE)
+    memset(bbtBlocks_, 0, sizeof(bbtBlocks_));
+    memset(bbtCopySequence_, 0, sizeof(bbtCopySequence_));
+#endif
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_WEAR_LEVELLING)
+    wlActiveMeta_ = 0u;
+    wlNextSlot_ = 0u;
+    wlTableDirty_ = false;
+    wlStaticMove_.pending = false;
+#  if IS_ENABLED(CONFIG_SERVICE_QSPI_STATIC_WEAR_LEVELLING)
+    wlStaticMoveDone_ = false;
+#  endif
+#endif
+    nand_.busyUntilUs = nand_.nowUs;
+    nand_.powerFailOp = 0u;
+
+    memset(ddr_, 0x5A, sizeof(ddr_));
+
+    CHECK(HSS_QSPIInit());
+}
+
+//
+// a freshly formatted device, with known contents in the working blocks, which are
+// copied to the shadow. Logical blocks are the good physical blocks in order
+static void format_(void)
+{
+    memset(nandData_, 0xFF, sizeof(nandData_));
+
+    for (uint32_t logicalBlock = 0u, physicalBlock = 0u; logicalBlock < WORKING_BLOCKS;
+        physicalBlock++) {
+        if (!is_factory_bad_(physicalBlock)) {
+            uint8_t * const pShadow = shadow_ + ((size_t)logicalBlock * NAND_BLOCK_SIZE);
+
+            fill_random_(pShadow, NAND_BLOCK_SIZE);
+            memcpy(nandData_ + ((size_t)physicalBlock * NAND_BLOCK_SIZE), pShadow,
+                NAND_BLOCK_SIZE);
+            logicalBlock++;
+        }
+    }
+
+    power_cycle_();
+
+    // the flash keeps the IO format it was left in
+    mss_qspi_io_format const format = nand_.format;
+    memset(&nand_, 0, sizeof(nand_));
+    nand_.format = format;
+}
+
+static void flush_(void)
+{
+    HSS_CachedQSPI_FlushWriteBuffer();
+    while (!HSS_CachedQSPI_IsWriteBackComplete()) {
+        RunStateMachine(&qspi_service);
+    }
+}
+
+//
+// checks every working block, read through the cache and directly from flash
+static bool working_blocks_match_(void)
+{
+    bool result = true;
+
+    for (size_t offset = 0u; result && (offset < sizeof(shadow_)); offset += sizeof(buffer_)) {
+        result = HSS_CachedQSPI_ReadBlock(buffer_, offset, sizeof(buffer_))
+            && !memcmp(buffer_, shadow_ + offset, sizeof(buffer_));
+    }
+
+    for (size_t offset = 0u; result && (offset < sizeof(shadow_)); offset += sizeof(buffer_)) {
+        result = HSS_QSPI_ReadBlock(buffer_, offset, sizeof(buffer_))
+            && !memcmp(buffer_, shadow_ + offset, sizeof(buffer_));
+    }
+
+    return result;
+}
+
+//
+// random sector-aligned reads and writes, as a USB host makes, over workingSetBlocks
+// logical blocks. Returns the cache hit rate, in percent, over the second half of the
+// workload, once the cache has warmed up
+static unsigned run_workload_(size_t workingSetBlocks, unsigned operations,
+    unsigned writePercent, unsigned *pMismatches)
+{
+    size_t const workingSetSize = workingSetBlocks * NAND_BLOCK_SIZE;
+    unsigned lookups = 0u, misses = 0u;
+
+    for (unsigned op = 0u; op < operations; op++) {
+        size_t const size = SECTOR_SIZE * (1u + (random_() % 128u));
+        size_t const offset = SECTOR_SIZE * (random_() % ((workingSetSize - size) / SECTOR_SIZE));
+        unsigned const blockReadsBefore = nand_.blockReads;
+
+        if ((random_() % 100u) < writePercent) {
+            fill_random_(buffer_, size);
+            memcpy(shadow_ + offset, buffer_, size);
+            CHECK(HSS_CachedQSPI_WriteBlock(offset, buffer_, size));
+        } else {
+            CHECK(HSS_CachedQSPI_ReadBlock(buffer_, offset, size));
+            *pMismatches += (memcmp(buffer_, shadow_ + offset, size) != 0);
+        }
+
+        if (op >= (operations / 2u)) {
+            lookups += (unsigned)(((offset + size - 1u) / NAND_BLOCK_SIZE)
+                - (offset / NAND_BLOCK_SIZE) + 1u);
+            misses += nand_.blockReads - blockReadsBefore;
+        }
+
+        // the USB host disconnects from time to time
+        if ((random_() % 64u) == 0u) {
+            flush_();
+        }
+    }
+
+    return lookups ? (100u * (lookups - misses)) / lookups : 0u;
+}
+
+static void test_random_workloads_keep_data(void)
+{
+    unsigned mismatches = 0u;
+
+    format_();
+    CHECK(working_blocks_match_());
+
+    (void)run_workload_(WORKING_BLOCKS, 4000u, 50u, &mismatches);
+    flush_();
+
+    CHECK_EQUAL(mismatches, 0u);
+    CHECK(working_blocks_match_());
+    CHECK_EQUAL(nand_.misalignedReads, 0u);
+    CHECK_EQUAL(nand_.overwrites, 0u);
+    CHECK_EQUAL(nand_.badPolls, 0u);
+    CHECK_EQUAL(nand_.busyCommands, 0u);
+
+    // and the data is in flash, not only in the cache
+    power_cycle_();
+    CHECK(working_blocks_match_());
+
+    //
+    // writes not yet flushed are read back from the cache, even across evictions
+    unsigned const erasesBefore = nand_.erases;
+    (void)run_workload_(WORKING_BLOCKS, 500u, 100u, &mismatches);
+    CHECK(nand_.erases > erasesBefore); // evictions wrote back dirty blocks
+    CHECK_EQUAL(mismatches, 0u);
+    flush_();
+    power_cycle_();
+    CHECK(working_blocks_match_());
+    CHECK_EQUAL(nand_.overwrites, 0u);
+}
+
+static void test_hit_rates(void)
+{
+    static const size_t workingSets[] = {
+        QSPI_CACHE_NUM_BLOCKS / 2u, QSPI_CACHE_NUM_BLOCKS, QSPI_CACHE_NUM_BLOCKS * 2u,
+        QSPI_CACHE_NUM_BLOCKS * 4u, WORKING_BLOCKS
+    };
+    unsigned hitRates[ARRAY_SIZE(workingSets)];
+    unsigned mismatches = 0u;
+
+    printf("  %u blocks in %u-way sets:\n", QSPI_CACHE_NUM_BLOCKS, QSPI_CACHE_NUM_WAYS);
+
+    for (size_t i = 0u; i < ARRAY_SIZE(workingSets); i++) {
+        format_();
+        hitRates[i] = run_workload_(workingSets[i], 2000u, 30u, &mismatches);
+
+        printf("    %3zu block working set: %3u%% hits, %u block reads, %u erases\n",
+            workingSets[i], hitRates[i], nand_.blockReads, nand_.erases);
+    }
+
+    CHECK_EQUAL(mismatches, 0u);
+
+    //
+    // a working set that fits misses only while the cache warms up, and hit rates fall
+    // as the working set grows
+    CHECK_EQUAL(hitRates[0], 100u);
+    CHECK_EQUAL(hitRates[1], 100u);
+    for (size_t i = 1u; i < ARRAY_SIZE(workingSets); i++) {
+        CHECK(hitRates[i] <= hitRates[i - 1u]);
+    }
+    CHECK(hitRates[ARRAY_SIZE(workingSets) - 1u] < 50u);
+}
+
+//
+// blocks QSPI_CACHE_NUM_SETS apart share a set, and the least recently used is evicted
+static void test_lru_replacement(void)
+{
+    uint8_t sector[SECTOR_SIZE];
+    uint32_t const stride = QSPI_CACHE_NUM_SETS * NAND_BLOCK_SIZE;
+
+    format_();
+
+    for (uint32_t way = 0u; way < QSPI_CACHE_NUM_WAYS; way++) {
+        CHECK(HSS_CachedQSPI_ReadBlock(sector, way * stride, sizeof(sector)));
+    }
+    CHECK_EQUAL(nand_.blockReads, QSPI_CACHE_NUM_WAYS);
+
+    // use the oldest again, so that the second oldest is evicted by the next block
+    CHECK(HSS_CachedQSPI_ReadBlock(sector, 0u, sizeof(sector)));
+    CHECK(HSS_CachedQSPI_ReadBlock(sector, QSPI_CACHE_NUM_WAYS * stride, sizeof(sector)));
+    CHECK_EQUAL(nand_.blockReads, QSPI_CACHE_NUM_WAYS + 1u);
+
+    CHECK(HSS_CachedQSPI_ReadBlock(sector, 0u, sizeof(sector)));
+    CHECK_EQUAL(nand_.blockReads, QSPI_CACHE_NUM_WAYS + 1u);
+    CHECK(HSS_CachedQSPI_ReadBlock(sector, stride, sizeof(sector)));
+    CHECK_EQUAL(nand_.blockReads, QSPI_CACHE_NUM_WAYS + 2u);
+}
+
+//
+// the flush before dirty blocks were tracked: a scan of a descriptor for every block
+static struct {
+    bool dirtyCache;
+    bool inCache;
+} blockDescs_[NAND_NUM_BLOCKS];
+
+static size_t scan_block_descs_(void)
+{
+    size_t written = 0u;
+
+    for (size_t i = 0u; i < ARRAY_SIZE(blockDescs_); i++) {
+        if (blockDescs_[i].dirtyCache) {
+            blockDescs_[i].dirtyCache = false;
+            written++;
+        }
+    }
+
+    return written;
+}
+
+static size_t walk_dirty_bitmap_(void)
+{
+    size_t written = 0u;
+    uint32_t logicalBlock;
+
+    while (find_next_dirty_block_(&logicalBlock)) {
+        mark_block_clean_(logicalBlock);
+        written++;
+    }
+
+    return written;
+}
+
+static double elapsed_ns_(struct timespec const *pStart, struct timespec const *pEnd)
+{
+    return ((double)(pEnd->tv_sec - pStart->tv_sec) * 1e9) + (double)(pEnd->tv_nsec - pStart->tv_nsec);
+}
+
+//
+// sparse updates of a few sectors across the whole 1Gbit device. Each flush erases and
+// programs only the dirty blocks, in ascending order, and finding them costs a bitmap
+// word per block rather than a visit to every block. This is built with the
+// sanitizers, so only the relative times are meaningful
+static void test_sparse_update_flush(void)
+{
+    static const unsigned dirtyCounts[] = { 1u, 2u, 4u, 8u, QSPI_CACHE_NUM_BLOCKS };
+    const unsigned passes = 2000u;
+    uint8_t sector[SECTOR_SIZE];
+
+    printf("  %8s %8s %12s %12s %14s %14s\n", "dirty", "erases", "words", "descriptors",
+        "bitmap ns", "scan ns");
+
+    for (size_t i = 0u; i < ARRAY_SIZE(dirtyCounts); i++) {
+        unsigned const dirtyCount = dirtyCounts[i];
+        uint32_t blocks[QSPI_CACHE_NUM_BLOCKS];
+
+        format_();
+
+        //
+        // no more blocks in a set than it has ways, so that nothing is evicted before the
+        // flush
+        for (unsigned d = 0u; d < dirtyCount; d++) {
+            uint32_t const set = d % QSPI_CACHE_NUM_SETS;
+            uint32_t const spread = (blockCount - set - 1u) / QSPI_CACHE_NUM_SETS;
+            bool duplicate;
+
+            do {
+                blocks[d] = set + (QSPI_CACHE_NUM_SETS * (random_() % spread));
+                duplicate = false;
+                for (unsigned e = 0u; e < d; e++) {
+                    duplicate |= (blocks[e] == blocks[d]);
+                }
+            } while (duplicate);
+
+            fill_random_(sector, sizeof(sector));
+            CHECK(HSS_CachedQSPI_WriteBlock(blocks[d] * NAND_BLOCK_SIZE, sector, sizeof(sector)));
+        }
+        CHECK_EQUAL(dirtyBlockCount_, dirtyCount);
+
+        //
+        // the words of the bitmap that are read, from the start of the bitmap to each
+        // dirty block in turn, against every descriptor
+        size_t words = 0u;
+        for (unsigned d = 0u; d < dirtyCount; d++) {
+            words += (blocks[d] / BITS_PER_LONG) + 1u;
+        }
+
+        flush_();
+        CHECK_EQUAL(nand_.erases, dirtyCount);
+        for (unsigned d = 1u; d < dirtyCount; d++) {
+            CHECK(nand_.eraseLog[d] > nand_.eraseLog[d - 1u]);
+        }
+
+        struct timespec start, mid, end;
+        size_t bitmapWritten = 0u, scanWritten = 0u;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (unsigned pass = 0u; pass < passes; pass++) {
+            for (unsigned d = 0u; d < dirtyCount; d++) {
+                mark_block_dirty_(blocks[d]);
+            }
+            bitmapWritten += walk_dirty_bitmap_();
+        }
+        clock_gettime(CLOCK_MONOTONIC, &mid);
+        for (unsigned pass = 0u; pass < passes; pass++) {
+            for (unsigned d = 0u; d < dirtyCount; d++) {
+                blockDescs_[logical_to_physical_block_(blocks[d])].dirtyCache = true;
+            }
+            scanWritten += scan_block_descs_();
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        CHECK_EQUAL(bitmapWritten, (size_t)passes * dirtyCount);
+        CHECK_EQUAL(scanWritten, (size_t)passes * dirtyCount);
+        CHECK(words < ARRAY_SIZE(blockDescs_));
+
+        printf("  %8u %8u %12zu %12zu %14.0f %14.0f\n", dirtyCount, nand_.erases, words,
+            ARRAY_SIZE(blockDescs_), elapsed_ns_(&start, &mid) / passes,
+            elapsed_ns_(&mid, &end) / passes);
+    }
+}
+
+//
+// the rest of the superloop, between runs of the QSPI write-back state machine
+#define OTHER_SERVICES_US       (20u)
+
+static unsigned dirty_half_the_cache_(void)
+{
+    uint8_t sector[SECTOR_SIZE];
+    unsigned dirtyCount = 0u;
+
+    //
+    // in each set, two clean blocks, and then two dirty blocks, so that the clean blocks
+    // are the least recently used
+    for (uint32_t way = 0u; way < QSPI_CACHE_NUM_WAYS; way++) {
+        for (uint32_t set = 0u; set < QSPI_CACHE_NUM_SETS; set++) {
+            size_t const offset = ((way * QSPI_CACHE_NUM_SETS) + set) * NAND_BLOCK_SIZE;
+
+            if (way < (QSPI_CACHE_NUM_WAYS / 2u)) {
+                CHECK(HSS_CachedQSPI_ReadBlock(sector, offset, sizeof(sector)));
+            } else {
+                fill_random_(sector, sizeof(sector));
+                memcpy(shadow_ + offset, sector, sizeof(sector));
+                CHECK(HSS_CachedQSPI_WriteBlock(offset, sector, sizeof(sector)));
+                dirtyCount++;
+            }
+        }
+    }
+
+    return dirtyCount;
+}
+
+//
+// each run of the write-back state machine starts at most one erase or page program, and
+// polls the flash once, so the superloop is not held up for the whole flush as it was
+// when the flush was synchronous. A cache miss during the flush waits only for the
+// flash operation in progress
+static void test_flush_latency(void)
+{
+    uint8_t sector[SECTOR_SIZE];
+
+    format_();
+    unsigned const dirtyCount = dirty_half_the_cache_();
+    uint64_t const start = nand_.nowUs;
+    uint64_t maxIterationUs = 0u, missUs = 0u;
+    unsigned iterations = 0u;
+
+    HSS_CachedQSPI_FlushWriteBuffer();
+    while (!HSS_CachedQSPI_IsWriteBackComplete()) {
+        uint64_t const iterationStart = nand_.nowUs;
+
+        RunStateMachine(&qspi_service);
+        maxIterationUs = MAX(maxIterationUs, nand_.nowUs - iterationStart);
+        iterations++;
+
+        //
+        // a USB host reads a block that is not cached, part way through the flush
+        if (iterations == 1000u) {
+            uint64_t const missStart = nand_.nowUs;
+
+            CHECK(HSS_CachedQSPI_ReadBlock(sector, WORKING_BLOCKS * NAND_BLOCK_SIZE / 2u,
+                sizeof(sector)));
+            missUs = nand_.nowUs - missStart;
+        }
+
+        nand_.nowUs += OTHER_SERVICES_US;
+    }
+
+    uint64_t const flushUs = nand_.nowUs - start;
+
+    CHECK_EQUAL(nand_.erases, dirtyCount);
+    CHECK_EQUAL(nand_.busyCommands, 0u);
+    CHECK(!memcmp(sector, shadow_ + (WORKING_BLOCKS * NAND_BLOCK_SIZE / 2u), sizeof(sector)));
+
+    //
+    // the same blocks written back in one call, as the flush used to
+    for (uint32_t way = QSPI_CACHE_NUM_WAYS / 2u; way < QSPI_CACHE_NUM_WAYS; way++) {
+        for (uint32_t set = 0u; set < QSPI_CACHE_NUM_SETS; set++) {
+            CHECK(HSS_CachedQSPI_WriteBlock(((way * QSPI_CACHE_NUM_SETS) + set) * NAND_BLOCK_SIZE,
+                shadow_, sizeof(sector)));
+        }
+    }
+
+    uint64_t const syncStart = nand_.nowUs;
+    for (size_t i = 0u; i < ARRAY_SIZE(cacheEntries_); i++) {
+        if (cacheEntries_[i].logicalBlock != QSPI_CACHE_INVALID_BLOCK) {
+            CHECK(write_back_entry_(&cacheEntries_[i]));
+        }
+    }
+    uint64_t const syncUs = nand_.nowUs - syncStart;
+    CHECK_EQUAL(dirtyBlockCount_, 0u);
+
+    printf("  %u dirty blocks: flushed in %llu us over %u iterations, at most %llu us each\n",
+        dirtyCount, (unsigned long long)flushUs, iterations, (unsigned long long)maxIterationUs);
+    printf("  cache miss during the flush: %llu us\n", (unsigned long long)missUs);
+    printf("  synchronous flush: %llu us in one iteration\n", (unsigned long long)syncUs);
+
+    size_t const blockReadUs = NAND_PAGES_PER_BLOCK
+        * ((2u * NAND_COMMAND_US) + NAND_T_RD_US + (NAND_PAGE_SIZE / QSPI_QUAD_BYTES_PER_US));
+
+    size_t maxIterationBoundUs = NAND_COMMAND_US + (NAND_PAGE_SIZE / QSPI_BYTES_PER_US) + NAND_POLL_US;
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_WEAR_LEVELLING)
+    // other than the wear levelling table, which is written in one go at the end of the flush
+    maxIterationBoundUs = MAX(maxIterationBoundUs, wlSlotPages_
+        * (NAND_COMMAND_US + (NAND_PAGE_SIZE / QSPI_BYTES_PER_US) + NAND_T_PROG_US));
+#endif
+
+    CHECK(maxIterationUs <= maxIterationBoundUs);
+    CHECK(missUs <= (NAND_T_BERS_US + blockReadUs));
+    CHECK(syncUs >= (dirtyCount * (NAND_T_BERS_US + (NAND_PAGES_PER_BLOCK * NAND_T_PROG_US))));
+}
+
+//
+// the IO format is only switched when a different one is needed, so a reader going
+// page by page, as the GPT code does, pays for one switch rather than two per read.
+// Each read is issued as one quad IO page read command per page, for the longest
+// physically contiguous run of blocks
+static void test_read_mode_switches(void)
+{
+    static const char * const names[] = {
+        "page by page, format restored after each",
+        "page by page",
+        "in one read",
+    };
+    size_t const size = 1024u * 1024u;
+    size_t const pages = size / NAND_PAGE_SIZE;
+    struct {
+        unsigned modeSwitches;
+        unsigned reads;
+        unsigned commands;
+        uint64_t us;
+    } costs[ARRAY_SIZE(names)];
+
+    format_();
+    printf("  per MiB read: %42s %8s %8s %10s %8s\n", "switches", "reads", "commands", "us",
+        "MiB/s");
+
+    for (size_t i = 0u; i < ARRAY_SIZE(names); i++) {
+        HSS_QSPI_RestoreDefaultIOFormat();
+
+        unsigned const modeSwitches = nand_.modeSwitches, reads = nand_.reads;
+        unsigned const commands = nand_.commands;
+        uint64_t const start = nand_.nowUs;
+
+        memset(buffer_, 0, sizeof(buffer_));
+        for (size_t offset = 0u; offset < size; ) {
+            size_t const readSize = (i < 2u) ? NAND_PAGE_SIZE : size;
+
+            CHECK(HSS_QSPI_ReadBlock(buffer_ + (offset % sizeof(buffer_)), offset,
+                MIN(readSize, sizeof(buffer_))));
+            offset += MIN(readSize, sizeof(buffer_));
+
+            // the read left the flash in the default format, as each read used to
+            if (i == 0u) {
+                HSS_QSPI_RestoreDefaultIOFormat();
+            }
+        }
+
+        costs[i].modeSwitches = nand_.modeSwitches - modeSwitches;
+        costs[i].reads = nand_.reads - reads;
+        costs[i].commands = nand_.commands - commands;
+        costs[i].us = nand_.nowUs - start;
+        CHECK(!memcmp(buffer_, shadow_ + size - sizeof(buffer_), sizeof(buffer_)));
+
+        printf("    %-44s %8u %8u %8u %10llu %8.1f\n", names[i], costs[i].modeSwitches,
+            costs[i].reads, costs[i].commands, (unsigned long long)costs[i].us,
+            (double)size / (double)costs[i].us);
+    }
+
+    CHECK_EQUAL(costs[0].modeSwitches, 2u * pages);
+    CHECK_EQUAL(costs[1].modeSwitches, 1u);
+    CHECK_EQUAL(costs[2].modeSwitches, 1u);
+
+    //
+    // two commands per page, a page read and a read from the buffer, and three for each
+    // switch
+    for (size_t i = 0u; i < ARRAY_SIZE(names); i++) {
+        CHECK_EQUAL(costs[i].commands, (2u * pages) + (3u * costs[i].modeSwitches));
+    }
+    CHECK(costs[2].reads <= ((size / sizeof(buffer_)) * 2u));
+    CHECK(costs[1].us < costs[0].us);
+    CHECK(costs[2].us <= costs[1].us);
+    CHECK_EQUAL(nand_.misalignedReads, 0u);
+}
+
+//
+// a long run of small updates, as a filesystem makes: a few hot blocks, holding its
+// allocation tables and a log, are written by every update, and a cold block now and
+// then, with each update flushed. Without wear levelling the hot blocks take almost every
+// erase. Dynamic wear levelling spreads them over the free pool, and static wear
+// levelling also over the blocks holding cold data
+#define HOT_BLOCKS              (4u)
+#define UPDATES                 (1000u)
+
+static int compare_counts_(void const *pA, void const *pB)
+{
+    uint32_t const a = *(uint32_t const *)pA, b = *(uint32_t const *)pB;
+
+    return (a > b) - (a < b);
+}
+
+static void test_erase_distribution(void)
+{
+    static uint32_t counts[NAND_NUM_BLOCKS];
+    uint8_t sector[SECTOR_SIZE];
+
+    format_();
+
+    for (unsigned update = 0u; update < UPDATES; update++) {
+        for (uint32_t block = 0u; block < HOT_BLOCKS + 1u; block++) {
+            uint32_t const logicalBlock = (block < HOT_BLOCKS) ? block
+                : (HOT_BLOCKS + (random_() % (WORKING_BLOCKS - HOT_BLOCKS)));
+            size_t const offset = (logicalBlock * NAND_BLOCK_SIZE)
+                + (SECTOR_SIZE * (random_() % (NAND_BLOCK_SIZE / SECTOR_SIZE)));
+
+            if ((block < HOT_BLOCKS) || ((random_() % 8u) == 0u)) {
+                fill_random_(sector, sizeof(sector));
+                memcpy(shadow_ + offset, sector, sizeof(sector));
+                CHECK(HSS_CachedQSPI_WriteBlock(offset, sector, sizeof(sector)));
+            }
+        }
+
+        flush_();
+    }
+
+    CHECK(working_blocks_match_());
+    CHECK_EQUAL(nand_.overwrites, 0u);
+
+    //
+    // over the good blocks that hold data. The wear levelling table's own blocks are
+    // reported separately, as they are not wear levelled
+    size_t goodBlocks = 0u;
+    uint64_t total = 0u;
+
+    for (uint32_t block = 0u; block < usable_physical_blocks_(); block++) {
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_WEAR_LEVELLING)
+        if (is_meta_block_(block)) {
+            printf("  wear levelling table block %u: %u erases\n", block, nand_.blockErases[block]);
+            continue;
+        }
+#endif
+        if (!is_factory_bad_(block)) {
+            counts[goodBlocks] = nand_.blockErases[block];
+            total += counts[goodBlocks];
+            goodBlocks++;
+        }
+    }
+
+    qsort(counts, goodBlocks, sizeof(counts[0]), compare_counts_);
+
+    size_t neverErased = 0u;
+    while ((neverErased < goodBlocks) && !counts[neverErased]) {
+        neverErased++;
+    }
+
+    uint32_t const maxCount = counts[goodBlocks - 1u];
+
+    printf("  %u updates, %llu erases over %zu data blocks, %zu never erased\n", UPDATES,
+        (unsigned long long)total, goodBlocks, neverErased);
+    printf("  erase counts: min %u, median %u, 90th %u, 99th %u, max %u, mean %.1f\n",
+        counts[0], counts[goodBlocks / 2u], counts[(goodBlocks * 90u) / 100u],
+        counts[(goodBlocks * 99u) / 100u], maxCount, (double)total / goodBlocks);
+
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_STATIC_WEAR_LEVELLING)
+    // within the threshold of the least-worn data block, but for the erases made by the
+    // flushes between moves
+    CHECK(maxCount <= (counts[0] + CONFIG_SERVICE_QSPI_STATIC_WEAR_LEVELLING_THRESHOLD
+        + HOT_BLOCKS + 1u));
+    CHECK(neverErased < (goodBlocks * 3u) / 4u);
+#elif IS_ENABLED(CONFIG_SERVICE_QSPI_WEAR_LEVELLING)
+    CHECK((maxCount * 4u) < UPDATES);
+    CHECK(neverErased > (goodBlocks / 2u));
+#else
+    CHECK_EQUAL(maxCount, UPDATES);
+#endif
+}
+
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_WEAR_LEVELLING)
+//
+// Power losses. Each case starts again from a fresh format for every erase or page
+// program at which the power is lost, and checks what the next start-up finds
+
+static const uint32_t updatedBlocks_[] = { 3u, 70u };
+static uint8_t updates_[ARRAY_SIZE(updatedBlocks_)][SECTOR_SIZE];
+
+//
+// a formatted device whose working blocks are more worn than the spare blocks, so that
+// each write-back moves its block, and the block that it leaves keeps the old data
+static uint32_t format_worn_(void)
+{
+    format_();
+
+    for (uint32_t logicalBlock = 0u; logicalBlock < WORKING_BLOCKS; logicalBlock++) {
+        pWlTable->eraseCount[pLogicalToPhysicalMap[logicalBlock]] = 100u;
+    }
+    CHECK(wl_persist_table_());
+
+    return pWlTable->sequence;
+}
+
+static void write_updates_(void)
+{
+    for (size_t i = 0u; i < ARRAY_SIZE(updatedBlocks_); i++) {
+        CHECK(HSS_CachedQSPI_WriteBlock(updatedBlocks_[i] * NAND_BLOCK_SIZE, updates_[i],
+            SECTOR_SIZE));
+    }
+}
+
+//
+// every working block holds its data from before the updates, other than the updated
+// blocks, which may instead hold their new data. Returns the number of updated blocks
+// found with their new data, or -1 on a mismatch
+static int working_blocks_old_or_new_(void)
+{
+    int result = 0;
+
+    for (uint32_t logicalBlock = 0u; (result >= 0) && (logicalBlock < WORKING_BLOCKS);
+        logicalBlock++) {
+        uint8_t const * const pOld = shadow_ + (logicalBlock * NAND_BLOCK_SIZE);
+        bool isNew = false;
+
+        CHECK(HSS_QSPI_ReadBlock(buffer_, logicalBlock * NAND_BLOCK_SIZE, NAND_BLOCK_SIZE));
+
+        for (size_t i = 0u; i < ARRAY_SIZE(updatedBlocks_); i++) {
+            if ((updatedBlocks_[i] == logicalBlock) && !memcmp(buffer_, updates_[i], SECTOR_SIZE)
+                && !memcmp(buffer_ + SECTOR_SIZE, pOld + SECTOR_SIZE, NAND_BLOCK_SIZE - SECTOR_SIZE)) {
+                isNew = true;
+            }
+        }
+
+        if (isNew) {
+            result++;
+        } else if (memcmp(buffer_, pOld, NAND_BLOCK_SIZE)) {
+            result = -1;
+        }
+    }
+
+    return result;
+}
+
+static void test_power_loss_during_flush(void)
+{
+    for (size_t i = 0u; i < ARRAY_SIZE(updatedBlocks_); i++) {
+        fill_random_(updates_[i], SECTOR_SIZE);
+    }
+
+    //
+    // count the erases and page programs of the flush: for each block an erase and its
+    // pages, and then the table
+    (void)format_worn_();
+    unsigned const firstOp = nand_.flashOps;
+    write_updates_();
+    flush_();
+    unsigned const flushOps = nand_.flashOps - firstOp;
+    unsigned const tableOps = wlSlotPages_;
+
+    CHECK_EQUAL(flushOps, (ARRAY_SIZE(updatedBlocks_) * (1u + NAND_PAGES_PER_BLOCK)) + tableOps);
+    CHECK_EQUAL(working_blocks_old_or_new_(), (int)ARRAY_SIZE(updatedBlocks_));
+
+    //
+    // the power is lost at each erase, every eighth page of the data, each page of the
+    // table, and not at all
+    for (unsigned op = 1u; op <= flushOps + 1u;
+        op += ((op % (1u + NAND_PAGES_PER_BLOCK)) && (op < flushOps - tableOps)) ? 8u : 1u) {
+        uint32_t const sequence = format_worn_();
+
+        nand_.powerFailOp = nand_.flashOps + op;
+        write_updates_();
+        flush_();
+        power_cycle_();
+
+        //
+        // the table survives, and until it is written the old data is kept, as the
+        // blocks it refers to are not reused until then
+        CHECK(working_blocks_old_or_new_() == ((op > flushOps) ? (int)ARRAY_SIZE(updatedBlocks_) : 0));
+        CHECK_EQUAL(pWlTable->sequence, (op > flushOps) ? sequence + 1u : sequence);
+
+        //
+        // and a torn slot is skipped rather than written again
+        write_updates_();
+        flush_();
+        power_cycle_();
+        CHECK_EQUAL(working_blocks_old_or_new_(), (int)ARRAY_SIZE(updatedBlocks_));
+        CHECK_EQUAL(nand_.overwrites, 0u);
+    }
+}
+
+//
+// when the active metadata block is full, the log continues in the other one, which
+// is erased first
+static void test_power_loss_during_table_rollover(void)
+{
+    for (unsigned op = 1u; op <= 1u + wlSlotPages_ + 1u; op++) {
+        (void)format_worn_();
+        while (wlNextSlot_ < wlSlotsPerBlock_) {
+            CHECK(wl_persist_table_());
+        }
+
+        uint32_t const sequence = pWlTable->sequence;
+        size_t const activeMeta = wlActiveMeta_;
+
+        nand_.powerFailOp = nand_.flashOps + op;
+        (void)wl_persist_table_();
+        power_cycle_();
+
+        if (op > 1u + wlSlotPages_) {
+            CHECK_EQUAL(pWlTable->sequence, sequence + 1u);
+            CHECK(wlActiveMeta_ != activeMeta);
+            CHECK_EQUAL(wlNextSlot_, 1u);
+        } else {
+            CHECK_EQUAL(pWlTable->sequence, sequence);
+            CHECK_EQUAL(wlActiveMeta_, activeMeta);
+            CHECK_EQUAL(wlNextSlot_, wlSlotsPerBlock_);
+        }
+
+        //
+        // the next table written, after a second start-up, is the one loaded
+        CHECK(wl_persist_table_());
+        uint32_t const nextSequence = pWlTable->sequence;
+        power_cycle_();
+        CHECK_EQUAL(pWlTable->sequence, nextSequence);
+        CHECK_EQUAL(nand_.overwrites, 0u);
+    }
+}
+#endif
+
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_BAD_BLOCK_TABLE)
+//
+// a block going bad updates both copies of the bad block table, the older one first
+#define GROWN_BAD_BLOCK         (500u)
+
+static bool bbt_copy_is_valid_(size_t copy)
+{
+    Flash_read((uint8_t *)pBbtScratch, bbtBlocks_[copy] * NAND_BLOCK_SIZE, sizeof(*pBbtScratch));
+
+    return bbt_is_valid_(pBbtScratch);
+}
+
+static void test_power_loss_during_bbt_update(void)
+{
+    // an erase and a page program for each copy, then no power loss
+    for (unsigned op = 1u; op <= (2u * QSPI_BBT_NUM_COPIES) + 1u; op++) {
+        format_();
+        CHECK_EQUAL(numBadBlocks, ARRAY_SIZE(factoryBadBlocks_));
+
+        nand_.powerFailOp = nand_.flashOps + op;
+        retire_failed_block_(GROWN_BAD_BLOCK);
+        power_cycle_();
+
+        //
+        // a valid copy is found, either old or new, so the flash is not scanned, and the
+        // copies are made the same again
+        CHECK_EQUAL(nand_.scans, 0u);
+        CHECK((numBadBlocks == ARRAY_SIZE(factoryBadBlocks_) + 1u)
+            || ((numBadBlocks == ARRAY_SIZE(factoryBadBlocks_)) && (op <= (2u * QSPI_BBT_NUM_COPIES))));
+        CHECK(is_bad_block_(GROWN_BAD_BLOCK) == (numBadBlocks > ARRAY_SIZE(factoryBadBlocks_)));
+        CHECK_EQUAL(bbtCopySequence_[0], bbtCopySequence_[1]);
+        CHECK(bbt_copy_is_valid_(0u) && bbt_copy_is_valid_(1u));
+
+        size_t const badBlocks = numBadBlocks;
+        power_cycle_();
+        CHECK_EQUAL(nand_.scans, 0u);
+        CHECK_EQUAL(numBadBlocks, badBlocks);
+    }
+}
+
+static void test_corrupt_bbt_copies(void)
+{
+    format_();
+    retire_failed_block_(GROWN_BAD_BLOCK);
+
+    //
+    // a damaged copy is replaced from the other, whichever it is
+    for (size_t copy = 0u; copy < QSPI_BBT_NUM_COPIES; copy++) {
+        nandData_[(bbtBlocks_[copy] * NAND_BLOCK_SIZE) + 20u] ^= 0x01u;
+        power_cycle_();
+
+        CHECK_EQUAL(nand_.scans, 0u);
+        CHECK_EQUAL(numBadBlocks, ARRAY_SIZE(factoryBadBlocks_) + 1u);
+        CHECK(bbt_copy_is_valid_(0u) && bbt_copy_is_valid_(1u));
+    }
+
+    //
+    // with both damaged, the flash is scanned, which finds only the bad block markers
+    // written at the factory, and the table is written again
+    for (size_t copy = 0u; copy < QSPI_BBT_NUM_COPIES; copy++) {
+        nandData_[(bbtBlocks_[copy] * NAND_BLOCK_SIZE) + 20u] ^= 0x01u;
+    }
+    power_cycle_();
+
+    CHECK_EQUAL(nand_.scans, 1u);
+    CHECK_EQUAL(numBadBlocks, ARRAY_SIZE(factoryBadBlocks_));
+    CHECK(bbt_copy_is_valid_(0u) && bbt_copy_is_valid_(1u));
+}
+#endif
+
+int main(void)
+{
+    RUN_TEST(test_random_workloads_keep_data);
+    RUN_TEST(test_lru_replacement);
+    RUN_TEST(test_hit_rates);
+    RUN_TEST(test_sparse_update_flush);
+    RUN_TEST(test_flush_latency);
+    RUN_TEST(test_read_mode_switches);
+    RUN_TEST(test_erase_distribution);
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_WEAR_LEVELLING)
+    RUN_TEST(test_power_loss_during_flush);
+    RUN_TEST(test_power_loss_during_table_rollover);
+#endif
+#if IS_ENABLED(CONFIG_SERVICE_QSPI_BAD_BLOCK_TABLE)
+    RUN_TEST(test_power_loss_during_bbt_update);
+    RUN_TEST(test_corrupt_bbt_copies);
+#endif
+
+    return unit_test_report("qspi_cache (" WEAR_LEVELLING ")");
+}
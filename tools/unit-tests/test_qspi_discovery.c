@@ -0,0 +1,288 @@
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/*!
+ * \file Host unit tests for QSPI flash parameter discovery
+ * \brief Checks the SFDP basic parameter table and ONFI parameter page parsers
+ */
+
+#include "config.h"
+#include "hss_types.h"
+
+#include <string.h>
+
+#include "qspi_discovery.h"
+#include "unit_test.h"
+
+static void put_le32_(uint8_t * const p, const uint32_t value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// SFDP
+//
+// The table is laid out as a 1Gbit NOR flash in the style of the MT25Q: 4KiB, 32KiB and
+// 64KiB erase types, 256 byte pages, and 1-1-2, 1-2-2, 1-1-4 and 1-4-4 fast reads
+//
+
+#define SFDP_BFPT_OFFSET    (0x30u)
+#define SFDP_BFPT_DWORDS    (16u)
+
+static uint8_t sfdp_[256];
+
+static void build_sfdp_(const size_t numDwords, uint32_t const * const pDwords)
+{
+    memset(sfdp_, 0xFF, sizeof(sfdp_));
+
+    put_le32_(&sfdp_[0], 0x50444653u);                  // "SFDP"
+    sfdp_[4] = 6u;                                      // JESD216 minor revision
+    sfdp_[5] = 1u;                                      // major revision
+    sfdp_[6] = 0u;                                      // one parameter header
+    sfdp_[7] = 0xFFu;
+
+    sfdp_[8] = 0x00u;                                   // BFPT ID LSB
+    sfdp_[9] = 6u;
+    sfdp_[10] = 1u;
+    sfdp_[11] = (uint8_t)numDwords;
+    put_le32_(&sfdp_[12], SFDP_BFPT_OFFSET | 0xFF000000u); // pointer, and BFPT ID MSB
+
+    for (size_t i = 0u; i < numDwords; i++) {
+        put_le32_(&sfdp_[SFDP_BFPT_OFFSET + (i * 4u)], pDwords[i]);
+    }
+}
+
+static void bfpt_defaults_(uint32_t * const pDwords)
+{
+    memset(pDwords, 0, SFDP_BFPT_DWORDS * sizeof(uint32_t));
+
+    pDwords[0] = (1u << 16) | (1u << 20) | (1u << 21) | (1u << 22);    // 1-1-2, 1-2-2, 1-4-4, 1-1-4
+    pDwords[1] = (1024u * 1024u * 1024u) - 1u;                      // 1Gbit, as bits - 1
+    pDwords[2] = 0x6B08EB0Au;                                       // 1-1-4 6Bh, 1-4-4 EBh
+    pDwords[3] = 0xBB083B08u;                                       // 1-2-2 BBh, 1-1-2 3Bh
+    pDwords[4] = 0u;                                                // no 2-2-2 or 4-4-4
+    pDwords[5] = 0xBB08FFFFu;
+    pDwords[6] = 0xEB0AFFFFu;
+    pDwords[7] = 0x520F200Cu;                                       // 4KiB 20h, 32KiB 52h
+    pDwords[8] = 0x0000D810u;                                       // 64KiB D8h
+    pDwords[10] = 8u << 4;                                          // 256 byte pages
+}
+
+static void test_sfdp_geometry(void)
+{
+    uint32_t dwords[SFDP_BFPT_DWORDS];
+    struct HSS_QSPI_FlashParams params = { 0 };
+
+    bfpt_defaults_(dwords);
+    build_sfdp_(SFDP_BFPT_DWORDS, dwords);
+
+    CHECK(HSS_QSPI_ParseSFDP(sfdp_, sizeof(sfdp_), &params));
+    CHECK_EQUAL(params.pageSize, 256u);
+    CHECK_EQUAL(params.pagesPerBlock, 256u);                        // largest erase type
+    CHECK_EQUAL(params.blocksPerDie, 2048u);
+}
+
+static void test_sfdp_density_power_of_two(void)
+{
+    uint32_t dwords[SFDP_BFPT_DWORDS];
+    struct HSS_QSPI_FlashParams params = { 0 };
+
+    bfpt_defaults_(dwords);
+    dwords[1] = 0x80000000u | 34u;                                  // 2^34 bits
+    build_sfdp_(SFDP_BFPT_DWORDS, dwords);
+
+    CHECK(HSS_QSPI_ParseSFDP(sfdp_, sizeof(sfdp_), &params));
+    CHECK_EQUAL(params.blocksPerDie, 32768u);
+}
+
+static void test_sfdp_read_mode_priority(void)
+{
+    uint32_t dwords[SFDP_BFPT_DWORDS];
+    struct HSS_QSPI_FlashParams params = { 0 };
+
+    bfpt_defaults_(dwords);
+    build_sfdp_(SFDP_BFPT_DWORDS, dwords);
+    CHECK(HSS_QSPI_ParseSFDP(sfdp_, sizeof(sfdp_), &params));
+    CHECK_EQUAL(params.readFormat, MSS_QSPI_QUAD_EX_RW);
+
+    dwords[4] = (1u << 4);                                          // 4-4-4
+    build_sfdp_(SFDP_BFPT_DWORDS, dwords);
+    CHECK(HSS_QSPI_ParseSFDP(sfdp_, sizeof(sfdp_), &params));
+    CHECK_EQUAL(params.readFormat, MSS_QSPI_QUAD_FULL);
+
+    dwords[4] = 0u;
+    dwords[0] = (1u << 16) | (1u << 20);                            // dual only
+    build_sfdp_(SFDP_BFPT_DWORDS, dwords);
+    CHECK(HSS_QSPI_ParseSFDP(sfdp_, sizeof(sfdp_), &params));
+    CHECK_EQUAL(params.readFormat, MSS_QSPI_DUAL_EX_RW);
+
+    dwords[0] = 0u;
+    build_sfdp_(SFDP_BFPT_DWORDS, dwords);
+    CHECK(HSS_QSPI_ParseSFDP(sfdp_, sizeof(sfdp_), &params));
+    CHECK_EQUAL(params.readFormat, MSS_QSPI_NORMAL);
+}
+
+static void test_sfdp_jesd216_original_table(void)
+{
+    uint32_t dwords[SFDP_BFPT_DWORDS];
+    struct HSS_QSPI_FlashParams params = { 0 };
+
+    //
+    // the original JESD216 table has 9 dwords, with no page size, so 256 is assumed
+    bfpt_defaults_(dwords);
+    dwords[10] = 0u;
+    build_sfdp_(9u, dwords);
+
+    CHECK(HSS_QSPI_ParseSFDP(sfdp_, sizeof(sfdp_), &params));
+    CHECK_EQUAL(params.pageSize, 256u);
+    CHECK_EQUAL(params.pagesPerBlock, 256u);
+}
+
+static void test_sfdp_rejects_invalid(void)
+{
+    uint32_t dwords[SFDP_BFPT_DWORDS];
+    struct HSS_QSPI_FlashParams params = { 0 };
+
+    bfpt_defaults_(dwords);
+
+    build_sfdp_(SFDP_BFPT_DWORDS, dwords);
+    sfdp_[0] = 'X';
+    CHECK(!HSS_QSPI_ParseSFDP(sfdp_, sizeof(sfdp_), &params));      // signature
+
+    build_sfdp_(SFDP_BFPT_DWORDS, dwords);
+    sfdp_[15] = 0x81u;
+    CHECK(!HSS_QSPI_ParseSFDP(sfdp_, sizeof(sfdp_), &params));      // not a BFPT
+
+    build_sfdp_(8u, dwords);
+    CHECK(!HSS_QSPI_ParseSFDP(sfdp_, sizeof(sfdp_), &params));      // too few dwords
+
+    build_sfdp_(SFDP_BFPT_DWORDS, dwords);
+    CHECK(!HSS_QSPI_ParseSFDP(sfdp_, SFDP_BFPT_OFFSET + 32u, &params));   // truncated
+    CHECK(!HSS_QSPI_ParseSFDP(sfdp_, 8u, &params));
+
+    dwords[7] = dwords[8] = 0u;
+    build_sfdp_(SFDP_BFPT_DWORDS, dwords);
+    CHECK(!HSS_QSPI_ParseSFDP(sfdp_, sizeof(sfdp_), &params));      // no erase types
+
+    bfpt_defaults_(dwords);
+    dwords[1] = (32u * 1024u) - 1u;                                 // 4KiB, smaller than a block
+    build_sfdp_(SFDP_BFPT_DWORDS, dwords);
+    CHECK(!HSS_QSPI_ParseSFDP(sfdp_, sizeof(sfdp_), &params));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// ONFI
+//
+// The page is laid out as a 1Gbit SPI NAND in the style of the W25N01GV: 2KiB pages,
+// 64 pages per block and 1024 blocks. Its CRC was calculated independently, bit-serially
+//
+
+#define ONFI_COPY_SIZE      (256u)
+#define ONFI_PAGE_CRC       (0xDBF5u)
+
+static uint8_t onfi_[3u * ONFI_COPY_SIZE];
+
+static void build_onfi_copy_(uint8_t * const pCopy)
+{
+    memset(pCopy, 0, ONFI_COPY_SIZE);
+
+    memcpy(pCopy, "ONFI", 4u);
+    put_le32_(&pCopy[80], 2048u);
+    put_le32_(&pCopy[92], 64u);
+    put_le32_(&pCopy[96], 1024u);
+    pCopy[100] = 1u;
+    pCopy[254] = (uint8_t)ONFI_PAGE_CRC;
+    pCopy[255] = (uint8_t)(ONFI_PAGE_CRC >> 8);
+}
+
+static void build_onfi_(void)
+{
+    for (size_t copy = 0u; copy < 3u; copy++) {
+        build_onfi_copy_(&onfi_[copy * ONFI_COPY_SIZE]);
+    }
+}
+
+static void test_onfi_geometry(void)
+{
+    struct HSS_QSPI_FlashParams params = { .readFormat = MSS_QSPI_QUAD_FULL };
+
+    build_onfi_();
+
+    CHECK(HSS_QSPI_ParseONFI(onfi_, sizeof(onfi_), &params));
+    CHECK_EQUAL(params.pageSize, 2048u);
+    CHECK_EQUAL(params.pagesPerBlock, 64u);
+    CHECK_EQUAL(params.blocksPerDie, 1024u);
+    CHECK_EQUAL(params.readFormat, MSS_QSPI_QUAD_FULL);             // left to the caller
+}
+
+static void test_onfi_crc16(void)
+{
+    struct HSS_QSPI_FlashParams params = { 0 };
+
+    build_onfi_();
+    onfi_[254] ^= 0x01u;
+    CHECK(!HSS_QSPI_ParseONFI(onfi_, ONFI_COPY_SIZE, &params));     // CRC field
+
+    build_onfi_();
+    onfi_[200] = 0x5Au;
+    CHECK(!HSS_QSPI_ParseONFI(onfi_, ONFI_COPY_SIZE, &params));     // covered data
+
+    build_onfi_();
+    onfi_[0] = 'X';
+    CHECK(!HSS_QSPI_ParseONFI(onfi_, ONFI_COPY_SIZE, &params));     // signature
+}
+
+static void test_onfi_redundant_copies(void)
+{
+    struct HSS_QSPI_FlashParams params = { 0 };
+
+    //
+    // the first copy with a valid CRC is used
+    build_onfi_();
+    onfi_[100] = 2u;
+    put_le32_(&onfi_[ONFI_COPY_SIZE + 96u], 512u);
+    onfi_[ONFI_COPY_SIZE + 200u] = 0x5Au;
+    CHECK(HSS_QSPI_ParseONFI(onfi_, sizeof(onfi_), &params));
+    CHECK_EQUAL(params.blocksPerDie, 1024u);
+
+    build_onfi_();
+    onfi_[ONFI_COPY_SIZE + 254u] ^= 0xFFu;
+    onfi_[254] ^= 0xFFu;
+    CHECK(HSS_QSPI_ParseONFI(onfi_, sizeof(onfi_), &params));
+    CHECK_EQUAL(params.pageSize, 2048u);
+
+    build_onfi_();
+    for (size_t copy = 0u; copy < 3u; copy++) {
+        onfi_[(copy * ONFI_COPY_SIZE) + 254u] ^= 0xFFu;
+    }
+    CHECK(!HSS_QSPI_ParseONFI(onfi_, sizeof(onfi_), &params));
+
+    // a partial copy is not used
+    build_onfi_();
+    CHECK(!HSS_QSPI_ParseONFI(onfi_, ONFI_COPY_SIZE - 1u, &params));
+}
+
+int main(void)
+{
+    RUN_TEST(test_sfdp_geometry);
+    RUN_TEST(test_sfdp_density_power_of_two);
+    RUN_TEST(test_sfdp_read_mode_priority);
+    RUN_TEST(test_sfdp_jesd216_original_table);
+    RUN_TEST(test_sfdp_rejects_invalid);
+    RUN_TEST(test_onfi_geometry);
+    RUN_TEST(test_onfi_crc16);
+    RUN_TEST(test_onfi_redundant_copies);
+
+    return unit_test_report("qspi_discovery");
+}
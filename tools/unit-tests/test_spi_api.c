@@ -0,0 +1,370 @@
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/*!
+ * \file Host unit tests for System Controller SPI flash reads
+ * \brief Checks that background reads are split into SPI copy requests of at most the
+ * chunk size, at the right flash and destination offsets, one at a time, and that failed
+ * requests end the read
+ *
+ * spi_api.c is included rather than linked, so that the System Controller registers it
+ * polls can be redirected to a model. The model takes SPI copy requests through its
+ * mailbox, and completes them when the test steps it.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "mss_sys_services.h"
+
+static SCBCTRL_TypeDef scbctrl_;
+#undef MSS_SCBCTRL
+#define MSS_SCBCTRL (&scbctrl_)
+
+#include "spi_api.c"
+#include "unit_test.h"
+
+#define FLASH_SIZE              ((size_t)CONFIG_SERVICE_SPI_FLASH_SIZE)
+#define CHUNK_SIZE              ((size_t)CONFIG_SERVICE_SPI_COPY_CHUNK_SIZE)
+#define GUARD_SIZE              (64u)
+#define FILL                    (0xA5u)
+#define MAX_REQUESTS            (512u)
+#define MAX_STEPS               (1000000u)
+
+static uint8_t flash_[FLASH_SIZE];
+static uint8_t memory_[GUARD_SIZE + FLASH_SIZE + GUARD_SIZE] __attribute__((aligned(8)));
+static uint8_t * const pDest_ = memory_ + GUARD_SIZE;
+
+struct Request {
+    uint64_t dest;
+    uint32_t src;
+    uint32_t byteCount;
+};
+
+//
+// the System Controller, which takes one request at a time through its mailbox. A posted
+// request sets REQ until the System Controller picks it up, and BUSY until it completes
+static struct {
+    uint8_t serviceMode;
+    bool immediate;             // complete each request as it is posted
+    unsigned busySteps;         // steps each request stays busy for
+    unsigned busyRemaining;
+    unsigned rejectRequest;     // refuse to post this request (counted from 1), or never
+    unsigned failRequest;       // complete this request with an error status, or never
+    uint16_t errorStatus;
+
+    struct Request log[MAX_REQUESTS];
+    size_t numRequests;
+    unsigned protocolErrors;
+    struct Request pending;
+    bool pendingFails;
+} sc_;
+
+static void sc_reset_(void)
+{
+    memset(&sc_, 0, sizeof(sc_));
+    memset(&scbctrl_, 0, sizeof(scbctrl_));
+    sc_.serviceMode = MSS_SYS_SERVICE_POLLING_MODE;
+    sc_.busySteps = 3u;
+    sc_.errorStatus = 0x7Fu;
+}
+
+static void sc_complete_(void)
+{
+    scbctrl_.SERVICES_CR &= ~SCBCTRL_SERVICESCR_REQ_MASK;
+    scbctrl_.SERVICES_SR &= ~(SCBCTRL_SERVICESSR_BUSY_MASK | SCBCTRL_SERVICESSR_STATUS_MASK);
+
+    if (sc_.pendingFails) {
+        scbctrl_.SERVICES_SR |= (uint32_t)sc_.errorStatus << SCBCTRL_SERVICESSR_STATUS;
+    } else {
+        memcpy((void *)(uintptr_t)sc_.pending.dest, flash_ + sc_.pending.src,
+            sc_.pending.byteCount);
+    }
+}
+
+static void sc_step_(void)
+{
+    if (scbctrl_.SERVICES_CR & SCBCTRL_SERVICESCR_REQ_MASK) {
+        scbctrl_.SERVICES_CR &= ~SCBCTRL_SERVICESCR_REQ_MASK;
+        scbctrl_.SERVICES_SR |= SCBCTRL_SERVICESSR_BUSY_MASK;
+    } else if (scbctrl_.SERVICES_SR & SCBCTRL_SERVICESSR_BUSY_MASK) {
+        if (sc_.busyRemaining) {
+            sc_.busyRemaining--;
+        } else {
+            sc_complete_();
+        }
+    }
+}
+
+void MSS_SYS_select_service_mode(uint8_t sys_service_mode,
+    mss_sys_service_handler_t mss_sys_service_interrupt_handler)
+{
+    if ((sys_service_mode == MSS_SYS_SERVICE_INTERRUPT_MODE)
+        && !mss_sys_service_interrupt_handler) {
+        sc_.protocolErrors++;
+    }
+
+    sc_.serviceMode = sys_service_mode;
+}
+
+uint16_t MSS_SYS_spi_copy(uint64_t mss_dest_addr, uint32_t mss_spi_flash, uint32_t n_bytes,
+    uint8_t options, uint16_t mb_offset)
+{
+    uint16_t status = 0u;
+    bool const inFlash = (mss_spi_flash <= FLASH_SIZE)
+        && (n_bytes <= FLASH_SIZE - mss_spi_flash);
+
+    //
+    // the HSS must not wait in the driver for the copy, or post a request while another is
+    // in progress, and reads whole requests from the start of the mailbox
+    if ((sc_.serviceMode != MSS_SYS_SERVICE_INTERRUPT_MODE)
+        || (scbctrl_.SERVICES_CR & SCBCTRL_SERVICESCR_REQ_MASK)
+        || (scbctrl_.SERVICES_SR & SCBCTRL_SERVICESSR_BUSY_MASK)
+        || (options != SPI_COPY_CLOCK_OPTION) || (mb_offset != 0u)
+        || !n_bytes || (n_bytes > CHUNK_SIZE) || !inFlash) {
+        sc_.protocolErrors++;
+    }
+
+    if (sc_.numRequests < MAX_REQUESTS) {
+        sc_.log[sc_.numRequests] = (struct Request){ mss_dest_addr, mss_spi_flash, n_bytes };
+    }
+    sc_.numRequests++;
+
+    if (sc_.numRequests == sc_.rejectRequest) {
+        status = sc_.errorStatus;
+    } else {
+        sc_.pending = (struct Request){ mss_dest_addr, mss_spi_flash, n_bytes };
+        sc_.pendingFails = (sc_.numRequests == sc_.failRequest) || !inFlash;
+        sc_.busyRemaining = sc_.busySteps;
+        scbctrl_.SERVICES_CR |= SCBCTRL_SERVICESCR_REQ_MASK;
+
+        if (sc_.immediate) {
+            sc_complete_();
+        }
+    }
+
+    return status;
+}
+
+//
+// xorshift, so that the flash contents are the same from run to run
+static uint32_t random_state_ = 0x5B1F1A5Eu;
+
+static uint32_t random_(void)
+{
+    random_state_ ^= random_state_ << 13;
+    random_state_ ^= random_state_ >> 17;
+    random_state_ ^= random_state_ << 5;
+
+    return random_state_;
+}
+
+static bool is_filled_(uint8_t const *pData, size_t size, uint8_t value)
+{
+    bool result = true;
+
+    for (size_t i = 0u; result && (i < size); i++) {
+        result = (pData[i] == value);
+    }
+
+    return result;
+}
+
+static void fill_memory_(void)
+{
+    memset(memory_, FILL, sizeof(memory_));
+}
+
+static bool guards_intact_(size_t byteCount)
+{
+    return is_filled_(memory_, GUARD_SIZE, FILL)
+        && is_filled_(pDest_ + byteCount, sizeof(memory_) - GUARD_SIZE - byteCount, FILL);
+}
+
+//
+// starts a background read, and steps the System Controller until it is complete,
+// checking that the service mode is restored after each request
+static bool run_read_(size_t srcOffset, size_t byteCount, unsigned *pSteps)
+{
+    bool result = false;
+    unsigned steps = 0u;
+
+    if (HSS_SPI_ReadBlockStart(pDest_, srcOffset, byteCount)) {
+        while (!HSS_SPI_IsTransferComplete(&result)) {
+            CHECK_EQUAL(sc_.serviceMode, MSS_SYS_SERVICE_POLLING_MODE);
+            sc_step_();
+            steps++;
+            assert(steps < MAX_STEPS);
+        }
+    } else {
+        CHECK(HSS_SPI_IsTransferComplete(&result));
+        CHECK(!result);
+    }
+
+    CHECK_EQUAL(sc_.serviceMode, MSS_SYS_SERVICE_POLLING_MODE);
+
+    if (pSteps) {
+        *pSteps = steps;
+    }
+
+    return result;
+}
+
+//
+// each request is for the next chunk of the read, at most CHUNK_SIZE bytes, in order
+static void check_requests_(size_t srcOffset, size_t byteCount, size_t numRequests)
+{
+    CHECK_EQUAL(sc_.numRequests, numRequests);
+
+    for (size_t i = 0u; i < MIN(numRequests, MAX_REQUESTS); i++) {
+        size_t const offset = i * CHUNK_SIZE;
+
+        CHECK_EQUAL(sc_.log[i].dest, (uint64_t)(uintptr_t)(pDest_ + offset));
+        CHECK_EQUAL(sc_.log[i].src, srcOffset + offset);
+        CHECK_EQUAL(sc_.log[i].byteCount, MIN(CHUNK_SIZE, byteCount - offset));
+    }
+}
+
+static void test_reads_split_into_chunks(void)
+{
+    // either side of the chunk size and its multiples, from offsets that are not aligned
+    static const struct {
+        size_t srcOffset;
+        size_t byteCount;
+    } reads[] = {
+        { 0u, 1u }, { 0u, 511u }, { 0u, 512u }, { 13u, CHUNK_SIZE - 1u },
+        { 0u, CHUNK_SIZE }, { 512u, CHUNK_SIZE + 1u }, { 7u, 3u * CHUNK_SIZE + 17u },
+        { CHUNK_SIZE - 1u, 2u * CHUNK_SIZE }, { FLASH_SIZE - CHUNK_SIZE - 5u, CHUNK_SIZE + 5u },
+        { 0u, FLASH_SIZE },
+    };
+
+    for (size_t i = 0u; i < ARRAY_SIZE(reads); i++) {
+        size_t const srcOffset = reads[i].srcOffset;
+        size_t const byteCount = reads[i].byteCount;
+        size_t const numRequests = (byteCount + CHUNK_SIZE - 1u) / CHUNK_SIZE;
+        unsigned steps;
+
+        sc_reset_();
+        fill_memory_();
+
+        CHECK(run_read_(srcOffset, byteCount, &steps));
+        check_requests_(srcOffset, byteCount, numRequests);
+        CHECK(!memcmp(pDest_, flash_ + srcOffset, byteCount));
+        CHECK(guards_intact_(byteCount));
+        CHECK_EQUAL(sc_.protocolErrors, 0u);
+
+        // each request is picked up, stays busy, and completes, before the next is posted
+        CHECK_EQUAL(steps, numRequests * (sc_.busySteps + 2u));
+    }
+}
+
+static void test_copy_error_ends_read(void)
+{
+    size_t const byteCount = 5u * CHUNK_SIZE + 100u;
+
+    for (unsigned failed = 1u; failed <= 6u; failed++) {
+        size_t const goodBytes = (failed - 1u) * CHUNK_SIZE;
+
+        sc_reset_();
+        fill_memory_();
+        sc_.failRequest = failed;
+
+        CHECK(!run_read_(3u, byteCount, NULL));
+        check_requests_(3u, byteCount, failed);
+        CHECK(!memcmp(pDest_, flash_ + 3u, goodBytes));
+        CHECK(guards_intact_(goodBytes));
+        CHECK_EQUAL(sc_.protocolErrors, 0u);
+
+        // and the next read is not affected
+        sc_reset_();
+        CHECK(run_read_(0u, CHUNK_SIZE + 1u, NULL));
+        CHECK(!memcmp(pDest_, flash_, CHUNK_SIZE + 1u));
+    }
+}
+
+static void test_rejected_request_ends_read(void)
+{
+    size_t const byteCount = 3u * CHUNK_SIZE;
+
+    for (unsigned rejected = 1u; rejected <= 3u; rejected++) {
+        size_t const goodBytes = (rejected - 1u) * CHUNK_SIZE;
+
+        sc_reset_();
+        fill_memory_();
+        sc_.rejectRequest = rejected;
+
+        CHECK(!run_read_(0u, byteCount, NULL));
+        check_requests_(0u, byteCount, rejected);
+        CHECK(!memcmp(pDest_, flash_, goodBytes));
+        CHECK(guards_intact_(goodBytes));
+        CHECK_EQUAL(sc_.protocolErrors, 0u);
+    }
+}
+
+static void test_reads_beyond_flash_rejected(void)
+{
+    sc_reset_();
+    fill_memory_();
+
+    CHECK(!run_read_(FLASH_SIZE - 1u, 2u, NULL));
+    CHECK(!run_read_(FLASH_SIZE + 1u, 0u, NULL));
+    CHECK(!run_read_(1u, SIZE_MAX, NULL));
+    CHECK_EQUAL(sc_.numRequests, 0u);
+
+    // an empty read, even at the end of the flash, completes without a request
+    CHECK(run_read_(FLASH_SIZE, 0u, NULL));
+    CHECK_EQUAL(sc_.numRequests, 0u);
+    CHECK(guards_intact_(0u));
+
+    CHECK(run_read_(FLASH_SIZE - 1u, 1u, NULL));
+    CHECK_EQUAL(sc_.numRequests, 1u);
+    CHECK_EQUAL(pDest_[0], flash_[FLASH_SIZE - 1u]);
+    CHECK_EQUAL(sc_.protocolErrors, 0u);
+}
+
+static void test_blocking_read(void)
+{
+    size_t const byteCount = 2u * CHUNK_SIZE + 1u;
+
+    sc_reset_();
+    fill_memory_();
+    sc_.immediate = true;
+
+    CHECK(HSS_SPI_ReadBlock(pDest_, 100u, byteCount));
+    check_requests_(100u, byteCount, 3u);
+    CHECK(!memcmp(pDest_, flash_ + 100u, byteCount));
+    CHECK(guards_intact_(byteCount));
+
+    sc_.numRequests = 0u;
+    sc_.failRequest = 2u;
+    CHECK(!HSS_SPI_ReadBlock(pDest_, 100u, byteCount));
+    CHECK_EQUAL(sc_.numRequests, 2u);
+    CHECK_EQUAL(sc_.serviceMode, MSS_SYS_SERVICE_POLLING_MODE);
+    CHECK_EQUAL(sc_.protocolErrors, 0u);
+}
+
+int main(void)
+{
+    for (size_t i = 0u; i < FLASH_SIZE; i++) {
+        flash_[i] = (uint8_t)random_();
+    }
+
+    CHECK(HSS_SPI_Init());
+
+    RUN_TEST(test_reads_split_into_chunks);
+    RUN_TEST(test_copy_error_ends_read);
+    RUN_TEST(test_rejected_request_ends_read);
+    RUN_TEST(test_reads_beyond_flash_rejected);
+    RUN_TEST(test_blocking_read);
+
+    return unit_test_report("spi_api");
+}
@@ -0,0 +1,425 @@
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/*!
+ * \file Host unit tests for the USB mass storage data path
+ * \brief Simulates the latency of READ(10) and WRITE(10) commands through the USB mass
+ * storage application, with one data buffer or two, and checks that the data reaches the
+ * host and the storage intact, and that no buffer is used by USB and storage at once
+ *
+ * flash_drive_app.c is included rather than linked, and driven through its media
+ * callbacks as the MSC class driver drives them. Storage and USB are replaced by models
+ * that keep a simulated clock. The timings are from a cost model, not measured.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+
+#include <string.h>
+
+#include "flash_drive_app.c"
+#include "unit_test.h"
+
+#define BLOCK_SIZE              (512u)
+#define DISK_SIZE               (16u * 1024u * 1024u)
+
+//
+// the cost model. These figures are assumptions rather than measurements, so only the
+// relative figures of one and two buffers are meaningful:
+//  - storage reads take STORAGE_READ_SETUP_US, then run at STORAGE_READ_BYTES_PER_US;
+//  - storage writes take STORAGE_WRITE_SETUP_US, then run at STORAGE_WRITE_BYTES_PER_US;
+//  - USB high-speed bulk transfers run at USB_BYTES_PER_US
+#define STORAGE_READ_SETUP_US       (100u)
+#define STORAGE_READ_BYTES_PER_US   (20u)
+#define STORAGE_WRITE_SETUP_US      (200u)
+#define STORAGE_WRITE_BYTES_PER_US  (10u)
+#define USB_BYTES_PER_US            (40u)
+
+static uint8_t disk_[DISK_SIZE];
+static uint8_t mirror_[DISK_SIZE];
+static uint8_t hostData_[DISK_SIZE];
+
+//
+// the storage model, which completes at most one background transfer at a time. The data
+// of a background transfer moves when it completes, so that a buffer reused too early
+// shows up in the data as well as in the hazard count
+static struct {
+    uint64_t nowUs;
+    uint64_t storageUs;
+    uint64_t usbUs;
+
+    bool inFlight;
+    bool isRead;
+    uint8_t *pBuffer;
+    size_t offset;
+    size_t byteCount;
+    uint64_t doneAtUs;
+
+    unsigned overlaps;          // transfers started while another was in flight
+    unsigned hazards;           // buffers used by USB while storage was using them
+    unsigned backgroundTransfers;
+    unsigned flushes;
+} sim_;
+
+static uint64_t storage_cost_(bool isRead, size_t byteCount)
+{
+    return isRead ?
+        (STORAGE_READ_SETUP_US + (byteCount / STORAGE_READ_BYTES_PER_US)) :
+        (STORAGE_WRITE_SETUP_US + (byteCount / STORAGE_WRITE_BYTES_PER_US));
+}
+
+static bool in_disk_(size_t offset, size_t byteCount)
+{
+    return (offset <= DISK_SIZE) && (byteCount <= DISK_SIZE - offset);
+}
+
+static void storage_move_(bool isRead, uint8_t *pBuffer, size_t offset, size_t byteCount)
+{
+    if (isRead) {
+        memcpy(pBuffer, disk_ + offset, byteCount);
+    } else {
+        memcpy(disk_ + offset, pBuffer, byteCount);
+    }
+}
+
+static bool storage_sync_(bool isRead, uint8_t *pBuffer, size_t offset, size_t byteCount)
+{
+    bool const result = in_disk_(offset, byteCount);
+
+    if (sim_.inFlight) {
+        sim_.overlaps++;
+    }
+
+    if (result) {
+        uint64_t const cost = storage_cost_(isRead, byteCount);
+
+        sim_.nowUs += cost;
+        sim_.storageUs += cost;
+        storage_move_(isRead, pBuffer, offset, byteCount);
+    }
+
+    return result;
+}
+
+static bool storage_start_(bool isRead, uint8_t *pBuffer, size_t offset, size_t byteCount)
+{
+    bool const result = in_disk_(offset, byteCount);
+
+    if (sim_.inFlight) {
+        sim_.overlaps++;
+    }
+
+    if (result) {
+        uint64_t const cost = storage_cost_(isRead, byteCount);
+
+        sim_.inFlight = true;
+        sim_.isRead = isRead;
+        sim_.pBuffer = pBuffer;
+        sim_.offset = offset;
+        sim_.byteCount = byteCount;
+        sim_.doneAtUs = sim_.nowUs + cost;
+        sim_.storageUs += cost;
+        sim_.backgroundTransfers++;
+    }
+
+    return result;
+}
+
+bool HSS_Storage_Init(void)
+{
+    return true;
+}
+
+bool HSS_Storage_ReadBlock(void *pDest, size_t srcOffset, size_t byteCount)
+{
+    return storage_sync_(true, (uint8_t *)pDest, srcOffset, byteCount);
+}
+
+bool HSS_Storage_WriteBlock(size_t dstOffset, void *pSrc, size_t byteCount)
+{
+    return storage_sync_(false, (uint8_t *)pSrc, dstOffset, byteCount);
+}
+
+bool HSS_Storage_ReadBlockStart(void *pDest, size_t srcOffset, size_t byteCount)
+{
+    return storage_start_(true, (uint8_t *)pDest, srcOffset, byteCount);
+}
+
+bool HSS_Storage_WriteBlockStart(size_t dstOffset, void *pSrc, size_t byteCount)
+{
+    return storage_start_(false, (uint8_t *)pSrc, dstOffset, byteCount);
+}
+
+//
+// polled in a loop until complete, so polling waits for the transfer in flight
+bool HSS_Storage_IsTransferComplete(bool *pResult)
+{
+    if (sim_.inFlight) {
+        sim_.nowUs = MAX(sim_.nowUs, sim_.doneAtUs);
+        storage_move_(sim_.isRead, sim_.pBuffer, sim_.offset, sim_.byteCount);
+        sim_.inFlight = false;
+    }
+
+    if (pResult) {
+        *pResult = true;
+    }
+
+    return true;
+}
+
+void HSS_Storage_GetInfo(uint32_t *pBlockSize, uint32_t *pEraseSize, uint32_t *pBlockCount)
+{
+    *pBlockSize = BLOCK_SIZE;
+    *pEraseSize = BLOCK_SIZE;
+    *pBlockCount = DISK_SIZE / BLOCK_SIZE;
+}
+
+void HSS_Storage_FlushWriteBuffer(void)
+{
+    sim_.flushes++;
+}
+
+HSSTicks_t HSS_GetTime(void)
+{
+    return 0u;
+}
+
+bool HSS_Timer_IsElapsed(HSSTicks_t startTick, HSSTicks_t durationInTicks)
+{
+    (void)startTick;
+    (void)durationInTicks;
+
+    return false;
+}
+
+//
+// the USB device driver, which hands the media callbacks to the test
+static mss_usbd_msc_media_t *pMedia_;
+mss_usbd_user_descr_cb_t flash_drive_descriptors_cb;
+
+void MSS_USBD_set_descr_cb_handler(mss_usbd_user_descr_cb_t *user_desc_cb)
+{
+    CHECK(user_desc_cb == &flash_drive_descriptors_cb);
+}
+
+void MSS_USBD_MSC_init(mss_usbd_msc_media_t *media_ops, mss_usb_device_speed_t speed)
+{
+    (void)speed;
+    pMedia_ = media_ops;
+}
+
+void MSS_USBD_init(mss_usb_device_speed_t speed)
+{
+    (void)speed;
+}
+
+//
+// a USB transfer of part of a command, while any storage transfer in flight carries on
+static void usb_transfer_(uint8_t const *pBuffer, size_t byteCount)
+{
+    uint64_t const cost = byteCount / USB_BYTES_PER_US;
+
+    if (sim_.inFlight && (pBuffer < sim_.pBuffer + sim_.byteCount)
+        && (sim_.pBuffer < pBuffer + byteCount)) {
+        sim_.hazards++;
+    }
+
+    sim_.nowUs += cost;
+    sim_.usbUs += cost;
+}
+
+//
+// the MSC class driver's handling of READ(10), which sends each part the application
+// returns, and asks for the rest
+static void host_read_(uint64_t offset, uint32_t byteCount)
+{
+    uint32_t residue = byteCount;
+
+    while (residue) {
+        uint8_t *pBuffer = NULL;
+        uint32_t const len = pMedia_->media_read(0u, &pBuffer, offset, residue);
+
+        CHECK(pBuffer != NULL);
+        CHECK(len && (len <= residue));
+        if (!pBuffer || !len || (len > residue)) {
+            break;
+        }
+
+        CHECK(!memcmp(pBuffer, mirror_ + offset, len));
+        usb_transfer_(pBuffer, len);
+
+        offset += len;
+        residue -= len;
+    }
+}
+
+//
+// the MSC class driver's handling of WRITE(10), which receives each part into the buffer
+// the application provides, and hands it back
+static void host_write_(uint64_t offset, uint32_t byteCount)
+{
+    uint32_t residue = byteCount;
+
+    while (residue) {
+        uint32_t appLen = 0u;
+        uint8_t * const pBuffer = pMedia_->media_acquire_write_buf(0u, offset, &appLen);
+        uint32_t const len = (appLen < residue) ? appLen : residue;
+
+        CHECK(pBuffer != NULL);
+        CHECK(len != 0u);
+        if (!pBuffer || !len) {
+            break;
+        }
+
+        usb_transfer_(pBuffer, len);
+        memcpy(pBuffer, hostData_ + offset, len);
+        memcpy(mirror_ + offset, hostData_ + offset, len);
+        CHECK(pMedia_->media_write_ready(0u, offset, len));
+
+        offset += len;
+        residue -= len;
+    }
+}
+
+//
+// xorshift, so that the data and workloads are the same from run to run
+static uint32_t random_state_ = 0x05BD35C1u;
+
+static uint32_t random_(void)
+{
+    random_state_ ^= random_state_ << 13;
+    random_state_ ^= random_state_ >> 17;
+    random_state_ ^= random_state_ << 5;
+
+    return random_state_;
+}
+
+static void connect_(void)
+{
+    memset(&sim_, 0, sizeof(sim_));
+
+    for (size_t i = 0u; i < DISK_SIZE; i++) {
+        disk_[i] = (uint8_t)random_();
+        hostData_[i] = (uint8_t)random_();
+    }
+    memcpy(mirror_, disk_, DISK_SIZE);
+
+    pMedia_ = NULL;
+    CHECK(FLASH_DRIVE_init());
+    CHECK(pMedia_ != NULL);
+}
+
+//
+// the host disconnecting, after which all the data written must be on the storage
+static void disconnect_(void)
+{
+    pMedia_->media_release(0u);
+
+    CHECK(!sim_.inFlight);
+    CHECK(sim_.flushes != 0u);
+    CHECK(!memcmp(disk_, mirror_, DISK_SIZE));
+    CHECK_EQUAL(sim_.overlaps, 0u);
+    CHECK_EQUAL(sim_.hazards, 0u);
+}
+
+struct Result {
+    uint64_t elapsedUs;
+    uint64_t serialUs;          // the time with no overlap of storage and USB
+};
+
+static struct Result run_sequential_(bool isRead, uint32_t commandSize, unsigned numCommands)
+{
+    connect_();
+
+    for (unsigned i = 0u; i < numCommands; i++) {
+        if (isRead) {
+            host_read_((uint64_t)i * commandSize, commandSize);
+        } else {
+            host_write_((uint64_t)i * commandSize, commandSize);
+        }
+    }
+
+    disconnect_();
+
+    return (struct Result){ sim_.nowUs, sim_.storageUs + sim_.usbUs };
+}
+
+static void test_random_commands(void)
+{
+    connect_();
+
+    for (unsigned i = 0u; i < 400u; i++) {
+        uint32_t const byteCount = (1u + (random_() % 512u)) * BLOCK_SIZE;
+        uint64_t const offset = (uint64_t)(random_() % ((DISK_SIZE - byteCount) / BLOCK_SIZE))
+            * BLOCK_SIZE;
+
+        if (random_() & 1u) {
+            host_read_(offset, byteCount);
+        } else {
+            host_write_(offset, byteCount);
+        }
+    }
+
+    disconnect_();
+}
+
+static void test_latency(void)
+{
+    static const struct {
+        char const *pName;
+        bool isRead;
+        uint32_t commandSize;
+    } workloads[] = {
+        { "READ(10) 4KiB",    true,  4096u },
+        { "READ(10) 128KiB",  true,  128u * 1024u },
+        { "READ(10) 1MiB",    true,  1024u * 1024u },
+        { "WRITE(10) 4KiB",   false, 4096u },
+        { "WRITE(10) 128KiB", false, 128u * 1024u },
+        { "WRITE(10) 1MiB",   false, 1024u * 1024u },
+    };
+    size_t const totalBytes = 8u * 1024u * 1024u;
+
+    printf("  %u data buffer(s), %zu MiB per workload\n", NUM_DATA_BUFFERS,
+        totalBytes / (1024u * 1024u));
+    printf("  %-20s %12s %12s %10s\n", "", "elapsed us", "serial us", "MB/s");
+
+    for (size_t i = 0u; i < ARRAY_SIZE(workloads); i++) {
+        unsigned const numCommands = (unsigned)(totalBytes / workloads[i].commandSize);
+        struct Result const result = run_sequential_(workloads[i].isRead,
+            workloads[i].commandSize, numCommands);
+
+        printf("  %-20s %12lu %12lu %10lu\n", workloads[i].pName,
+            (unsigned long)result.elapsedUs, (unsigned long)result.serialUs,
+            (unsigned long)(totalBytes / result.elapsedUs));
+
+        CHECK(result.elapsedUs <= result.serialUs);
+
+        if ((NUM_DATA_BUFFERS == 1u)
+            || (workloads[i].isRead && (workloads[i].commandSize <= SD_RD_WR_SIZE))) {
+            //
+            // without a second buffer nothing overlaps, and reads only prefetch the next
+            // part of the same command
+            CHECK_EQUAL(result.elapsedUs, result.serialUs);
+        } else {
+            //
+            // with two buffers, reads send one part while reading the next, and writes
+            // receive the next part, of the same command or the next, while programming
+            CHECK(result.elapsedUs * 10u < result.serialUs * 9u);
+        }
+    }
+}
+
+int main(void)
+{
+    RUN_TEST(test_random_commands);
+    RUN_TEST(test_latency);
+
+    return unit_test_report(IS_ENABLED(CONFIG_SERVICE_USBDMSC_DOUBLE_BUFFER) ?
+        "usbdmsc_double_buffer" : "usbdmsc");
+}
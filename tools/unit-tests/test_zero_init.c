@@ -0,0 +1,330 @@
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/*!
+ * \file Host unit tests for clearing zero-initialized boot image chunks
+ * \brief Checks that ZI chunks cleared by doubling copies are fully cleared, without
+ * touching their neighbours, and compares the ways of clearing them over large synthetic
+ * ZI tables
+ *
+ * The copies are made by the test as soon as they are submitted, so that the order of
+ * the steps is checked rather than the PDMA itself, which test_memcpy_via_pdma covers.
+ * The timings are from a cost model, not measured.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "hss_boot_download.h"
+#include "unit_test.h"
+
+#define MAX_CHUNK_SIZE          (16u * 1024u * 1024u)
+#define GUARD_SIZE              (64u)
+#define FILL                    (0xA5u)
+
+//
+// the cost model. These figures are assumptions rather than measurements, so only the
+// relative figures of the strategies are meaningful:
+//  - the E51 clears DDR at CPU_BYTES_PER_US;
+//  - the PDMA copies at PDMA_BYTES_PER_US, with all channels in use;
+//  - each PDMA copy costs the E51 PDMA_SUBMIT_US to submit, and is only seen to be
+//    complete on the next pass of the superloop, up to SUPERLOOP_US later;
+//  - a U54 needs HART_IPI_US to be woken and to report back
+#define CPU_BYTES_PER_US        (800u)
+#define PDMA_BYTES_PER_US       (1600u)
+#define PDMA_SUBMIT_US          (2u)
+#define SUPERLOOP_US            (10u)
+#define HART_IPI_US             (50u)
+#define NUM_U54_HARTS           (4u)
+
+static uint8_t memory_[GUARD_SIZE + MAX_CHUNK_SIZE + GUARD_SIZE] __attribute__((aligned(64)));
+static uint8_t * const pChunk_ = memory_ + GUARD_SIZE;
+
+static struct Cost {
+    size_t copies;
+    size_t cpuBytes;
+    size_t copyBytes;
+    size_t e51Us;           // time the E51 is busy clearing
+    size_t elapsedUs;       // time until the chunk is clear
+} cost_;
+
+//
+// xorshift, so that the tables are the same from run to run
+static uint32_t random_state_ = 0x2EE0C1E5u;
+
+static uint32_t random_(void)
+{
+    random_state_ ^= random_state_ << 13;
+    random_state_ ^= random_state_ >> 17;
+    random_state_ ^= random_state_ << 5;
+
+    return random_state_;
+}
+
+static bool is_filled_(uint8_t const *pData, size_t size, uint8_t value)
+{
+    bool result = true;
+
+    for (size_t i = 0u; result && (i < size); i++) {
+        result = (pData[i] == value);
+    }
+
+    return result;
+}
+
+static void fill_chunk_(size_t size)
+{
+    memset(memory_, FILL, GUARD_SIZE + size + GUARD_SIZE);
+}
+
+static bool chunk_is_clear_(size_t size)
+{
+    return is_filled_(pChunk_, size, 0u)
+        && is_filled_(memory_, GUARD_SIZE, FILL)
+        && is_filled_(pChunk_ + size, GUARD_SIZE, FILL);
+}
+
+static void cpu_clear_(void *pDest, size_t size)
+{
+    memset(pDest, 0, size);
+    cost_.cpuBytes += size;
+    cost_.e51Us += size / CPU_BYTES_PER_US;
+    cost_.elapsedUs += size / CPU_BYTES_PER_US;
+}
+
+static void pdma_copy_(void *pDest, void const *pSrc, size_t size)
+{
+    memcpy(pDest, pSrc, size);
+    cost_.copies++;
+    cost_.copyBytes += size;
+    cost_.e51Us += PDMA_SUBMIT_US;
+    cost_.elapsedUs += PDMA_SUBMIT_US + MAX(size / PDMA_BYTES_PER_US, SUPERLOOP_US);
+}
+
+//
+// the copy engine, which checks that each copy is taken from the cleared prefix of the
+// chunk into the uncleared region that follows it
+static struct {
+    size_t size;
+    size_t cleared;
+    unsigned failAfter;     // fail the copy after this many, or never if zero
+    unsigned badCopies;
+} engine_;
+
+static bool copy_(void *pContext, void *pDest, void const *pSrc, size_t byteCount)
+{
+    bool result = true;
+
+    CHECK(pContext == &engine_);
+
+    if ((pSrc != pChunk_) || ((uint8_t *)pDest != pChunk_ + engine_.cleared)
+        || (byteCount > engine_.cleared) || (engine_.cleared + byteCount > engine_.size)
+        || !is_filled_(pSrc, byteCount, 0u)) {
+        engine_.badCopies++;
+    }
+
+    if (engine_.failAfter && (cost_.copies >= engine_.failAfter)) {
+        result = false;
+    } else {
+        pdma_copy_(pDest, pSrc, byteCount);
+        engine_.cleared += byteCount;
+    }
+
+    return result;
+}
+
+//
+// the strategies, each clearing the chunk at pChunk_
+static void clear_by_memset_(size_t size)
+{
+    cpu_clear_(pChunk_, size);
+}
+
+static void clear_by_doubling_(size_t size)
+{
+    size_t offset = 0u;
+    unsigned steps = 0u;
+
+    engine_.size = size;
+    engine_.cleared = HSS_BOOT_ZI_SEED_SIZE;
+
+    while (!HSS_BootDownload_ZeroInitStep(&offset, pChunk_, size, copy_, &engine_)) {
+        steps++;
+        assert(steps < 64u);
+    }
+
+    CHECK_EQUAL(offset, 0u);
+
+    // the seed is cleared by the CPU, and not counted by the copy engine
+    if (size >= HSS_BOOT_ZI_COPY_THRESHOLD) {
+        cost_.cpuBytes += size - cost_.copyBytes;
+        cost_.e51Us += (size - cost_.copyBytes) / CPU_BYTES_PER_US;
+        cost_.elapsedUs += (size - cost_.copyBytes) / CPU_BYTES_PER_US;
+    } else {
+        cost_.cpuBytes += size;
+        cost_.e51Us += size / CPU_BYTES_PER_US;
+        cost_.elapsedUs += size / CPU_BYTES_PER_US;
+    }
+}
+
+static uint8_t zeroSource_[HSS_BOOT_ZI_SEED_SIZE] __attribute__((aligned(64)));
+
+static void clear_from_zero_source_(size_t size)
+{
+    for (size_t offset = 0u; offset < size; offset += sizeof(zeroSource_)) {
+        pdma_copy_(pChunk_ + offset, zeroSource_, MIN(size - offset, sizeof(zeroSource_)));
+    }
+}
+
+//
+// each U54 clears a share of the chunk in parallel, so the elapsed time is that of the
+// largest share
+static void clear_across_harts_(size_t size)
+{
+    size_t const share = (size + NUM_U54_HARTS - 1u) / NUM_U54_HARTS;
+
+    for (size_t offset = 0u; offset < size; offset += share) {
+        memset(pChunk_ + offset, 0, MIN(size - offset, share));
+    }
+
+    cost_.elapsedUs += HART_IPI_US + (share / CPU_BYTES_PER_US);
+    cost_.e51Us += HART_IPI_US;
+}
+
+static size_t doubling_copies_(size_t size)
+{
+    size_t copies = 0u;
+
+    if (size >= HSS_BOOT_ZI_COPY_THRESHOLD) {
+        for (size_t cleared = HSS_BOOT_ZI_SEED_SIZE; cleared < size; cleared *= 2u) {
+            copies++;
+        }
+    }
+
+    return copies;
+}
+
+static void test_chunks_cleared_without_touching_neighbours(void)
+{
+    // either side of the threshold and of powers of two, and sizes that are not a whole
+    // number of PDMA units
+    static const size_t sizes[] = {
+        1u, 17u, HSS_BOOT_ZI_SEED_SIZE, HSS_BOOT_ZI_COPY_THRESHOLD - 1u,
+        HSS_BOOT_ZI_COPY_THRESHOLD, HSS_BOOT_ZI_COPY_THRESHOLD + 1u,
+        HSS_BOOT_ZI_COPY_THRESHOLD + 4095u, 3u * HSS_BOOT_ZI_COPY_THRESHOLD + 9u,
+        1024u * 1024u - 1u, 1024u * 1024u, 1024u * 1024u + 13u, MAX_CHUNK_SIZE,
+    };
+
+    for (size_t i = 0u; i < ARRAY_SIZE(sizes); i++) {
+        memset(&cost_, 0, sizeof(cost_));
+        memset(&engine_, 0, sizeof(engine_));
+        fill_chunk_(sizes[i]);
+
+        clear_by_doubling_(sizes[i]);
+
+        CHECK(chunk_is_clear_(sizes[i]));
+        CHECK_EQUAL(engine_.badCopies, 0u);
+        CHECK_EQUAL(cost_.copies, doubling_copies_(sizes[i]));
+    }
+}
+
+static void test_failed_copy_falls_back_to_cpu(void)
+{
+    const size_t size = 4u * 1024u * 1024u + 100u;
+
+    for (unsigned failAfter = 1u; failAfter <= doubling_copies_(size); failAfter++) {
+        memset(&cost_, 0, sizeof(cost_));
+        memset(&engine_, 0, sizeof(engine_));
+        engine_.failAfter = failAfter;
+        fill_chunk_(size);
+
+        clear_by_doubling_(size);
+
+        CHECK(chunk_is_clear_(size));
+        CHECK_EQUAL(engine_.badCopies, 0u);
+        CHECK_EQUAL(cost_.copies, failAfter);
+    }
+}
+
+//
+// large synthetic ZI tables, of the bss and heaps of a Linux-class payload on each U54
+static size_t make_table_(size_t sizes[], size_t count)
+{
+    size_t total = 0u;
+
+    for (size_t i = 0u; i < count; i++) {
+        // log-uniform from 256 bytes to MAX_CHUNK_SIZE
+        unsigned const shift = 8u + (random_() % 17u);
+        sizes[i] = MIN((size_t)1u << shift, MAX_CHUNK_SIZE);
+        sizes[i] = MAX(sizes[i] - (random_() % (sizes[i] / 2u)), 1u);
+        total += sizes[i];
+    }
+
+    return total;
+}
+
+static void test_benchmark(void)
+{
+    static const struct {
+        char const *pName;
+        void (*clear)(size_t size);
+    } strategies[] = {
+        { "memset (E51)",            clear_by_memset_ },
+        { "PDMA doubling self-copy", clear_by_doubling_ },
+        { "PDMA from zeroed 4KiB",   clear_from_zero_source_ },
+        { "split across U54s",       clear_across_harts_ },
+    };
+    size_t sizes[48];
+    size_t const total = make_table_(sizes, ARRAY_SIZE(sizes));
+    struct Cost costs[ARRAY_SIZE(strategies)];
+
+    printf("  %zu ZI chunks, %zu KiB in total\n", ARRAY_SIZE(sizes), total / 1024u);
+    printf("  %-24s %8s %12s %12s %12s\n", "", "copies", "CPU KiB", "E51 us", "elapsed us");
+
+    for (size_t s = 0u; s < ARRAY_SIZE(strategies); s++) {
+        memset(&costs[s], 0, sizeof(costs[s]));
+
+        for (size_t i = 0u; i < ARRAY_SIZE(sizes); i++) {
+            memset(&cost_, 0, sizeof(cost_));
+            memset(&engine_, 0, sizeof(engine_));
+            fill_chunk_(sizes[i]);
+
+            strategies[s].clear(sizes[i]);
+
+            CHECK(chunk_is_clear_(sizes[i]));
+            CHECK_EQUAL(engine_.badCopies, 0u);
+            costs[s].copies += cost_.copies;
+            costs[s].cpuBytes += cost_.cpuBytes;
+            costs[s].e51Us += cost_.e51Us;
+            costs[s].elapsedUs += cost_.elapsedUs;
+        }
+
+        printf("  %-24s %8zu %12zu %12zu %12zu\n", strategies[s].pName, costs[s].copies,
+            costs[s].cpuBytes / 1024u, costs[s].e51Us, costs[s].elapsedUs);
+    }
+
+    //
+    // the doubling copies leave the E51 free for most of the time, without the
+    // per-copy overheads of a small zero source
+    CHECK(costs[1].e51Us * 4u < costs[0].e51Us);
+    CHECK(costs[1].copies * 16u < costs[2].copies);
+    CHECK(costs[1].elapsedUs < costs[2].elapsedUs);
+}
+
+int main(void)
+{
+    RUN_TEST(test_chunks_cleared_without_touching_neighbours);
+    RUN_TEST(test_failed_copy_falls_back_to_cpu);
+    RUN_TEST(test_benchmark);
+
+    return unit_test_report("zero_init");
+}
@@ -0,0 +1,55 @@
+#ifndef UNIT_TEST_H
+#define UNIT_TEST_H
+
+/*******************************************************************************
+ * Copyright 2025 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ * Host unit tests - minimal check and reporting helpers
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static unsigned unitTestChecks_ = 0u;
+static unsigned unitTestFailures_ = 0u;
+
+#define CHECK(cond) \
+    do { \
+        unitTestChecks_++; \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            unitTestFailures_++; \
+        } \
+    } while (0)
+
+#define CHECK_EQUAL(actual, expected) \
+    do { \
+        unsigned long long const actual_ = (unsigned long long)(actual); \
+        unsigned long long const expected_ = (unsigned long long)(expected); \
+        unitTestChecks_++; \
+        if (actual_ != expected_) { \
+            fprintf(stderr, "%s:%d: %s is 0x%llx vs expected 0x%llx\n", __FILE__, __LINE__, \
+                #actual, actual_, expected_); \
+            unitTestFailures_++; \
+        } \
+    } while (0)
+
+#define RUN_TEST(fn) \
+    do { \
+        unsigned const failuresBefore_ = unitTestFailures_; \
+        fn(); \
+        printf("  %-48s %s\n", #fn, (unitTestFailures_ == failuresBefore_) ? "ok" : "FAILED"); \
+    } while (0)
+
+static inline int unit_test_report(char const * const pName)
+{
+    printf("%s: %u checks, %u failures\n", pName, unitTestChecks_, unitTestFailures_);
+    return unitTestFailures_ ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#endif